@@ -4,11 +4,11 @@ use rusqlite::{params, Row};
 
 use crate::models::{
     album::{CreateAlbum, UpdateAlbum},
-    Album, AlbumWithCount, RecentlyEditedAlbum,
+    Album, AlbumWithCount, BatchItemStatus, RecentlyEditedAlbum,
 };
 use crate::utils::error::{AppError, AppResult};
 
-use super::connection::Database;
+use super::connection::{batch_item_status, Database};
 
 /// 从数据库行映射到 Album 结构
 fn row_to_album(row: &Row<'_>) -> rusqlite::Result<Album> {
@@ -223,6 +223,85 @@ impl Database {
         })
     }
 
+    /// 将多张照片批量加入多个相册（单事务）
+    ///
+    /// 返回每个 (照片, 相册) 组合的结果，按照片优先排列：
+    /// `status[photo_index * album_ids.len() + album_index]`
+    pub fn add_photos_to_albums(
+        &self,
+        photo_ids: &[i64],
+        album_ids: &[i64],
+    ) -> AppResult<Vec<BatchItemStatus>> {
+        if photo_ids.is_empty() || album_ids.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        self.transaction(|conn| {
+            let now = crate::models::photo::chrono_now_pub();
+
+            // 每个相册的当前最大排序号
+            let mut max_orders = Vec::with_capacity(album_ids.len());
+            {
+                let mut stmt = conn.prepare(
+                    "SELECT COALESCE(MAX(sort_order), 0) FROM album_photos WHERE album_id = ?1",
+                )?;
+                for album_id in album_ids {
+                    let max_order: i32 = stmt
+                        .query_row(params![album_id], |row| row.get(0))
+                        .unwrap_or(0);
+                    max_orders.push(max_order);
+                }
+            }
+
+            let mut statuses = Vec::with_capacity(photo_ids.len() * album_ids.len());
+            let mut stmt = conn.prepare(
+                "INSERT OR IGNORE INTO album_photos (album_id, photo_id, sort_order, date_added) VALUES (?1, ?2, ?3, ?4)",
+            )?;
+
+            for photo_id in photo_ids {
+                for (album_id, max_order) in album_ids.iter().zip(max_orders.iter_mut()) {
+                    let status = batch_item_status(
+                        stmt.execute(params![album_id, photo_id, *max_order + 1, now]),
+                    )?;
+                    if status == BatchItemStatus::Applied {
+                        *max_order += 1;
+                    }
+                    statuses.push(status);
+                }
+            }
+
+            Ok(statuses)
+        })
+    }
+
+    /// 从多个相册批量移除多张照片（单事务）
+    ///
+    /// 结果排列方式同 [`Database::add_photos_to_albums`]。
+    pub fn remove_photos_from_albums(
+        &self,
+        photo_ids: &[i64],
+        album_ids: &[i64],
+    ) -> AppResult<Vec<BatchItemStatus>> {
+        if photo_ids.is_empty() || album_ids.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        self.transaction(|conn| {
+            let mut statuses = Vec::with_capacity(photo_ids.len() * album_ids.len());
+
+            let mut stmt =
+                conn.prepare("DELETE FROM album_photos WHERE album_id = ?1 AND photo_id = ?2")?;
+
+            for photo_id in photo_ids {
+                for album_id in album_ids {
+                    statuses.push(batch_item_status(stmt.execute(params![album_id, photo_id]))?);
+                }
+            }
+
+            Ok(statuses)
+        })
+    }
+
     /// 从相册移除照片
     pub fn remove_photo_from_album(&self, album_id: i64, photo_id: i64) -> AppResult<bool> {
         let conn = self.connection()?;
@@ -486,4 +565,37 @@ mod tests {
         let photos_in_album = db.get_photo_ids_in_album(album_id).unwrap();
         assert_eq!(photos_in_album.len(), 5);
     }
+
+    #[test]
+    fn test_add_photos_to_albums_batch() {
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+
+        let album_a = db
+            .create_album(&CreateAlbum { album_name: "A".to_string(), description: None })
+            .unwrap();
+        let album_b = db
+            .create_album(&CreateAlbum { album_name: "B".to_string(), description: None })
+            .unwrap();
+
+        let mut photo_ids = Vec::new();
+        for i in 0..4 {
+            let photo = create_test_photo(&format!("photo_{}.jpg", i));
+            photo_ids.push(db.create_photo(&photo).unwrap());
+        }
+
+        let statuses = db.add_photos_to_albums(&photo_ids, &[album_a, album_b]).unwrap();
+        assert_eq!(statuses.len(), 8);
+        assert!(statuses.iter().all(|s| *s == BatchItemStatus::Applied));
+
+        // 保持加入顺序
+        assert_eq!(db.get_photo_ids_in_album(album_b).unwrap(), photo_ids);
+
+        let statuses = db.add_photos_to_albums(&photo_ids[..1], &[album_a]).unwrap();
+        assert_eq!(statuses, vec![BatchItemStatus::Unchanged]);
+
+        let statuses = db.remove_photos_from_albums(&photo_ids, &[album_a]).unwrap();
+        assert!(statuses.iter().all(|s| *s == BatchItemStatus::Applied));
+        assert!(db.get_photo_ids_in_album(album_a).unwrap().is_empty());
+    }
 }
@@ -3,9 +3,13 @@
 //! 提供 SQLite 数据库连接池和初始化功能
 
 use rusqlite::{Connection, OpenFlags};
+use std::ops::{Deref, DerefMut};
 use std::path::PathBuf;
-use std::sync::{Arc, Mutex};
+use std::sync::{Arc, Mutex, MutexGuard};
+use std::time::Instant;
 
+use crate::metrics;
+use crate::models::BatchItemStatus;
 use crate::paths::PathProvider;
 use crate::utils::error::{AppError, AppResult};
 
@@ -66,6 +70,32 @@ impl Database {
         Ok(db)
     }
 
+    /// 打开一个独立的只读连接
+    ///
+    /// 用于长时间运行的流式读取：WAL 模式下与主连接并发，
+    /// 不占用主连接的互斥锁。内存数据库无法共享，返回错误。
+    pub fn open_reader(&self) -> AppResult<Connection> {
+        if self.path.as_os_str() == ":memory:" {
+            return Err(AppError::General("内存数据库不支持独立只读连接".to_string()));
+        }
+
+        let conn = Connection::open_with_flags(
+            &self.path,
+            OpenFlags::SQLITE_OPEN_READ_ONLY | OpenFlags::SQLITE_OPEN_NO_MUTEX,
+        )?;
+
+        conn.execute_batch(
+            r#"
+            PRAGMA cache_size = -16000;
+            PRAGMA temp_store = MEMORY;
+            PRAGMA mmap_size = 268435456;
+            PRAGMA busy_timeout = 5000;
+            "#,
+        )?;
+
+        Ok(conn)
+    }
+
     /// 配置数据库连接
     fn configure(&self) -> AppResult<()> {
         let conn = self.conn.lock().map_err(|e| {
@@ -164,10 +194,14 @@ impl Database {
     }
 
     /// 获取数据库连接（用于执行查询）
-    pub fn connection(&self) -> AppResult<std::sync::MutexGuard<'_, Connection>> {
-        self.conn.lock().map_err(|e| {
+    pub fn connection(&self) -> AppResult<ConnectionGuard<'_>> {
+        let requested = Instant::now();
+        let guard = self.conn.lock().map_err(|e| {
             AppError::Database(rusqlite::Error::InvalidParameterName(e.to_string()))
-        })
+        })?;
+        let acquired = Instant::now();
+        metrics::global().record("db.lock_wait", acquired - requested);
+        Ok(ConnectionGuard { guard, acquired })
     }
 
     /// 执行事务
@@ -222,6 +256,50 @@ impl Database {
     }
 }
 
+/// 将批量写操作中单条语句的执行结果映射为单项状态
+///
+/// 约束失败（如外键不存在）只回滚该条语句，不中断所在事务。
+pub(crate) fn batch_item_status(result: rusqlite::Result<usize>) -> AppResult<BatchItemStatus> {
+    match result {
+        Ok(0) => Ok(BatchItemStatus::Unchanged),
+        Ok(_) => Ok(BatchItemStatus::Applied),
+        Err(rusqlite::Error::SqliteFailure(e, _))
+            if e.code == rusqlite::ErrorCode::ConstraintViolation =>
+        {
+            Ok(BatchItemStatus::Failed)
+        }
+        Err(e) => Err(AppError::Database(e)),
+    }
+}
+
+/// 数据库连接守卫
+///
+/// 释放时将持有连接的时长（即查询或事务耗时）记入 `db.query` 直方图。
+pub struct ConnectionGuard<'a> {
+    guard: MutexGuard<'a, Connection>,
+    acquired: Instant,
+}
+
+impl Deref for ConnectionGuard<'_> {
+    type Target = Connection;
+
+    fn deref(&self) -> &Connection {
+        &self.guard
+    }
+}
+
+impl DerefMut for ConnectionGuard<'_> {
+    fn deref_mut(&mut self) -> &mut Connection {
+        &mut self.guard
+    }
+}
+
+impl Drop for ConnectionGuard<'_> {
+    fn drop(&mut self) {
+        metrics::global().record("db.query", self.acquired.elapsed());
+    }
+}
+
 /// 数据库统计信息
 #[derive(Debug, Clone, serde::Serialize)]
 #[serde(rename_all = "camelCase")]
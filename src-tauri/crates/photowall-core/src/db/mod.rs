@@ -8,7 +8,9 @@ pub mod photo_dao;
 pub mod tag_dao;
 pub mod album_dao;
 pub mod scan_dir_dao;
+pub mod scan_journal_dao;
 
 // 重新导出常用类型
-pub use connection::{Database, DatabaseStats, default_db_path, default_db_path_with_provider};
+pub use connection::{ConnectionGuard, Database, DatabaseStats, default_db_path, default_db_path_with_provider};
 pub use scan_dir_dao::ScanDirectoryState;
+pub use scan_journal_dao::{FileStamp, JournalDir, JournalDirSnapshot, JournalEntry};
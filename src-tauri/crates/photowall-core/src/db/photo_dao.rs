@@ -8,6 +8,9 @@ use crate::models::{
     SearchFilters, SortOrder,
 };
 use crate::utils::error::{AppError, AppResult};
+use crate::utils::color_signature::ColorSignature;
+use crate::utils::image_quality::QualityScores;
+use crate::utils::perceptual_hash::PerceptualHash;
 
 use super::connection::Database;
 
@@ -81,6 +84,157 @@ fn build_cursor_condition(
     }
 }
 
+/// 根据搜索过滤器构建 WHERE 子句与参数（不含游标条件）
+fn build_search_conditions(
+    filters: &SearchFilters,
+) -> (Vec<String>, Vec<Box<dyn rusqlite::ToSql>>) {
+    let mut where_clauses: Vec<String> = Vec::new();
+    let mut params_vec: Vec<Box<dyn rusqlite::ToSql>> = Vec::new();
+
+    // 回收站过滤
+    if filters.in_trash == Some(true) {
+        where_clauses.push("is_deleted = 1".to_string());
+    } else {
+        where_clauses.push("is_deleted = 0".to_string());
+    }
+
+    // 全文搜索查询
+    if let Some(ref query) = filters.query {
+        if !query.trim().is_empty() {
+            where_clauses.push(
+                "photo_id IN (SELECT rowid FROM photos_fts WHERE photos_fts MATCH ?)".to_string(),
+            );
+            // 为 FTS5 转义特殊字符，并添加前缀匹配
+            let fts_query = format!("{}*", query.replace('\"', "\"\""));
+            params_vec.push(Box::new(fts_query));
+        }
+    }
+
+    // 日期范围过滤
+    if let Some(ref date_from) = filters.date_from {
+        where_clauses.push("date_taken >= ?".to_string());
+        params_vec.push(Box::new(date_from.clone()));
+    }
+    if let Some(ref date_to) = filters.date_to {
+        where_clauses.push("date_taken <= ?".to_string());
+        params_vec.push(Box::new(date_to.clone()));
+    }
+
+    // 相机型号过滤
+    if let Some(ref camera_model) = filters.camera_model {
+        where_clauses.push("camera_model LIKE ?".to_string());
+        params_vec.push(Box::new(format!("%{}%", camera_model)));
+    }
+
+    // 镜头型号过滤
+    if let Some(ref lens_model) = filters.lens_model {
+        where_clauses.push("lens_model LIKE ?".to_string());
+        params_vec.push(Box::new(format!("%{}%", lens_model)));
+    }
+
+    // 评分过滤
+    if let Some(min_rating) = filters.min_rating {
+        where_clauses.push("rating >= ?".to_string());
+        params_vec.push(Box::new(min_rating));
+    }
+    if let Some(max_rating) = filters.max_rating {
+        where_clauses.push("rating <= ?".to_string());
+        params_vec.push(Box::new(max_rating));
+    }
+
+    // 收藏过滤
+    if filters.favorites_only == Some(true) {
+        where_clauses.push("is_favorite = 1".to_string());
+    }
+
+    // GPS 过滤
+    if filters.has_gps == Some(true) {
+        where_clauses.push(
+            "gps_latitude IS NOT NULL AND gps_longitude IS NOT NULL".to_string(),
+        );
+    }
+
+    // 质量评分过滤（未评分的照片比较结果为 NULL，不匹配）
+    if let Some(min_sharpness) = filters.min_sharpness {
+        where_clauses.push("sharpness >= ?".to_string());
+        params_vec.push(Box::new(min_sharpness));
+    }
+    if let Some(max_highlight_clip) = filters.max_highlight_clip {
+        where_clauses.push("highlight_clip <= ?".to_string());
+        params_vec.push(Box::new(max_highlight_clip));
+    }
+    if let Some(max_shadow_clip) = filters.max_shadow_clip {
+        where_clauses.push("shadow_clip <= ?".to_string());
+        params_vec.push(Box::new(max_shadow_clip));
+    }
+    if let Some(max_noise) = filters.max_noise {
+        where_clauses.push("noise <= ?".to_string());
+        params_vec.push(Box::new(max_noise));
+    }
+
+    // 文件扩展名过滤（使用 format 字段）
+    if let Some(ref extensions) = filters.file_extensions {
+        if !extensions.is_empty() {
+            let placeholders: Vec<String> = extensions.iter().map(|_| "?".to_string()).collect();
+            where_clauses.push(format!(
+                "LOWER(format) IN ({})",
+                placeholders.join(", ")
+            ));
+            for ext in extensions {
+                params_vec.push(Box::new(ext.to_lowercase()));
+            }
+        }
+    }
+
+    // 标签过滤
+    if let Some(ref tag_ids) = filters.tag_ids {
+        if !tag_ids.is_empty() {
+            let placeholders: Vec<String> = tag_ids.iter().map(|_| "?".to_string()).collect();
+            where_clauses.push(format!(
+                "photo_id IN (SELECT DISTINCT photo_id FROM photo_tags WHERE tag_id IN ({}))",
+                placeholders.join(", ")
+            ));
+            for tag_id in tag_ids {
+                params_vec.push(Box::new(*tag_id));
+            }
+        }
+    }
+
+    // 相册过滤
+    if let Some(album_id) = filters.album_id {
+        where_clauses.push(
+            "photo_id IN (SELECT photo_id FROM album_photos WHERE album_id = ?)".to_string(),
+        );
+        params_vec.push(Box::new(album_id));
+    }
+
+    // 文件夹过滤
+    if let Some(ref folder_path) = filters.folder_path {
+        let include_subfolders = filters.include_subfolders.unwrap_or(true);
+        if include_subfolders {
+            let pattern = if folder_path.ends_with('\\') || folder_path.ends_with('/') {
+                format!("{}%", folder_path)
+            } else {
+                format!("{}\\%", folder_path)
+            };
+            where_clauses.push("file_path LIKE ?".to_string());
+            params_vec.push(Box::new(pattern));
+        } else {
+            where_clauses.push(
+                r#"(substr(file_path, 1, length(file_path) - length(file_name) - 1) = ?
+                    OR substr(file_path, 1, length(file_path) - length(file_name) - 1) = ? || '\'
+                    OR substr(file_path, 1, length(file_path) - length(file_name) - 1) = ? || '/')"#
+                    .to_string(),
+            );
+            params_vec.push(Box::new(folder_path.clone()));
+            params_vec.push(Box::new(folder_path.clone()));
+            params_vec.push(Box::new(folder_path.clone()));
+        }
+    }
+
+    (where_clauses, params_vec)
+}
+
 /// 从数据库行映射到 Photo 结构
 fn row_to_photo(row: &Row<'_>) -> rusqlite::Result<Photo> {
     Ok(Photo {
@@ -108,9 +262,31 @@ fn row_to_photo(row: &Row<'_>) -> rusqlite::Result<Photo> {
         is_favorite: row.get::<_, i32>("is_favorite")? != 0,
         is_deleted: row.get::<_, i32>("is_deleted").unwrap_or(0) != 0,
         deleted_at: row.get("deleted_at").ok(),
+        thumbhash: row.get("thumbhash").ok().flatten(),
+        // SQLite 只有有符号 64 位整数，按位存取
+        dhash: row.get::<_, Option<i64>>("dhash").ok().flatten().map(|v| v as u64),
+        phash: row.get::<_, Option<i64>>("phash").ok().flatten().map(|v| v as u64),
+        sharpness: row.get("sharpness").ok().flatten(),
+        highlight_clip: row.get("highlight_clip").ok().flatten(),
+        shadow_clip: row.get("shadow_clip").ok().flatten(),
+        noise: row.get("noise").ok().flatten(),
+        // 调色板只在单张照片详情中解码，列表查询不逐行解析颜色签名
+        palette: None,
     })
 }
 
+/// 映射单张照片，并从颜色签名解码主色调色板
+fn row_to_photo_with_palette(row: &Row<'_>) -> rusqlite::Result<Photo> {
+    let mut photo = row_to_photo(row)?;
+    photo.palette = row
+        .get::<_, Option<Vec<u8>>>("color_signature")
+        .ok()
+        .flatten()
+        .and_then(|bytes| ColorSignature::from_bytes(&bytes))
+        .map(|signature| signature.palette.iter().map(|c| c.hex()).collect());
+    Ok(photo)
+}
+
 impl Database {
     // ==================== Photo CRUD ====================
 
@@ -211,7 +387,7 @@ impl Database {
         let result = conn.query_row(
             "SELECT * FROM photos WHERE photo_id = ?1",
             params![photo_id],
-            row_to_photo,
+            row_to_photo_with_palette,
         );
 
         match result {
@@ -545,6 +721,153 @@ impl Database {
         Ok(rows > 0)
     }
 
+    /// 保存 ThumbHash 占位图（同一文件哈希的所有照片共享）
+    ///
+    /// 已有占位图的照片不会被覆盖，避免每个尺寸的缩略图生成都触发写入。
+    pub fn set_thumbhash(&self, file_hash: &str, thumbhash: &[u8]) -> AppResult<usize> {
+        let conn = self.connection()?;
+        let rows = conn.execute(
+            "UPDATE photos SET thumbhash = ?1 WHERE file_hash = ?2 AND thumbhash IS NULL",
+            params![thumbhash, file_hash],
+        )?;
+        Ok(rows)
+    }
+
+    /// 保存感知哈希（同一文件哈希的所有照片共享，已有时不覆盖）
+    pub fn set_perceptual_hash(&self, file_hash: &str, hash: &PerceptualHash) -> AppResult<usize> {
+        let conn = self.connection()?;
+        let rows = conn.execute(
+            "UPDATE photos SET dhash = ?1, phash = ?2 WHERE file_hash = ?3 AND phash IS NULL",
+            params![hash.dhash as i64, hash.phash as i64, file_hash],
+        )?;
+        Ok(rows)
+    }
+
+    /// 保存图像质量评分（已有评分时不覆盖，返回更新的行数）
+    pub fn set_quality_scores(&self, file_hash: &str, scores: &QualityScores) -> AppResult<usize> {
+        let conn = self.connection()?;
+        let rows = conn.execute(
+            r#"
+            UPDATE photos SET sharpness = ?1, highlight_clip = ?2, shadow_clip = ?3, noise = ?4
+            WHERE file_hash = ?5 AND sharpness IS NULL
+            "#,
+            params![
+                scores.sharpness,
+                scores.highlight_clip,
+                scores.shadow_clip,
+                scores.noise,
+                file_hash
+            ],
+        )?;
+        Ok(rows)
+    }
+
+    /// 保存打包的颜色签名（已有签名时不覆盖，返回更新的行数）
+    pub fn set_color_signature(&self, file_hash: &str, signature: &[u8]) -> AppResult<usize> {
+        let conn = self.connection()?;
+        let rows = conn.execute(
+            "UPDATE photos SET color_signature = ?1 WHERE file_hash = ?2 AND color_signature IS NULL",
+            params![signature, file_hash],
+        )?;
+        Ok(rows)
+    }
+
+    /// 获取所有未删除照片的打包颜色签名（用于加载颜色索引）
+    pub fn get_color_signatures(&self) -> AppResult<Vec<(i64, Vec<u8>)>> {
+        let conn = self.connection()?;
+
+        let mut stmt = conn.prepare(
+            "SELECT photo_id, color_signature FROM photos WHERE color_signature IS NOT NULL AND is_deleted = 0",
+        )?;
+
+        let signatures = stmt
+            .query_map([], |row| Ok((row.get(0)?, row.get(1)?)))?
+            .collect::<Result<Vec<_>, _>>()?;
+
+        Ok(signatures)
+    }
+
+    /// 获取未删除照片的颜色签名
+    pub fn get_color_signature(&self, photo_id: i64) -> AppResult<Option<ColorSignature>> {
+        let conn = self.connection()?;
+
+        let result = conn.query_row(
+            "SELECT color_signature FROM photos WHERE photo_id = ?1 AND is_deleted = 0",
+            params![photo_id],
+            |row| row.get::<_, Option<Vec<u8>>>(0),
+        );
+
+        match result {
+            Ok(bytes) => Ok(bytes.and_then(|b| ColorSignature::from_bytes(&b))),
+            Err(rusqlite::Error::QueryReturnedNoRows) => Ok(None),
+            Err(e) => Err(AppError::Database(e)),
+        }
+    }
+
+    /// 获取所有待 OCR 的未删除照片 (photo_id, file_path)，按添加时间倒序
+    pub fn get_pending_ocr_paths(&self) -> AppResult<Vec<(i64, String)>> {
+        let conn = self.connection()?;
+
+        let mut stmt = conn.prepare(
+            "SELECT photo_id, file_path FROM photos WHERE is_deleted = 0 AND ocr_status = 0 ORDER BY date_added DESC",
+        )?;
+
+        let paths = stmt
+            .query_map([], |row| Ok((row.get(0)?, row.get(1)?)))?
+            .collect::<Result<Vec<_>, _>>()?;
+
+        Ok(paths)
+    }
+
+    /// 写入 OCR 结果（文字同步进入全文索引）
+    pub fn update_photo_ocr(&self, photo_id: i64, ocr_text: Option<&str>, status: i32) -> AppResult<bool> {
+        let conn = self.connection()?;
+        let now = crate::models::photo::chrono_now_pub();
+
+        let rows = conn.execute(
+            "UPDATE photos SET ocr_text = ?1, ocr_status = ?2, ocr_processed_at = ?3 WHERE photo_id = ?4",
+            params![ocr_text, status, now, photo_id],
+        )?;
+
+        Ok(rows > 0)
+    }
+
+    /// 获取所有未删除照片的感知哈希（用于加载近似重复索引）
+    pub fn get_perceptual_hashes(&self) -> AppResult<Vec<(i64, PerceptualHash)>> {
+        let conn = self.connection()?;
+
+        let mut stmt = conn.prepare(
+            "SELECT photo_id, dhash, phash FROM photos WHERE phash IS NOT NULL AND dhash IS NOT NULL AND is_deleted = 0",
+        )?;
+
+        let hashes = stmt
+            .query_map([], |row| {
+                Ok((
+                    row.get::<_, i64>(0)?,
+                    PerceptualHash {
+                        dhash: row.get::<_, i64>(1)? as u64,
+                        phash: row.get::<_, i64>(2)? as u64,
+                    },
+                ))
+            })?
+            .collect::<Result<Vec<_>, _>>()?;
+
+        Ok(hashes)
+    }
+
+    /// 根据文件哈希获取未删除照片的 ID
+    pub fn get_photo_ids_by_file_hash(&self, file_hash: &str) -> AppResult<Vec<i64>> {
+        let conn = self.connection()?;
+
+        let mut stmt = conn.prepare("SELECT photo_id FROM photos WHERE file_hash = ?1 AND is_deleted = 0")?;
+
+        let ids = stmt
+            .query_map(params![file_hash], |row| row.get(0))?
+            .collect::<Result<Vec<i64>, _>>()?;
+
+        Ok(ids)
+    }
+
     /// 检查文件路径是否存在
     pub fn photo_exists_by_path(&self, file_path: &str) -> AppResult<bool> {
         let conn = self.connection()?;
@@ -578,129 +901,7 @@ impl Database {
     ) -> AppResult<PaginatedResult<Photo>> {
         let conn = self.connection()?;
 
-        let mut where_clauses: Vec<String> = Vec::new();
-        let mut params_vec: Vec<Box<dyn rusqlite::ToSql>> = Vec::new();
-
-        // 回收站过滤
-        if filters.in_trash == Some(true) {
-            where_clauses.push("is_deleted = 1".to_string());
-        } else {
-            where_clauses.push("is_deleted = 0".to_string());
-        }
-
-        // 全文搜索查询
-        if let Some(ref query) = filters.query {
-            if !query.trim().is_empty() {
-                where_clauses.push(
-                    "photo_id IN (SELECT rowid FROM photos_fts WHERE photos_fts MATCH ?)".to_string()
-                );
-                // 为 FTS5 转义特殊字符，并添加前缀匹配
-                let fts_query = format!("{}*", query.replace('"', "\"\""));
-                params_vec.push(Box::new(fts_query));
-            }
-        }
-
-        // 日期范围过滤
-        if let Some(ref date_from) = filters.date_from {
-            where_clauses.push("date_taken >= ?".to_string());
-            params_vec.push(Box::new(date_from.clone()));
-        }
-        if let Some(ref date_to) = filters.date_to {
-            where_clauses.push("date_taken <= ?".to_string());
-            params_vec.push(Box::new(date_to.clone()));
-        }
-
-        // 相机型号过滤
-        if let Some(ref camera_model) = filters.camera_model {
-            where_clauses.push("camera_model LIKE ?".to_string());
-            params_vec.push(Box::new(format!("%{}%", camera_model)));
-        }
-
-        // 镜头型号过滤
-        if let Some(ref lens_model) = filters.lens_model {
-            where_clauses.push("lens_model LIKE ?".to_string());
-            params_vec.push(Box::new(format!("%{}%", lens_model)));
-        }
-
-        // 评分过滤
-        if let Some(min_rating) = filters.min_rating {
-            where_clauses.push("rating >= ?".to_string());
-            params_vec.push(Box::new(min_rating));
-        }
-        if let Some(max_rating) = filters.max_rating {
-            where_clauses.push("rating <= ?".to_string());
-            params_vec.push(Box::new(max_rating));
-        }
-
-        // 收藏过滤
-        if filters.favorites_only == Some(true) {
-            where_clauses.push("is_favorite = 1".to_string());
-        }
-
-        // GPS 过滤
-        if filters.has_gps == Some(true) {
-            where_clauses.push("gps_latitude IS NOT NULL AND gps_longitude IS NOT NULL".to_string());
-        }
-
-        // 文件扩展名过滤（使用 format 字段）
-        if let Some(ref extensions) = filters.file_extensions {
-            if !extensions.is_empty() {
-                let placeholders: Vec<String> = extensions.iter().map(|_| "?".to_string()).collect();
-                where_clauses.push(format!(
-                    "LOWER(format) IN ({})",
-                    placeholders.join(", ")
-                ));
-                for ext in extensions {
-                    params_vec.push(Box::new(ext.to_lowercase()));
-                }
-            }
-        }
-
-        // 标签过滤
-        if let Some(ref tag_ids) = filters.tag_ids {
-            if !tag_ids.is_empty() {
-                let placeholders: Vec<String> = tag_ids.iter().map(|_| "?".to_string()).collect();
-                where_clauses.push(format!(
-                    "photo_id IN (SELECT DISTINCT photo_id FROM photo_tags WHERE tag_id IN ({}))",
-                    placeholders.join(", ")
-                ));
-                for tag_id in tag_ids {
-                    params_vec.push(Box::new(*tag_id));
-                }
-            }
-        }
-
-        // 相册过滤
-        if let Some(album_id) = filters.album_id {
-            where_clauses.push(
-                "photo_id IN (SELECT photo_id FROM album_photos WHERE album_id = ?)".to_string()
-            );
-            params_vec.push(Box::new(album_id));
-        }
-
-        // 文件夹过滤
-        if let Some(ref folder_path) = filters.folder_path {
-            let include_subfolders = filters.include_subfolders.unwrap_or(true);
-            if include_subfolders {
-                let pattern = if folder_path.ends_with('\\') || folder_path.ends_with('/') {
-                    format!("{}%", folder_path)
-                } else {
-                    format!("{}\\%", folder_path)
-                };
-                where_clauses.push("file_path LIKE ?".to_string());
-                params_vec.push(Box::new(pattern));
-            } else {
-                where_clauses.push(
-                    r#"(substr(file_path, 1, length(file_path) - length(file_name) - 1) = ?
-                        OR substr(file_path, 1, length(file_path) - length(file_name) - 1) = ? || '\'
-                        OR substr(file_path, 1, length(file_path) - length(file_name) - 1) = ? || '/')"#
-                        .to_string(),
-                );
-                params_vec.push(Box::new(folder_path.clone()));
-                params_vec.push(Box::new(folder_path.clone()));
-                params_vec.push(Box::new(folder_path.clone()));
-            }
-        }
+        let (where_clauses, mut params_vec) = build_search_conditions(filters);
 
         // 构建 WHERE 子句
         let where_sql = format!("WHERE {}", where_clauses.join(" AND "));
@@ -753,131 +954,7 @@ impl Database {
     ) -> AppResult<(Vec<Photo>, Option<i64>)> {
         let conn = self.connection()?;
 
-        let mut base_where_clauses: Vec<String> = Vec::new();
-        let mut base_params_vec: Vec<Box<dyn rusqlite::ToSql>> = Vec::new();
-
-        // 回收站过滤
-        if filters.in_trash == Some(true) {
-            base_where_clauses.push("is_deleted = 1".to_string());
-        } else {
-            base_where_clauses.push("is_deleted = 0".to_string());
-        }
-
-        // 全文搜索查询
-        if let Some(ref query) = filters.query {
-            if !query.trim().is_empty() {
-                base_where_clauses.push(
-                    "photo_id IN (SELECT rowid FROM photos_fts WHERE photos_fts MATCH ?)".to_string(),
-                );
-                // 为 FTS5 转义特殊字符，并添加前缀匹配
-                let fts_query = format!("{}*", query.replace('\"', "\"\""));
-                base_params_vec.push(Box::new(fts_query));
-            }
-        }
-
-        // 日期范围过滤
-        if let Some(ref date_from) = filters.date_from {
-            base_where_clauses.push("date_taken >= ?".to_string());
-            base_params_vec.push(Box::new(date_from.clone()));
-        }
-        if let Some(ref date_to) = filters.date_to {
-            base_where_clauses.push("date_taken <= ?".to_string());
-            base_params_vec.push(Box::new(date_to.clone()));
-        }
-
-        // 相机型号过滤
-        if let Some(ref camera_model) = filters.camera_model {
-            base_where_clauses.push("camera_model LIKE ?".to_string());
-            base_params_vec.push(Box::new(format!("%{}%", camera_model)));
-        }
-
-        // 镜头型号过滤
-        if let Some(ref lens_model) = filters.lens_model {
-            base_where_clauses.push("lens_model LIKE ?".to_string());
-            base_params_vec.push(Box::new(format!("%{}%", lens_model)));
-        }
-
-        // 评分过滤
-        if let Some(min_rating) = filters.min_rating {
-            base_where_clauses.push("rating >= ?".to_string());
-            base_params_vec.push(Box::new(min_rating));
-        }
-        if let Some(max_rating) = filters.max_rating {
-            base_where_clauses.push("rating <= ?".to_string());
-            base_params_vec.push(Box::new(max_rating));
-        }
-
-        // 收藏过滤
-        if filters.favorites_only == Some(true) {
-            base_where_clauses.push("is_favorite = 1".to_string());
-        }
-
-        // GPS 过滤
-        if filters.has_gps == Some(true) {
-            base_where_clauses.push(
-                "gps_latitude IS NOT NULL AND gps_longitude IS NOT NULL".to_string(),
-            );
-        }
-
-        // 文件扩展名过滤（使用 format 字段）
-        if let Some(ref extensions) = filters.file_extensions {
-            if !extensions.is_empty() {
-                let placeholders: Vec<String> = extensions.iter().map(|_| "?".to_string()).collect();
-                base_where_clauses.push(format!(
-                    "LOWER(format) IN ({})",
-                    placeholders.join(", ")
-                ));
-                for ext in extensions {
-                    base_params_vec.push(Box::new(ext.to_lowercase()));
-                }
-            }
-        }
-
-        // 标签过滤
-        if let Some(ref tag_ids) = filters.tag_ids {
-            if !tag_ids.is_empty() {
-                let placeholders: Vec<String> = tag_ids.iter().map(|_| "?".to_string()).collect();
-                base_where_clauses.push(format!(
-                    "photo_id IN (SELECT DISTINCT photo_id FROM photo_tags WHERE tag_id IN ({}))",
-                    placeholders.join(", ")
-                ));
-                for tag_id in tag_ids {
-                    base_params_vec.push(Box::new(*tag_id));
-                }
-            }
-        }
-
-        // 相册过滤
-        if let Some(album_id) = filters.album_id {
-            base_where_clauses.push(
-                "photo_id IN (SELECT photo_id FROM album_photos WHERE album_id = ?)".to_string(),
-            );
-            base_params_vec.push(Box::new(album_id));
-        }
-
-        // 文件夹过滤
-        if let Some(ref folder_path) = filters.folder_path {
-            let include_subfolders = filters.include_subfolders.unwrap_or(true);
-            if include_subfolders {
-                let pattern = if folder_path.ends_with('\\') || folder_path.ends_with('/') {
-                    format!("{}%", folder_path)
-                } else {
-                    format!("{}\\%", folder_path)
-                };
-                base_where_clauses.push("file_path LIKE ?".to_string());
-                base_params_vec.push(Box::new(pattern));
-            } else {
-                base_where_clauses.push(
-                    r#"(substr(file_path, 1, length(file_path) - length(file_name) - 1) = ?
-                        OR substr(file_path, 1, length(file_path) - length(file_name) - 1) = ? || '\'
-                        OR substr(file_path, 1, length(file_path) - length(file_name) - 1) = ? || '/')"#
-                        .to_string(),
-                );
-                base_params_vec.push(Box::new(folder_path.clone()));
-                base_params_vec.push(Box::new(folder_path.clone()));
-                base_params_vec.push(Box::new(folder_path.clone()));
-            }
-        }
+        let (base_where_clauses, base_params_vec) = build_search_conditions(filters);
 
         let base_where_sql = format!("WHERE {}", base_where_clauses.join(" AND "));
 
@@ -925,6 +1002,44 @@ impl Database {
         Ok((photos, total))
     }
 
+    /// 流式遍历符合过滤条件的照片
+    ///
+    /// 在独立的只读连接上执行一次查询，逐行回调 `f`，
+    /// 回调返回 `false` 时提前结束。遍历期间持有同一个读快照。
+    pub fn for_each_photo<F>(
+        &self,
+        filters: &SearchFilters,
+        sort: &PhotoSortOptions,
+        mut f: F,
+    ) -> AppResult<()>
+    where
+        F: FnMut(Photo) -> bool,
+    {
+        let conn = self.open_reader()?;
+
+        let (where_clauses, params_vec) = build_search_conditions(filters);
+        let sql = format!(
+            "SELECT * FROM photos WHERE {} ORDER BY {} {} NULLS LAST, photo_id {}",
+            where_clauses.join(" AND "),
+            sort.field.as_column(),
+            sort.order.as_sql(),
+            sort.order.as_sql()
+        );
+
+        let params_refs: Vec<&dyn rusqlite::ToSql> =
+            params_vec.iter().map(|p| p.as_ref()).collect();
+        let mut stmt = conn.prepare(&sql)?;
+        let mut rows = stmt.query(params_refs.as_slice())?;
+
+        while let Some(row) = rows.next()? {
+            if !f(row_to_photo(row)?) {
+                break;
+            }
+        }
+
+        Ok(())
+    }
+
     /// 简单文本搜索（不使用 FTS）
     pub fn search_photos_simple(
         &self,
@@ -1554,6 +1669,141 @@ mod tests {
         assert!(retrieved.is_favorite);
     }
 
+    #[test]
+    fn test_set_thumbhash() {
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+
+        let id = db.create_photo(&create_test_photo("test.jpg")).unwrap();
+        assert!(db.get_photo(id).unwrap().unwrap().thumbhash.is_none());
+
+        assert_eq!(db.set_thumbhash("hash_test.jpg", &[1, 2, 3]).unwrap(), 1);
+        // 已有占位图时不覆盖
+        assert_eq!(db.set_thumbhash("hash_test.jpg", &[4, 5, 6]).unwrap(), 0);
+
+        let photo = db.get_photo(id).unwrap().unwrap();
+        assert_eq!(photo.thumbhash, Some(vec![1, 2, 3]));
+        let json = serde_json::to_value(&photo).unwrap();
+        assert_eq!(json["thumbhash"], "AQID");
+    }
+
+    #[test]
+    fn test_set_perceptual_hash() {
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+
+        let id = db.create_photo(&create_test_photo("test.jpg")).unwrap();
+        let hash = PerceptualHash {
+            dhash: 0x8000_0000_0000_0001,
+            phash: u64::MAX,
+        };
+
+        assert_eq!(db.set_perceptual_hash("hash_test.jpg", &hash).unwrap(), 1);
+        assert_eq!(db.set_perceptual_hash("hash_test.jpg", &PerceptualHash { dhash: 1, phash: 2 }).unwrap(), 0);
+        assert_eq!(db.get_perceptual_hashes().unwrap(), vec![(id, hash)]);
+        assert_eq!(db.get_photo_ids_by_file_hash("hash_test.jpg").unwrap(), vec![id]);
+
+        // 最高位为 1 的哈希经 i64 存取后不变
+        let photo = db.get_photo(id).unwrap().unwrap();
+        assert_eq!(photo.dhash, Some(hash.dhash));
+        assert_eq!(photo.phash, Some(hash.phash));
+        let json = serde_json::to_value(&photo).unwrap();
+        assert_eq!(json["dhash"], "8000000000000001");
+        assert_eq!(json["phash"], "ffffffffffffffff");
+    }
+
+    #[test]
+    fn test_quality_score_filters() {
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+
+        let sharp = db.create_photo(&create_test_photo("sharp.jpg")).unwrap();
+        let blurry = db.create_photo(&create_test_photo("blurry.jpg")).unwrap();
+        db.create_photo(&create_test_photo("unscored.jpg")).unwrap();
+
+        let scores = |sharpness, highlight_clip| QualityScores {
+            sharpness,
+            highlight_clip,
+            shadow_clip: 0.0,
+            noise: 2.0,
+        };
+        assert_eq!(db.set_quality_scores("hash_sharp.jpg", &scores(850.0, 0.02)).unwrap(), 1);
+        assert_eq!(db.set_quality_scores("hash_blurry.jpg", &scores(40.0, 0.0)).unwrap(), 1);
+        // 已有评分时不覆盖
+        assert_eq!(db.set_quality_scores("hash_sharp.jpg", &scores(1.0, 1.0)).unwrap(), 0);
+
+        let search = |filters: SearchFilters| -> Vec<i64> {
+            let (photos, _) = db
+                .search_photos_cursor(&filters, 10, None, &PhotoSortOptions::default(), false)
+                .unwrap();
+            let mut ids: Vec<i64> = photos.iter().map(|p| p.photo_id).collect();
+            ids.sort_unstable();
+            ids
+        };
+
+        assert_eq!(search(SearchFilters { min_sharpness: Some(100.0), ..Default::default() }), vec![sharp]);
+        assert_eq!(search(SearchFilters { max_highlight_clip: Some(0.01), ..Default::default() }), vec![blurry]);
+        assert_eq!(search(SearchFilters { max_noise: Some(5.0), ..Default::default() }), vec![sharp, blurry]);
+        assert_eq!(search(SearchFilters::default()).len(), 3);
+
+        let photo = db.get_photo(sharp).unwrap().unwrap();
+        assert_eq!(photo.sharpness, Some(850.0));
+        assert_eq!(photo.highlight_clip, Some(0.02));
+    }
+
+    #[test]
+    fn test_color_signature_round_trip() {
+        use crate::utils::color_signature::{PaletteColor, EMBEDDING_DIM};
+
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+
+        let id = db.create_photo(&create_test_photo("test.jpg")).unwrap();
+        let signature = ColorSignature {
+            palette: vec![PaletteColor { rgb: [0x1e, 0x90, 0xff], weight: 0.6 }],
+            embedding: [7u8; EMBEDDING_DIM],
+        };
+
+        assert_eq!(db.set_color_signature("hash_test.jpg", &signature.to_bytes()).unwrap(), 1);
+        assert_eq!(db.set_color_signature("hash_test.jpg", &[1, 0]).unwrap(), 0);
+
+        assert_eq!(db.get_color_signatures().unwrap(), vec![(id, signature.to_bytes())]);
+        assert_eq!(db.get_color_signature(id).unwrap().unwrap().embedding, signature.embedding);
+
+        let photo = db.get_photo(id).unwrap().unwrap();
+        assert_eq!(photo.palette, Some(vec!["#1e90ff".to_string()]));
+        // 列表查询不解码调色板
+        let by_hash = db.get_photo_by_hash("hash_test.jpg").unwrap().unwrap();
+        assert_eq!(by_hash.palette, None);
+
+        db.soft_delete_photos(&[id]).unwrap();
+        assert!(db.get_color_signature(id).unwrap().is_none());
+        assert!(db.get_color_signatures().unwrap().is_empty());
+    }
+
+    #[test]
+    fn test_ocr_text_is_searchable() {
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+
+        let receipt = db.create_photo(&create_test_photo("receipt.jpg")).unwrap();
+        let blank = db.create_photo(&create_test_photo("blank.jpg")).unwrap();
+        assert_eq!(db.get_pending_ocr_paths().unwrap().len(), 2);
+
+        assert!(db.update_photo_ocr(receipt, Some("Invoice 2024 total"), 1).unwrap());
+        assert!(db.update_photo_ocr(blank, None, 3).unwrap());
+        assert!(db.get_pending_ocr_paths().unwrap().is_empty());
+
+        let filters = SearchFilters {
+            query: Some("invoice".to_string()),
+            ..Default::default()
+        };
+        let (photos, _) = db
+            .search_photos_cursor(&filters, 10, None, &PhotoSortOptions::default(), false)
+            .unwrap();
+        assert_eq!(photos.iter().map(|p| p.photo_id).collect::<Vec<_>>(), vec![receipt]);
+    }
+
     #[test]
     fn test_delete_photo() {
         let db = Database::open_in_memory().unwrap();
@@ -1590,6 +1840,34 @@ mod tests {
         assert_eq!(result.total_pages, 2);
     }
 
+    #[test]
+    fn test_for_each_photo_streams_in_sort_order() {
+        let tmp = tempfile::TempDir::new().unwrap();
+        let db = Database::open(tmp.path().join("photowall.db")).unwrap();
+        db.init().unwrap();
+
+        let photos: Vec<CreatePhoto> = (0..25)
+            .map(|i| create_test_photo(&format!("photo_{:02}.jpg", i)))
+            .collect();
+        db.create_photos_batch(&photos).unwrap();
+
+        let sort = PhotoSortOptions {
+            field: PhotoSortField::FileName,
+            order: SortOrder::Asc,
+        };
+
+        let mut names = Vec::new();
+        db.for_each_photo(&SearchFilters::default(), &sort, |photo| {
+            names.push(photo.file_name);
+            names.len() < 20
+        })
+        .unwrap();
+
+        assert_eq!(names.len(), 20);
+        assert_eq!(names[0], "photo_00.jpg");
+        assert_eq!(names[19], "photo_19.jpg");
+    }
+
     #[test]
     fn test_favorite_photos() {
         let db = Database::open_in_memory().unwrap();
@@ -0,0 +1,331 @@
+//! 扫描日志数据访问层
+//!
+//! 记录每个目录的修改时间以及其中每个条目的 (设备号, inode, 大小, 修改时间)，
+//! 重新扫描时据此跳过未变化的目录和文件。
+
+use std::collections::HashMap;
+use std::path::MAIN_SEPARATOR;
+
+use rusqlite::{params, Connection, Row};
+
+use crate::utils::error::{AppError, AppResult};
+
+use super::connection::Database;
+
+/// 文件系统戳记
+///
+/// 四项全部相同即视为文件未变化。Windows 上标准库拿不到稳定的文件 ID，
+/// 设备号和 inode 记为 0，仅比较大小与修改时间。
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub struct FileStamp {
+    pub device: i64,
+    pub inode: i64,
+    pub size: i64,
+    /// 修改时间（Unix 纳秒）
+    pub mtime_ns: i64,
+}
+
+impl FileStamp {
+    /// 从文件元数据生成戳记
+    pub fn from_metadata(metadata: &std::fs::Metadata) -> Self {
+        let mtime_ns = metadata
+            .modified()
+            .ok()
+            .and_then(|t| t.duration_since(std::time::UNIX_EPOCH).ok())
+            .map(|d| d.as_nanos() as i64)
+            .unwrap_or(0);
+
+        #[cfg(unix)]
+        let (device, inode) = {
+            use std::os::unix::fs::MetadataExt;
+            (metadata.dev() as i64, metadata.ino() as i64)
+        };
+        #[cfg(not(unix))]
+        let (device, inode) = (0i64, 0i64);
+
+        Self {
+            device,
+            inode,
+            size: metadata.len() as i64,
+            mtime_ns,
+        }
+    }
+}
+
+/// 日志中的一个条目（图片文件或子目录）
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct JournalEntry {
+    pub file_path: String,
+    pub dir_path: String,
+    pub is_dir: bool,
+    pub stamp: FileStamp,
+}
+
+/// 目录级日志
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct JournalDir {
+    pub dir_path: String,
+    /// 读取目录前记录的修改时间（Unix 纳秒），0 表示不可信，下次扫描必定重新读取
+    pub mtime_ns: i64,
+    /// 目录中已入日志的图片文件数
+    pub file_count: i64,
+}
+
+/// 一次扫描后需要回写的目录快照
+#[derive(Debug, Clone)]
+pub struct JournalDirSnapshot {
+    pub dir: JournalDir,
+    /// 当前的全部子目录
+    pub subdirs: Vec<JournalEntry>,
+    /// 日志中有、磁盘上已不存在的条目
+    pub removed: Vec<JournalEntry>,
+}
+
+/// 从数据库行映射到 JournalEntry
+fn row_to_entry(row: &Row<'_>) -> rusqlite::Result<JournalEntry> {
+    Ok(JournalEntry {
+        file_path: row.get("file_path")?,
+        dir_path: row.get("dir_path")?,
+        is_dir: row.get::<_, i32>("is_dir")? != 0,
+        stamp: FileStamp {
+            device: row.get("device")?,
+            inode: row.get("inode")?,
+            size: row.get("file_size")?,
+            mtime_ns: row.get("mtime_ns")?,
+        },
+    })
+}
+
+/// 写入或更新条目
+fn upsert_entries(conn: &Connection, entries: &[JournalEntry]) -> AppResult<()> {
+    let mut stmt = conn.prepare(
+        r#"
+        INSERT INTO scan_journal_entries (file_path, dir_path, is_dir, device, inode, file_size, mtime_ns)
+        VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)
+        ON CONFLICT(file_path) DO UPDATE SET
+            dir_path = ?2,
+            is_dir = ?3,
+            device = ?4,
+            inode = ?5,
+            file_size = ?6,
+            mtime_ns = ?7
+        "#,
+    )?;
+
+    for entry in entries {
+        stmt.execute(params![
+            entry.file_path,
+            entry.dir_path,
+            entry.is_dir as i32,
+            entry.stamp.device,
+            entry.stamp.inode,
+            entry.stamp.size,
+            entry.stamp.mtime_ns,
+        ])?;
+    }
+
+    Ok(())
+}
+
+impl Database {
+    /// 获取目录级日志
+    pub fn get_journal_dir(&self, dir_path: &str) -> AppResult<Option<JournalDir>> {
+        let conn = self.connection()?;
+
+        let result = conn.query_row(
+            "SELECT dir_path, mtime_ns, file_count FROM scan_journal_dirs WHERE dir_path = ?1",
+            params![dir_path],
+            |row| {
+                Ok(JournalDir {
+                    dir_path: row.get(0)?,
+                    mtime_ns: row.get(1)?,
+                    file_count: row.get(2)?,
+                })
+            },
+        );
+
+        match result {
+            Ok(dir) => Ok(Some(dir)),
+            Err(rusqlite::Error::QueryReturnedNoRows) => Ok(None),
+            Err(e) => Err(AppError::Database(e)),
+        }
+    }
+
+    /// 获取目录下已记录的子目录路径
+    pub fn get_journal_subdirs(&self, dir_path: &str) -> AppResult<Vec<String>> {
+        let conn = self.connection()?;
+
+        let mut stmt = conn.prepare(
+            "SELECT file_path FROM scan_journal_entries WHERE dir_path = ?1 AND is_dir = 1",
+        )?;
+
+        let subdirs = stmt
+            .query_map(params![dir_path], |row| row.get(0))?
+            .collect::<Result<Vec<String>, _>>()?;
+
+        Ok(subdirs)
+    }
+
+    /// 获取目录下的全部日志条目，按路径索引
+    pub fn get_journal_entries(&self, dir_path: &str) -> AppResult<HashMap<String, JournalEntry>> {
+        let conn = self.connection()?;
+
+        let mut stmt = conn.prepare("SELECT * FROM scan_journal_entries WHERE dir_path = ?1")?;
+
+        let entries = stmt
+            .query_map(params![dir_path], row_to_entry)?
+            .map(|r| r.map(|e| (e.file_path.clone(), e)))
+            .collect::<Result<HashMap<_, _>, _>>()?;
+
+        Ok(entries)
+    }
+
+    /// 批量写入已处理文件的日志条目
+    pub fn upsert_journal_entries(&self, entries: &[JournalEntry]) -> AppResult<()> {
+        if entries.is_empty() {
+            return Ok(());
+        }
+        self.transaction(|conn| upsert_entries(conn, entries))
+    }
+
+    /// 回写一个目录的扫描结果
+    ///
+    /// 删除已消失的条目（消失的子目录连同其整棵子树），记录子目录；
+    /// 只有 `complete` 为 true（目录中所有文件均已处理成功）时才写入目录修改时间，
+    /// 否则下次扫描仍会重新读取该目录。
+    pub fn commit_journal_dir(&self, snapshot: &JournalDirSnapshot, complete: bool) -> AppResult<()> {
+        self.transaction(|conn| {
+            for entry in &snapshot.removed {
+                conn.execute(
+                    "DELETE FROM scan_journal_entries WHERE file_path = ?1",
+                    params![entry.file_path],
+                )?;
+
+                if entry.is_dir {
+                    // 用 substr 比较前缀，路径中的 _ 和 % 不会被当作 LIKE 通配符
+                    let prefix = format!("{}{}", entry.file_path, MAIN_SEPARATOR);
+                    conn.execute(
+                        r#"
+                        DELETE FROM scan_journal_entries
+                        WHERE dir_path = ?1 OR substr(dir_path, 1, length(?2)) = ?2
+                        "#,
+                        params![entry.file_path, prefix],
+                    )?;
+                    conn.execute(
+                        r#"
+                        DELETE FROM scan_journal_dirs
+                        WHERE dir_path = ?1 OR substr(dir_path, 1, length(?2)) = ?2
+                        "#,
+                        params![entry.file_path, prefix],
+                    )?;
+                }
+            }
+
+            upsert_entries(conn, &snapshot.subdirs)?;
+
+            if complete {
+                let dir = &snapshot.dir;
+                conn.execute(
+                    r#"
+                    INSERT INTO scan_journal_dirs (dir_path, mtime_ns, file_count)
+                    VALUES (?1, ?2, ?3)
+                    ON CONFLICT(dir_path) DO UPDATE SET
+                        mtime_ns = ?2,
+                        file_count = ?3
+                    "#,
+                    params![dir.dir_path, dir.mtime_ns, dir.file_count],
+                )?;
+            }
+
+            Ok(())
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn setup_db() -> Database {
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+        db
+    }
+
+    fn entry(file_path: &str, dir_path: &str, is_dir: bool, size: i64) -> JournalEntry {
+        JournalEntry {
+            file_path: file_path.to_string(),
+            dir_path: dir_path.to_string(),
+            is_dir,
+            stamp: FileStamp {
+                device: 1,
+                inode: size,
+                size,
+                mtime_ns: 1_000,
+            },
+        }
+    }
+
+    fn snapshot(dir_path: &str, subdirs: Vec<JournalEntry>, removed: Vec<JournalEntry>) -> JournalDirSnapshot {
+        JournalDirSnapshot {
+            dir: JournalDir {
+                dir_path: dir_path.to_string(),
+                mtime_ns: 42,
+                file_count: 1,
+            },
+            subdirs,
+            removed,
+        }
+    }
+
+    #[test]
+    fn test_commit_and_read_back() {
+        let db = setup_db();
+        let sep = MAIN_SEPARATOR;
+        let root = format!("{sep}lib");
+        let sub = format!("{root}{sep}a_1");
+
+        db.upsert_journal_entries(&[entry(&format!("{root}{sep}x.jpg"), &root, false, 10)])
+            .unwrap();
+        db.commit_journal_dir(&snapshot(&root, vec![entry(&sub, &root, true, 0)], vec![]), true)
+            .unwrap();
+
+        let dir = db.get_journal_dir(&root).unwrap().unwrap();
+        assert_eq!(dir.mtime_ns, 42);
+        assert_eq!(db.get_journal_subdirs(&root).unwrap(), vec![sub.clone()]);
+        assert_eq!(db.get_journal_entries(&root).unwrap().len(), 2);
+
+        // 未完成的目录不写入修改时间
+        db.commit_journal_dir(&snapshot(&sub, vec![], vec![]), false).unwrap();
+        assert!(db.get_journal_dir(&sub).unwrap().is_none());
+    }
+
+    #[test]
+    fn test_removed_subdir_prunes_subtree() {
+        let db = setup_db();
+        let sep = MAIN_SEPARATOR;
+        let root = format!("{sep}lib");
+        let sub = format!("{root}{sep}a_1");
+        let deep = format!("{sub}{sep}b");
+        // 与 a_1 前缀相同但不在其子树下
+        let sibling = format!("{root}{sep}a_10");
+
+        db.upsert_journal_entries(&[
+            entry(&format!("{sub}{sep}1.jpg"), &sub, false, 1),
+            entry(&format!("{deep}{sep}2.jpg"), &deep, false, 2),
+            entry(&format!("{sibling}{sep}3.jpg"), &sibling, false, 3),
+        ])
+        .unwrap();
+        db.commit_journal_dir(&snapshot(&deep, vec![], vec![]), true).unwrap();
+        db.commit_journal_dir(&snapshot(&sibling, vec![], vec![]), true).unwrap();
+
+        db.commit_journal_dir(&snapshot(&root, vec![], vec![entry(&sub, &root, true, 0)]), true)
+            .unwrap();
+
+        assert!(db.get_journal_entries(&sub).unwrap().is_empty());
+        assert!(db.get_journal_entries(&deep).unwrap().is_empty());
+        assert!(db.get_journal_dir(&deep).unwrap().is_none());
+        assert_eq!(db.get_journal_entries(&sibling).unwrap().len(), 1);
+        assert!(db.get_journal_dir(&sibling).unwrap().is_some());
+    }
+}
@@ -3,7 +3,7 @@
 //! 包含所有表的 CREATE 语句和迁移脚本
 
 /// 数据库版本
-pub const SCHEMA_VERSION: i32 = 4;
+pub const SCHEMA_VERSION: i32 = 10;
 
 /// 初始化 Schema SQL
 pub const INIT_SCHEMA: &str = r#"
@@ -32,7 +32,18 @@ CREATE TABLE IF NOT EXISTS photos (
     rating          INTEGER DEFAULT 0 CHECK(rating >= 0 AND rating <= 5),
     is_favorite     INTEGER DEFAULT 0,
     is_deleted      INTEGER DEFAULT 0,
-    deleted_at      TEXT
+    deleted_at      TEXT,
+    thumbhash       BLOB,
+    dhash           INTEGER,
+    phash           INTEGER,
+    sharpness       REAL,
+    highlight_clip  REAL,
+    shadow_clip     REAL,
+    noise           REAL,
+    color_signature BLOB,
+    ocr_text        TEXT,
+    ocr_status      INTEGER DEFAULT 0,
+    ocr_processed_at TEXT
 );
 
 -- 标签表
@@ -78,6 +89,24 @@ CREATE TABLE IF NOT EXISTS scan_directories (
     is_active       INTEGER DEFAULT 1
 );
 
+-- 扫描日志：目录修改时间
+CREATE TABLE IF NOT EXISTS scan_journal_dirs (
+    dir_path        TEXT PRIMARY KEY,
+    mtime_ns        INTEGER NOT NULL,
+    file_count      INTEGER NOT NULL DEFAULT 0
+);
+
+-- 扫描日志：目录中的图片文件与子目录戳记
+CREATE TABLE IF NOT EXISTS scan_journal_entries (
+    file_path       TEXT PRIMARY KEY,
+    dir_path        TEXT NOT NULL,
+    is_dir          INTEGER NOT NULL DEFAULT 0,
+    device          INTEGER NOT NULL,
+    inode           INTEGER NOT NULL,
+    file_size       INTEGER NOT NULL,
+    mtime_ns        INTEGER NOT NULL
+);
+
 -- 数据库版本表
 CREATE TABLE IF NOT EXISTS schema_version (
     version         INTEGER PRIMARY KEY,
@@ -92,6 +121,7 @@ CREATE INDEX IF NOT EXISTS idx_photos_rating ON photos(rating);
 CREATE INDEX IF NOT EXISTS idx_photos_is_favorite ON photos(is_favorite);
 CREATE INDEX IF NOT EXISTS idx_photos_camera_model ON photos(camera_model);
 CREATE INDEX IF NOT EXISTS idx_photos_is_deleted ON photos(is_deleted);
+CREATE INDEX IF NOT EXISTS idx_photos_ocr_status ON photos(ocr_status);
 
 CREATE INDEX IF NOT EXISTS idx_tags_tag_name ON tags(tag_name);
 
@@ -102,6 +132,15 @@ CREATE INDEX IF NOT EXISTS idx_photo_tags_tag_id ON photo_tags(tag_id);
 
 CREATE INDEX IF NOT EXISTS idx_album_photos_album_id ON album_photos(album_id);
 CREATE INDEX IF NOT EXISTS idx_album_photos_photo_id ON album_photos(photo_id);
+
+CREATE INDEX IF NOT EXISTS idx_scan_journal_entries_dir ON scan_journal_entries(dir_path, is_dir);
+
+-- 触发器：照片被彻底删除后清除其扫描日志，下次扫描会重新发现该文件
+CREATE TRIGGER IF NOT EXISTS photos_scan_journal_delete AFTER DELETE ON photos BEGIN
+    DELETE FROM scan_journal_dirs
+    WHERE dir_path IN (SELECT dir_path FROM scan_journal_entries WHERE file_path = OLD.file_path);
+    DELETE FROM scan_journal_entries WHERE file_path = OLD.file_path;
+END;
 "#;
 
 /// 全文搜索表 Schema (FTS5)
@@ -112,28 +151,30 @@ CREATE VIRTUAL TABLE IF NOT EXISTS photos_fts USING fts5(
     file_path,
     camera_model,
     lens_model,
+    ocr_text,
     content='photos',
     content_rowid='photo_id'
 );
 
 -- 触发器：插入时同步 FTS
 CREATE TRIGGER IF NOT EXISTS photos_fts_insert AFTER INSERT ON photos BEGIN
-    INSERT INTO photos_fts(rowid, file_name, file_path, camera_model, lens_model)
-    VALUES (NEW.photo_id, NEW.file_name, NEW.file_path, NEW.camera_model, NEW.lens_model);
+    INSERT INTO photos_fts(rowid, file_name, file_path, camera_model, lens_model, ocr_text)
+    VALUES (NEW.photo_id, NEW.file_name, NEW.file_path, NEW.camera_model, NEW.lens_model, NEW.ocr_text);
 END;
 
 -- 触发器：删除时同步 FTS
 CREATE TRIGGER IF NOT EXISTS photos_fts_delete AFTER DELETE ON photos BEGIN
-    INSERT INTO photos_fts(photos_fts, rowid, file_name, file_path, camera_model, lens_model)
-    VALUES ('delete', OLD.photo_id, OLD.file_name, OLD.file_path, OLD.camera_model, OLD.lens_model);
+    INSERT INTO photos_fts(photos_fts, rowid, file_name, file_path, camera_model, lens_model, ocr_text)
+    VALUES ('delete', OLD.photo_id, OLD.file_name, OLD.file_path, OLD.camera_model, OLD.lens_model, OLD.ocr_text);
 END;
 
--- 触发器：更新时同步 FTS
-CREATE TRIGGER IF NOT EXISTS photos_fts_update AFTER UPDATE ON photos BEGIN
-    INSERT INTO photos_fts(photos_fts, rowid, file_name, file_path, camera_model, lens_model)
-    VALUES ('delete', OLD.photo_id, OLD.file_name, OLD.file_path, OLD.camera_model, OLD.lens_model);
-    INSERT INTO photos_fts(rowid, file_name, file_path, camera_model, lens_model)
-    VALUES (NEW.photo_id, NEW.file_name, NEW.file_path, NEW.camera_model, NEW.lens_model);
+-- 触发器：更新时同步 FTS（仅索引列变化时）
+CREATE TRIGGER IF NOT EXISTS photos_fts_update
+AFTER UPDATE OF file_name, file_path, camera_model, lens_model, ocr_text ON photos BEGIN
+    INSERT INTO photos_fts(photos_fts, rowid, file_name, file_path, camera_model, lens_model, ocr_text)
+    VALUES ('delete', OLD.photo_id, OLD.file_name, OLD.file_path, OLD.camera_model, OLD.lens_model, OLD.ocr_text);
+    INSERT INTO photos_fts(rowid, file_name, file_path, camera_model, lens_model, ocr_text)
+    VALUES (NEW.photo_id, NEW.file_name, NEW.file_path, NEW.camera_model, NEW.lens_model, NEW.ocr_text);
 END;
 "#;
 
@@ -175,4 +216,120 @@ pub const MIGRATIONS: &[Migration] = &[
             CREATE INDEX IF NOT EXISTS idx_scan_directories_next_scan ON scan_directories(next_scan_time);
         "#,
     },
+    Migration {
+        version: 5,
+        description: "Add thumbhash placeholder column to photos",
+        sql: r#"
+            ALTER TABLE photos ADD COLUMN thumbhash BLOB;
+
+            -- 只在全文索引列变化时同步 FTS，占位图等写入不再重建 FTS 行
+            DROP TRIGGER IF EXISTS photos_fts_update;
+            CREATE TRIGGER photos_fts_update
+            AFTER UPDATE OF file_name, file_path, camera_model, lens_model ON photos BEGIN
+                INSERT INTO photos_fts(photos_fts, rowid, file_name, file_path, camera_model, lens_model)
+                VALUES ('delete', OLD.photo_id, OLD.file_name, OLD.file_path, OLD.camera_model, OLD.lens_model);
+                INSERT INTO photos_fts(rowid, file_name, file_path, camera_model, lens_model)
+                VALUES (NEW.photo_id, NEW.file_name, NEW.file_path, NEW.camera_model, NEW.lens_model);
+            END;
+        "#,
+    },
+    Migration {
+        version: 6,
+        description: "Add scan journal for incremental rescans",
+        sql: r#"
+            CREATE TABLE IF NOT EXISTS scan_journal_dirs (
+                dir_path        TEXT PRIMARY KEY,
+                mtime_ns        INTEGER NOT NULL,
+                file_count      INTEGER NOT NULL DEFAULT 0
+            );
+
+            CREATE TABLE IF NOT EXISTS scan_journal_entries (
+                file_path       TEXT PRIMARY KEY,
+                dir_path        TEXT NOT NULL,
+                is_dir          INTEGER NOT NULL DEFAULT 0,
+                device          INTEGER NOT NULL,
+                inode           INTEGER NOT NULL,
+                file_size       INTEGER NOT NULL,
+                mtime_ns        INTEGER NOT NULL
+            );
+
+            CREATE INDEX IF NOT EXISTS idx_scan_journal_entries_dir ON scan_journal_entries(dir_path, is_dir);
+
+            CREATE TRIGGER IF NOT EXISTS photos_scan_journal_delete AFTER DELETE ON photos BEGIN
+                DELETE FROM scan_journal_dirs
+                WHERE dir_path IN (SELECT dir_path FROM scan_journal_entries WHERE file_path = OLD.file_path);
+                DELETE FROM scan_journal_entries WHERE file_path = OLD.file_path;
+            END;
+        "#,
+    },
+    Migration {
+        version: 7,
+        description: "Add perceptual hash columns to photos",
+        sql: r#"
+            ALTER TABLE photos ADD COLUMN dhash INTEGER;
+            ALTER TABLE photos ADD COLUMN phash INTEGER;
+        "#,
+    },
+    Migration {
+        version: 8,
+        description: "Add image quality score columns to photos",
+        sql: r#"
+            ALTER TABLE photos ADD COLUMN sharpness REAL;
+            ALTER TABLE photos ADD COLUMN highlight_clip REAL;
+            ALTER TABLE photos ADD COLUMN shadow_clip REAL;
+            ALTER TABLE photos ADD COLUMN noise REAL;
+        "#,
+    },
+    Migration {
+        version: 9,
+        description: "Add packed colour signature column to photos",
+        sql: r#"
+            ALTER TABLE photos ADD COLUMN color_signature BLOB;
+        "#,
+    },
+    Migration {
+        version: 10,
+        description: "Add OCR text columns and index ocr_text in FTS",
+        sql: r#"
+            ALTER TABLE photos ADD COLUMN ocr_text TEXT;
+            ALTER TABLE photos ADD COLUMN ocr_status INTEGER DEFAULT 0;
+            ALTER TABLE photos ADD COLUMN ocr_processed_at TEXT;
+            CREATE INDEX IF NOT EXISTS idx_photos_ocr_status ON photos(ocr_status);
+
+            -- 重建 FTS 表以加入 ocr_text 列
+            DROP TRIGGER IF EXISTS photos_fts_insert;
+            DROP TRIGGER IF EXISTS photos_fts_delete;
+            DROP TRIGGER IF EXISTS photos_fts_update;
+            DROP TABLE IF EXISTS photos_fts;
+
+            CREATE VIRTUAL TABLE photos_fts USING fts5(
+                file_name,
+                file_path,
+                camera_model,
+                lens_model,
+                ocr_text,
+                content='photos',
+                content_rowid='photo_id'
+            );
+            INSERT INTO photos_fts(photos_fts) VALUES ('rebuild');
+
+            CREATE TRIGGER photos_fts_insert AFTER INSERT ON photos BEGIN
+                INSERT INTO photos_fts(rowid, file_name, file_path, camera_model, lens_model, ocr_text)
+                VALUES (NEW.photo_id, NEW.file_name, NEW.file_path, NEW.camera_model, NEW.lens_model, NEW.ocr_text);
+            END;
+
+            CREATE TRIGGER photos_fts_delete AFTER DELETE ON photos BEGIN
+                INSERT INTO photos_fts(photos_fts, rowid, file_name, file_path, camera_model, lens_model, ocr_text)
+                VALUES ('delete', OLD.photo_id, OLD.file_name, OLD.file_path, OLD.camera_model, OLD.lens_model, OLD.ocr_text);
+            END;
+
+            CREATE TRIGGER photos_fts_update
+            AFTER UPDATE OF file_name, file_path, camera_model, lens_model, ocr_text ON photos BEGIN
+                INSERT INTO photos_fts(photos_fts, rowid, file_name, file_path, camera_model, lens_model, ocr_text)
+                VALUES ('delete', OLD.photo_id, OLD.file_name, OLD.file_path, OLD.camera_model, OLD.lens_model, OLD.ocr_text);
+                INSERT INTO photos_fts(rowid, file_name, file_path, camera_model, lens_model, ocr_text)
+                VALUES (NEW.photo_id, NEW.file_name, NEW.file_path, NEW.camera_model, NEW.lens_model, NEW.ocr_text);
+            END;
+        "#,
+    },
 ];
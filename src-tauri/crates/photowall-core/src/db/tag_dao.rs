@@ -4,11 +4,11 @@ use rusqlite::{params, Row};
 
 use crate::models::{
     tag::{CreateTag, UpdateTag},
-    Tag, TagWithCount,
+    BatchItemStatus, Tag, TagWithCount,
 };
 use crate::utils::error::{AppError, AppResult};
 
-use super::connection::Database;
+use super::connection::{batch_item_status, Database};
 
 /// 从数据库行映射到 Tag 结构
 fn row_to_tag(row: &Row<'_>) -> rusqlite::Result<Tag> {
@@ -187,6 +187,65 @@ impl Database {
         })
     }
 
+    /// 为多张照片批量添加多个标签（单事务）
+    ///
+    /// 返回每个 (照片, 标签) 组合的结果，按照片优先排列：
+    /// `status[photo_index * tag_ids.len() + tag_index]`
+    pub fn add_tags_to_photos(
+        &self,
+        photo_ids: &[i64],
+        tag_ids: &[i64],
+    ) -> AppResult<Vec<BatchItemStatus>> {
+        if photo_ids.is_empty() || tag_ids.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        self.transaction(|conn| {
+            let now = crate::models::photo::chrono_now_pub();
+            let mut statuses = Vec::with_capacity(photo_ids.len() * tag_ids.len());
+
+            let mut stmt = conn.prepare(
+                "INSERT OR IGNORE INTO photo_tags (photo_id, tag_id, date_created) VALUES (?1, ?2, ?3)",
+            )?;
+
+            for photo_id in photo_ids {
+                for tag_id in tag_ids {
+                    statuses.push(batch_item_status(stmt.execute(params![photo_id, tag_id, now]))?);
+                }
+            }
+
+            Ok(statuses)
+        })
+    }
+
+    /// 从多张照片批量移除多个标签（单事务）
+    ///
+    /// 结果排列方式同 [`Database::add_tags_to_photos`]。
+    pub fn remove_tags_from_photos(
+        &self,
+        photo_ids: &[i64],
+        tag_ids: &[i64],
+    ) -> AppResult<Vec<BatchItemStatus>> {
+        if photo_ids.is_empty() || tag_ids.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        self.transaction(|conn| {
+            let mut statuses = Vec::with_capacity(photo_ids.len() * tag_ids.len());
+
+            let mut stmt =
+                conn.prepare("DELETE FROM photo_tags WHERE photo_id = ?1 AND tag_id = ?2")?;
+
+            for photo_id in photo_ids {
+                for tag_id in tag_ids {
+                    statuses.push(batch_item_status(stmt.execute(params![photo_id, tag_id]))?);
+                }
+            }
+
+            Ok(statuses)
+        })
+    }
+
     /// 从照片移除标签
     pub fn remove_tag_from_photo(&self, photo_id: i64, tag_id: i64) -> AppResult<bool> {
         let conn = self.connection()?;
@@ -359,4 +418,35 @@ mod tests {
         assert_eq!(tags_with_count.len(), 1);
         assert_eq!(tags_with_count[0].photo_count, 5);
     }
+
+    #[test]
+    fn test_add_tags_to_photos_batch() {
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+
+        let mut photo_ids = Vec::new();
+        for i in 0..3 {
+            let photo = create_test_photo(&format!("photo_{}.jpg", i));
+            photo_ids.push(db.create_photo(&photo).unwrap());
+        }
+        let tag_a = db.create_tag(&CreateTag { tag_name: "A".to_string(), color: None }).unwrap();
+        let tag_b = db.create_tag(&CreateTag { tag_name: "B".to_string(), color: None }).unwrap();
+
+        db.add_tag_to_photo(photo_ids[0], tag_a).unwrap();
+
+        // 最后一个照片 ID 不存在，应单独失败而不回滚其他项
+        let mut ids = photo_ids.clone();
+        ids.push(9999);
+        let statuses = db.add_tags_to_photos(&ids, &[tag_a, tag_b]).unwrap();
+
+        assert_eq!(statuses.len(), 8);
+        assert_eq!(statuses[0], BatchItemStatus::Unchanged);
+        assert_eq!(statuses[1], BatchItemStatus::Applied);
+        assert_eq!(statuses[6], BatchItemStatus::Failed);
+        assert_eq!(db.get_photo_ids_for_tag(tag_b).unwrap().len(), 3);
+
+        let statuses = db.remove_tags_from_photos(&photo_ids, &[tag_b]).unwrap();
+        assert!(statuses.iter().all(|s| *s == BatchItemStatus::Applied));
+        assert!(db.get_photo_ids_for_tag(tag_b).unwrap().is_empty());
+    }
 }
@@ -3,7 +3,11 @@
 //! This module provides traits and implementations for emitting events
 //! to the frontend without depending on Tauri directly.
 
-use std::sync::Arc;
+use std::cell::RefCell;
+use std::collections::{HashMap, VecDeque};
+use std::sync::{Arc, Condvar, Mutex, MutexGuard};
+use std::thread::{self, JoinHandle};
+use std::time::{Duration, Instant};
 
 /// Trait for emitting events to the frontend.
 ///
@@ -57,3 +61,485 @@ impl EventSink for LoggingEventSink {
         tracing::debug!(event = event_name, payload = payload_json, "Event emitted");
     }
 }
+
+/// How events of one type are coalesced by [`CoalescingEventSink`].
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum CoalesceMode {
+    /// Forward every event as soon as it is emitted.
+    Immediate,
+    /// Keep only the most recent payload per tick (e.g. progress updates).
+    Latest,
+    /// Collect payloads and deliver them as one JSON array per tick,
+    /// under the event name with a `-batch` suffix.
+    Batch,
+}
+
+struct ChannelState {
+    mode: CoalesceMode,
+    interval: Duration,
+    last_emit: Option<Instant>,
+    pending: Vec<String>,
+}
+
+impl ChannelState {
+    fn deadline(&self) -> Option<Instant> {
+        self.last_emit.map(|t| t + self.interval)
+    }
+
+    /// Take the pending payloads as a single delivery.
+    fn take_delivery(&mut self, event_name: &str, now: Instant) -> Option<(String, String)> {
+        if self.pending.is_empty() {
+            return None;
+        }
+        self.last_emit = Some(now);
+        match self.mode {
+            CoalesceMode::Batch => {
+                let payload = format!("[{}]", self.pending.join(","));
+                self.pending.clear();
+                Some((format!("{}-batch", event_name), payload))
+            }
+            _ => self
+                .pending
+                .pop()
+                .map(|payload| {
+                    self.pending.clear();
+                    (event_name.to_string(), payload)
+                }),
+        }
+    }
+}
+
+#[derive(Default)]
+struct CoalesceState {
+    channels: HashMap<String, ChannelState>,
+    /// Turn handed to the next batch of deliveries taken from this state.
+    next_turn: u64,
+    stopped: bool,
+}
+
+impl CoalesceState {
+    fn take_all(&mut self, now: Instant) -> Vec<(String, String)> {
+        self.channels
+            .iter_mut()
+            .filter_map(|(name, channel)| channel.take_delivery(name, now))
+            .collect()
+    }
+
+    fn take_turn(&mut self) -> u64 {
+        let turn = self.next_turn;
+        self.next_turn += 1;
+        turn
+    }
+
+    /// Deliveries whose tick has elapsed, plus the earliest future deadline.
+    fn take_due(&mut self, now: Instant) -> (Vec<(String, String)>, Option<Instant>) {
+        let mut due = Vec::new();
+        let mut next: Option<Instant> = None;
+        for (name, channel) in self.channels.iter_mut() {
+            if channel.pending.is_empty() {
+                continue;
+            }
+            match channel.deadline() {
+                Some(deadline) if deadline > now => {
+                    next = Some(next.map_or(deadline, |n| n.min(deadline)));
+                }
+                _ => due.extend(channel.take_delivery(name, now)),
+            }
+        }
+        (due, next)
+    }
+}
+
+/// Event sink that rate-limits and coalesces selected event types.
+///
+/// Each configured event type is delivered at most `max_rate_hz` times per
+/// second. The first event after a quiet period is forwarded immediately;
+/// events arriving within the same tick are merged and delivered by a
+/// background flusher when the tick ends. Unconfigured events pass through
+/// unchanged, after any pending coalesced events have been flushed so that
+/// e.g. the last progress update still precedes `index-finished`.
+///
+/// Deliveries from callers and from the flusher take a turn while the state
+/// lock is held and reach `inner` in turn order, so events arrive in the order
+/// their payloads were taken. No lock is held while `inner` runs: an `inner`
+/// that emits or flushes on the delivering thread has those events queued
+/// behind the delivery in progress instead of waiting for a turn.
+pub struct CoalescingEventSink {
+    inner: SharedEventSink,
+    state: Arc<(Mutex<CoalesceState>, Condvar)>,
+    turns: Arc<Turns>,
+    flusher: Mutex<Option<JoinHandle<()>>>,
+}
+
+/// The turn currently allowed to deliver.
+#[derive(Default)]
+struct Turns {
+    serving: Mutex<u64>,
+    cvar: Condvar,
+}
+
+thread_local! {
+    /// Deliveries running on this thread, keyed by sink; events emitted from
+    /// inside a delivery are appended to its queue.
+    static DELIVERING: RefCell<Vec<(usize, VecDeque<(String, String)>)>> = RefCell::new(Vec::new());
+}
+
+fn sink_id(turns: &Arc<Turns>) -> usize {
+    Arc::as_ptr(turns) as usize
+}
+
+/// Queue `deliveries` behind the delivery of the same sink running on this
+/// thread; hands them back if there is none.
+fn queue_reentrant(id: usize, deliveries: Vec<(String, String)>) -> Option<Vec<(String, String)>> {
+    DELIVERING.with(|delivering| {
+        let mut delivering = delivering.borrow_mut();
+        match delivering.iter_mut().rev().find(|(sink, _)| *sink == id) {
+            Some((_, queue)) => {
+                queue.extend(deliveries);
+                None
+            }
+            None => Some(deliveries),
+        }
+    })
+}
+
+/// Ends a turn even if `inner` panics, so later deliveries are not stuck.
+struct TurnGuard<'a> {
+    turns: &'a Turns,
+}
+
+impl Drop for TurnGuard<'_> {
+    fn drop(&mut self) {
+        DELIVERING.with(|delivering| delivering.borrow_mut().pop());
+        let mut serving = self.turns.serving.lock().unwrap_or_else(|e| e.into_inner());
+        *serving += 1;
+        self.turns.cvar.notify_all();
+    }
+}
+
+/// Wait for `turn`, then deliver `deliveries` and anything emitted re-entrantly
+/// while they run.
+fn deliver(inner: &dyn EventSink, turns: &Arc<Turns>, turn: u64, deliveries: Vec<(String, String)>) {
+    {
+        let mut serving = turns.serving.lock().unwrap_or_else(|e| e.into_inner());
+        while *serving != turn {
+            serving = turns.cvar.wait(serving).unwrap_or_else(|e| e.into_inner());
+        }
+    }
+    DELIVERING.with(|delivering| delivering.borrow_mut().push((sink_id(turns), deliveries.into())));
+    let _turn = TurnGuard { turns };
+    loop {
+        let next = DELIVERING.with(|delivering| {
+            delivering.borrow_mut().last_mut().and_then(|(_, queue)| queue.pop_front())
+        });
+        match next {
+            Some((name, payload)) => inner.emit(&name, &payload),
+            None => break,
+        }
+    }
+}
+
+impl CoalescingEventSink {
+    /// Wrap `inner`; no event type is coalesced until configured.
+    pub fn new(inner: SharedEventSink) -> Self {
+        let state = Arc::new((Mutex::new(CoalesceState::default()), Condvar::new()));
+        let turns = Arc::new(Turns::default());
+
+        let flusher_state = state.clone();
+        let flusher_turns = turns.clone();
+        let flusher_sink = inner.clone();
+        let flusher = thread::spawn(move || loop {
+            let (deliveries, turn) = {
+                let (lock, cvar) = &*flusher_state;
+                let mut state = match lock.lock() {
+                    Ok(state) => state,
+                    Err(_) => return,
+                };
+                loop {
+                    if state.stopped {
+                        return;
+                    }
+                    let now = Instant::now();
+                    let (due, next) = state.take_due(now);
+                    if !due.is_empty() {
+                        break (due, state.take_turn());
+                    }
+                    state = match next {
+                        Some(deadline) => match cvar.wait_timeout(state, deadline - now) {
+                            Ok((state, _)) => state,
+                            Err(_) => return,
+                        },
+                        None => match cvar.wait(state) {
+                            Ok(state) => state,
+                            Err(_) => return,
+                        },
+                    };
+                }
+            };
+            deliver(&*flusher_sink, &flusher_turns, turn, deliveries);
+        });
+
+        Self {
+            inner,
+            state,
+            turns,
+            flusher: Mutex::new(Some(flusher)),
+        }
+    }
+
+    /// Configure coalescing for one event type.
+    ///
+    /// `max_rate_hz == 0` or `CoalesceMode::Immediate` disables coalescing
+    /// for the event (pending payloads are delivered on the next emit or flush).
+    pub fn configure(&self, event_name: &str, mode: CoalesceMode, max_rate_hz: u32) {
+        let (lock, cvar) = &*self.state;
+        if let Ok(mut state) = lock.lock() {
+            if mode == CoalesceMode::Immediate || max_rate_hz == 0 {
+                if let Some(channel) = state.channels.get_mut(event_name) {
+                    channel.mode = CoalesceMode::Immediate;
+                    channel.interval = Duration::ZERO;
+                }
+            } else {
+                let interval = Duration::from_secs(1) / max_rate_hz;
+                let channel = state
+                    .channels
+                    .entry(event_name.to_string())
+                    .or_insert_with(|| ChannelState {
+                        mode,
+                        interval,
+                        last_emit: None,
+                        pending: Vec::new(),
+                    });
+                channel.mode = mode;
+                channel.interval = interval;
+            }
+            cvar.notify_one();
+        }
+    }
+
+    /// Deliver all pending coalesced events now.
+    ///
+    /// Called from inside a delivery, the events are queued behind it and
+    /// delivered once the current callback returns.
+    pub fn flush(&self) {
+        let (lock, _) = &*self.state;
+        let mut state = match lock.lock() {
+            Ok(state) => state,
+            Err(_) => return,
+        };
+        let deliveries = state.take_all(Instant::now());
+        self.dispatch(state, deliveries);
+    }
+
+    /// Deliver events taken from `state`, releasing the state lock first.
+    fn dispatch(&self, mut state: MutexGuard<'_, CoalesceState>, deliveries: Vec<(String, String)>) {
+        if deliveries.is_empty() {
+            return;
+        }
+        let Some(deliveries) = queue_reentrant(sink_id(&self.turns), deliveries) else {
+            return;
+        };
+        let turn = state.take_turn();
+        drop(state);
+        deliver(&*self.inner, &self.turns, turn, deliveries);
+    }
+}
+
+impl EventSink for CoalescingEventSink {
+    fn emit(&self, event_name: &str, payload_json: &str) {
+        let (lock, cvar) = &*self.state;
+        let mut state = match lock.lock() {
+            Ok(state) => state,
+            Err(_) => return,
+        };
+        let now = Instant::now();
+
+        let coalesced = matches!(
+            state.channels.get(event_name),
+            Some(channel) if channel.mode != CoalesceMode::Immediate
+        );
+
+        let deliveries: Vec<(String, String)> = if !coalesced {
+            let mut deliveries = state.take_all(now);
+            deliveries.push((event_name.to_string(), payload_json.to_string()));
+            deliveries
+        } else if let Some(channel) = state.channels.get_mut(event_name) {
+            channel.pending.push(payload_json.to_string());
+            let due = channel.deadline().map_or(true, |deadline| deadline <= now);
+            if due && channel.pending.len() == 1 {
+                // Leading edge: nothing was waiting, deliver right away.
+                channel.take_delivery(event_name, now).into_iter().collect()
+            } else {
+                cvar.notify_one();
+                Vec::new()
+            }
+        } else {
+            Vec::new()
+        };
+        self.dispatch(state, deliveries);
+    }
+}
+
+impl Drop for CoalescingEventSink {
+    fn drop(&mut self) {
+        {
+            let (lock, cvar) = &*self.state;
+            if let Ok(mut state) = lock.lock() {
+                state.stopped = true;
+            }
+            cvar.notify_all();
+        }
+        if let Ok(mut flusher) = self.flusher.lock() {
+            if let Some(handle) = flusher.take() {
+                let _ = handle.join();
+            }
+        }
+        self.flush();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[derive(Default)]
+    struct RecordingSink {
+        events: Mutex<Vec<(String, String)>>,
+    }
+
+    impl EventSink for RecordingSink {
+        fn emit(&self, event_name: &str, payload_json: &str) {
+            self.events
+                .lock()
+                .unwrap()
+                .push((event_name.to_string(), payload_json.to_string()));
+        }
+    }
+
+    #[test]
+    fn test_coalesce_latest_keeps_last_payload() {
+        let recorder = Arc::new(RecordingSink::default());
+        let sink = CoalescingEventSink::new(recorder.clone());
+        sink.configure("index-progress", CoalesceMode::Latest, 1);
+
+        for i in 0..100 {
+            sink.emit("index-progress", &i.to_string());
+        }
+        sink.emit("index-finished", "{}");
+
+        let events = recorder.events.lock().unwrap();
+        assert_eq!(events.len(), 3);
+        assert_eq!(events[0], ("index-progress".to_string(), "0".to_string()));
+        assert_eq!(events[1], ("index-progress".to_string(), "99".to_string()));
+        assert_eq!(events[2].0, "index-finished");
+    }
+
+    #[test]
+    fn test_coalesce_batch_builds_array() {
+        let recorder = Arc::new(RecordingSink::default());
+        let sink = CoalescingEventSink::new(recorder.clone());
+        sink.configure("thumbnail-ready", CoalesceMode::Batch, 1);
+
+        sink.emit("thumbnail-ready", r#"{"n":1}"#);
+        sink.emit("thumbnail-ready", r#"{"n":2}"#);
+        sink.emit("thumbnail-ready", r#"{"n":3}"#);
+        sink.flush();
+
+        let events = recorder.events.lock().unwrap();
+        assert_eq!(events.len(), 2);
+        assert_eq!(events[0].0, "thumbnail-ready-batch");
+        assert_eq!(events[0].1, r#"[{"n":1}]"#);
+        assert_eq!(events[1].1, r#"[{"n":2},{"n":3}]"#);
+    }
+
+    /// Signals when a progress delivery starts and records it only after a delay.
+    struct SlowProgressSink {
+        started: Mutex<std::sync::mpsc::Sender<String>>,
+        events: Mutex<Vec<String>>,
+    }
+
+    impl EventSink for SlowProgressSink {
+        fn emit(&self, event_name: &str, payload_json: &str) {
+            if event_name == "index-progress" {
+                let _ = self.started.lock().unwrap().send(payload_json.to_string());
+                thread::sleep(Duration::from_millis(50));
+            }
+            self.events.lock().unwrap().push(payload_json.to_string());
+        }
+    }
+
+    #[test]
+    fn test_flusher_delivery_precedes_later_events() {
+        let (tx, rx) = std::sync::mpsc::channel();
+        let recorder = Arc::new(SlowProgressSink {
+            started: Mutex::new(tx),
+            events: Mutex::new(Vec::new()),
+        });
+        let sink = CoalescingEventSink::new(recorder.clone());
+        sink.configure("index-progress", CoalesceMode::Latest, 10);
+
+        // Leading edge is delivered by the caller, the second by the flusher.
+        sink.emit("index-progress", "1");
+        sink.emit("index-progress", "2");
+        assert_eq!(rx.recv().unwrap(), "1");
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap(), "2");
+
+        // The flusher is now inside the slow delivery of "2".
+        sink.emit("index-finished", "done");
+        assert_eq!(*recorder.events.lock().unwrap(), vec!["1", "2", "done"]);
+    }
+
+    /// Emits and flushes through the coalescing sink from inside its callback.
+    #[derive(Default)]
+    struct ReentrantSink {
+        outer: Mutex<std::sync::Weak<CoalescingEventSink>>,
+        events: Mutex<Vec<String>>,
+        done: Mutex<Option<std::sync::mpsc::Sender<()>>>,
+    }
+
+    impl EventSink for ReentrantSink {
+        fn emit(&self, event_name: &str, payload_json: &str) {
+            self.events.lock().unwrap().push(payload_json.to_string());
+            let outer = self.outer.lock().unwrap().upgrade();
+            if let Some(outer) = outer {
+                match payload_json {
+                    "2" => outer.emit("index-finished", "from-flusher"),
+                    "start" => {
+                        outer.emit("index-progress", "3");
+                        outer.flush();
+                        outer.emit("index-finished", "from-caller");
+                    }
+                    _ => {}
+                }
+            }
+            if event_name == "index-finished" && payload_json == "from-flusher" {
+                if let Some(done) = self.done.lock().unwrap().take() {
+                    let _ = done.send(());
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_reentrant_emit_and_flush_do_not_deadlock() {
+        let (tx, rx) = std::sync::mpsc::channel();
+        let recorder = Arc::new(ReentrantSink::default());
+        *recorder.done.lock().unwrap() = Some(tx);
+        let sink = Arc::new(CoalescingEventSink::new(recorder.clone()));
+        *recorder.outer.lock().unwrap() = Arc::downgrade(&sink);
+        sink.configure("index-progress", CoalesceMode::Latest, 10);
+
+        // "2" is delivered by the flusher, whose callback emits again.
+        sink.emit("index-progress", "1");
+        sink.emit("index-progress", "2");
+        rx.recv_timeout(Duration::from_secs(5)).unwrap();
+
+        // Caller-thread delivery whose callback emits, flushes and emits again;
+        // the nested events follow the one that triggered them.
+        sink.emit("index-started", "start");
+        assert_eq!(
+            *recorder.events.lock().unwrap(),
+            vec!["1", "2", "from-flusher", "start", "3", "from-caller"]
+        );
+    }
+}
@@ -18,6 +18,7 @@
 //! - `events`: Event emission abstraction (EventSink trait)
 //! - `paths`: Path provider abstraction (PathProvider trait)
 //! - `jobs`: Job management and cancellation system
+//! - `metrics`: Runtime counters and latency histograms
 //! - `utils`: Error handling and utilities
 //!
 //! # Example
@@ -46,6 +47,7 @@
 pub mod db;
 pub mod events;
 pub mod jobs;
+pub mod metrics;
 pub mod models;
 pub mod paths;
 pub mod services;
@@ -53,7 +55,7 @@ pub mod utils;
 
 // Re-export commonly used types
 pub use db::{Database, DatabaseStats};
-pub use events::{EventSink, SharedEventSink, NoOpEventSink, LoggingEventSink};
+pub use events::{EventSink, SharedEventSink, NoOpEventSink, LoggingEventSink, CoalescingEventSink, CoalesceMode};
 pub use jobs::{JobId, JobManager, CancelToken};
 pub use models::{Photo, Tag, Album, AppSettings};
 pub use paths::{PathProvider, SharedPathProvider, QtPathProvider, TauriPathProvider};
@@ -61,7 +63,7 @@ pub use services::{
     Scanner, ScanOptions, ScanResult,
     PhotoIndexer, IndexOptions, IndexResult,
     ThumbnailService, ThumbnailSize, ThumbnailQueue, ThumbnailTask,
-    SettingsManager,
+    SettingsManager, DuplicateIndex, ColorIndex,
 };
 pub use utils::{AppError, AppResult, CommandError};
 
@@ -82,6 +84,10 @@ pub struct PhotowallCore {
     pub job_manager: Arc<JobManager>,
     /// Thumbnail service
     pub thumbnail_service: ThumbnailService,
+    /// In-memory near-duplicate index over perceptual hashes
+    pub duplicate_index: Arc<DuplicateIndex>,
+    /// In-memory colour-similarity index over colour embeddings
+    pub color_index: Arc<ColorIndex>,
 }
 
 impl PhotowallCore {
@@ -115,6 +121,22 @@ impl PhotowallCore {
         // Create thumbnail service
         let thumbnail_service = ThumbnailService::new(path_provider.thumbnails_dir())?;
 
+        // Load the near-duplicate index; a failure only disables similarity search
+        let duplicate_index = match DuplicateIndex::load(&db) {
+            Ok(index) => index,
+            Err(e) => {
+                tracing::warn!("Failed to load near-duplicate index: {}", e);
+                DuplicateIndex::empty()
+            }
+        };
+        let color_index = match ColorIndex::load(&db) {
+            Ok(index) => index,
+            Err(e) => {
+                tracing::warn!("Failed to load colour index: {}", e);
+                ColorIndex::empty()
+            }
+        };
+
         // Set up event sink for thumbnail queue
         services::set_event_sink(event_sink.clone());
 
@@ -124,6 +146,8 @@ impl PhotowallCore {
             event_sink,
             job_manager: Arc::new(JobManager::new()),
             thumbnail_service,
+            duplicate_index: Arc::new(duplicate_index),
+            color_index: Arc::new(color_index),
         })
     }
 
@@ -151,12 +175,43 @@ impl PhotowallCore {
     pub fn thumbnails(&self) -> &ThumbnailService {
         &self.thumbnail_service
     }
+
+    /// Get the near-duplicate index reference.
+    pub fn duplicates(&self) -> &Arc<DuplicateIndex> {
+        &self.duplicate_index
+    }
+
+    /// Get the colour-similarity index reference.
+    pub fn colors(&self) -> &Arc<ColorIndex> {
+        &self.color_index
+    }
+
+    /// Drop photos from the in-memory search indexes after they are trashed
+    /// or permanently deleted.
+    pub fn forget_photos(&self, photo_ids: &[i64]) {
+        self.duplicate_index.remove(photo_ids);
+        self.color_index.remove(photo_ids);
+    }
+
+    /// Reload photos into the in-memory search indexes after they are
+    /// restored from the trash.
+    pub fn reindex_photos(&self, photo_ids: &[i64]) -> AppResult<()> {
+        self.duplicate_index.refresh(&self.db, photo_ids)?;
+        self.color_index.refresh(&self.db, photo_ids)
+    }
 }
 
 impl Drop for PhotowallCore {
     fn drop(&mut self) {
         // Clean up event sink
         services::clear_event_sink();
+        // Worker threads may still hold the thumbnail service; commit the
+        // pending pack index records so finished thumbnails survive restart.
+        if let Some(pack) = self.thumbnail_service.pack_store() {
+            if let Err(e) = pack.flush() {
+                tracing::warn!("Failed to flush thumbnail packs: {}", e);
+            }
+        }
     }
 }
 
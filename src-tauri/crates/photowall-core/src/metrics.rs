@@ -0,0 +1,365 @@
+//! Runtime metrics: counters, gauges and latency histograms.
+//!
+//! All metrics live in one process-wide registry and are keyed by static
+//! names such as `"db.query"` or `"thumbnail.cache.hit"`. Recording is
+//! lock-free apart from a shared read lock on the name lookup, so it is
+//! cheap enough for per-query and per-FFI-call instrumentation.
+//!
+//! Histograms are HDR-style log-linear: exact below 8 µs, then 8 buckets per
+//! power of two (at most 12.5% relative error) up to about 19 hours.
+
+use std::collections::{BTreeMap, HashMap};
+use std::sync::atomic::{AtomicI64, AtomicU64, Ordering};
+use std::sync::{Arc, OnceLock, RwLock};
+use std::time::{Duration, Instant};
+
+/// Sub-buckets per power of two, as a bit count.
+const SUB_BITS: u32 = 3;
+const SUB_COUNT: u64 = 1 << SUB_BITS;
+/// Largest tracked exponent; larger values are clamped into the last bucket.
+const MAX_EXP: u32 = 36;
+const BUCKET_COUNT: usize = ((MAX_EXP - SUB_BITS + 2) as usize) * SUB_COUNT as usize;
+
+fn bucket_index(value_us: u64) -> usize {
+    if value_us < SUB_COUNT {
+        return value_us as usize;
+    }
+    let exp = (63 - value_us.leading_zeros()).min(MAX_EXP);
+    let value = value_us.min((1u64 << (MAX_EXP + 1)) - 1);
+    let sub = (value >> (exp - SUB_BITS)) & (SUB_COUNT - 1);
+    ((exp - SUB_BITS + 1) as u64 * SUB_COUNT + sub) as usize
+}
+
+/// Smallest value (µs) that falls into bucket `index`.
+fn bucket_lower(index: usize) -> u64 {
+    let index = index as u64;
+    if index < SUB_COUNT {
+        return index;
+    }
+    let exp = (index / SUB_COUNT) as u32 + SUB_BITS - 1;
+    (SUB_COUNT + index % SUB_COUNT) << (exp - SUB_BITS)
+}
+
+/// Largest value (µs) that falls into bucket `index`.
+fn bucket_upper(index: usize) -> u64 {
+    if index + 1 >= BUCKET_COUNT {
+        return u64::MAX;
+    }
+    bucket_lower(index + 1) - 1
+}
+
+/// Lock-free latency histogram with microsecond resolution.
+pub struct LatencyHistogram {
+    buckets: Box<[AtomicU64]>,
+    count: AtomicU64,
+    sum_us: AtomicU64,
+    max_us: AtomicU64,
+}
+
+impl LatencyHistogram {
+    pub fn new() -> Self {
+        Self {
+            buckets: (0..BUCKET_COUNT).map(|_| AtomicU64::new(0)).collect(),
+            count: AtomicU64::new(0),
+            sum_us: AtomicU64::new(0),
+            max_us: AtomicU64::new(0),
+        }
+    }
+
+    /// Record one sample.
+    pub fn record(&self, duration: Duration) {
+        let us = duration.as_micros().min(u64::MAX as u128) as u64;
+        self.buckets[bucket_index(us)].fetch_add(1, Ordering::Relaxed);
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.sum_us.fetch_add(us, Ordering::Relaxed);
+        self.max_us.fetch_max(us, Ordering::Relaxed);
+    }
+
+    fn reset(&self) {
+        for bucket in self.buckets.iter() {
+            bucket.store(0, Ordering::Relaxed);
+        }
+        self.count.store(0, Ordering::Relaxed);
+        self.sum_us.store(0, Ordering::Relaxed);
+        self.max_us.store(0, Ordering::Relaxed);
+    }
+
+    /// Take a point-in-time snapshot.
+    ///
+    /// Concurrent recording may make the totals differ from the bucket sum
+    /// by a few samples; percentiles are computed from the buckets.
+    pub fn snapshot(&self, include_buckets: bool) -> HistogramSnapshot {
+        let counts: Vec<u64> = self.buckets.iter().map(|b| b.load(Ordering::Relaxed)).collect();
+        let total: u64 = counts.iter().sum();
+        let max_us = self.max_us.load(Ordering::Relaxed);
+        let sum_us = self.sum_us.load(Ordering::Relaxed);
+        let count = self.count.load(Ordering::Relaxed);
+
+        let percentile = |q: f64| -> u64 {
+            if total == 0 {
+                return 0;
+            }
+            let rank = ((q * total as f64).ceil() as u64).max(1);
+            let mut seen = 0;
+            for (i, &c) in counts.iter().enumerate() {
+                seen += c;
+                if seen >= rank {
+                    return bucket_upper(i).min(max_us);
+                }
+            }
+            max_us
+        };
+
+        let buckets = include_buckets.then(|| {
+            counts
+                .iter()
+                .enumerate()
+                .filter(|(_, &c)| c > 0)
+                .map(|(i, &c)| [bucket_lower(i), c])
+                .collect()
+        });
+
+        HistogramSnapshot {
+            count,
+            sum_us,
+            mean_us: if count > 0 { sum_us as f64 / count as f64 } else { 0.0 },
+            p50_us: percentile(0.50),
+            p90_us: percentile(0.90),
+            p99_us: percentile(0.99),
+            p999_us: percentile(0.999),
+            max_us,
+            buckets,
+        }
+    }
+}
+
+impl Default for LatencyHistogram {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Serializable view of a [`LatencyHistogram`]; all times in microseconds.
+#[derive(Debug, Clone, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct HistogramSnapshot {
+    pub count: u64,
+    pub sum_us: u64,
+    pub mean_us: f64,
+    pub p50_us: u64,
+    pub p90_us: u64,
+    pub p99_us: u64,
+    pub p999_us: u64,
+    pub max_us: u64,
+    /// Non-empty buckets as `[lower bound µs, count]`, if requested.
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub buckets: Option<Vec<[u64; 2]>>,
+}
+
+/// Point-in-time snapshot of all metrics.
+#[derive(Debug, Clone, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct MetricsSnapshot {
+    /// Seconds since the registry was created or last reset.
+    pub uptime_secs: f64,
+    /// Monotonic counters; rates are derived by diffing successive snapshots.
+    pub counters: BTreeMap<String, u64>,
+    pub gauges: BTreeMap<String, i64>,
+    /// `hit / (hit + miss)` for every `<name>.hit` / `<name>.miss` counter pair.
+    pub hit_rates: BTreeMap<String, f64>,
+    pub histograms: BTreeMap<String, HistogramSnapshot>,
+}
+
+/// Metrics registry.
+pub struct Metrics {
+    counters: RwLock<HashMap<&'static str, Arc<AtomicU64>>>,
+    gauges: RwLock<HashMap<&'static str, Arc<AtomicI64>>>,
+    histograms: RwLock<HashMap<&'static str, Arc<LatencyHistogram>>>,
+    started: RwLock<Instant>,
+}
+
+impl Metrics {
+    pub fn new() -> Self {
+        Self {
+            counters: RwLock::new(HashMap::new()),
+            gauges: RwLock::new(HashMap::new()),
+            histograms: RwLock::new(HashMap::new()),
+            started: RwLock::new(Instant::now()),
+        }
+    }
+
+    fn get_or_insert<T: Default>(map: &RwLock<HashMap<&'static str, Arc<T>>>, name: &'static str) -> Arc<T> {
+        if let Some(existing) = map.read().ok().and_then(|m| m.get(name).cloned()) {
+            return existing;
+        }
+        match map.write() {
+            Ok(mut m) => m.entry(name).or_default().clone(),
+            Err(_) => Arc::new(T::default()),
+        }
+    }
+
+    /// Get (or register) a counter.
+    pub fn counter(&self, name: &'static str) -> Arc<AtomicU64> {
+        Self::get_or_insert(&self.counters, name)
+    }
+
+    /// Add `n` to a counter.
+    pub fn incr(&self, name: &'static str, n: u64) {
+        self.counter(name).fetch_add(n, Ordering::Relaxed);
+    }
+
+    /// Set a gauge to its current value.
+    pub fn set_gauge(&self, name: &'static str, value: i64) {
+        Self::get_or_insert(&self.gauges, name).store(value, Ordering::Relaxed);
+    }
+
+    /// Get (or register) a histogram.
+    pub fn histogram(&self, name: &'static str) -> Arc<LatencyHistogram> {
+        Self::get_or_insert(&self.histograms, name)
+    }
+
+    /// Record one latency sample.
+    pub fn record(&self, name: &'static str, duration: Duration) {
+        self.histogram(name).record(duration);
+    }
+
+    /// Snapshot all metrics.
+    pub fn snapshot(&self, include_buckets: bool) -> MetricsSnapshot {
+        let counters: BTreeMap<String, u64> = self
+            .counters
+            .read()
+            .map(|m| m.iter().map(|(k, v)| (k.to_string(), v.load(Ordering::Relaxed))).collect())
+            .unwrap_or_default();
+        let gauges = self
+            .gauges
+            .read()
+            .map(|m| m.iter().map(|(k, v)| (k.to_string(), v.load(Ordering::Relaxed))).collect())
+            .unwrap_or_default();
+        let histograms = self
+            .histograms
+            .read()
+            .map(|m| m.iter().map(|(k, v)| (k.to_string(), v.snapshot(include_buckets))).collect())
+            .unwrap_or_default();
+
+        let mut hit_rates = BTreeMap::new();
+        for (name, &hits) in &counters {
+            if let Some(base) = name.strip_suffix(".hit") {
+                let misses = counters.get(&format!("{}.miss", base)).copied().unwrap_or(0);
+                if hits + misses > 0 {
+                    hit_rates.insert(base.to_string(), hits as f64 / (hits + misses) as f64);
+                }
+            }
+        }
+
+        let uptime_secs = self.started.read().map(|s| s.elapsed().as_secs_f64()).unwrap_or(0.0);
+
+        MetricsSnapshot {
+            uptime_secs,
+            counters,
+            gauges,
+            hit_rates,
+            histograms,
+        }
+    }
+
+    /// Zero all counters and histograms; gauges keep their current value.
+    pub fn reset(&self) {
+        if let Ok(m) = self.counters.read() {
+            for counter in m.values() {
+                counter.store(0, Ordering::Relaxed);
+            }
+        }
+        if let Ok(m) = self.histograms.read() {
+            for histogram in m.values() {
+                histogram.reset();
+            }
+        }
+        if let Ok(mut started) = self.started.write() {
+            *started = Instant::now();
+        }
+    }
+}
+
+impl Default for Metrics {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Process-wide metrics registry.
+pub fn global() -> &'static Metrics {
+    static METRICS: OnceLock<Metrics> = OnceLock::new();
+    METRICS.get_or_init(Metrics::new)
+}
+
+/// Records the time from creation to drop into a global histogram.
+pub struct Timer {
+    name: &'static str,
+    start: Instant,
+}
+
+impl Timer {
+    pub fn start(name: &'static str) -> Self {
+        Self {
+            name,
+            start: Instant::now(),
+        }
+    }
+}
+
+impl Drop for Timer {
+    fn drop(&mut self) {
+        global().record(self.name, self.start.elapsed());
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_bucket_bounds_roundtrip() {
+        for value in [0u64, 1, 7, 8, 9, 15, 16, 17, 100, 1_000, 123_456, 10_000_000] {
+            let index = bucket_index(value);
+            assert!(bucket_lower(index) <= value, "value {}", value);
+            assert!(bucket_upper(index) >= value, "value {}", value);
+        }
+        assert_eq!(bucket_index(u64::MAX), BUCKET_COUNT - 1);
+    }
+
+    #[test]
+    fn test_histogram_percentiles() {
+        let histogram = LatencyHistogram::new();
+        for us in 1..=1000 {
+            histogram.record(Duration::from_micros(us));
+        }
+        let snap = histogram.snapshot(true);
+        assert_eq!(snap.count, 1000);
+        assert_eq!(snap.max_us, 1000);
+        // 12.5% bucket resolution
+        assert!((500..=563).contains(&snap.p50_us), "p50 {}", snap.p50_us);
+        assert!((990..=1000).contains(&snap.p99_us), "p99 {}", snap.p99_us);
+        assert_eq!(snap.buckets.unwrap().iter().map(|b| b[1]).sum::<u64>(), 1000);
+    }
+
+    #[test]
+    fn test_snapshot_hit_rates_and_reset() {
+        let metrics = Metrics::new();
+        metrics.incr("cache.hit", 3);
+        metrics.incr("cache.miss", 1);
+        metrics.set_gauge("queue.depth", 7);
+        metrics.record("db.query", Duration::from_millis(2));
+
+        let snap = metrics.snapshot(false);
+        assert_eq!(snap.hit_rates["cache"], 0.75);
+        assert_eq!(snap.gauges["queue.depth"], 7);
+        assert_eq!(snap.histograms["db.query"].count, 1);
+        assert!(snap.histograms["db.query"].buckets.is_none());
+
+        metrics.reset();
+        let snap = metrics.snapshot(false);
+        assert_eq!(snap.counters["cache.hit"], 0);
+        assert_eq!(snap.histograms["db.query"].count, 0);
+        assert_eq!(snap.gauges["queue.depth"], 7);
+    }
+}
@@ -56,6 +56,18 @@ impl<T> PaginatedResult<T> {
     }
 }
 
+/// 批量写操作中单项的结果
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(u8)]
+pub enum BatchItemStatus {
+    /// 已写入
+    Applied = 0,
+    /// 无变化（关联已存在或不存在）
+    Unchanged = 1,
+    /// 失败（照片、标签或相册不存在）
+    Failed = 2,
+}
+
 /// 排序方向
 #[derive(Debug, Clone, Copy, serde::Serialize, serde::Deserialize, Default)]
 #[serde(rename_all = "lowercase")]
@@ -151,6 +163,14 @@ pub struct SearchFilters {
     pub has_gps: Option<bool>,
     /// 文件扩展名列表（用于RAW格式筛选）
     pub file_extensions: Option<Vec<String>>,
+    /// 最低清晰度（拉普拉斯方差，未评分的照片不匹配）
+    pub min_sharpness: Option<f64>,
+    /// 最高高光裁切比例（0-1）
+    pub max_highlight_clip: Option<f64>,
+    /// 最高暗部裁切比例（0-1）
+    pub max_shadow_clip: Option<f64>,
+    /// 最高噪点估计
+    pub max_noise: Option<f64>,
 }
 
 /// 搜索结果
@@ -54,6 +54,69 @@ pub struct Photo {
     pub is_deleted: bool,
     /// 删除时间
     pub deleted_at: Option<String>,
+    /// ThumbHash 占位图（JSON 中为 Base64 字符串）
+    #[serde(default, with = "thumbhash_base64", skip_serializing_if = "Option::is_none")]
+    pub thumbhash: Option<Vec<u8>>,
+    /// 64 位 dHash（JSON 中为 16 位十六进制字符串，避免 JavaScript 丢失精度）
+    #[serde(default, with = "hash_hex", skip_serializing_if = "Option::is_none")]
+    pub dhash: Option<u64>,
+    /// 64 位 DCT pHash（JSON 中为 16 位十六进制字符串）
+    #[serde(default, with = "hash_hex", skip_serializing_if = "Option::is_none")]
+    pub phash: Option<u64>,
+    /// 清晰度（拉普拉斯方差，越大越清晰）
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub sharpness: Option<f64>,
+    /// 高光裁切像素比例（0-1）
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub highlight_clip: Option<f64>,
+    /// 暗部裁切像素比例（0-1）
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub shadow_clip: Option<f64>,
+    /// 噪点估计（灰度标准差）
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub noise: Option<f64>,
+    /// 主色调色板（`#rrggbb`，按占比降序；仅按 ID 获取单张照片时填充）
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub palette: Option<Vec<String>>,
+}
+
+/// ThumbHash 的 Base64 序列化
+mod thumbhash_base64 {
+    use base64::{engine::general_purpose::STANDARD, Engine as _};
+    use serde::{Deserialize, Deserializer, Serializer};
+
+    pub fn serialize<S: Serializer>(value: &Option<Vec<u8>>, serializer: S) -> Result<S::Ok, S::Error> {
+        match value {
+            Some(bytes) => serializer.serialize_str(&STANDARD.encode(bytes)),
+            None => serializer.serialize_none(),
+        }
+    }
+
+    pub fn deserialize<'de, D: Deserializer<'de>>(deserializer: D) -> Result<Option<Vec<u8>>, D::Error> {
+        let value: Option<String> = Option::deserialize(deserializer)?;
+        value
+            .map(|s| STANDARD.decode(s).map_err(serde::de::Error::custom))
+            .transpose()
+    }
+}
+
+/// 64 位感知哈希的十六进制序列化
+mod hash_hex {
+    use serde::{Deserialize, Deserializer, Serializer};
+
+    pub fn serialize<S: Serializer>(value: &Option<u64>, serializer: S) -> Result<S::Ok, S::Error> {
+        match value {
+            Some(hash) => serializer.serialize_str(&format!("{:016x}", hash)),
+            None => serializer.serialize_none(),
+        }
+    }
+
+    pub fn deserialize<'de, D: Deserializer<'de>>(deserializer: D) -> Result<Option<u64>, D::Error> {
+        let value: Option<String> = Option::deserialize(deserializer)?;
+        value
+            .map(|s| u64::from_str_radix(&s, 16).map_err(serde::de::Error::custom))
+            .transpose()
+    }
 }
 
 impl Photo {
@@ -89,6 +152,14 @@ impl Photo {
             is_favorite: false,
             is_deleted: false,
             deleted_at: None,
+            thumbhash: None,
+            dhash: None,
+            phash: None,
+            sharpness: None,
+            highlight_clip: None,
+            shadow_clip: None,
+            noise: None,
+            palette: None,
         }
     }
 }
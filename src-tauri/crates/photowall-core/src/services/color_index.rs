@@ -0,0 +1,239 @@
+//! 颜色相似检索服务
+//!
+//! 所有照片的颜色嵌入连续存放在内存中，查询时并行暴力计算 L1 距离。
+//! 每个嵌入 64 字节，十万张照片约 6MB，一次查询只需顺序扫过这块内存。
+
+use std::collections::HashMap;
+use std::sync::RwLock;
+
+use rayon::prelude::*;
+
+use crate::db::Database;
+use crate::utils::color_signature::{embedding_distance, ColorEmbedding, ColorSignature};
+use crate::utils::error::{AppError, AppResult};
+
+/// 每个并行任务处理的嵌入数
+const SCAN_CHUNK: usize = 4096;
+
+/// 颜色相似结果
+#[derive(Debug, Clone, Copy, PartialEq, Eq, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct ColorMatch {
+    pub photo_id: i64,
+    /// 嵌入 L1 距离，越小越相似（0 表示颜色分布相同）
+    pub distance: u32,
+}
+
+/// 嵌入表（删除时用末尾条目填补空位，保持连续）
+#[derive(Default)]
+struct EmbeddingTable {
+    ids: Vec<i64>,
+    embeddings: Vec<ColorEmbedding>,
+    slot_of: HashMap<i64, usize>,
+}
+
+impl EmbeddingTable {
+    fn upsert(&mut self, photo_id: i64, embedding: ColorEmbedding) {
+        match self.slot_of.get(&photo_id) {
+            Some(&slot) => self.embeddings[slot] = embedding,
+            None => {
+                self.slot_of.insert(photo_id, self.ids.len());
+                self.ids.push(photo_id);
+                self.embeddings.push(embedding);
+            }
+        }
+    }
+
+    fn remove(&mut self, photo_id: i64) {
+        if let Some(slot) = self.slot_of.remove(&photo_id) {
+            self.ids.swap_remove(slot);
+            self.embeddings.swap_remove(slot);
+            if let Some(&moved) = self.ids.get(slot) {
+                self.slot_of.insert(moved, slot);
+            }
+        }
+    }
+
+    /// 距离最小的 `limit` 个条目，按距离升序；`limit` 为 0 时返回全部（与近似重复查询一致）
+    fn nearest(&self, query: &ColorEmbedding, limit: usize, exclude: Option<i64>) -> Vec<ColorMatch> {
+        let limit = if limit == 0 { usize::MAX } else { limit };
+
+        // 每段各自保留前 limit 个，再合并
+        let mut candidates: Vec<ColorMatch> = self
+            .embeddings
+            .par_chunks(SCAN_CHUNK)
+            .enumerate()
+            .flat_map_iter(|(chunk, embeddings)| {
+                let base = chunk * SCAN_CHUNK;
+                let mut local: Vec<ColorMatch> = embeddings
+                    .iter()
+                    .enumerate()
+                    .map(|(i, e)| ColorMatch {
+                        photo_id: self.ids[base + i],
+                        distance: embedding_distance(query, e),
+                    })
+                    .filter(|m| Some(m.photo_id) != exclude)
+                    .collect();
+                keep_nearest(&mut local, limit);
+                local
+            })
+            .collect();
+
+        keep_nearest(&mut candidates, limit);
+        candidates.sort_unstable_by_key(|m| (m.distance, m.photo_id));
+        candidates
+    }
+}
+
+/// 只保留距离最小的 `limit` 个（顺序不定）
+fn keep_nearest(matches: &mut Vec<ColorMatch>, limit: usize) {
+    if matches.len() > limit {
+        matches.select_nth_unstable_by_key(limit - 1, |m| (m.distance, m.photo_id));
+        matches.truncate(limit);
+    }
+}
+
+/// 全库颜色相似索引
+pub struct ColorIndex {
+    table: RwLock<EmbeddingTable>,
+}
+
+impl ColorIndex {
+    /// 从数据库加载所有未删除照片的颜色签名
+    pub fn load(db: &Database) -> AppResult<Self> {
+        let started = std::time::Instant::now();
+        let index = Self::empty();
+        {
+            let mut table = index.write()?;
+            for (photo_id, bytes) in db.get_color_signatures()? {
+                if let Some(signature) = ColorSignature::from_bytes(&bytes) {
+                    table.upsert(photo_id, signature.embedding);
+                }
+            }
+            tracing::info!(
+                "颜色索引加载完成: {} 张照片, {}ms",
+                table.ids.len(),
+                started.elapsed().as_millis()
+            );
+        }
+        Ok(index)
+    }
+
+    /// 空索引
+    pub fn empty() -> Self {
+        Self {
+            table: RwLock::new(EmbeddingTable::default()),
+        }
+    }
+
+    fn read(&self) -> AppResult<std::sync::RwLockReadGuard<'_, EmbeddingTable>> {
+        self.table
+            .read()
+            .map_err(|e| AppError::General(format!("颜色索引锁异常: {}", e)))
+    }
+
+    fn write(&self) -> AppResult<std::sync::RwLockWriteGuard<'_, EmbeddingTable>> {
+        self.table
+            .write()
+            .map_err(|e| AppError::General(format!("颜色索引锁异常: {}", e)))
+    }
+
+    /// 已索引的照片数
+    pub fn len(&self) -> usize {
+        self.table.read().map(|t| t.ids.len()).unwrap_or(0)
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// 插入或更新照片
+    pub fn upsert(&self, photo_id: i64, embedding: ColorEmbedding) {
+        if let Ok(mut table) = self.table.write() {
+            table.upsert(photo_id, embedding);
+        }
+    }
+
+    /// 移除照片（移入回收站或彻底删除时调用）
+    pub fn remove(&self, photo_ids: &[i64]) {
+        if let Ok(mut table) = self.table.write() {
+            for &id in photo_ids {
+                table.remove(id);
+            }
+        }
+    }
+
+    /// 从数据库重新读取指定照片的颜色签名（从回收站恢复时调用）
+    pub fn refresh(&self, db: &Database, photo_ids: &[i64]) -> AppResult<()> {
+        for &id in photo_ids {
+            match db.get_color_signature(id)? {
+                Some(signature) => self.upsert(id, signature.embedding),
+                None => self.remove(&[id]),
+            }
+        }
+        Ok(())
+    }
+
+    /// 与照片颜色最相近的照片（不含自身），`None` 表示该照片不在索引中
+    pub fn similar_to_photo(&self, photo_id: i64, limit: usize) -> AppResult<Option<Vec<ColorMatch>>> {
+        let table = self.read()?;
+        let query = match table.slot_of.get(&photo_id) {
+            Some(&slot) => table.embeddings[slot],
+            None => return Ok(None),
+        };
+        Ok(Some(table.nearest(&query, limit, Some(photo_id))))
+    }
+
+    /// 与给定嵌入最相近的照片
+    pub fn similar_to_embedding(&self, query: &ColorEmbedding, limit: usize) -> AppResult<Vec<ColorMatch>> {
+        Ok(self.read()?.nearest(query, limit, None))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::utils::color_signature::EMBEDDING_DIM;
+
+    fn embedding(fill: u8) -> ColorEmbedding {
+        [fill; EMBEDDING_DIM]
+    }
+
+    #[test]
+    fn test_nearest_orders_by_distance() {
+        let index = ColorIndex::empty();
+        for i in 0..10_000i64 {
+            index.upsert(i, embedding((i % 200) as u8));
+        }
+
+        let matches = index.similar_to_embedding(&embedding(50), 3).unwrap();
+        assert_eq!(matches.len(), 3);
+        assert_eq!(matches[0].distance, 0);
+        assert!(matches.iter().all(|m| m.photo_id % 200 == 50));
+
+        // limit 为 0 不限数量
+        assert_eq!(index.similar_to_embedding(&embedding(50), 0).unwrap().len(), 10_000);
+
+        let matches = index.similar_to_photo(51, 5).unwrap().unwrap();
+        assert!(matches.iter().all(|m| m.photo_id != 51));
+        assert_eq!(matches[0].distance, 0);
+        assert!(index.similar_to_photo(-1, 5).unwrap().is_none());
+    }
+
+    #[test]
+    fn test_remove_keeps_table_consistent() {
+        let index = ColorIndex::empty();
+        index.upsert(1, embedding(10));
+        index.upsert(2, embedding(20));
+        index.upsert(3, embedding(30));
+
+        index.remove(&[1]);
+        assert_eq!(index.len(), 2);
+        // 被移动到空位的条目仍能按 ID 找到
+        let matches = index.similar_to_photo(3, 10).unwrap().unwrap();
+        assert_eq!(matches, vec![ColorMatch { photo_id: 2, distance: 10 * EMBEDDING_DIM as u32 }]);
+
+        index.upsert(3, embedding(20));
+        assert_eq!(index.similar_to_photo(2, 1).unwrap().unwrap()[0].distance, 0);
+    }
+}
@@ -0,0 +1,494 @@
+//! 近似重复索引服务
+//!
+//! 在内存中对感知哈希建立汉明空间索引（多索引哈希，Multi-Index Hashing）：
+//! 64 位哈希切成 4 段 16 位，每段一张倒排表。两哈希距离不超过 r 时，
+//! 由抽屉原理至少有一段距离不超过 r / 4，只需在各段枚举这一半径内的取值，
+//! 再对候选逐一校验完整距离，避免两两比较。
+
+use std::collections::HashMap;
+use std::sync::RwLock;
+
+use rayon::prelude::*;
+
+use crate::db::Database;
+use crate::utils::error::{AppError, AppResult};
+use crate::utils::perceptual_hash::{hamming_distance, PerceptualHash};
+
+/// 段数
+const CHUNKS: usize = 4;
+/// 每段的取值个数
+const CHUNK_VALUES: usize = 1 << 16;
+/// 未建入倒排表的新条目超过此数时重建
+const REBUILD_THRESHOLD: usize = 4096;
+/// 支持的最大查询距离（每段半径 6，单段最多枚举约 1.5 万个取值）
+pub const MAX_DUPLICATE_DISTANCE: u32 = 27;
+
+/// 使用哪种感知哈希
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PerceptualHashKind {
+    /// DCT pHash，对缩放、压缩、轻微调色更稳定
+    PHash,
+    /// dHash，计算更快，对裁剪更敏感
+    DHash,
+}
+
+/// 近邻结果
+#[derive(Debug, Clone, Copy, PartialEq, Eq, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct DuplicateNeighbor {
+    pub photo_id: i64,
+    pub distance: u32,
+}
+
+/// 单段倒排表（CSR 格式）
+#[derive(Default)]
+struct ChunkTable {
+    /// 取值 v 的条目位于 `entries[offsets[v]..offsets[v + 1]]`
+    offsets: Vec<u32>,
+    /// (完整哈希, 条目编号)，哈希内联存放，校验候选时顺序读取，不必随机访问 `hashes`
+    entries: Vec<(u64, u32)>,
+}
+
+#[inline]
+fn chunk(hash: u64, c: usize) -> u16 {
+    (hash >> (c * 16)) as u16
+}
+
+/// 单一哈希种类的汉明空间索引
+#[derive(Default)]
+pub struct HammingIndex {
+    ids: Vec<i64>,
+    hashes: Vec<u64>,
+    live: Vec<bool>,
+    slot_of: HashMap<i64, u32>,
+    dead: usize,
+    tables: Vec<ChunkTable>,
+    /// 前 `indexed` 个条目已建入倒排表，其余线性扫描
+    indexed: usize,
+}
+
+impl HammingIndex {
+    /// 由 (photo_id, hash) 列表构建索引
+    pub fn build(entries: impl IntoIterator<Item = (i64, u64)>) -> Self {
+        let mut index = Self::default();
+        for (id, hash) in entries {
+            index.push(id, hash);
+        }
+        index.rebuild();
+        index
+    }
+
+    /// 有效条目数
+    pub fn len(&self) -> usize {
+        self.slot_of.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.slot_of.is_empty()
+    }
+
+    /// 照片的哈希
+    pub fn get(&self, photo_id: i64) -> Option<u64> {
+        self.slot_of.get(&photo_id).map(|&slot| self.hashes[slot as usize])
+    }
+
+    /// 插入或更新照片的哈希
+    pub fn upsert(&mut self, photo_id: i64, hash: u64) {
+        if self.get(photo_id) == Some(hash) {
+            return;
+        }
+        self.remove(photo_id);
+        self.push(photo_id, hash);
+        if self.ids.len() - self.indexed > REBUILD_THRESHOLD {
+            self.rebuild();
+        }
+    }
+
+    /// 移除照片
+    pub fn remove(&mut self, photo_id: i64) {
+        if let Some(slot) = self.slot_of.remove(&photo_id) {
+            self.live[slot as usize] = false;
+            self.dead += 1;
+        }
+    }
+
+    fn push(&mut self, photo_id: i64, hash: u64) {
+        if let Some(old) = self.slot_of.insert(photo_id, self.ids.len() as u32) {
+            self.live[old as usize] = false;
+            self.dead += 1;
+        }
+        self.ids.push(photo_id);
+        self.hashes.push(hash);
+        self.live.push(true);
+    }
+
+    /// 清理已删除条目并重建全部倒排表（计数排序，O(n)）
+    fn rebuild(&mut self) {
+        if self.dead > 0 {
+            let mut ids = Vec::with_capacity(self.slot_of.len());
+            let mut hashes = Vec::with_capacity(self.slot_of.len());
+            for slot in 0..self.ids.len() {
+                if self.live[slot] {
+                    ids.push(self.ids[slot]);
+                    hashes.push(self.hashes[slot]);
+                }
+            }
+            self.slot_of = ids.iter().enumerate().map(|(slot, &id)| (id, slot as u32)).collect();
+            self.live = vec![true; ids.len()];
+            self.ids = ids;
+            self.hashes = hashes;
+            self.dead = 0;
+        }
+
+        let hashes = &self.hashes;
+        self.tables = (0..CHUNKS)
+            .into_par_iter()
+            .map(|c| {
+                let mut offsets = vec![0u32; CHUNK_VALUES + 1];
+                for &hash in hashes {
+                    offsets[chunk(hash, c) as usize + 1] += 1;
+                }
+                for v in 0..CHUNK_VALUES {
+                    offsets[v + 1] += offsets[v];
+                }
+                let mut cursor = offsets.clone();
+                let mut entries = vec![(0u64, 0u32); hashes.len()];
+                for (slot, &hash) in hashes.iter().enumerate() {
+                    let v = chunk(hash, c) as usize;
+                    entries[cursor[v] as usize] = (hash, slot as u32);
+                    cursor[v] += 1;
+                }
+                ChunkTable { offsets, entries }
+            })
+            .collect();
+        self.indexed = self.ids.len();
+    }
+
+    /// 查找与 `hash` 距离不超过 `max_distance` 的条目，对每个 (slot, 距离) 调用 `visit`
+    fn search(&self, hash: u64, max_distance: u32, mut visit: impl FnMut(usize, u32)) {
+        let radius = max_distance / CHUNKS as u32;
+        let query: [u16; CHUNKS] = std::array::from_fn(|c| chunk(hash, c));
+
+        for (c, table) in self.tables.iter().enumerate() {
+            for_each_within(query[c], radius, |value| {
+                let v = value as usize;
+                for &(other, slot) in &table.entries[table.offsets[v] as usize..table.offsets[v + 1] as usize] {
+                    let distance = hamming_distance(other, hash);
+                    if distance > max_distance {
+                        continue;
+                    }
+                    // 更靠前的段也在半径内时，该条目已在那一段被访问过
+                    if (0..c).any(|p| hamming_distance(chunk(other, p) as u64, query[p] as u64) <= radius) {
+                        continue;
+                    }
+                    if self.live[slot as usize] {
+                        visit(slot as usize, distance);
+                    }
+                }
+            });
+        }
+
+        for slot in self.indexed..self.ids.len() {
+            if self.live[slot] {
+                let distance = hamming_distance(self.hashes[slot], hash);
+                if distance <= max_distance {
+                    visit(slot, distance);
+                }
+            }
+        }
+    }
+
+    /// 与 `hash` 距离不超过 `max_distance` 的照片，按距离升序
+    pub fn neighbors_of_hash(&self, hash: u64, max_distance: u32) -> Vec<DuplicateNeighbor> {
+        let mut result = Vec::new();
+        self.search(hash, max_distance.min(MAX_DUPLICATE_DISTANCE), |slot, distance| {
+            result.push(DuplicateNeighbor {
+                photo_id: self.ids[slot],
+                distance,
+            });
+        });
+        result.sort_by_key(|n| (n.distance, n.photo_id));
+        result
+    }
+
+    /// 照片的近邻（不含自身），按距离升序
+    pub fn neighbors(&self, photo_id: i64, max_distance: u32) -> Option<Vec<DuplicateNeighbor>> {
+        let hash = self.get(photo_id)?;
+        let mut result = self.neighbors_of_hash(hash, max_distance);
+        result.retain(|n| n.photo_id != photo_id);
+        Some(result)
+    }
+
+    /// 全库近似重复分组
+    ///
+    /// 距离不超过 `max_distance` 的照片连边后取连通分量（单链接），
+    /// 只返回至少两张照片的分组；组内按照片 ID 排序，组间按大小降序。
+    pub fn clusters(&self, max_distance: u32) -> Vec<Vec<i64>> {
+        let max_distance = max_distance.min(MAX_DUPLICATE_DISTANCE);
+
+        // 每个条目只收集编号更大的近邻，每条边只出现一次
+        let edges: Vec<(u32, u32)> = (0..self.ids.len())
+            .into_par_iter()
+            .filter(|&slot| self.live[slot])
+            .flat_map_iter(|slot| {
+                let mut local = Vec::new();
+                self.search(self.hashes[slot], max_distance, |other, _| {
+                    if other > slot {
+                        local.push((slot as u32, other as u32));
+                    }
+                });
+                local
+            })
+            .collect();
+
+        let mut parent: Vec<u32> = (0..self.ids.len() as u32).collect();
+        fn find(parent: &mut [u32], mut x: u32) -> u32 {
+            while parent[x as usize] != x {
+                parent[x as usize] = parent[parent[x as usize] as usize];
+                x = parent[x as usize];
+            }
+            x
+        }
+        for (a, b) in edges {
+            let (ra, rb) = (find(&mut parent, a), find(&mut parent, b));
+            if ra != rb {
+                parent[ra.max(rb) as usize] = ra.min(rb);
+            }
+        }
+
+        let mut groups: HashMap<u32, Vec<i64>> = HashMap::new();
+        for slot in 0..self.ids.len() {
+            if self.live[slot] {
+                let root = find(&mut parent, slot as u32);
+                groups.entry(root).or_default().push(self.ids[slot]);
+            }
+        }
+
+        let mut clusters: Vec<Vec<i64>> = groups.into_values().filter(|g| g.len() > 1).collect();
+        for cluster in &mut clusters {
+            cluster.sort_unstable();
+        }
+        clusters.sort_by(|a, b| b.len().cmp(&a.len()).then(a[0].cmp(&b[0])));
+        clusters
+    }
+}
+
+/// 枚举与 `value` 汉明距离不超过 `radius` 的全部 16 位取值
+fn for_each_within(value: u16, radius: u32, mut f: impl FnMut(u16)) {
+    fn flip(value: u16, start: u32, remaining: u32, f: &mut impl FnMut(u16)) {
+        f(value);
+        if remaining == 0 {
+            return;
+        }
+        for bit in start..16 {
+            flip(value ^ (1 << bit), bit + 1, remaining - 1, f);
+        }
+    }
+    flip(value, 0, radius.min(16), &mut f);
+}
+
+/// 全库近似重复索引（pHash 与 dHash 各一份）
+pub struct DuplicateIndex {
+    phash: RwLock<HammingIndex>,
+    dhash: RwLock<HammingIndex>,
+}
+
+impl DuplicateIndex {
+    /// 从数据库加载所有未删除照片的感知哈希
+    pub fn load(db: &Database) -> AppResult<Self> {
+        let started = std::time::Instant::now();
+        let rows = db.get_perceptual_hashes()?;
+
+        let (phash, dhash) = rayon::join(
+            || HammingIndex::build(rows.iter().map(|(id, h)| (*id, h.phash))),
+            || HammingIndex::build(rows.iter().map(|(id, h)| (*id, h.dhash))),
+        );
+        tracing::info!(
+            "近似重复索引加载完成: {} 张照片, {}ms",
+            rows.len(),
+            started.elapsed().as_millis()
+        );
+
+        Ok(Self {
+            phash: RwLock::new(phash),
+            dhash: RwLock::new(dhash),
+        })
+    }
+
+    /// 空索引
+    pub fn empty() -> Self {
+        Self {
+            phash: RwLock::new(HammingIndex::default()),
+            dhash: RwLock::new(HammingIndex::default()),
+        }
+    }
+
+    fn index(&self, kind: PerceptualHashKind) -> &RwLock<HammingIndex> {
+        match kind {
+            PerceptualHashKind::PHash => &self.phash,
+            PerceptualHashKind::DHash => &self.dhash,
+        }
+    }
+
+    fn read(&self, kind: PerceptualHashKind) -> AppResult<std::sync::RwLockReadGuard<'_, HammingIndex>> {
+        self.index(kind)
+            .read()
+            .map_err(|e| AppError::General(format!("近似重复索引锁异常: {}", e)))
+    }
+
+    /// 已索引的照片数
+    pub fn len(&self) -> usize {
+        self.phash.read().map(|i| i.len()).unwrap_or(0)
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// 插入或更新照片
+    pub fn upsert(&self, photo_id: i64, hash: &PerceptualHash) {
+        if let Ok(mut index) = self.phash.write() {
+            index.upsert(photo_id, hash.phash);
+        }
+        if let Ok(mut index) = self.dhash.write() {
+            index.upsert(photo_id, hash.dhash);
+        }
+    }
+
+    /// 移除照片（移入回收站或彻底删除时调用）
+    pub fn remove(&self, photo_ids: &[i64]) {
+        for lock in [&self.phash, &self.dhash] {
+            if let Ok(mut index) = lock.write() {
+                for &id in photo_ids {
+                    index.remove(id);
+                }
+            }
+        }
+    }
+
+    /// 从数据库重新读取指定照片的哈希（从回收站恢复时调用）
+    pub fn refresh(&self, db: &Database, photo_ids: &[i64]) -> AppResult<()> {
+        for &id in photo_ids {
+            match db.get_photo(id)? {
+                Some(photo) if !photo.is_deleted => {
+                    if let (Some(dhash), Some(phash)) = (photo.dhash, photo.phash) {
+                        self.upsert(id, &PerceptualHash { dhash, phash });
+                    }
+                }
+                _ => self.remove(&[id]),
+            }
+        }
+        Ok(())
+    }
+
+    /// 照片的近邻，`None` 表示该照片不在索引中
+    pub fn neighbors(
+        &self,
+        photo_id: i64,
+        kind: PerceptualHashKind,
+        max_distance: u32,
+    ) -> AppResult<Option<Vec<DuplicateNeighbor>>> {
+        Ok(self.read(kind)?.neighbors(photo_id, max_distance))
+    }
+
+    /// 全库近似重复分组
+    pub fn clusters(&self, kind: PerceptualHashKind, max_distance: u32) -> AppResult<Vec<Vec<i64>>> {
+        Ok(self.read(kind)?.clusters(max_distance))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// 确定性的伪随机 64 位哈希
+    fn hash_of(i: u64) -> u64 {
+        let mut z = i.wrapping_add(0x9E37_79B9_7F4A_7C15);
+        z = (z ^ (z >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+        z = (z ^ (z >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+        z ^ (z >> 31)
+    }
+
+    fn brute_force(entries: &[(i64, u64)], hash: u64, max_distance: u32) -> Vec<i64> {
+        let mut ids: Vec<i64> = entries
+            .iter()
+            .filter(|(_, h)| hamming_distance(*h, hash) <= max_distance)
+            .map(|(id, _)| *id)
+            .collect();
+        ids.sort_unstable();
+        ids
+    }
+
+    #[test]
+    fn test_for_each_within_counts() {
+        let mut count = 0;
+        for_each_within(0xABCD, 2, |_| count += 1);
+        // 1 + C(16,1) + C(16,2)
+        assert_eq!(count, 1 + 16 + 120);
+    }
+
+    #[test]
+    fn test_search_matches_brute_force() {
+        // 随机哈希加上若干人为构造的近邻
+        let mut entries: Vec<(i64, u64)> = (0..3000).map(|i| (i as i64, hash_of(i))).collect();
+        for i in 0..200u64 {
+            let base = hash_of(i);
+            let flipped = base ^ (hash_of(i + 10_000) & hash_of(i + 20_000) & hash_of(i + 30_000));
+            entries.push((10_000 + i as i64, flipped));
+        }
+
+        let mut index = HammingIndex::build(entries.iter().copied());
+        // 插入部分条目走线性扫描的未建表区
+        for i in 0..50u64 {
+            let entry = (20_000 + i as i64, hash_of(i) ^ 0b1011);
+            index.upsert(entry.0, entry.1);
+            entries.push(entry);
+        }
+
+        for max_distance in [0, 3, 8, 12] {
+            for q in (0..200u64).step_by(7) {
+                let hash = hash_of(q);
+                let mut found: Vec<i64> = index
+                    .neighbors_of_hash(hash, max_distance)
+                    .into_iter()
+                    .map(|n| n.photo_id)
+                    .collect();
+                found.sort_unstable();
+                assert_eq!(found, brute_force(&entries, hash, max_distance), "k={}", max_distance);
+            }
+        }
+    }
+
+    #[test]
+    fn test_upsert_and_remove() {
+        let mut index = HammingIndex::build([(1, 0u64), (2, 0b1)]);
+        assert_eq!(index.neighbors(1, 2).unwrap().len(), 1);
+
+        index.remove(2);
+        assert!(index.neighbors(1, 2).unwrap().is_empty());
+        assert!(index.neighbors(2, 2).is_none());
+
+        index.upsert(2, u64::MAX);
+        index.upsert(3, 0b11);
+        let neighbors = index.neighbors(1, 2).unwrap();
+        assert_eq!(neighbors, vec![DuplicateNeighbor { photo_id: 3, distance: 2 }]);
+        assert_eq!(index.len(), 3);
+    }
+
+    #[test]
+    fn test_clusters() {
+        let entries = vec![
+            (1, 0u64),
+            (2, 0b11),            // 与 1 距离 2
+            (3, 0b1111),          // 与 2 距离 2，与 1 距离 4（单链接归入同组）
+            (4, u64::MAX),        // 远离其他
+            (5, u64::MAX ^ 0b1),  // 与 4 距离 1
+            (6, 0xFFFF_0000),     // 单独
+        ];
+        let index = HammingIndex::build(entries);
+
+        let clusters = index.clusters(2);
+        assert_eq!(clusters, vec![vec![1, 2, 3], vec![4, 5]]);
+        assert!(index.clusters(0).is_empty());
+    }
+}
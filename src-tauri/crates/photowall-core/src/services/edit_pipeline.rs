@@ -0,0 +1,986 @@
+//! 融合编辑管线
+//!
+//! [`EditorService::apply_edits`] 每个调整单独遍历一次整张图，并在步骤之间量化到 u8。
+//! 预览需要对同一组参数反复渲染，这里把编辑操作编译成阶段：
+//! - 连续的逐像素调整（亮度、对比度、曝光、色温……）合并成一次遍历，中间结果保持浮点；
+//! - 几何和邻域操作（旋转、裁剪、锐化、模糊、一键优化）仍走 `EditorService`。
+//!
+//! 最后一组逐像素调整作为输出遍历，按行分块在 rayon 线程池上并行，并可随时取消。
+//! 输出遍历可直接写入调用方提供的缓冲区（RGBA8 或 RGBA16F，任意行距），
+//! 显示层拿到后直接上传纹理，不再经过编码和拷贝。
+//! 前后对比和溢出警告同样在输出遍历中逐像素合成（见 [`DisplayMode`]），不需要额外渲染；
+//! 示波器也在这次遍历中顺带统计。
+
+use std::borrow::Cow;
+use std::sync::OnceLock;
+
+use image::{DynamicImage, RgbaImage};
+use rayon::prelude::*;
+
+use crate::utils::error::{AppError, AppResult};
+
+use super::colorspace::{self, adjust_temperature_value, lab_to_srgb, luminance, srgb_to_lab};
+use super::editor::{CropRect, EditOperation, EditParams, EditorService};
+use super::scopes::{ScopeAccumulator, Scopes};
+
+/// 每个并行任务处理的行数
+const ROWS_PER_CHUNK: usize = 16;
+
+/// 伽马查找表的分段数
+const GAMMA_LUT_STEPS: usize = 4096;
+
+/// 分段线性插值的查找表，输入为 0..1
+struct GammaLut([f32; GAMMA_LUT_STEPS + 1]);
+
+impl GammaLut {
+    fn build(f: fn(f32) -> f32) -> Box<Self> {
+        let mut table = Box::new(GammaLut([0.0; GAMMA_LUT_STEPS + 1]));
+        for (i, v) in table.0.iter_mut().enumerate() {
+            *v = f(i as f32 / GAMMA_LUT_STEPS as f32);
+        }
+        table
+    }
+
+    #[inline]
+    fn eval(&self, v: f32) -> f32 {
+        let pos = v.clamp(0.0, 1.0) * GAMMA_LUT_STEPS as f32;
+        let i = (pos as usize).min(GAMMA_LUT_STEPS - 1);
+        let t = pos - i as f32;
+        self.0[i] + (self.0[i + 1] - self.0[i]) * t
+    }
+}
+
+/// 查表版 sRGB → 线性，误差远小于 8 位量化；逐像素的 `powf` 是预览渲染的主要开销
+#[inline]
+fn srgb_to_linear(v: f32) -> f32 {
+    static LUT: OnceLock<Box<GammaLut>> = OnceLock::new();
+    LUT.get_or_init(|| GammaLut::build(colorspace::srgb_to_linear)).eval(v)
+}
+
+/// 查表版线性 → sRGB
+#[inline]
+fn linear_to_srgb(v: f32) -> f32 {
+    static LUT: OnceLock<Box<GammaLut>> = OnceLock::new();
+    LUT.get_or_init(|| GammaLut::build(colorspace::linear_to_srgb)).eval(v)
+}
+
+/// 可融合的逐像素调整，参数已换算成计算用的常量
+#[derive(Debug, Clone, Copy)]
+enum PointOp {
+    Brightness(f32),
+    Contrast(f32),
+    Saturation(f32),
+    /// 曝光倍数 2^EV
+    Exposure(f32),
+    Highlights(f32),
+    Shadows(f32),
+    /// Bradford 色温适应是线性变换，预先求出作用于线性 RGB 的矩阵（按列存放）
+    Temperature([[f32; 3]; 3]),
+    /// Lab a 通道偏移
+    Tint(f32),
+    Vignette(f32),
+}
+
+impl PointOp {
+    /// 逐像素调整返回 `Some`，取值为 0 的调整返回 `Some(None)`；其他操作返回 `None`。
+    /// 取值范围和换算与 `EditorService` 中对应的函数一致。
+    fn compile(op: &EditOperation) -> Option<Option<PointOp>> {
+        let point = match *op {
+            EditOperation::Brightness { value } => {
+                let value = value.clamp(-100, 100);
+                (value != 0).then(|| PointOp::Brightness(value as f32 / 100.0))
+            }
+            EditOperation::Contrast { value } => {
+                let value = value.clamp(-100, 100);
+                let factor = if value >= 0 {
+                    1.0 + value as f32 / 50.0
+                } else {
+                    1.0 + value as f32 / 100.0
+                };
+                (value != 0).then(|| PointOp::Contrast(factor))
+            }
+            EditOperation::Saturation { value } => {
+                let value = value.clamp(-100, 100);
+                (value != 0).then(|| PointOp::Saturation(1.0 + value as f32 / 100.0))
+            }
+            EditOperation::Exposure { value } => {
+                let value = value.clamp(-200, 200);
+                (value != 0).then(|| PointOp::Exposure(2.0_f32.powf(value as f32 / 100.0)))
+            }
+            EditOperation::Highlights { value } => {
+                let value = value.clamp(-100, 100);
+                (value != 0).then(|| PointOp::Highlights(value as f32 / 100.0))
+            }
+            EditOperation::Shadows { value } => {
+                let value = value.clamp(-100, 100);
+                (value != 0).then(|| PointOp::Shadows(value as f32 / 100.0))
+            }
+            EditOperation::Temperature { value } => {
+                let value = value.clamp(-100, 100);
+                (value != 0).then(|| {
+                    PointOp::Temperature([
+                        adjust_temperature_value([1.0, 0.0, 0.0], value),
+                        adjust_temperature_value([0.0, 1.0, 0.0], value),
+                        adjust_temperature_value([0.0, 0.0, 1.0], value),
+                    ])
+                })
+            }
+            EditOperation::Tint { value } => {
+                let value = value.clamp(-100, 100);
+                (value != 0).then(|| PointOp::Tint(value as f32 / 100.0 * 30.0))
+            }
+            EditOperation::Vignette { value } => {
+                let value = value.clamp(0, 100);
+                (value != 0).then(|| PointOp::Vignette(value as f32 / 100.0))
+            }
+            _ => return None,
+        };
+        Some(point)
+    }
+
+    /// 作用于 0..1 的 sRGB 像素；`dist2` 为到中心的归一化距离平方（暗角用）
+    #[inline]
+    fn apply(self, [r, g, b]: [f32; 3], dist2: f32) -> [f32; 3] {
+        let out = match self {
+            PointOp::Brightness(f) => {
+                let f3 = |v: f32| if f >= 0.0 { v + (1.0 - v) * f } else { v * (1.0 + f) };
+                [f3(r), f3(g), f3(b)]
+            }
+            PointOp::Contrast(factor) => {
+                let f3 = |v: f32| (v - 0.5) * factor + 0.5;
+                [f3(r), f3(g), f3(b)]
+            }
+            PointOp::Saturation(factor) => {
+                let gray = 0.299 * r + 0.587 * g + 0.114 * b;
+                [gray + (r - gray) * factor, gray + (g - gray) * factor, gray + (b - gray) * factor]
+            }
+            PointOp::Exposure(factor) => {
+                let f3 = |v: f32| {
+                    let exposed = srgb_to_linear(v) * factor;
+                    // Filmic 高光保护
+                    let protected = if exposed > 1.0 {
+                        1.0 - (-(exposed - 1.0) * 2.0).exp() * 0.5
+                    } else {
+                        exposed
+                    };
+                    linear_to_srgb(protected.clamp(0.0, 1.0))
+                };
+                [f3(r), f3(g), f3(b)]
+            }
+            PointOp::Highlights(strength) => {
+                let (lr, lg, lb) = (srgb_to_linear(r), srgb_to_linear(g), srgb_to_linear(b));
+                let lum = luminance(lr, lg, lb);
+                let pivot = 0.5;
+                if lum <= pivot {
+                    return [r, g, b];
+                }
+                let blend = 1.0 / (1.0 + (-6.0 * (lum - pivot)).exp());
+                let adjustment = if strength > 0.0 {
+                    (1.0 - lum) * blend * strength * 0.5
+                } else {
+                    -lum * blend * strength.abs() * 0.5
+                };
+                let scale = if lum > 0.001 { (lum + adjustment) / lum } else { 1.0 };
+                [
+                    linear_to_srgb((lr * scale).clamp(0.0, 1.0)),
+                    linear_to_srgb((lg * scale).clamp(0.0, 1.0)),
+                    linear_to_srgb((lb * scale).clamp(0.0, 1.0)),
+                ]
+            }
+            PointOp::Shadows(strength) => {
+                let (lr, lg, lb) = (srgb_to_linear(r), srgb_to_linear(g), srgb_to_linear(b));
+                let lum = luminance(lr, lg, lb);
+                let pivot = 0.3;
+                if lum >= pivot {
+                    return [r, g, b];
+                }
+                let blend = 1.0 / (1.0 + (6.0 * (lum - pivot)).exp());
+                let adjustment = if strength > 0.0 {
+                    (pivot - lum) * blend * strength * 0.8
+                } else {
+                    -lum * blend * strength.abs() * 0.5
+                };
+                let new_lum = (lum + adjustment).clamp(0.001, 1.0);
+                let scale = new_lum / lum.max(0.001);
+                [
+                    linear_to_srgb((lr * scale).clamp(0.0, 1.0)),
+                    linear_to_srgb((lg * scale).clamp(0.0, 1.0)),
+                    linear_to_srgb((lb * scale).clamp(0.0, 1.0)),
+                ]
+            }
+            PointOp::Temperature(m) => {
+                let (lr, lg, lb) = (srgb_to_linear(r), srgb_to_linear(g), srgb_to_linear(b));
+                let nr = m[0][0] * lr + m[1][0] * lg + m[2][0] * lb;
+                let ng = m[0][1] * lr + m[1][1] * lg + m[2][1] * lb;
+                let nb = m[0][2] * lr + m[1][2] * lg + m[2][2] * lb;
+                [
+                    linear_to_srgb(nr.clamp(0.0, 1.0)),
+                    linear_to_srgb(ng.clamp(0.0, 1.0)),
+                    linear_to_srgb(nb.clamp(0.0, 1.0)),
+                ]
+            }
+            PointOp::Tint(adjustment) => {
+                let (l, a, lab_b) = srgb_to_lab(r, g, b);
+                let (nr, ng, nb) = lab_to_srgb(l, a + adjustment, lab_b);
+                [nr, ng, nb]
+            }
+            PointOp::Vignette(strength) => {
+                let v = 1.0 - dist2 * strength;
+                [r * v, g * v, b * v]
+            }
+        };
+        [out[0].clamp(0.0, 1.0), out[1].clamp(0.0, 1.0), out[2].clamp(0.0, 1.0)]
+    }
+}
+
+/// 一组融合的逐像素调整
+#[derive(Debug, Clone, Default)]
+pub(crate) struct PointPass {
+    ops: Vec<PointOp>,
+}
+
+impl PointPass {
+    pub(crate) fn is_identity(&self) -> bool {
+        self.ops.is_empty()
+    }
+
+    /// 计算 `(x, y)` 处像素调整后的值（0..1 sRGB）
+    #[inline]
+    pub(crate) fn apply(&self, rgb: [f32; 3], x: u32, y: u32, width: u32, height: u32) -> [f32; 3] {
+        let mut rgb = rgb;
+        for op in &self.ops {
+            let dist2 = match op {
+                PointOp::Vignette(_) => {
+                    let (cx, cy) = (width as f32 / 2.0, height as f32 / 2.0);
+                    let (dx, dy) = (x as f32 - cx, y as f32 - cy);
+                    (dx * dx + dy * dy) / (cx * cx + cy * cy)
+                }
+                _ => 0.0,
+            };
+            rgb = op.apply(rgb, dist2);
+        }
+        rgb
+    }
+
+    /// 对整张图执行一次，结果量化回 RGBA8
+    fn run(&self, src: &RgbaImage, cancelled: &(dyn Fn() -> bool + Sync)) -> Option<RgbaImage> {
+        let (width, height) = src.dimensions();
+        let row_bytes = width as usize * 4;
+        let mut out = vec![0u8; row_bytes * height as usize];
+        let mut target = FrameBuffer {
+            format: PixelFormat::Rgba8,
+            stride: row_bytes,
+            data: &mut out,
+        };
+        if !self.write(src, src, DisplayMode::Edited, &mut target, None, cancelled) {
+            return None;
+        }
+        RgbaImage::from_raw(width, height, out)
+    }
+
+    /// 对整张图执行一次，按显示方式与 `before`（调整前、几何相同的图）合成后
+    /// 按目标格式写入 `dst`；调用方已检查过容量。
+    ///
+    /// `scopes` 不为空时同时抽样统计编辑结果的示波器：分块累加到所在工作线程的部分计数，
+    /// 结束后合并。已取消时返回 false
+    fn write(
+        &self,
+        src: &RgbaImage,
+        before: &RgbaImage,
+        mode: DisplayMode,
+        dst: &mut FrameBuffer,
+        mut scopes: Option<&mut ScopeAccumulator>,
+        cancelled: &(dyn Fn() -> bool + Sync),
+    ) -> bool {
+        let (width, height) = src.dimensions();
+        let (frame_width, _) = mode.frame_size(width, height);
+        let src_row = width as usize * 4;
+        let bpp = dst.format.bytes_per_pixel();
+        let dst_row = frame_width as usize * bpp;
+        let (format, stride) = (dst.format, dst.stride);
+        let want_scopes = scopes.is_some();
+        let copy_rows =
+            format == PixelFormat::Rgba8 && mode == DisplayMode::Edited && self.is_identity() && !want_scopes;
+        let split_x = match mode {
+            DisplayMode::Split { position } => (position.clamp(0.0, 1.0) * width as f32).round() as u32,
+            _ => 0,
+        };
+
+        // 预先求出每个像素所在的列，不抽样的列记为 NOT_SAMPLED，避免逐像素除法
+        const NOT_SAMPLED: u16 = u16::MAX;
+        let step = Scopes::sample_step(width, height);
+        let columns: Vec<u16> = match want_scopes {
+            true => (0..width)
+                .map(|x| match x % step {
+                    0 => Scopes::column(x, width) as u16,
+                    _ => NOT_SAMPLED,
+                })
+                .collect(),
+            false => vec![NOT_SAMPLED; width as usize],
+        };
+
+        if let Some(scopes) = scopes.as_mut() {
+            scopes.begin();
+        }
+        let accumulator = scopes.as_deref();
+        if let Some(len) = format.frame_len(frame_width, height, stride).filter(|&len| len > 0) {
+            dst.data[..len]
+                .par_chunks_mut(stride * ROWS_PER_CHUNK)
+                .enumerate()
+                .for_each(|(chunk, rows)| {
+                    if cancelled() {
+                        return;
+                    }
+                    let mut write_rows = |mut partial: Option<&mut Scopes>| {
+                        let y0 = chunk * ROWS_PER_CHUNK;
+                        // 最后一行可能不足 stride，chunks_mut 的尾块正好是一行像素
+                        for (dy, row) in rows.chunks_mut(stride).enumerate() {
+                            let y = (y0 + dy) as u32;
+                            let range = y as usize * src_row..(y as usize + 1) * src_row;
+                            let (after_px, before_px) = (&src.as_raw()[range.clone()], &before.as_raw()[range]);
+                            let dst_px = &mut row[..dst_row];
+                            if copy_rows {
+                                dst_px.copy_from_slice(after_px);
+                                continue;
+                            }
+                            let sample_row = y % step == 0;
+                            let mut put = |x: u32, rgb: [f32; 3], alpha: u8| {
+                                let d = &mut dst_px[x as usize * bpp..(x as usize + 1) * bpp];
+                                match format {
+                                    PixelFormat::Rgba8 => pack(rgb, alpha, d),
+                                    PixelFormat::Rgba16F => pack_f16(rgb, alpha, d),
+                                }
+                            };
+                            for (x, (s, o)) in after_px.chunks_exact(4).zip(before_px.chunks_exact(4)).enumerate() {
+                                let column = if sample_row { columns[x] } else { NOT_SAMPLED };
+                                let x = x as u32;
+                                // 分割线及其左侧不显示编辑结果，不抽样时省去调整计算
+                                let hidden = matches!(mode, DisplayMode::Split { .. }) && split_x > 0 && x <= split_x;
+                                let edited = if hidden && column == NOT_SAMPLED {
+                                    [0.0; 3]
+                                } else {
+                                    self.apply(unpack(s), x, y, width, height)
+                                };
+                                if let (Some(scopes), true) = (partial.as_deref_mut(), column != NOT_SAMPLED) {
+                                    scopes.add(edited, column as usize);
+                                }
+                                match mode {
+                                    DisplayMode::Edited => put(x, edited, s[3]),
+                                    DisplayMode::Split { .. } if hidden && x == split_x => put(x, SPLIT_LINE, 255),
+                                    DisplayMode::Split { .. } if hidden => put(x, unpack(o), o[3]),
+                                    DisplayMode::Split { .. } => put(x, edited, s[3]),
+                                    DisplayMode::SideBySide => {
+                                        put(x, unpack(o), o[3]);
+                                        put(width + x, edited, s[3]);
+                                    }
+                                    DisplayMode::Clipping { shadows, highlights } => {
+                                        put(x, clipping_overlay(edited, shadows, highlights), s[3])
+                                    }
+                                }
+                            }
+                        }
+                    };
+                    match accumulator {
+                        Some(accumulator) => accumulator.with_partial(|partial| write_rows(Some(partial))),
+                        None => write_rows(None),
+                    }
+                });
+        }
+        if let Some(scopes) = scopes {
+            scopes.finish();
+        }
+        !cancelled()
+    }
+}
+
+/// 分割线颜色
+const SPLIT_LINE: [f32; 3] = [1.0, 1.0, 1.0];
+
+/// 溢出标记：任一通道达到高光阈值标红，任一通道不高于阴影阈值标蓝，高光优先
+#[inline]
+fn clipping_overlay(rgb: [f32; 3], shadows: u8, highlights: u8) -> [f32; 3] {
+    let quantize = |v: f32| (v * 255.0 + 0.5) as u8;
+    let max = quantize(rgb[0].max(rgb[1]).max(rgb[2]));
+    let min = quantize(rgb[0].min(rgb[1]).min(rgb[2]));
+    if max >= highlights {
+        [1.0, 0.0, 0.0]
+    } else if min <= shadows {
+        [0.0, 0.0, 1.0]
+    } else {
+        rgb
+    }
+}
+
+#[inline]
+pub(crate) fn unpack(px: &[u8]) -> [f32; 3] {
+    [px[0] as f32 / 255.0, px[1] as f32 / 255.0, px[2] as f32 / 255.0]
+}
+
+#[inline]
+pub(crate) fn pack(rgb: [f32; 3], alpha: u8, dst: &mut [u8]) {
+    dst[0] = (rgb[0] * 255.0 + 0.5) as u8;
+    dst[1] = (rgb[1] * 255.0 + 0.5) as u8;
+    dst[2] = (rgb[2] * 255.0 + 0.5) as u8;
+    dst[3] = alpha;
+}
+
+#[inline]
+fn pack_f16(rgb: [f32; 3], alpha: u8, dst: &mut [u8]) {
+    dst[0..2].copy_from_slice(&f32_to_f16(rgb[0]).to_ne_bytes());
+    dst[2..4].copy_from_slice(&f32_to_f16(rgb[1]).to_ne_bytes());
+    dst[4..6].copy_from_slice(&f32_to_f16(rgb[2]).to_ne_bytes());
+    dst[6..8].copy_from_slice(&f32_to_f16(alpha as f32 / 255.0).to_ne_bytes());
+}
+
+/// f32 → IEEE 754 半精度（就近舍入）；输入为有限值，溢出时取无穷大
+fn f32_to_f16(v: f32) -> u16 {
+    let bits = v.to_bits();
+    let sign = ((bits >> 16) & 0x8000) as u16;
+    let exp = ((bits >> 23) & 0xff) as i32 - 127 + 15;
+    let mantissa = bits & 0x7f_ffff;
+    if exp >= 31 {
+        return sign | 0x7c00;
+    }
+    if exp <= 0 {
+        // 非规格化数；太小的值归零
+        if exp < -10 {
+            return sign;
+        }
+        let shift = (14 - exp) as u32;
+        let m = mantissa | 0x80_0000;
+        return sign | ((m + (1 << (shift - 1))) >> shift) as u16;
+    }
+    let half = ((exp as u32) << 10) | (mantissa >> 13);
+    let rest = mantissa & 0x1fff;
+    // 进位可以溢出到指数位，结果仍然正确
+    let rounded = if rest > 0x1000 || (rest == 0x1000 && half & 1 == 1) { half + 1 } else { half };
+    sign | rounded as u16
+}
+
+/// 输出帧的显示方式
+#[derive(Debug, Clone, Copy, PartialEq, Default)]
+pub enum DisplayMode {
+    /// 只显示编辑结果
+    #[default]
+    Edited,
+    /// 分割对比：竖直分割线左侧为调整前，`position` 为分割线的横向位置（0..1）
+    Split { position: f32 },
+    /// 并排对比：左半为调整前，右半为编辑结果，帧宽加倍
+    SideBySide,
+    /// 溢出警告：通道值（0..255）不高于 `shadows` 标蓝，不低于 `highlights` 标红
+    Clipping { shadows: u8, highlights: u8 },
+}
+
+impl DisplayMode {
+    /// 需要调整前的图像
+    fn needs_before(self) -> bool {
+        matches!(self, DisplayMode::Split { .. } | DisplayMode::SideBySide)
+    }
+
+    /// 编辑结果为 `width` x `height` 时的帧尺寸
+    pub fn frame_size(self, width: u32, height: u32) -> (u32, u32) {
+        match self {
+            DisplayMode::SideBySide => (width * 2, height),
+            _ => (width, height),
+        }
+    }
+}
+
+/// 输出像素格式
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PixelFormat {
+    /// 每通道 8 位
+    Rgba8,
+    /// 每通道 16 位半精度浮点，取值 0..1（sRGB 编码），本机字节序
+    Rgba16F,
+}
+
+impl PixelFormat {
+    pub fn bytes_per_pixel(self) -> usize {
+        match self {
+            PixelFormat::Rgba8 => 4,
+            PixelFormat::Rgba16F => 8,
+        }
+    }
+
+    /// 按 `stride` 行距存放一帧所需的字节数（最后一行不要求填满 stride）；
+    /// stride 放不下一行时返回 `None`
+    pub fn frame_len(self, width: u32, height: u32, stride: usize) -> Option<usize> {
+        let row = width as usize * self.bytes_per_pixel();
+        if stride < row {
+            return None;
+        }
+        Some(match height {
+            0 => 0,
+            h => stride * (h as usize - 1) + row,
+        })
+    }
+}
+
+/// 渲染目标缓冲区
+pub struct FrameBuffer<'a> {
+    pub format: PixelFormat,
+    /// 行距（字节）
+    pub stride: usize,
+    pub data: &'a mut [u8],
+}
+
+impl FrameBuffer<'_> {
+    /// 检查能否容纳 `width` x `height` 的帧
+    pub fn check(&self, width: u32, height: u32) -> AppResult<usize> {
+        match self.format.frame_len(width, height, self.stride) {
+            Some(len) if len <= self.data.len() => Ok(len),
+            _ => Err(AppError::General(format!(
+                "输出缓冲区太小: {}x{} {:?}, 行距 {}, 容量 {}",
+                width,
+                height,
+                self.format,
+                self.stride,
+                self.data.len()
+            ))),
+        }
+    }
+
+    /// 已写入的 `width` x `height` 帧
+    pub fn frame(&self, width: u32, height: u32) -> &[u8] {
+        let len = self.format.frame_len(width, height, self.stride).unwrap_or(0);
+        &self.data[..len]
+    }
+}
+
+enum Stage {
+    /// 几何或邻域操作，整图执行
+    Image(EditOperation),
+    /// 中间的逐像素调整组
+    Point(PointPass),
+}
+
+/// 编译后的编辑管线
+pub struct EditPipeline {
+    stages: Vec<Stage>,
+    /// 最后一组逐像素调整，在输出遍历中执行
+    output: PointPass,
+}
+
+impl EditPipeline {
+    /// 按操作顺序编译；相邻的逐像素调整合并为一组
+    pub fn compile(params: &EditParams) -> Self {
+        let mut stages = Vec::new();
+        let mut current = PointPass::default();
+        for op in &params.operations {
+            match PointOp::compile(op) {
+                Some(Some(point)) => current.ops.push(point),
+                Some(None) => {}
+                None => {
+                    if !current.is_identity() {
+                        stages.push(Stage::Point(std::mem::take(&mut current)));
+                    }
+                    stages.push(Stage::Image(op.clone()));
+                }
+            }
+        }
+        Self { stages, output: current }
+    }
+
+    /// 执行输出遍历之前的所有阶段
+    ///
+    /// `scale` 为输入图相对原图的缩放比例，裁剪区域和模糊半径按它换算，
+    /// 使不同分辨率的预览看起来一致。已取消时返回 `None`。
+    pub(crate) fn prepare<'a>(
+        &self,
+        src: &'a RgbaImage,
+        scale: f32,
+        cancelled: &(dyn Fn() -> bool + Sync),
+    ) -> Option<Cow<'a, RgbaImage>> {
+        let mut current = Cow::Borrowed(src);
+        for stage in &self.stages {
+            if cancelled() {
+                return None;
+            }
+            current = match stage {
+                Stage::Point(pass) => Cow::Owned(pass.run(&current, cancelled)?),
+                Stage::Image(op) => {
+                    let op = match scaled_operation(op, scale, current.dimensions()) {
+                        Some(op) => op,
+                        // 预览中无效的操作（如裁剪越界）直接跳过
+                        None => continue,
+                    };
+                    let img = DynamicImage::ImageRgba8(current.into_owned());
+                    let result = match op {
+                        ScaledOp::Blur(sigma) => img.blur(sigma),
+                        ScaledOp::Op(op) => match EditorService::apply_operation(img, &op) {
+                            Ok(img) => img,
+                            Err(e) => {
+                                tracing::debug!("预览编辑操作失败 {:?}: {}", op, e);
+                                return None;
+                            }
+                        },
+                    };
+                    Cow::Owned(result.into_rgba8())
+                }
+            };
+        }
+        Some(current)
+    }
+
+    /// 调整前的对比图：只执行旋转、翻转和裁剪，使之与编辑结果逐像素对齐
+    fn prepare_before<'a>(
+        &self,
+        src: &'a RgbaImage,
+        scale: f32,
+        cancelled: &(dyn Fn() -> bool + Sync),
+    ) -> Option<Cow<'a, RgbaImage>> {
+        let mut current = Cow::Borrowed(src);
+        for stage in &self.stages {
+            let Stage::Image(op) = stage else { continue };
+            if !matches!(op, EditOperation::Rotate { .. } | EditOperation::Flip { .. } | EditOperation::Crop { .. }) {
+                continue;
+            }
+            if cancelled() {
+                return None;
+            }
+            let Some(ScaledOp::Op(op)) = scaled_operation(op, scale, current.dimensions()) else {
+                continue;
+            };
+            let img = DynamicImage::ImageRgba8(current.into_owned());
+            current = match EditorService::apply_operation(img, &op) {
+                Ok(img) => Cow::Owned(img.into_rgba8()),
+                Err(e) => {
+                    tracing::debug!("对比图编辑操作失败 {:?}: {}", op, e);
+                    return None;
+                }
+            };
+        }
+        Some(current)
+    }
+
+    /// 完整渲染为 RGBA8
+    pub fn render(&self, src: &RgbaImage, scale: f32, cancelled: &(dyn Fn() -> bool + Sync)) -> Option<RgbaImage> {
+        self.render_display(src, scale, DisplayMode::Edited, None, cancelled)
+    }
+
+    /// 按显示方式完整渲染为 RGBA8；`scopes` 不为空时统计编辑结果的示波器
+    pub fn render_display(
+        &self,
+        src: &RgbaImage,
+        scale: f32,
+        mode: DisplayMode,
+        scopes: Option<&mut ScopeAccumulator>,
+        cancelled: &(dyn Fn() -> bool + Sync),
+    ) -> Option<RgbaImage> {
+        let prepared = self.prepare(src, scale, cancelled)?;
+        if mode == DisplayMode::Edited && self.output.is_identity() && scopes.is_none() {
+            return Some(prepared.into_owned());
+        }
+        let before = self.before(src, &prepared, scale, mode, cancelled).ok()??;
+        let (width, height) = mode.frame_size(prepared.width(), prepared.height());
+        let stride = width as usize * 4;
+        let mut out = vec![0u8; stride * height as usize];
+        let mut target = FrameBuffer {
+            format: PixelFormat::Rgba8,
+            stride,
+            data: &mut out,
+        };
+        if !self.output.write(&prepared, &before, mode, &mut target, scopes, cancelled) {
+            return None;
+        }
+        RgbaImage::from_raw(width, height, out)
+    }
+
+    /// 按显示方式完整渲染并直接写入 `dst`，返回帧尺寸；已取消时返回 `Ok(None)`
+    ///
+    /// 几何操作会改变输出尺寸，缓冲区放不下时返回错误且不写入。
+    /// `scopes` 不为空时统计编辑结果的示波器。
+    pub fn render_into(
+        &self,
+        src: &RgbaImage,
+        scale: f32,
+        mode: DisplayMode,
+        dst: &mut FrameBuffer,
+        scopes: Option<&mut ScopeAccumulator>,
+        cancelled: &(dyn Fn() -> bool + Sync),
+    ) -> AppResult<Option<(u32, u32)>> {
+        let Some(prepared) = self.prepare(src, scale, cancelled) else {
+            return Ok(None);
+        };
+        let Some(before) = self.before(src, &prepared, scale, mode, cancelled)? else {
+            return Ok(None);
+        };
+        let (width, height) = mode.frame_size(prepared.width(), prepared.height());
+        dst.check(width, height)?;
+        Ok(self
+            .output
+            .write(&prepared, &before, mode, dst, scopes, cancelled)
+            .then_some((width, height)))
+    }
+
+    /// 显示方式需要的对比图；不需要时借用 `prepared` 占位
+    fn before<'a>(
+        &self,
+        src: &'a RgbaImage,
+        prepared: &'a RgbaImage,
+        scale: f32,
+        mode: DisplayMode,
+        cancelled: &(dyn Fn() -> bool + Sync),
+    ) -> AppResult<Option<Cow<'a, RgbaImage>>> {
+        if !mode.needs_before() {
+            return Ok(Some(Cow::Borrowed(prepared)));
+        }
+        let Some(before) = self.prepare_before(src, scale, cancelled) else {
+            return Ok(None);
+        };
+        // 几何操作相同，尺寸不同只可能是某一侧的操作执行失败
+        if before.dimensions() != prepared.dimensions() {
+            return Err(AppError::General("调整前后的预览尺寸不一致".to_string()));
+        }
+        Ok(Some(before))
+    }
+}
+
+enum ScaledOp {
+    Blur(f32),
+    Op(EditOperation),
+}
+
+/// 把以原图像素为单位的操作换算到缩放后的图像；对 `dims` 无效的裁剪返回 `None`
+fn scaled_operation(op: &EditOperation, scale: f32, dims: (u32, u32)) -> Option<ScaledOp> {
+    let scaled = match op {
+        EditOperation::Crop { rect } => {
+            let rect = CropRect {
+                x: (rect.x as f32 * scale).round() as u32,
+                y: (rect.y as f32 * scale).round() as u32,
+                width: ((rect.width as f32 * scale).round() as u32).max(1),
+                height: ((rect.height as f32 * scale).round() as u32).max(1),
+            };
+            if rect.x >= dims.0 || rect.y >= dims.1 {
+                return None;
+            }
+            ScaledOp::Op(EditOperation::Crop { rect })
+        }
+        EditOperation::Blur { value } if scale != 1.0 => {
+            let value = (*value).clamp(0, 100);
+            ScaledOp::Blur(value as f32 / 10.0 * scale)
+        }
+        _ => ScaledOp::Op(op.clone()),
+    };
+    Some(scaled)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::services::editor::FlipDirection;
+    use image::Rgba;
+
+    fn gradient(w: u32, h: u32) -> RgbaImage {
+        RgbaImage::from_fn(w, h, |x, y| Rgba([(x * 255 / w) as u8, (y * 255 / h) as u8, 128, 255]))
+    }
+
+    fn params(ops: Vec<EditOperation>) -> EditParams {
+        EditParams { operations: ops }
+    }
+
+    fn max_diff(a: &RgbaImage, b: &RgbaImage) -> u8 {
+        a.as_raw().iter().zip(b.as_raw()).map(|(x, y)| x.abs_diff(*y)).max().unwrap_or(0)
+    }
+
+    #[test]
+    fn test_fused_matches_sequential() {
+        let src = gradient(64, 48);
+        let ops = vec![
+            EditOperation::Exposure { value: 50 },
+            EditOperation::Contrast { value: 20 },
+            EditOperation::Saturation { value: -30 },
+            EditOperation::Highlights { value: -40 },
+            EditOperation::Shadows { value: 30 },
+            EditOperation::Temperature { value: 25 },
+            EditOperation::Tint { value: -10 },
+            EditOperation::Vignette { value: 40 },
+        ];
+        let sequential = |ops: Vec<EditOperation>| {
+            EditorService::apply_edits(DynamicImage::ImageRgba8(src.clone()), &params(ops))
+                .unwrap()
+                .into_rgba8()
+        };
+
+        // 单个调整与 EditorService 只差取整方式（四舍五入 vs 截断）
+        for op in &ops {
+            let fused = EditPipeline::compile(&params(vec![op.clone()])).render(&src, 1.0, &|| false).unwrap();
+            assert!(max_diff(&fused, &sequential(vec![op.clone()])) <= 1, "{:?}", op);
+        }
+
+        // 串联时顺序实现每步截断误差累积，融合实现保持浮点，只比较平均偏差
+        let fused = EditPipeline::compile(&params(ops.clone())).render(&src, 1.0, &|| false).unwrap();
+        let expected = sequential(ops);
+        let total: u64 = fused.as_raw().iter().zip(expected.as_raw()).map(|(x, y)| x.abs_diff(*y) as u64).sum();
+        assert!(total as f64 / fused.as_raw().len() as f64 <= 3.0);
+    }
+
+    #[test]
+    fn test_geometric_ops_split_stages() {
+        let src = gradient(40, 20);
+        let pipeline = EditPipeline::compile(&params(vec![
+            EditOperation::Brightness { value: 10 },
+            EditOperation::Rotate { degrees: 90 },
+            EditOperation::Contrast { value: 0 },
+            EditOperation::Crop { rect: CropRect { x: 0, y: 0, width: 20, height: 30 } },
+            EditOperation::Brightness { value: 10 },
+        ]));
+        assert_eq!(pipeline.stages.len(), 3);
+        assert_eq!(pipeline.output.ops.len(), 1);
+
+        let full = pipeline.render(&src, 1.0, &|| false).unwrap();
+        assert_eq!(full.dimensions(), (20, 30));
+        // 半尺寸输入时裁剪区域按比例缩小
+        let half = image::imageops::resize(&src, 20, 10, image::imageops::FilterType::Triangle);
+        let preview = pipeline.render(&half, 0.5, &|| false).unwrap();
+        assert_eq!(preview.dimensions(), (10, 15));
+    }
+
+    #[test]
+    fn test_render_into_strided_buffers() {
+        let src = gradient(30, 20);
+        let pipeline = EditPipeline::compile(&params(vec![EditOperation::Exposure { value: 40 }]));
+        let expected = pipeline.render(&src, 1.0, &|| false).unwrap();
+
+        // RGBA8，每行带填充；填充字节保持不变
+        let stride = 30 * 4 + 12;
+        let mut data = vec![0xAAu8; stride * 20];
+        let mut target = FrameBuffer { format: PixelFormat::Rgba8, stride, data: &mut data };
+        assert_eq!(pipeline.render_into(&src, 1.0, DisplayMode::Edited, &mut target, None, &|| false).unwrap(), Some((30, 20)));
+        for y in 0..20 {
+            let row = &data[y * stride..(y + 1) * stride];
+            assert_eq!(&row[..120], &expected.as_raw()[y * 120..(y + 1) * 120]);
+            assert!(row[120..].iter().all(|&b| b == 0xAA));
+        }
+
+        // RGBA16F，最后一行不带填充
+        let stride = 30 * 8 + 16;
+        let mut data = vec![0u8; stride * 19 + 30 * 8];
+        let mut target = FrameBuffer { format: PixelFormat::Rgba16F, stride, data: &mut data };
+        assert_eq!(pipeline.render_into(&src, 1.0, DisplayMode::Edited, &mut target, None, &|| false).unwrap(), Some((30, 20)));
+        let channel = |x: usize, y: usize, c: usize| {
+            let i = y * stride + x * 8 + c * 2;
+            f16_to_f32(u16::from_ne_bytes([data[i], data[i + 1]]))
+        };
+        for (x, y) in [(0, 0), (29, 19), (15, 7)] {
+            let px = expected.get_pixel(x as u32, y as u32);
+            for c in 0..4 {
+                assert!((channel(x, y, c) * 255.0 - px[c] as f32).abs() <= 0.6, "({}, {}) {}", x, y, c);
+            }
+        }
+
+        // 容量不足时报错
+        let mut small = vec![0u8; 30 * 4 * 19];
+        let mut target = FrameBuffer { format: PixelFormat::Rgba8, stride: 120, data: &mut small };
+        assert!(pipeline.render_into(&src, 1.0, DisplayMode::Edited, &mut target, None, &|| false).is_err());
+    }
+
+    fn f16_to_f32(h: u16) -> f32 {
+        let exp = ((h >> 10) & 0x1f) as i32;
+        let mantissa = (h & 0x3ff) as f32;
+        let value = match exp {
+            0 => mantissa * 2f32.powi(-24),
+            _ => (1.0 + mantissa / 1024.0) * 2f32.powi(exp - 15),
+        };
+        if h & 0x8000 != 0 { -value } else { value }
+    }
+
+    #[test]
+    fn test_f32_to_f16() {
+        assert_eq!(f32_to_f16(0.0), 0);
+        assert_eq!(f32_to_f16(1.0), 0x3c00);
+        assert_eq!(f32_to_f16(0.5), 0x3800);
+        assert_eq!(f32_to_f16(-2.0), 0xc000);
+        assert_eq!(f32_to_f16(2f32.powi(-24)), 1);
+        assert_eq!(f32_to_f16(1e6), 0x7c00);
+        for i in 0..=255 {
+            let v = i as f32 / 255.0;
+            assert!((f16_to_f32(f32_to_f16(v)) - v).abs() <= v * 0.0005 + 1e-7);
+        }
+    }
+
+    #[test]
+    fn test_display_modes() {
+        let src = gradient(40, 20);
+        let pipeline = EditPipeline::compile(&params(vec![
+            EditOperation::Brightness { value: 30 },
+            EditOperation::Flip { direction: FlipDirection::Horizontal },
+            EditOperation::Contrast { value: 20 },
+        ]));
+        let edited = pipeline.render(&src, 1.0, &|| false).unwrap();
+        let render = |mode| pipeline.render_display(&src, 1.0, mode, None, &|| false).unwrap();
+        // 对比图只做了翻转
+        let original = |x: u32, y: u32| *src.get_pixel(39 - x, y);
+
+        let split = render(DisplayMode::Split { position: 0.25 });
+        assert_eq!(split.dimensions(), (40, 20));
+        assert_eq!(*split.get_pixel(3, 5), original(3, 5));
+        assert_eq!(*split.get_pixel(10, 5), Rgba([255, 255, 255, 255]));
+        assert_eq!(*split.get_pixel(30, 5), *edited.get_pixel(30, 5));
+
+        let side = render(DisplayMode::SideBySide);
+        assert_eq!(side.dimensions(), (80, 20));
+        assert_eq!(*side.get_pixel(7, 9), original(7, 9));
+        assert_eq!(*side.get_pixel(47, 9), *edited.get_pixel(7, 9));
+
+        let clipping = render(DisplayMode::Clipping { shadows: 0, highlights: 250 });
+        for (x, y) in [(0, 0), (39, 19), (20, 10)] {
+            let px = *edited.get_pixel(x, y);
+            let expected = if px.0[..3].iter().any(|&v| v >= 250) {
+                Rgba([255, 0, 0, 255])
+            } else if px.0[..3].iter().any(|&v| v == 0) {
+                Rgba([0, 0, 255, 255])
+            } else {
+                px
+            };
+            assert_eq!(*clipping.get_pixel(x, y), expected, "({}, {})", x, y);
+        }
+
+        // 并排帧写入缓冲区时按加倍的宽度检查容量
+        let mut data = vec![0u8; 40 * 4 * 20];
+        let mut target = FrameBuffer { format: PixelFormat::Rgba8, stride: 160, data: &mut data };
+        assert!(pipeline.render_into(&src, 1.0, DisplayMode::SideBySide, &mut target, None, &|| false).is_err());
+    }
+
+    #[test]
+    fn test_scopes_match_edited_pixels() {
+        // 高度超过多个分块，覆盖部分计数的合并
+        let src = gradient(50, ROWS_PER_CHUNK as u32 * 5 + 3);
+        let pipeline = EditPipeline::compile(&params(vec![EditOperation::Saturation { value: 40 }]));
+        let (width, height) = src.dimensions();
+        let mut expected = Scopes::new();
+        for (x, y, px) in src.enumerate_pixels() {
+            expected.add(pipeline.output.apply(unpack(&px.0), x, y, width, height), Scopes::column(x, width));
+        }
+
+        // 分割对比中左侧显示调整前，示波器仍统计整幅编辑结果
+        let mut scopes = ScopeAccumulator::new();
+        let mode = DisplayMode::Split { position: 0.5 };
+        pipeline.render_display(&src, 1.0, mode, Some(&mut scopes), &|| false).unwrap();
+        assert_eq!(scopes.scopes().waveform.iter().sum::<u32>(), width * height);
+        assert!(*scopes.scopes() == expected);
+
+        // 累加器跨帧复用，上一帧的部分计数不会带入
+        pipeline.render_display(&src, 1.0, mode, Some(&mut scopes), &|| false).unwrap();
+        assert!(*scopes.scopes() == expected);
+
+        // 不需要调整也会统计
+        let identity = EditPipeline::compile(&params(vec![]));
+        identity.render_display(&src, 1.0, DisplayMode::Edited, Some(&mut scopes), &|| false).unwrap();
+        assert_eq!(scopes.scopes().vectorscope.iter().sum::<u32>(), src.width() * src.height());
+
+        // 大图抽样：步长 2 时每 2x2 取一个样本
+        let large = gradient(1100, 1000);
+        assert_eq!(Scopes::sample_step(1100, 1000), 2);
+        identity.render_display(&large, 1.0, DisplayMode::Edited, Some(&mut scopes), &|| false).unwrap();
+        assert_eq!(scopes.scopes().waveform.iter().sum::<u32>(), 550 * 500);
+    }
+
+    #[test]
+    fn test_cancelled_render_returns_none() {
+        let src = gradient(32, 32);
+        let pipeline = EditPipeline::compile(&params(vec![EditOperation::Brightness { value: 10 }]));
+        assert!(pipeline.render(&src, 1.0, &|| true).is_none());
+    }
+}
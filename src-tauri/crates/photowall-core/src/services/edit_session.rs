@@ -0,0 +1,680 @@
+//! 编辑预览会话
+//!
+//! 打开时解码一次原图并生成两级预览源图：完整预览分辨率和其 1/4 边长的粗略级。
+//! 每次提交参数后，后台渲染线程先渲染粗略级并立即回调，再细化到完整预览分辨率。
+//! 渲染期间参数再次变化时放弃当前细化，直接从粗略级开始渲染最新参数。
+//!
+//! 设置输出缓冲区后，输出遍历直接写入调用方的内存或宿主映射的共享文件，
+//! 回调只通知哪一帧已就绪，像素不再经过会话内部的中间图像。
+//! 显示方式（分割对比、并排对比、溢出警告）在同一输出遍历中合成，切换时只重渲染最后一次参数。
+//! 开启示波器后每帧附带编辑结果的波形、分量和矢量示波器计数。
+
+use std::fs::OpenOptions;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::{self, JoinHandle};
+use std::time::Instant;
+
+use image::{imageops::FilterType, DynamicImage, RgbaImage};
+use memmap2::MmapMut;
+
+use crate::metrics;
+use crate::utils::error::{AppError, AppResult};
+
+use super::edit_pipeline::{DisplayMode, EditPipeline, FrameBuffer, PixelFormat};
+use super::editor::{EditParams, EditorService};
+use super::scopes::{ScopeAccumulator, Scopes};
+
+/// 会话选项
+#[derive(Debug, Clone)]
+pub struct EditSessionOptions {
+    /// 完整预览的最长边（像素）
+    pub preview_max_size: u32,
+    /// 粗略级相对完整预览的边长缩小倍数，1 表示不渲染粗略级
+    pub coarse_divisor: u32,
+}
+
+impl Default for EditSessionOptions {
+    fn default() -> Self {
+        Self {
+            preview_max_size: 1600,
+            coarse_divisor: 4,
+        }
+    }
+}
+
+/// 预览级别
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PreviewLevel {
+    /// 粗略级（1/4 边长）
+    Coarse = 0,
+    /// 完整预览分辨率
+    Full = 1,
+}
+
+/// 一帧渲染结果
+///
+/// 未设置输出缓冲区时为 RGBA8、行间无填充；否则 `pixels` 指向输出缓冲区的开头。
+pub struct PreviewFrame<'a> {
+    /// 对应 `submit` 返回的编号
+    pub generation: u64,
+    pub level: PreviewLevel,
+    /// 该参数的最后一帧
+    pub is_final: bool,
+    pub format: PixelFormat,
+    pub width: u32,
+    pub height: u32,
+    /// 行距（字节）
+    pub stride: usize,
+    pub pixels: &'a [u8],
+    /// 编辑结果的示波器，未开启时为 `None`
+    pub scopes: Option<&'a Scopes>,
+}
+
+enum OutputMemory {
+    /// 调用方持有的内存
+    Raw { ptr: *mut u8, len: usize },
+    /// 文件映射，宿主进程映射同一文件读取
+    Shared { map: MmapMut, path: PathBuf },
+}
+
+/// 渲染输出缓冲区
+pub struct OutputBuffer {
+    format: PixelFormat,
+    stride: usize,
+    memory: OutputMemory,
+}
+
+// SAFETY: 裸指针由 `from_raw` 的调用方保证在缓冲区交还前有效，且只有渲染线程写入
+unsafe impl Send for OutputBuffer {}
+
+impl OutputBuffer {
+    /// 使用调用方提供的内存
+    ///
+    /// # Safety
+    /// `ptr` 必须在该缓冲区从会话中移除（或会话关闭）之前一直可写 `len` 字节，
+    /// 期间调用方只能在帧回调内读取。
+    pub unsafe fn from_raw(ptr: *mut u8, len: usize, stride: usize, format: PixelFormat) -> Self {
+        Self {
+            format,
+            stride,
+            memory: OutputMemory::Raw { ptr, len },
+        }
+    }
+
+    /// 创建可容纳 `width` x `height` 帧的共享文件映射，行距为 `width` 个像素
+    ///
+    /// 文件已存在时会被截断重建；缓冲区释放时删除文件。
+    pub fn create_shared(path: &Path, width: u32, height: u32, format: PixelFormat) -> AppResult<Self> {
+        let stride = width as usize * format.bytes_per_pixel();
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .truncate(true)
+            .open(path)?;
+        file.set_len((stride * height as usize).max(1) as u64)?;
+        let map = unsafe { MmapMut::map_mut(&file)? };
+        Ok(Self {
+            format,
+            stride,
+            memory: OutputMemory::Shared {
+                map,
+                path: path.to_path_buf(),
+            },
+        })
+    }
+
+    pub fn format(&self) -> PixelFormat {
+        self.format
+    }
+
+    pub fn stride(&self) -> usize {
+        self.stride
+    }
+
+    fn shape(&self) -> OutputShape {
+        let len = match &self.memory {
+            OutputMemory::Raw { len, .. } => *len,
+            OutputMemory::Shared { map, .. } => map.len(),
+        };
+        OutputShape {
+            format: self.format,
+            stride: self.stride,
+            len,
+        }
+    }
+
+    fn frame_buffer(&mut self) -> FrameBuffer<'_> {
+        let data = match &mut self.memory {
+            OutputMemory::Raw { ptr, len } => unsafe { std::slice::from_raw_parts_mut(*ptr, *len) },
+            OutputMemory::Shared { map, .. } => &mut map[..],
+        };
+        FrameBuffer {
+            format: self.format,
+            stride: self.stride,
+            data,
+        }
+    }
+}
+
+impl Drop for OutputBuffer {
+    fn drop(&mut self) {
+        if let OutputMemory::Shared { path, .. } = &self.memory {
+            // Windows 上宿主仍映射着文件时删除会失败，留给宿主清理
+            let _ = std::fs::remove_file(path);
+        }
+    }
+}
+
+/// 帧回调，在渲染线程上调用
+pub type FrameCallback = dyn Fn(&PreviewFrame) + Send + Sync;
+
+/// 输出缓冲区的格式和容量，记在请求里，校验显示方式时不必等待渲染释放缓冲区
+#[derive(Debug, Clone, Copy)]
+struct OutputShape {
+    format: PixelFormat,
+    stride: usize,
+    len: usize,
+}
+
+impl OutputShape {
+    fn check(&self, (width, height): (u32, u32)) -> AppResult<()> {
+        match self.format.frame_len(width, height, self.stride) {
+            Some(len) if len <= self.len => Ok(()),
+            _ => Err(AppError::General(format!(
+                "输出缓冲区太小: {}x{} {:?}, 行距 {}, 容量 {}",
+                width, height, self.format, self.stride, self.len
+            ))),
+        }
+    }
+}
+
+struct Request {
+    /// 待渲染的参数
+    params: Option<EditParams>,
+    /// 最后一次提交的参数，切换显示方式时重新渲染
+    last: EditParams,
+    mode: DisplayMode,
+    /// 当前输出缓冲区的形状，与 `Shared::output` 同步更新
+    output: Option<OutputShape>,
+    generation: u64,
+    stopped: bool,
+}
+
+struct Shared {
+    /// 按级别排列的源图（粗略级在前），以及各自相对原图的缩放比例
+    levels: Vec<(PreviewLevel, RgbaImage, f32)>,
+    request: Mutex<Request>,
+    wake: Condvar,
+    /// 最新提交的编号，渲染中随时检查是否已被取代
+    latest: AtomicU64,
+    /// 输出缓冲区；渲染和回调期间持有锁，更换缓冲区会等待当前帧结束
+    output: Mutex<Option<OutputBuffer>>,
+    scopes_enabled: AtomicBool,
+    on_frame: Box<FrameCallback>,
+}
+
+impl Shared {
+    fn render_loop(&self) {
+        // 示波器的部分计数跨帧复用
+        let mut scopes = ScopeAccumulator::new();
+        loop {
+            let (params, mode, generation) = {
+                let mut request = self.request.lock().unwrap_or_else(|e| e.into_inner());
+                loop {
+                    if request.stopped {
+                        return;
+                    }
+                    if let Some(params) = request.params.take() {
+                        break (params, request.mode, request.generation);
+                    }
+                    request = self.wake.wait(request).unwrap_or_else(|e| e.into_inner());
+                }
+            };
+            self.render(&params, mode, generation, &mut scopes);
+        }
+    }
+
+    /// 由粗到细渲染；被新参数取代时返回 false
+    fn render(&self, params: &EditParams, mode: DisplayMode, generation: u64, scopes: &mut ScopeAccumulator) -> bool {
+        let pipeline = EditPipeline::compile(params);
+        let superseded = || self.latest.load(Ordering::Acquire) != generation;
+        let mut scopes = self.scopes_enabled.load(Ordering::Relaxed).then_some(scopes);
+
+        for (i, (level, source, scale)) in self.levels.iter().enumerate() {
+            let start = Instant::now();
+            let is_final = i + 1 == self.levels.len();
+            let mut output = self.output.lock().unwrap_or_else(|e| e.into_inner());
+            let rendered: RgbaImage;
+            let mut target: FrameBuffer;
+            let frame = match output.as_mut() {
+                Some(buffer) => {
+                    target = buffer.frame_buffer();
+                    match pipeline.render_into(source, *scale, mode, &mut target, scopes.as_deref_mut(), &superseded) {
+                        Ok(Some((width, height))) => Some(PreviewFrame {
+                            generation,
+                            level: *level,
+                            is_final,
+                            format: target.format,
+                            width,
+                            height,
+                            stride: target.stride,
+                            pixels: target.frame(width, height),
+                            scopes: scopes.as_deref().map(ScopeAccumulator::scopes),
+                        }),
+                        Ok(None) => None,
+                        // 渲染开始后切换了显示方式又换了缓冲区时，旧显示方式的帧可能放不下；此时渲染已被取代，按放弃处理
+                        Err(_) if superseded() => None,
+                        Err(e) => {
+                            tracing::warn!("预览写入输出缓冲区失败: {}", e);
+                            metrics::global().incr("edit.preview.output_error", 1);
+                            return false;
+                        }
+                    }
+                }
+                None => match pipeline.render_display(source, *scale, mode, scopes.as_deref_mut(), &superseded) {
+                    Some(frame) => {
+                        rendered = frame;
+                        Some(PreviewFrame {
+                            generation,
+                            level: *level,
+                            is_final,
+                            format: PixelFormat::Rgba8,
+                            width: rendered.width(),
+                            height: rendered.height(),
+                            stride: rendered.width() as usize * 4,
+                            pixels: rendered.as_raw(),
+                            scopes: scopes.as_deref().map(ScopeAccumulator::scopes),
+                        })
+                    }
+                    None => None,
+                },
+            };
+            let Some(frame) = frame else {
+                metrics::global().incr("edit.preview.abandoned", 1);
+                return false;
+            };
+            metrics::global().record(
+                match level {
+                    PreviewLevel::Coarse => "edit.preview.coarse",
+                    PreviewLevel::Full => "edit.preview.full",
+                },
+                start.elapsed(),
+            );
+            if superseded() {
+                metrics::global().incr("edit.preview.abandoned", 1);
+                return false;
+            }
+            (self.on_frame)(&frame);
+        }
+        true
+    }
+}
+
+/// 编辑预览会话
+pub struct EditSession {
+    shared: Arc<Shared>,
+    worker: Option<JoinHandle<()>>,
+}
+
+impl EditSession {
+    /// 打开图像文件
+    pub fn open(path: &Path, options: EditSessionOptions, on_frame: Box<FrameCallback>) -> AppResult<Self> {
+        let img = EditorService::load_image(path)?;
+        Ok(Self::from_image(img, options, on_frame))
+    }
+
+    /// 由已解码的图像创建会话
+    pub fn from_image(img: DynamicImage, options: EditSessionOptions, on_frame: Box<FrameCallback>) -> Self {
+        let source_width = img.width().max(1) as f32;
+        let full = EditorService::generate_preview(&img, options.preview_max_size.max(1)).into_rgba8();
+        drop(img);
+        let full_scale = full.width() as f32 / source_width;
+
+        let mut levels = Vec::with_capacity(2);
+        let divisor = options.coarse_divisor.max(1);
+        if divisor > 1 && full.width() >= divisor * 2 && full.height() >= divisor * 2 {
+            let coarse = image::imageops::resize(
+                &full,
+                full.width() / divisor,
+                full.height() / divisor,
+                FilterType::Triangle,
+            );
+            let coarse_scale = coarse.width() as f32 / source_width;
+            levels.push((PreviewLevel::Coarse, coarse, coarse_scale));
+        }
+        levels.push((PreviewLevel::Full, full, full_scale));
+
+        let shared = Arc::new(Shared {
+            levels,
+            request: Mutex::new(Request {
+                params: None,
+                last: EditParams::default(),
+                mode: DisplayMode::Edited,
+                output: None,
+                generation: 0,
+                stopped: false,
+            }),
+            wake: Condvar::new(),
+            latest: AtomicU64::new(0),
+            output: Mutex::new(None),
+            scopes_enabled: AtomicBool::new(false),
+            on_frame,
+        });
+
+        let worker = {
+            let shared = shared.clone();
+            thread::Builder::new()
+                .name("edit-preview".to_string())
+                .spawn(move || shared.render_loop())
+                .expect("failed to spawn preview render thread")
+        };
+
+        Self {
+            shared,
+            worker: Some(worker),
+        }
+    }
+
+    /// 提交新参数，返回本次提交的编号
+    ///
+    /// 立即返回；尚未开始的旧参数被丢弃，正在进行的渲染在下一个检查点放弃。
+    pub fn submit(&self, params: EditParams) -> u64 {
+        let mut request = self.shared.request.lock().unwrap_or_else(|e| e.into_inner());
+        request.last = params.clone();
+        request.params = Some(params);
+        self.queue(&mut request)
+    }
+
+    /// 切换显示方式并按最后一次提交的参数重新渲染，返回本次渲染的编号
+    ///
+    /// 设置了输出缓冲区时，缓冲区必须能容纳新显示方式下的最大帧。
+    /// 只按请求里记录的缓冲区形状校验，不等待正在进行的渲染，可以在帧回调里调用；
+    /// 正在进行的渲染在下一个检查点放弃。
+    pub fn set_display_mode(&self, mode: DisplayMode) -> AppResult<u64> {
+        let mut request = self.shared.request.lock().unwrap_or_else(|e| e.into_inner());
+        if let Some(shape) = request.output {
+            shape.check(self.max_frame_size_for(mode))?;
+        }
+        request.mode = mode;
+        request.params = Some(request.last.clone());
+        Ok(self.queue(&mut request))
+    }
+
+    /// 开启或关闭示波器统计，从下一次渲染起生效
+    pub fn set_scopes_enabled(&self, enabled: bool) {
+        self.shared.scopes_enabled.store(enabled, Ordering::Relaxed);
+    }
+
+    fn queue(&self, request: &mut Request) -> u64 {
+        request.generation += 1;
+        self.shared.latest.store(request.generation, Ordering::Release);
+        self.shared.wake.notify_one();
+        request.generation
+    }
+
+    /// 完整预览的尺寸
+    pub fn preview_size(&self) -> (u32, u32) {
+        let (_, full, _) = self.shared.levels.last().expect("session has a full level");
+        full.dimensions()
+    }
+
+    /// 当前显示方式、任意编辑参数下帧的最大尺寸
+    ///
+    /// 旋转会交换宽高，裁剪只会缩小，因此以完整预览的最长边为边长的正方形总能容纳；
+    /// 并排对比时宽度加倍。
+    pub fn max_frame_size(&self) -> (u32, u32) {
+        let mode = self.shared.request.lock().unwrap_or_else(|e| e.into_inner()).mode;
+        self.max_frame_size_for(mode)
+    }
+
+    fn max_frame_size_for(&self, mode: DisplayMode) -> (u32, u32) {
+        let (width, height) = self.preview_size();
+        let edge = width.max(height);
+        mode.frame_size(edge, edge)
+    }
+
+    /// 设置输出缓冲区，`None` 恢复为会话内部的 RGBA8 帧；返回被替换的缓冲区
+    ///
+    /// 缓冲区必须能容纳 [`max_frame_size`](Self::max_frame_size) 的帧。
+    /// 正在渲染或回调中的帧结束后才会生效，因此不能在帧回调里调用。
+    pub fn set_output(&self, buffer: Option<OutputBuffer>) -> AppResult<Option<OutputBuffer>> {
+        let mut output = self.shared.output.lock().unwrap_or_else(|e| e.into_inner());
+        {
+            // 校验和登记形状在同一次请求锁内完成，set_display_mode 总是按即将生效的缓冲区校验
+            let mut request = self.shared.request.lock().unwrap_or_else(|e| e.into_inner());
+            let shape = buffer.as_ref().map(OutputBuffer::shape);
+            if let Some(shape) = shape {
+                shape.check(self.max_frame_size_for(request.mode))?;
+            }
+            request.output = shape;
+        }
+        Ok(std::mem::replace(&mut *output, buffer))
+    }
+}
+
+impl Drop for EditSession {
+    fn drop(&mut self) {
+        {
+            let mut request = self.shared.request.lock().unwrap_or_else(|e| e.into_inner());
+            request.stopped = true;
+            // 让正在进行的渲染尽快放弃
+            self.shared.latest.store(u64::MAX, Ordering::Release);
+        }
+        self.shared.wake.notify_all();
+        if let Some(worker) = self.worker.take() {
+            let _ = worker.join();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::services::editor::EditOperation;
+    use image::Rgba;
+    use std::sync::mpsc;
+    use std::time::Duration;
+
+    fn gradient(w: u32, h: u32) -> DynamicImage {
+        DynamicImage::ImageRgba8(RgbaImage::from_fn(w, h, |x, y| {
+            Rgba([(x * 255 / w) as u8, (y * 255 / h) as u8, 128, 255])
+        }))
+    }
+
+    fn brightness(value: i32) -> EditParams {
+        EditParams {
+            operations: vec![EditOperation::Brightness { value }],
+        }
+    }
+
+    #[test]
+    fn test_coarse_then_full() {
+        let (tx, rx) = mpsc::channel();
+        let tx = Mutex::new(tx);
+        let session = EditSession::from_image(
+            gradient(800, 400),
+            EditSessionOptions {
+                preview_max_size: 400,
+                coarse_divisor: 4,
+            },
+            Box::new(move |frame| {
+                let _ = tx.lock().unwrap().send((frame.generation, frame.level, frame.is_final, frame.width, frame.height));
+            }),
+        );
+        assert_eq!(session.preview_size(), (400, 200));
+
+        let generation = session.submit(brightness(20));
+        let first = rx.recv_timeout(Duration::from_secs(5)).unwrap();
+        let second = rx.recv_timeout(Duration::from_secs(5)).unwrap();
+        assert_eq!(first, (generation, PreviewLevel::Coarse, false, 100, 50));
+        assert_eq!(second, (generation, PreviewLevel::Full, true, 400, 200));
+    }
+
+    #[test]
+    fn test_new_params_supersede_refinement() {
+        let (tx, rx) = mpsc::channel();
+        let tx = Mutex::new(tx);
+        let session = EditSession::from_image(
+            gradient(64, 64),
+            EditSessionOptions::default(),
+            Box::new(move |frame| {
+                // 粗略帧回调较慢，期间提交的新参数应让本次细化被放弃
+                if frame.level == PreviewLevel::Coarse {
+                    thread::sleep(Duration::from_millis(50));
+                }
+                let _ = tx.lock().unwrap().send((frame.generation, frame.level));
+            }),
+        );
+
+        let first = session.submit(brightness(10));
+        thread::sleep(Duration::from_millis(10));
+        let second = session.submit(brightness(20));
+
+        let mut frames = Vec::new();
+        while let Ok(frame) = rx.recv_timeout(Duration::from_secs(2)) {
+            frames.push(frame);
+            if frame == (second, PreviewLevel::Full) {
+                break;
+            }
+        }
+        assert!(!frames.contains(&(first, PreviewLevel::Full)));
+        assert_eq!(frames.last(), Some(&(second, PreviewLevel::Full)));
+    }
+
+    #[test]
+    fn test_frames_written_to_output_buffer() {
+        let (tx, rx) = mpsc::channel();
+        let tx = Mutex::new(tx);
+        let session = EditSession::from_image(
+            gradient(80, 40),
+            EditSessionOptions {
+                preview_max_size: 80,
+                coarse_divisor: 4,
+            },
+            Box::new(move |frame| {
+                let alpha = u16::from_ne_bytes([frame.pixels[6], frame.pixels[7]]);
+                let _ = tx.lock().unwrap().send((frame.level, frame.format, frame.stride, frame.pixels.as_ptr() as usize, alpha));
+            }),
+        );
+        assert_eq!(session.max_frame_size(), (80, 80));
+
+        let stride = 80 * 8 + 64;
+        let mut memory = vec![0u8; stride * 80];
+        let too_small = unsafe { OutputBuffer::from_raw(memory.as_mut_ptr(), stride * 40, stride, PixelFormat::Rgba16F) };
+        assert!(session.set_output(Some(too_small)).is_err());
+        let buffer = unsafe { OutputBuffer::from_raw(memory.as_mut_ptr(), memory.len(), stride, PixelFormat::Rgba16F) };
+        assert!(session.set_output(Some(buffer)).unwrap().is_none());
+
+        session.submit(brightness(0));
+        for level in [PreviewLevel::Coarse, PreviewLevel::Full] {
+            let frame = rx.recv_timeout(Duration::from_secs(5)).unwrap();
+            // 不透明像素的 alpha 为半精度 1.0
+            assert_eq!(frame, (level, PixelFormat::Rgba16F, stride, memory.as_ptr() as usize, 0x3c00));
+        }
+
+        // 恢复内部缓冲区后帧不再指向调用方内存
+        assert!(session.set_output(None).unwrap().is_some());
+        session.submit(brightness(10));
+        let frame = rx.recv_timeout(Duration::from_secs(5)).unwrap();
+        assert_eq!((frame.1, frame.2), (PixelFormat::Rgba8, 20 * 4));
+        assert_ne!(frame.3, memory.as_ptr() as usize);
+        drop(session);
+    }
+
+    #[test]
+    fn test_frames_carry_scopes_when_enabled() {
+        let (tx, rx) = mpsc::channel();
+        let tx = Mutex::new(tx);
+        let session = EditSession::from_image(
+            gradient(80, 40),
+            EditSessionOptions {
+                preview_max_size: 80,
+                coarse_divisor: 4,
+            },
+            Box::new(move |frame| {
+                let samples = frame.scopes.map(|s| s.waveform.iter().sum::<u32>());
+                let _ = tx.lock().unwrap().send((frame.level, frame.width * frame.height, samples));
+            }),
+        );
+
+        session.submit(brightness(10));
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap().2, None);
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap().2, None);
+
+        session.set_scopes_enabled(true);
+        session.submit(brightness(20));
+        for level in [PreviewLevel::Coarse, PreviewLevel::Full] {
+            let (frame_level, pixels, samples) = rx.recv_timeout(Duration::from_secs(5)).unwrap();
+            assert_eq!((frame_level, samples), (level, Some(pixels)));
+        }
+    }
+
+    #[test]
+    fn test_display_mode_rerenders_last_params() {
+        let (tx, rx) = mpsc::channel();
+        let tx = Mutex::new(tx);
+        let session = EditSession::from_image(
+            gradient(80, 40),
+            EditSessionOptions {
+                preview_max_size: 80,
+                coarse_divisor: 1,
+            },
+            Box::new(move |frame| {
+                let _ = tx.lock().unwrap().send((frame.generation, frame.width, frame.height));
+            }),
+        );
+
+        session.submit(brightness(10));
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap().1, 80);
+
+        let generation = session.set_display_mode(DisplayMode::SideBySide).unwrap();
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap(), (generation, 160, 40));
+        assert_eq!(session.max_frame_size(), (160, 80));
+
+        // 只够单幅的缓冲区不能用于并排对比
+        let mut memory = vec![0u8; 80 * 80 * 4];
+        let buffer = unsafe { OutputBuffer::from_raw(memory.as_mut_ptr(), memory.len(), 80 * 4, PixelFormat::Rgba8) };
+        assert!(session.set_output(Some(buffer)).is_err());
+        session.set_display_mode(DisplayMode::Edited).unwrap();
+        let buffer = unsafe { OutputBuffer::from_raw(memory.as_mut_ptr(), memory.len(), 80 * 4, PixelFormat::Rgba8) };
+        session.set_output(Some(buffer)).unwrap();
+        assert!(session.set_display_mode(DisplayMode::SideBySide).is_err());
+        drop(session);
+    }
+
+    #[test]
+    fn test_display_mode_from_frame_callback() {
+        let (tx, rx) = mpsc::channel();
+        let tx = Mutex::new(tx);
+        let handle: Arc<std::sync::OnceLock<std::sync::Weak<EditSession>>> = Arc::default();
+        let callback_handle = handle.clone();
+        let session = Arc::new(EditSession::from_image(
+            gradient(80, 40),
+            EditSessionOptions {
+                preview_max_size: 80,
+                coarse_divisor: 1,
+            },
+            Box::new(move |frame| {
+                // 回调期间渲染线程持有输出缓冲区，切换显示方式不能等待它
+                if frame.width == 80 {
+                    if let Some(session) = callback_handle.get().and_then(std::sync::Weak::upgrade) {
+                        session.set_display_mode(DisplayMode::SideBySide).unwrap();
+                    }
+                }
+                let _ = tx.lock().unwrap().send(frame.width);
+            }),
+        ));
+        let mut memory = vec![0u8; 160 * 80 * 4];
+        let buffer = unsafe { OutputBuffer::from_raw(memory.as_mut_ptr(), memory.len(), 160 * 4, PixelFormat::Rgba8) };
+        session.set_output(Some(buffer)).unwrap();
+        handle.set(Arc::downgrade(&session)).unwrap();
+
+        session.submit(brightness(10));
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap(), 80);
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap(), 160);
+        drop(session);
+    }
+}
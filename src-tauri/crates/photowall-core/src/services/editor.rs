@@ -84,7 +84,7 @@ impl EditorService {
     }
 
     /// 应用单个编辑操作
-    fn apply_operation(img: DynamicImage, op: &EditOperation) -> AppResult<DynamicImage> {
+    pub(crate) fn apply_operation(img: DynamicImage, op: &EditOperation) -> AppResult<DynamicImage> {
         match op {
             EditOperation::Rotate { degrees } => Ok(Self::rotate(img, *degrees)),
             EditOperation::Flip { direction } => Ok(Self::flip(img, *direction)),
@@ -2,20 +2,30 @@
 //!
 //! 整合扫描、元数据提取、哈希计算，提供完整的照片索引功能
 
+use std::collections::HashSet;
 use std::path::{Path, PathBuf};
 use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
-use std::sync::Arc;
+use std::sync::{mpsc, Arc, Mutex};
+use std::time::{Duration, Instant};
 
 use rayon::prelude::*;
 
-use crate::db::Database;
+use crate::db::{Database, JournalEntry};
+use crate::metrics;
 use crate::models::photo::CreatePhoto;
 use crate::utils::error::{AppError, AppResult};
 
 use super::hasher::FileHasher;
 use super::metadata::MetadataExtractor;
+use super::scan_journal::{JournalScanResult, JournalScanner};
 use super::scanner::{ScanOptions, Scanner};
 
+/// 批次中最早一条等待提交的最长时间，保证慢速磁盘上照片也能尽快出现
+const FLUSH_INTERVAL: Duration = Duration::from_millis(500);
+
+/// 只需记录扫描日志的条目攒够此数即提交
+const JOURNAL_BATCH_SIZE: usize = 1000;
+
 /// 索引进度
 #[derive(Debug, Clone, serde::Serialize, serde::Deserialize)]
 #[serde(rename_all = "camelCase")]
@@ -82,6 +92,13 @@ pub struct IndexOptions {
     pub detect_duplicates: bool,
     /// 批量插入大小
     pub batch_size: usize,
+    /// 是否使用扫描日志跳过未变化的目录和文件
+    #[serde(default = "default_use_journal")]
+    pub use_journal: bool,
+}
+
+fn default_use_journal() -> bool {
+    true
 }
 
 impl Default for IndexOptions {
@@ -91,10 +108,62 @@ impl Default for IndexOptions {
             skip_existing: true,
             detect_duplicates: true,
             batch_size: 100,
+            use_journal: true,
         }
     }
 }
 
+/// 单个文件的处理结果，交给写入线程
+enum Processed {
+    /// 新照片，连同其扫描日志条目
+    Photo(CreatePhoto, Option<JournalEntry>),
+    /// 已存在或重复，只需记录扫描日志
+    Seen(JournalEntry),
+}
+
+/// 写入线程中尚未提交的批次
+#[derive(Default)]
+struct PendingBatch {
+    photos: Vec<CreatePhoto>,
+    /// 与 `photos` 对应的日志条目，照片写入成功后才记录
+    photo_entries: Vec<JournalEntry>,
+    seen: Vec<JournalEntry>,
+    /// 批次中最早一条的到达时间
+    oldest: Option<Instant>,
+}
+
+impl PendingBatch {
+    fn push(&mut self, processed: Processed) {
+        self.oldest.get_or_insert_with(Instant::now);
+        match processed {
+            Processed::Photo(photo, entry) => {
+                self.photos.push(photo);
+                self.photo_entries.extend(entry);
+            }
+            Processed::Seen(entry) => self.seen.push(entry),
+        }
+    }
+
+    fn is_full(&self, batch_size: usize) -> bool {
+        self.photos.len() >= batch_size || self.seen.len() >= JOURNAL_BATCH_SIZE
+    }
+
+    fn is_empty(&self) -> bool {
+        self.photos.is_empty() && self.seen.is_empty()
+    }
+
+    /// 最早一条已等待超过 [`FLUSH_INTERVAL`]
+    fn is_due(&self) -> bool {
+        self.oldest.map_or(false, |t| t.elapsed() >= FLUSH_INTERVAL)
+    }
+
+    /// 距离必须提交还剩的时间；空批次时为一个完整间隔
+    fn time_left(&self) -> Duration {
+        self.oldest
+            .map_or(FLUSH_INTERVAL, |t| FLUSH_INTERVAL.saturating_sub(t.elapsed()))
+    }
+}
+
 /// 照片索引器
 pub struct PhotoIndexer {
     db: Arc<Database>,
@@ -156,6 +225,12 @@ impl PhotoIndexer {
     {
         // 1. 扫描目录
         tracing::info!("开始扫描目录: {}", path.display());
+        if self.options.use_journal {
+            let scan = JournalScanner::new(self.options.scan_options.clone(), &self.db)
+                .scan_directory(path)?;
+            return self.index_journal_scan(scan, progress_callback);
+        }
+
         let scanner = Scanner::new(self.options.scan_options.clone());
         let scan_result = scanner.scan_directory(path)?;
 
@@ -180,6 +255,12 @@ impl PhotoIndexer {
         F: Fn(&IndexProgress) + Send + Sync,
     {
         // 扫描所有目录
+        if self.options.use_journal {
+            let scan = JournalScanner::new(self.options.scan_options.clone(), &self.db)
+                .scan_directories(paths)?;
+            return self.index_journal_scan(scan, progress_callback);
+        }
+
         let scanner = Scanner::new(self.options.scan_options.clone());
         let scan_result = scanner.scan_directories(paths)?;
 
@@ -187,51 +268,120 @@ impl PhotoIndexer {
         self.index_files(&scan_result.files, progress_callback)
     }
 
+    /// 索引增量扫描的结果，完成后回写目录日志
+    ///
+    /// 未变化的文件直接计入跳过数；有文件处理失败的目录不写入修改时间，下次扫描会重新读取。
+    fn index_journal_scan<F>(&self, scan: JournalScanResult, progress_callback: F) -> AppResult<IndexResult>
+    where
+        F: Fn(&IndexProgress) + Send + Sync,
+    {
+        let m = metrics::global();
+        m.incr("indexer.dirs_unchanged", scan.dirs_unchanged as u64);
+        m.incr("indexer.files_unchanged", scan.files_unchanged as u64);
+
+        let files: Vec<PathBuf> = scan.candidates.iter().map(|e| PathBuf::from(&e.file_path)).collect();
+        let (result, failed_dirs) = self.run_pipeline(
+            &files,
+            Some(scan.candidates.as_slice()),
+            scan.files_unchanged,
+            progress_callback,
+        )?;
+
+        for snapshot in &scan.changed_dirs {
+            let complete = !failed_dirs.contains(&snapshot.dir.dir_path);
+            if let Err(e) = self.db.commit_journal_dir(snapshot, complete) {
+                tracing::warn!("写入扫描日志失败 {}: {}", snapshot.dir.dir_path, e);
+            }
+        }
+
+        Ok(result)
+    }
+
     /// 索引文件列表
     fn index_files<F>(&self, files: &[PathBuf], progress_callback: F) -> AppResult<IndexResult>
     where
         F: Fn(&IndexProgress) + Send + Sync,
     {
-        let total = files.len();
+        self.run_pipeline(files, None, 0, progress_callback)
+            .map(|(result, _)| result)
+    }
+
+    /// 索引流水线
+    ///
+    /// rayon 并行计算哈希、提取元数据，结果经有界通道交给写入线程，
+    /// 写入线程每凑满 `batch_size` 条，或最早一条已等待 [`FLUSH_INTERVAL`]，就提交一个事务；
+    /// 输入持续但缓慢时也按时提交，不必等到通道空闲。
+    /// 内存占用与库大小无关，已提交的照片在索引进行中即可被查询到。
+    ///
+    /// `journal` 与 `files` 一一对应时，处理成功的文件随批次写入扫描日志；
+    /// `unchanged` 为扫描阶段已判定未变化的文件数，计入总数和跳过数。
+    /// 返回值附带有文件处理失败的目录集合。
+    fn run_pipeline<F>(
+        &self,
+        files: &[PathBuf],
+        journal: Option<&[JournalEntry]>,
+        unchanged: usize,
+        progress_callback: F,
+    ) -> AppResult<(IndexResult, HashSet<String>)>
+    where
+        F: Fn(&IndexProgress) + Send + Sync,
+    {
+        let total = files.len() + unchanged;
+        let started = std::time::Instant::now();
+        let m = metrics::global();
         let indexed = AtomicUsize::new(0);
-        let skipped = AtomicUsize::new(0);
+        let skipped = AtomicUsize::new(unchanged);
         let failed = AtomicUsize::new(0);
-        let processed = AtomicUsize::new(0);
+        let processed = AtomicUsize::new(unchanged);
+
+        let failed_files = Mutex::new(Vec::new());
+        let failed_dirs = Mutex::new(HashSet::new());
+        let batch_size = self.options.batch_size.max(1);
+
+        // 通道容量为两个批次：写入落后时生产者阻塞，而不是无限堆积
+        let (tx, rx) = mpsc::sync_channel::<Processed>(batch_size * 2);
 
-        let failed_files = std::sync::Mutex::new(Vec::new());
+        std::thread::scope(|scope| {
+            let writer = scope.spawn(|| self.write_batches(rx, batch_size, &failed_dirs));
 
-        // 并行处理文件
-        let photo_data: Vec<Option<CreatePhoto>> = files
-            .par_iter()
-            .map(|file_path| {
+            files.par_iter().enumerate().for_each_with(tx, |tx, (i, file_path)| {
                 // 检查是否取消
                 if self.is_cancelled() {
-                    return None;
+                    return;
                 }
 
+                let journal_entry = journal.map(|entries| entries[i].clone());
+                let file_started = std::time::Instant::now();
                 let result = self.process_single_file(file_path);
+                m.record("indexer.file", file_started.elapsed());
+                m.incr("indexer.files_processed", 1);
 
                 // 更新进度计数
                 let processed_now = processed.fetch_add(1, Ordering::SeqCst) + 1;
 
-                let outcome = match result {
+                match result {
                     Ok(Some(photo)) => {
                         indexed.fetch_add(1, Ordering::SeqCst);
-                        Some(photo)
+                        // 写入线程只会在取消时提前退出
+                        let _ = tx.send(Processed::Photo(photo, journal_entry));
                     }
                     Ok(None) => {
                         skipped.fetch_add(1, Ordering::SeqCst);
-                        None
+                        if let Some(entry) = journal_entry {
+                            let _ = tx.send(Processed::Seen(entry));
+                        }
                     }
                     Err(e) => {
                         failed.fetch_add(1, Ordering::SeqCst);
+                        if let (Some(entry), Ok(mut dirs)) = (journal_entry, failed_dirs.lock()) {
+                            dirs.insert(entry.dir_path);
+                        }
                         if let Ok(mut files) = failed_files.lock() {
                             files.push(format!("{}: {}", file_path.display(), e));
                         }
                         tracing::warn!("处理文件失败 {}: {}", file_path.display(), e);
-                        None
                     }
-                };
+                }
 
                 let mut progress = IndexProgress {
                     total,
@@ -244,34 +394,19 @@ impl PhotoIndexer {
                 };
                 progress.update_percentage();
                 progress_callback(&progress);
+            });
+            // for_each_with 结束时所有发送端已释放，写入线程随之排空退出
 
-                outcome
-            })
-            .collect();
+            if writer.join().is_err() {
+                tracing::error!("索引写入线程异常退出");
+            }
+        });
 
-        // 检查是否取消
+        // 检查是否取消（已提交的批次保留）
         if self.is_cancelled() {
             return Err(AppError::General("索引已取消".to_string()));
         }
 
-        // 批量插入数据库
-        let photos_to_insert: Vec<CreatePhoto> = photo_data.into_iter().flatten().collect();
-
-        if !photos_to_insert.is_empty() {
-            tracing::info!("批量插入 {} 条照片记录", photos_to_insert.len());
-
-            // 分批插入
-            for chunk in photos_to_insert.chunks(self.options.batch_size) {
-                if self.is_cancelled() {
-                    return Err(AppError::General("索引已取消".to_string()));
-                }
-
-                if let Err(e) = self.db.create_photos_batch(chunk) {
-                    tracing::error!("批量插入失败: {}", e);
-                }
-            }
-        }
-
         // 发送最终进度
         let final_progress = IndexProgress {
             total,
@@ -285,13 +420,96 @@ impl PhotoIndexer {
         progress_callback(&final_progress);
 
         let failed_files = failed_files.into_inner().unwrap_or_default();
+        let failed_dirs = failed_dirs.into_inner().unwrap_or_default();
 
-        Ok(IndexResult {
+        let elapsed = started.elapsed().as_secs_f64();
+        m.incr("indexer.photos_indexed", indexed.load(Ordering::SeqCst) as u64);
+        m.incr("indexer.files_failed", failed.load(Ordering::SeqCst) as u64);
+        if elapsed > 0.0 {
+            m.set_gauge("indexer.last_run_files_per_sec", (total as f64 / elapsed).round() as i64);
+        }
+
+        let result = IndexResult {
             indexed: indexed.load(Ordering::SeqCst),
             skipped: skipped.load(Ordering::SeqCst),
             failed: failed.load(Ordering::SeqCst),
             failed_files,
-        })
+        };
+        Ok((result, failed_dirs))
+    }
+
+    /// 写入线程：攒批并逐批提交
+    fn write_batches(
+        &self,
+        rx: mpsc::Receiver<Processed>,
+        batch_size: usize,
+        failed_dirs: &Mutex<HashSet<String>>,
+    ) {
+        let mut batch = PendingBatch::default();
+        let mut committed = 0usize;
+
+        loop {
+            let flush = match rx.recv_timeout(batch.time_left()) {
+                Ok(processed) => {
+                    batch.push(processed);
+                    batch.is_full(batch_size) || batch.is_due()
+                }
+                Err(mpsc::RecvTimeoutError::Timeout) => !batch.is_empty(),
+                Err(mpsc::RecvTimeoutError::Disconnected) => break,
+            };
+
+            if self.is_cancelled() {
+                return;
+            }
+            if flush {
+                committed += self.commit_batch(&mut batch, failed_dirs);
+            }
+        }
+
+        if !self.is_cancelled() && !batch.is_empty() {
+            committed += self.commit_batch(&mut batch, failed_dirs);
+        }
+        tracing::info!("索引写入完成，共提交 {} 条照片记录", committed);
+    }
+
+    /// 提交一个批次并清空，返回写入的照片数
+    ///
+    /// 照片写入成功后才记录其扫描日志；写入失败的文件所在目录记入 `failed_dirs`。
+    fn commit_batch(&self, batch: &mut PendingBatch, failed_dirs: &Mutex<HashSet<String>>) -> usize {
+        let started = std::time::Instant::now();
+        let mut count = 0;
+        let mut lost = Vec::new();
+
+        if !batch.photos.is_empty() {
+            match self.db.create_photos_batch(&batch.photos) {
+                Ok(ids) => {
+                    count = ids.len();
+                    batch.seen.append(&mut batch.photo_entries);
+                }
+                Err(e) => {
+                    tracing::error!("批量插入失败: {}", e);
+                    lost.append(&mut batch.photo_entries);
+                }
+            }
+        }
+
+        if let Err(e) = self.db.upsert_journal_entries(&batch.seen) {
+            tracing::warn!("写入扫描日志失败: {}", e);
+            lost.append(&mut batch.seen);
+        }
+
+        if !lost.is_empty() {
+            if let Ok(mut dirs) = failed_dirs.lock() {
+                dirs.extend(lost.into_iter().map(|e| e.dir_path));
+            }
+        }
+
+        metrics::global().record("indexer.batch_commit", started.elapsed());
+        batch.photos.clear();
+        batch.photo_entries.clear();
+        batch.seen.clear();
+        batch.oldest = None;
+        count
     }
 
     /// 处理单个文件
@@ -548,6 +766,93 @@ mod tests {
         assert_eq!(result2.skipped, 1);
     }
 
+    #[test]
+    fn test_index_commits_in_batches() {
+        let temp_dir = TempDir::new().unwrap();
+        let base_path = temp_dir.path();
+
+        for i in 0..25 {
+            fs::write(base_path.join(format!("photo{}.jpg", i)), format!("fake {}", i)).unwrap();
+        }
+
+        let db = Arc::new(Database::open_in_memory().unwrap());
+        db.init().unwrap();
+
+        let options = IndexOptions {
+            batch_size: 4,
+            ..IndexOptions::default()
+        };
+        let indexer = PhotoIndexer::new(db.clone(), options);
+        let result = indexer.index_directory(base_path).unwrap();
+
+        // 最后一个不满的批次也要提交
+        assert_eq!(result.indexed, 25);
+        assert_eq!(db.count_photos().unwrap(), 25);
+    }
+
+    #[test]
+    fn test_pending_batch_due_by_oldest_item() {
+        let entry = || JournalEntry {
+            file_path: "/p/a.jpg".to_string(),
+            dir_path: "/p".to_string(),
+            is_dir: false,
+            stamp: Default::default(),
+        };
+
+        let mut batch = PendingBatch::default();
+        assert_eq!(batch.time_left(), FLUSH_INTERVAL);
+        assert!(!batch.is_due());
+
+        batch.push(Processed::Seen(entry()));
+        assert!(!batch.is_due());
+        assert!(batch.time_left() <= FLUSH_INTERVAL);
+
+        // 后续条目不重置计时：最早一条到期即提交
+        batch.oldest = Instant::now().checked_sub(FLUSH_INTERVAL);
+        batch.push(Processed::Seen(entry()));
+        assert!(batch.is_due());
+        assert_eq!(batch.time_left(), Duration::ZERO);
+    }
+
+    #[test]
+    fn test_rescan_uses_journal() {
+        let temp_dir = TempDir::new().unwrap();
+        let base_path = temp_dir.path();
+
+        for i in 0..3 {
+            fs::write(base_path.join(format!("photo{}.jpg", i)), format!("fake {}", i)).unwrap();
+        }
+        // 目录修改时间需早于扫描开始，才会被记为未变化
+        let past = std::time::SystemTime::now() - Duration::from_secs(60);
+        filetime::set_file_mtime(base_path, filetime::FileTime::from_system_time(past)).unwrap();
+
+        let db = Arc::new(Database::open_in_memory().unwrap());
+        db.init().unwrap();
+        let indexer = PhotoIndexer::new(db.clone(), IndexOptions::default());
+
+        assert_eq!(indexer.index_directory(base_path).unwrap().indexed, 3);
+
+        let dir_path = base_path.to_string_lossy().to_string();
+        let journal = db.get_journal_dir(&dir_path).unwrap().unwrap();
+        assert_eq!(journal.file_count, 3);
+
+        let rescan = indexer.index_directory(base_path).unwrap();
+        assert_eq!(rescan.indexed, 0);
+        assert_eq!(rescan.skipped, 3);
+
+        // 彻底删除照片会清除日志，重新扫描时再次发现该文件
+        let photo = db
+            .get_photo_by_path(&base_path.join("photo0.jpg").to_string_lossy())
+            .unwrap()
+            .unwrap();
+        db.delete_photo(photo.photo_id).unwrap();
+        assert!(db.get_journal_dir(&dir_path).unwrap().is_none());
+
+        let rescan = indexer.index_directory(base_path).unwrap();
+        assert_eq!(rescan.indexed, 1);
+        assert_eq!(rescan.skipped, 2);
+    }
+
     #[test]
     fn test_cancel_indexing() {
         let temp_dir = TempDir::new().unwrap();
@@ -3,17 +3,28 @@
 //! 包含所有业务逻辑服务
 
 pub mod scanner;
+pub mod scan_journal;
 pub mod metadata;
 pub mod hasher;
 pub mod indexer;
 pub mod thumbnail;
+pub mod thumbnail_pack;
+pub mod thumbnail_atlas;
 pub mod thumbnail_queue;
 pub mod watcher;
 pub mod settings;
 pub mod libraw;
 pub mod editor;
+pub mod edit_pipeline;
+pub mod edit_session;
+pub mod scopes;
 pub mod colorspace;
 pub mod auto_scan;
+pub mod duplicate_index;
+pub mod color_index;
+pub mod ocr_preprocess;
+pub mod ocr_batch;
+pub mod viewer_prefetch;
 
 // Windows-specific modules
 #[cfg(target_os = "windows")]
@@ -23,12 +34,23 @@ pub mod native_editor;
 
 // 重新导出常用类型
 pub use scanner::{Scanner, ScanOptions, ScanResult, ScanProgress, is_image_file, SUPPORTED_FORMATS};
+pub use scan_journal::{JournalScanner, JournalScanResult};
 pub use metadata::{MetadataExtractor, ImageMetadata};
 pub use hasher::{FileHasher, HashOptions};
 pub use indexer::{PhotoIndexer, IndexOptions, IndexProgress, IndexResult};
 pub use thumbnail::{ThumbnailService, ThumbnailSize, ThumbnailResult, CacheStats};
-pub use thumbnail_queue::{ThumbnailQueue, ThumbnailTask, set_event_sink, clear_event_sink};
+pub use thumbnail_pack::{ThumbnailPackStore, PackedThumbnail, PackCompactStats};
+pub use thumbnail_atlas::{build_atlas, AtlasFormat, AtlasOptions, AtlasCell, AtlasPage, ThumbnailAtlas};
+pub use thumbnail_queue::{OffscreenPolicy, ThumbnailQueue, ThumbnailTask, set_event_sink, clear_event_sink};
 pub use watcher::{FileWatcher, WatcherConfig, FileChangeEvent, FileChangeType};
 pub use settings::SettingsManager;
 pub use editor::{EditorService, EditParams, EditOperation, FlipDirection, CropRect};
+pub use edit_pipeline::{DisplayMode, EditPipeline, PixelFormat};
+pub use edit_session::{EditSession, EditSessionOptions, OutputBuffer, PreviewFrame, PreviewLevel};
+pub use scopes::{ScopeAccumulator, Scopes, SCOPE_COLUMNS, SCOPE_LEVELS, VECTORSCOPE_SIZE};
 pub use auto_scan::{AutoScanManager, AutoScanStatus, StepScanConfig};
+pub use color_index::{ColorIndex, ColorMatch};
+pub use ocr_preprocess::{OcrImage, OcrPreprocessOptions};
+pub use ocr_batch::{OcrBatch, OcrBatchOptions, OcrBatchProgress, OcrBatchResult, OcrOutcome, OcrRecognizer, OcrStatus, OcrTask};
+pub use viewer_prefetch::{PrefetchOptions, Rendition, ViewerPrefetcher};
+pub use duplicate_index::{DuplicateIndex, DuplicateNeighbor, HammingIndex, PerceptualHashKind, MAX_DUPLICATE_DISTANCE};
@@ -28,6 +28,14 @@ pub struct PwAdjustments {
     pub vignette: f32,
 }
 
+/// 像素缓冲区 (与 C 结构体对应，由库分配)
+#[repr(C)]
+struct PwPixels {
+    data: *mut u8,
+    width: c_int,
+    height: c_int,
+}
+
 // 函数类型定义
 type PwEditorInit = unsafe extern "C" fn() -> c_int;
 type PwEditorCleanup = unsafe extern "C" fn();
@@ -69,6 +77,14 @@ type PwAdjustTemperature = unsafe extern "C" fn(
     output_path: *const c_char,
     kelvin_shift: c_float,
 ) -> c_int;
+type PwThumbnail = unsafe extern "C" fn(
+    input_path: *const c_char,
+    output_path: *const c_char,
+    size: c_int,
+    quality: c_int,
+    pixels: *mut PwPixels,
+) -> c_int;
+type PwFreePixels = unsafe extern "C" fn(pixels: *mut PwPixels);
 
 /// Native Editor 库封装
 pub struct NativeEditor {
@@ -83,6 +99,8 @@ pub struct NativeEditor {
     adjust_highlights: Symbol<'static, PwAdjustHighlights>,
     adjust_shadows: Symbol<'static, PwAdjustShadows>,
     adjust_temperature: Symbol<'static, PwAdjustTemperature>,
+    /// 旧版 DLL 没有导出 pw_thumbnail / pw_free_pixels，此时为 None
+    thumbnail: Option<(Symbol<'static, PwThumbnail>, Symbol<'static, PwFreePixels>)>,
     initialized: bool,
 }
 
@@ -169,6 +187,12 @@ impl NativeEditor {
                 .get(b"pw_adjust_temperature")
                 .map_err(|e| AppError::General(format!("Symbol pw_adjust_temperature not found: {}", e)))?;
 
+            // 可选符号：缺失时缩略图回退到 WIC / image crate，不影响编辑功能
+            let thumbnail: Option<(Symbol<PwThumbnail>, Symbol<PwFreePixels>)> = library
+                .get(b"pw_thumbnail")
+                .ok()
+                .zip(library.get(b"pw_free_pixels").ok());
+
             // 延长生命周期 (库会一直保持加载)
             let init: Symbol<'static, PwEditorInit> = std::mem::transmute(init);
             let cleanup: Symbol<'static, PwEditorCleanup> = std::mem::transmute(cleanup);
@@ -180,6 +204,8 @@ impl NativeEditor {
             let adjust_highlights: Symbol<'static, PwAdjustHighlights> = std::mem::transmute(adjust_highlights);
             let adjust_shadows: Symbol<'static, PwAdjustShadows> = std::mem::transmute(adjust_shadows);
             let adjust_temperature: Symbol<'static, PwAdjustTemperature> = std::mem::transmute(adjust_temperature);
+            let thumbnail: Option<(Symbol<'static, PwThumbnail>, Symbol<'static, PwFreePixels>)> =
+                thumbnail.map(|(generate, free)| (std::mem::transmute(generate), std::mem::transmute(free)));
 
             let mut editor = NativeEditor {
                 _library: library,
@@ -193,6 +219,7 @@ impl NativeEditor {
                 adjust_highlights,
                 adjust_shadows,
                 adjust_temperature,
+                thumbnail,
                 initialized: false,
             };
 
@@ -381,6 +408,53 @@ impl NativeEditor {
             Ok(())
         }
     }
+
+    /// 是否支持 libvips 缩略图
+    pub fn supports_thumbnail(&self) -> bool {
+        self.thumbnail.is_some()
+    }
+
+    /// 生成 WebP 缩略图（shrink-on-load + EXIF 方向 + sRGB 转换）
+    ///
+    /// `size` 为输出最长边，只缩小不放大。同时返回编码前的 RGBA8 像素 (宽, 高, 像素)，
+    /// 供计算哈希和质量评分，不必再解码有损的 WebP。
+    pub fn thumbnail(
+        &self,
+        input_path: &Path,
+        output_path: &Path,
+        size: u32,
+        quality: i32,
+    ) -> AppResult<(u32, u32, Vec<u8>)> {
+        let (thumbnail, free_pixels) = self.thumbnail.as_ref().ok_or_else(|| {
+            AppError::General("pw_thumbnail not available in native editor".to_string())
+        })?;
+        let input = path_to_cstring(input_path)?;
+        let output = path_to_cstring(output_path)?;
+
+        let mut pixels = PwPixels {
+            data: std::ptr::null_mut(),
+            width: 0,
+            height: 0,
+        };
+        let result = unsafe { thumbnail(input.as_ptr(), output.as_ptr(), size as c_int, quality, &mut pixels) };
+
+        if result != 0 {
+            return Err(AppError::General(format!(
+                "Failed to generate thumbnail: {}",
+                self.last_error()
+            )));
+        }
+        if pixels.data.is_null() || pixels.width <= 0 || pixels.height <= 0 {
+            unsafe { free_pixels(&mut pixels) };
+            return Err(AppError::General("pw_thumbnail returned no pixels".to_string()));
+        }
+
+        let (width, height) = (pixels.width as u32, pixels.height as u32);
+        let len = width as usize * height as usize * 4;
+        let data = unsafe { std::slice::from_raw_parts(pixels.data, len) }.to_vec();
+        unsafe { free_pixels(&mut pixels) };
+        Ok((width, height, data))
+    }
 }
 
 impl Drop for NativeEditor {
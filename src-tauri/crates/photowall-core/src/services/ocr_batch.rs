@@ -0,0 +1,524 @@
+//! 批量 OCR 流水线
+//!
+//! 解码和预处理在本次批处理专用的 rayon 线程池上并行执行，结果经有界通道交给固定数量的识别线程。
+//! 识别落后时预处理任务阻塞在通道上，内存中最多积压 `queue_depth` 张预处理后的图片；
+//! 阻塞的只是专用线程，不会占住全局 rayon 线程池上的缩略图、索引等任务。
+//! 预处理失败时回退为未处理的灰度原图交给识别，与单张识别的行为一致。
+//! 识别引擎由调用方通过 [`OcrRecognizer`] 提供（Tesseract 命令行、系统 OCR 或 C 回调）。
+
+use std::path::PathBuf;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::{mpsc, Arc, Mutex};
+use std::time::Instant;
+
+use rayon::prelude::*;
+
+use crate::metrics;
+use crate::utils::error::AppResult;
+
+use super::ocr_preprocess::{self, OcrImage, OcrPreprocessOptions};
+
+/// 默认识别线程数上限（OCR 引擎本身多为多线程，更多并发只会争抢 CPU 和内存）
+const DEFAULT_MAX_RECOGNIZER_THREADS: usize = 4;
+
+/// OCR 识别引擎
+///
+/// 会被多个识别线程同时调用。
+pub trait OcrRecognizer: Send + Sync {
+    /// 识别预处理后的二值图，返回识别出的文字（没有文字时返回空字符串）
+    fn recognize(&self, image: &OcrImage) -> AppResult<String>;
+}
+
+/// OCR 状态（与数据库 `photos.ocr_status` 取值一致）
+#[derive(Debug, Clone, Copy, PartialEq, Eq, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+#[repr(i32)]
+pub enum OcrStatus {
+    /// 未处理
+    Pending = 0,
+    /// 已识别出文字
+    Processed = 1,
+    /// 处理失败
+    Failed = 2,
+    /// 无文字
+    NoText = 3,
+}
+
+/// 批量 OCR 选项
+#[derive(Debug, Clone, Default)]
+pub struct OcrBatchOptions {
+    /// 预处理选项
+    pub preprocess: OcrPreprocessOptions,
+    /// 识别线程数，0 表示 CPU 核数的一半（至少 1，至多 4）
+    pub recognizer_threads: usize,
+    /// 预处理线程数，0 表示 CPU 核数减去识别线程数（至少 1）
+    pub preprocess_threads: usize,
+    /// 等待识别的预处理图片上限，0 表示识别线程数的两倍
+    pub queue_depth: usize,
+}
+
+/// 一个 OCR 任务
+#[derive(Debug, Clone)]
+pub struct OcrTask {
+    pub photo_id: i64,
+    pub path: PathBuf,
+}
+
+/// 单张照片的 OCR 结果
+#[derive(Debug, Clone)]
+pub struct OcrOutcome {
+    pub photo_id: i64,
+    pub status: OcrStatus,
+    /// 识别出的文字（仅 `Processed` 时有值）
+    pub text: Option<String>,
+    /// 失败原因（仅 `Failed` 时有值）
+    pub error: Option<String>,
+}
+
+/// 批量 OCR 进度
+#[derive(Debug, Clone, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct OcrBatchProgress {
+    pub total: usize,
+    pub processed: usize,
+    pub recognized: usize,
+    pub no_text: usize,
+    pub failed: usize,
+    pub percentage: f64,
+}
+
+/// 批量 OCR 结果
+#[derive(Debug, Clone, Default, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct OcrBatchResult {
+    pub total: usize,
+    pub recognized: usize,
+    pub no_text: usize,
+    pub failed: usize,
+    pub cancelled: bool,
+}
+
+#[derive(Default)]
+struct Counters {
+    processed: AtomicUsize,
+    recognized: AtomicUsize,
+    no_text: AtomicUsize,
+    failed: AtomicUsize,
+}
+
+impl Counters {
+    fn record(&self, status: OcrStatus) -> usize {
+        let counter = match status {
+            OcrStatus::Processed => &self.recognized,
+            OcrStatus::NoText => &self.no_text,
+            _ => &self.failed,
+        };
+        counter.fetch_add(1, Ordering::SeqCst);
+        self.processed.fetch_add(1, Ordering::SeqCst) + 1
+    }
+
+    fn progress(&self, total: usize, processed: usize) -> OcrBatchProgress {
+        OcrBatchProgress {
+            total,
+            processed,
+            recognized: self.recognized.load(Ordering::SeqCst),
+            no_text: self.no_text.load(Ordering::SeqCst),
+            failed: self.failed.load(Ordering::SeqCst),
+            percentage: if total > 0 { processed as f64 / total as f64 * 100.0 } else { 100.0 },
+        }
+    }
+}
+
+/// 批量 OCR
+pub struct OcrBatch {
+    recognizer: Arc<dyn OcrRecognizer>,
+    options: OcrBatchOptions,
+    cancel_flag: Arc<AtomicBool>,
+}
+
+impl OcrBatch {
+    /// 创建批量 OCR
+    pub fn new(recognizer: Arc<dyn OcrRecognizer>, options: OcrBatchOptions) -> Self {
+        Self::with_cancel_flag(recognizer, options, Arc::new(AtomicBool::new(false)))
+    }
+
+    /// 创建带外部取消标志的批量 OCR
+    pub fn with_cancel_flag(
+        recognizer: Arc<dyn OcrRecognizer>,
+        options: OcrBatchOptions,
+        cancel_flag: Arc<AtomicBool>,
+    ) -> Self {
+        Self {
+            recognizer,
+            options,
+            cancel_flag,
+        }
+    }
+
+    fn is_cancelled(&self) -> bool {
+        self.cancel_flag.load(Ordering::Relaxed)
+    }
+
+    fn recognizer_threads(&self) -> usize {
+        if self.options.recognizer_threads > 0 {
+            self.options.recognizer_threads
+        } else {
+            (cpu_count() / 2).clamp(1, DEFAULT_MAX_RECOGNIZER_THREADS)
+        }
+    }
+
+    fn preprocess_threads(&self, recognizer_threads: usize) -> usize {
+        if self.options.preprocess_threads > 0 {
+            self.options.preprocess_threads
+        } else {
+            cpu_count().saturating_sub(recognizer_threads).max(1)
+        }
+    }
+
+    /// 执行批量 OCR
+    ///
+    /// `on_outcome` 在识别线程上逐张回调（可用于写库），`on_progress` 紧随其后。
+    /// 取消后尚未预处理或尚未识别的照片不回调，保持未处理状态。
+    pub fn run<F, P>(&self, tasks: &[OcrTask], on_outcome: F, on_progress: P) -> OcrBatchResult
+    where
+        F: Fn(&OcrOutcome) + Sync,
+        P: Fn(&OcrBatchProgress) + Sync,
+    {
+        let preprocess = &self.options.preprocess;
+        self.run_with(
+            tasks,
+            |task| {
+                ocr_preprocess::preprocess_file(&task.path, preprocess).or_else(|e| {
+                    tracing::warn!("OCR 预处理失败，使用原图: {} - {}", task.path.display(), e);
+                    ocr_preprocess::load_unprocessed(&task.path, preprocess.target_dpi)
+                })
+            },
+            on_outcome,
+            on_progress,
+        )
+    }
+
+    fn run_with<L, F, P>(&self, tasks: &[OcrTask], preprocess: L, on_outcome: F, on_progress: P) -> OcrBatchResult
+    where
+        L: Fn(&OcrTask) -> AppResult<OcrImage> + Sync,
+        F: Fn(&OcrOutcome) + Sync,
+        P: Fn(&OcrBatchProgress) + Sync,
+    {
+        let total = tasks.len();
+        let started = Instant::now();
+        let m = metrics::global();
+        let counters = Counters::default();
+        let threads = self.recognizer_threads();
+        let depth = if self.options.queue_depth > 0 { self.options.queue_depth } else { threads * 2 };
+
+        let report = |outcome: OcrOutcome| {
+            let processed = counters.record(outcome.status);
+            on_outcome(&outcome);
+            on_progress(&counters.progress(total, processed));
+        };
+
+        let pool = match rayon::ThreadPoolBuilder::new()
+            .num_threads(self.preprocess_threads(threads))
+            .thread_name(|i| format!("ocr-preprocess-{}", i))
+            .build()
+        {
+            Ok(pool) => pool,
+            Err(e) => {
+                tracing::error!("创建 OCR 预处理线程池失败: {}", e);
+                return OcrBatchResult {
+                    total,
+                    cancelled: self.is_cancelled(),
+                    ..Default::default()
+                };
+            }
+        };
+
+        let (tx, rx) = mpsc::sync_channel::<(usize, OcrImage)>(depth);
+        let rx = Mutex::new(rx);
+
+        std::thread::scope(|scope| {
+            for _ in 0..threads {
+                scope.spawn(|| loop {
+                    let next = match rx.lock() {
+                        Ok(rx) => rx.recv(),
+                        Err(_) => break,
+                    };
+                    let (index, image) = match next {
+                        Ok(item) => item,
+                        Err(_) => break,
+                    };
+                    // 取消后继续排空通道，让阻塞中的预处理任务尽快退出
+                    if self.is_cancelled() {
+                        continue;
+                    }
+
+                    let task = &tasks[index];
+                    let recognize_started = Instant::now();
+                    let result = self.recognizer.recognize(&image);
+                    m.record("ocr.recognize", recognize_started.elapsed());
+                    report(outcome_of(task.photo_id, result));
+                });
+            }
+
+            pool.install(|| {
+                tasks.par_iter().enumerate().for_each_with(tx, |tx, (index, task)| {
+                    if self.is_cancelled() {
+                        return;
+                    }
+
+                    let preprocess_started = Instant::now();
+                    let image = preprocess(task);
+                    m.record("ocr.preprocess", preprocess_started.elapsed());
+
+                    match image {
+                        // 识别线程只会在 panic 时提前退出
+                        Ok(image) => {
+                            let _ = tx.send((index, image));
+                        }
+                        Err(e) => {
+                            tracing::warn!("OCR 预处理失败 {}: {}", task.path.display(), e);
+                            report(OcrOutcome {
+                                photo_id: task.photo_id,
+                                status: OcrStatus::Failed,
+                                text: None,
+                                error: Some(e.to_string()),
+                            });
+                        }
+                    }
+                });
+            });
+            // for_each_with 结束时所有发送端已释放，识别线程排空通道后退出
+        });
+
+        let result = OcrBatchResult {
+            total,
+            recognized: counters.recognized.load(Ordering::SeqCst),
+            no_text: counters.no_text.load(Ordering::SeqCst),
+            failed: counters.failed.load(Ordering::SeqCst),
+            cancelled: self.is_cancelled(),
+        };
+
+        let elapsed = started.elapsed().as_secs_f64();
+        m.incr("ocr.photos_processed", counters.processed.load(Ordering::SeqCst) as u64);
+        if elapsed > 0.0 {
+            m.set_gauge(
+                "ocr.last_run_photos_per_min",
+                (counters.processed.load(Ordering::SeqCst) as f64 * 60.0 / elapsed).round() as i64,
+            );
+        }
+        tracing::info!(
+            "批量 OCR 完成: {} 张, 有文字 {}, 无文字 {}, 失败 {}, 取消 {}, {:.1}s",
+            total,
+            result.recognized,
+            result.no_text,
+            result.failed,
+            result.cancelled,
+            elapsed
+        );
+
+        result
+    }
+}
+
+fn cpu_count() -> usize {
+    std::thread::available_parallelism().map(|n| n.get()).unwrap_or(4)
+}
+
+fn outcome_of(photo_id: i64, result: AppResult<String>) -> OcrOutcome {
+    match result {
+        Ok(text) => {
+            let trimmed = text.trim();
+            if trimmed.is_empty() {
+                OcrOutcome {
+                    photo_id,
+                    status: OcrStatus::NoText,
+                    text: None,
+                    error: None,
+                }
+            } else {
+                OcrOutcome {
+                    photo_id,
+                    status: OcrStatus::Processed,
+                    text: Some(trimmed.to_string()),
+                    error: None,
+                }
+            }
+        }
+        Err(e) => OcrOutcome {
+            photo_id,
+            status: OcrStatus::Failed,
+            text: None,
+            error: Some(e.to_string()),
+        },
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::utils::error::AppError;
+    use std::collections::HashSet;
+
+    /// 按图片宽度返回文字的识别器，记录同时在识别的线程数峰值
+    struct FakeRecognizer {
+        active: AtomicUsize,
+        peak: AtomicUsize,
+    }
+
+    impl OcrRecognizer for FakeRecognizer {
+        fn recognize(&self, image: &OcrImage) -> AppResult<String> {
+            let active = self.active.fetch_add(1, Ordering::SeqCst) + 1;
+            self.peak.fetch_max(active, Ordering::SeqCst);
+            std::thread::sleep(std::time::Duration::from_millis(2));
+            self.active.fetch_sub(1, Ordering::SeqCst);
+            match image.width % 3 {
+                0 => Ok(format!("  text {}  ", image.width)),
+                1 => Ok(String::new()),
+                _ => Err(AppError::General("engine error".to_string())),
+            }
+        }
+    }
+
+    fn image(width: u32) -> OcrImage {
+        OcrImage {
+            width,
+            height: 1,
+            pixels: vec![255; width as usize],
+            dpi: 300,
+            skew_degrees: 0.0,
+        }
+    }
+
+    fn tasks(count: i64) -> Vec<OcrTask> {
+        (0..count)
+            .map(|i| OcrTask {
+                photo_id: i,
+                path: PathBuf::from(format!("{}.jpg", i)),
+            })
+            .collect()
+    }
+
+    fn recognizer() -> Arc<FakeRecognizer> {
+        Arc::new(FakeRecognizer {
+            active: AtomicUsize::new(0),
+            peak: AtomicUsize::new(0),
+        })
+    }
+
+    #[test]
+    fn test_batch_reports_every_task() {
+        let recognizer = recognizer();
+        let batch = OcrBatch::new(
+            recognizer.clone(),
+            OcrBatchOptions {
+                recognizer_threads: 3,
+                queue_depth: 2,
+                ..Default::default()
+            },
+        );
+
+        let outcomes = Mutex::new(Vec::new());
+        let last_progress = Mutex::new(None);
+        let tasks = tasks(60);
+        let result = batch.run_with(
+            &tasks,
+            // ID 为 7 的倍数时预处理失败，其余按 ID 生成不同宽度
+            |task| match task.photo_id {
+                id if id % 7 == 0 => Err(AppError::General("decode error".to_string())),
+                id => Ok(image(id as u32)),
+            },
+            |outcome| outcomes.lock().unwrap().push(outcome.clone()),
+            |progress| *last_progress.lock().unwrap() = Some(progress.clone()),
+        );
+
+        let mut outcomes = outcomes.into_inner().unwrap();
+        outcomes.sort_by_key(|o| o.photo_id);
+        assert_eq!(outcomes.len(), 60);
+        for outcome in &outcomes {
+            let expected = match outcome.photo_id {
+                id if id % 7 == 0 => OcrStatus::Failed,
+                id if id % 3 == 0 => OcrStatus::Processed,
+                id if id % 3 == 1 => OcrStatus::NoText,
+                _ => OcrStatus::Failed,
+            };
+            assert_eq!(outcome.status, expected, "photo {}", outcome.photo_id);
+        }
+        assert_eq!(outcomes[3].text.as_deref(), Some("text 3"));
+
+        assert_eq!(result.recognized + result.no_text + result.failed, 60);
+        assert!(!result.cancelled);
+        let progress = last_progress.into_inner().unwrap().unwrap();
+        assert_eq!(progress.processed, 60);
+        assert_eq!(progress.failed, result.failed);
+        assert!(recognizer.peak.load(Ordering::SeqCst) <= 3);
+    }
+
+    #[test]
+    fn test_preprocessing_runs_on_dedicated_pool() {
+        let batch = OcrBatch::new(
+            recognizer(),
+            OcrBatchOptions {
+                recognizer_threads: 2,
+                preprocess_threads: 3,
+                ..Default::default()
+            },
+        );
+
+        let names = Mutex::new(HashSet::new());
+        let tasks = tasks(40);
+        let result = batch.run_with(
+            &tasks,
+            |task| {
+                let name = std::thread::current().name().unwrap_or_default().to_string();
+                names.lock().unwrap().insert(name);
+                Ok(image(task.photo_id as u32 * 3))
+            },
+            |_| {},
+            |_| {},
+        );
+
+        assert_eq!(result.recognized, 40);
+        let names = names.into_inner().unwrap();
+        assert!(!names.is_empty() && names.len() <= 3, "{:?}", names);
+        assert!(names.iter().all(|n| n.starts_with("ocr-preprocess-")), "{:?}", names);
+    }
+
+    #[test]
+    fn test_default_thread_counts_are_bounded() {
+        let batch = OcrBatch::new(recognizer(), OcrBatchOptions::default());
+        let recognizers = batch.recognizer_threads();
+        assert!((1..=DEFAULT_MAX_RECOGNIZER_THREADS).contains(&recognizers));
+        assert!(batch.preprocess_threads(recognizers) >= 1);
+        assert_eq!(batch.preprocess_threads(cpu_count()), 1);
+    }
+
+    #[test]
+    fn test_cancel_stops_pipeline() {
+        let cancel = Arc::new(AtomicBool::new(false));
+        let batch = OcrBatch::with_cancel_flag(
+            recognizer(),
+            OcrBatchOptions {
+                recognizer_threads: 2,
+                queue_depth: 1,
+                ..Default::default()
+            },
+            cancel.clone(),
+        );
+
+        let reported = AtomicUsize::new(0);
+        let tasks = tasks(2000);
+        let result = batch.run_with(
+            &tasks,
+            |task| Ok(image(task.photo_id as u32 * 3)),
+            |_| {
+                if reported.fetch_add(1, Ordering::SeqCst) == 10 {
+                    cancel.store(true, Ordering::SeqCst);
+                }
+            },
+            |_| {},
+        );
+
+        assert!(result.cancelled);
+        assert!(reported.load(Ordering::SeqCst) < 100, "{}", reported.load(Ordering::SeqCst));
+    }
+}
@@ -0,0 +1,397 @@
+//! OCR 预处理
+//!
+//! 把照片整理成适合 OCR 引擎的二值图，直接在内存中交给识别步骤：
+//! 1. 按目标 DPI 缩小加载（Windows 上由 WIC 在解码时缩放，其余平台解码后缩放）
+//! 2. 灰度化
+//! 3. Sauvola 自适应二值化（积分图求局部均值和方差）
+//! 4. 投影轮廓法检测倾斜角并纠偏
+//!
+//! 照片没有可靠的物理 DPI，按“长边对应一张 A4 纸长边”换算目标像素数。
+
+use std::path::Path;
+
+use image::imageops::FilterType;
+use image::{DynamicImage, GrayImage};
+
+use crate::utils::error::{AppError, AppResult};
+
+use super::thumbnail::apply_exif_orientation;
+use super::wic::WicProcessor;
+
+/// A4 纸长边（英寸）
+const PAGE_LONG_EDGE_INCHES: f32 = 11.69;
+/// Sauvola 公式中标准差的动态范围
+const SAUVOLA_R: f32 = 128.0;
+/// 参与倾斜检测的前景像素上限
+const MAX_SKEW_SAMPLES: usize = 200_000;
+/// 小于此角度（度）不纠偏
+const MIN_DESKEW_DEGREES: f32 = 0.2;
+
+/// 预处理选项
+#[derive(Debug, Clone, serde::Serialize, serde::Deserialize)]
+#[serde(rename_all = "camelCase", default)]
+pub struct OcrPreprocessOptions {
+    /// 目标 DPI（长边按 A4 换算），只缩小不放大
+    pub target_dpi: u32,
+    /// Sauvola 窗口边长（像素，奇数），0 表示按 DPI 自动选择（约 1/10 英寸）
+    pub window_size: u32,
+    /// Sauvola 灵敏度系数 k
+    pub sauvola_k: f32,
+    /// 是否纠偏
+    pub deskew: bool,
+    /// 检测的最大倾斜角（度）
+    pub max_skew_degrees: f32,
+}
+
+impl Default for OcrPreprocessOptions {
+    fn default() -> Self {
+        Self {
+            target_dpi: 300,
+            window_size: 0,
+            sauvola_k: 0.35,
+            deskew: true,
+            max_skew_degrees: 10.0,
+        }
+    }
+}
+
+impl OcrPreprocessOptions {
+    /// 目标长边像素数
+    pub fn target_long_edge(&self) -> u32 {
+        (self.target_dpi.max(1) as f32 * PAGE_LONG_EDGE_INCHES).round() as u32
+    }
+
+    fn effective_window(&self) -> usize {
+        let window = if self.window_size > 0 {
+            self.window_size
+        } else {
+            (self.target_dpi / 10).max(15)
+        };
+        (window | 1) as usize
+    }
+}
+
+/// 预处理结果：8 位二值图（0 为前景文字，255 为背景）
+#[derive(Debug, Clone)]
+pub struct OcrImage {
+    pub width: u32,
+    pub height: u32,
+    /// 按行存储的 `width * height` 个像素
+    pub pixels: Vec<u8>,
+    /// 传给 OCR 引擎的 DPI
+    pub dpi: u32,
+    /// 检测到并已纠正的倾斜角（度，逆时针为正）
+    pub skew_degrees: f32,
+}
+
+impl OcrImage {
+    /// 转为 image crate 的灰度图（不复制像素）
+    pub fn into_gray_image(self) -> GrayImage {
+        GrayImage::from_raw(self.width, self.height, self.pixels)
+            .expect("OcrImage 像素数与尺寸一致")
+    }
+}
+
+/// 从文件加载并预处理
+pub fn preprocess_file(path: &Path, options: &OcrPreprocessOptions) -> AppResult<OcrImage> {
+    if !path.exists() {
+        return Err(AppError::FileNotFound(path.display().to_string()));
+    }
+
+    let gray = load_scaled_gray(path, options.target_long_edge())?;
+    Ok(preprocess_gray(&gray, options))
+}
+
+/// 不做缩放、二值化和纠偏，直接加载灰度原图（预处理失败时的回退）
+pub fn load_unprocessed(path: &Path, dpi: u32) -> AppResult<OcrImage> {
+    let gray = apply_exif_orientation(path, image::open(path)?).to_luma8();
+    Ok(OcrImage {
+        width: gray.width(),
+        height: gray.height(),
+        pixels: gray.into_raw(),
+        dpi,
+        skew_degrees: 0.0,
+    })
+}
+
+/// 对已解码的灰度图做二值化和纠偏
+pub fn preprocess_gray(gray: &GrayImage, options: &OcrPreprocessOptions) -> OcrImage {
+    let (width, height) = (gray.width() as usize, gray.height() as usize);
+    let mut pixels = sauvola_binarize(gray.as_raw(), width, height, options.effective_window(), options.sauvola_k);
+    let (mut out_w, mut out_h) = (width, height);
+
+    let mut skew_degrees = 0.0;
+    if options.deskew && options.max_skew_degrees > 0.0 {
+        let angle = detect_skew(&pixels, width, height, options.max_skew_degrees);
+        if angle.abs() >= MIN_DESKEW_DEGREES {
+            let (rotated, w, h) = rotate_binary(&pixels, width, height, angle);
+            pixels = rotated;
+            out_w = w;
+            out_h = h;
+            skew_degrees = angle;
+        }
+    }
+
+    OcrImage {
+        width: out_w as u32,
+        height: out_h as u32,
+        pixels,
+        dpi: options.target_dpi,
+        skew_degrees,
+    }
+}
+
+/// 按目标长边缩小加载为灰度图
+///
+/// 先只读文件头取尺寸，需要缩小时优先用 WIC 在解码阶段缩放（JPEG 可直接按 DCT 缩放），
+/// 避免先解码出整张原图。
+fn load_scaled_gray(path: &Path, target_long_edge: u32) -> AppResult<GrayImage> {
+    let (orig_w, orig_h) = image::image_dimensions(path)?;
+    let long_edge = orig_w.max(orig_h).max(1);
+    let scale = (target_long_edge as f64 / long_edge as f64).min(1.0);
+    let (new_w, new_h) = (
+        ((orig_w as f64 * scale).round() as u32).max(1),
+        ((orig_h as f64 * scale).round() as u32).max(1),
+    );
+
+    let img = if scale < 1.0 {
+        let wic = WicProcessor::new().and_then(|processor| {
+            let (buffer, w, h) = processor.load_and_resize(path, new_w, new_h)?;
+            WicProcessor::buffer_to_dynamic_image(buffer, w, h)
+        });
+        match wic {
+            Ok(img) => img,
+            Err(_) => image::open(path)?.resize(new_w, new_h, FilterType::Triangle),
+        }
+    } else {
+        image::open(path)?
+    };
+
+    Ok(apply_exif_orientation(path, img).to_luma8())
+}
+
+/// 积分图的一行（前缀和与前缀平方和）
+#[derive(Clone)]
+struct IntegralRow {
+    sum: Vec<u64>,
+    sq_sum: Vec<u64>,
+}
+
+/// Sauvola 自适应二值化
+///
+/// 阈值 `T = m * (1 + k * (s / R - 1))`，m、s 为窗口内均值和标准差，由积分图 O(1) 求得。
+/// 只保留窗口覆盖的积分图行（环形缓冲），内存与图像宽度成正比，而不是整张图。
+fn sauvola_binarize(luma: &[u8], width: usize, height: usize, window: usize, k: f32) -> Vec<u8> {
+    let radius = window / 2;
+    let ring = 2 * radius + 2;
+    let mut rows = vec![
+        IntegralRow {
+            sum: vec![0; width + 1],
+            sq_sum: vec![0; width + 1],
+        };
+        ring
+    ];
+    // rows 中保存了积分图第 0..=computed 行（第 0 行全 0）
+    let mut computed = 0usize;
+
+    let mut out = vec![255u8; width * height];
+    for y in 0..height {
+        let y0 = y.saturating_sub(radius);
+        let y1 = (y + radius + 1).min(height);
+
+        while computed < y1 {
+            let (prev, next) = (computed % ring, (computed + 1) % ring);
+            let src = &luma[computed * width..(computed + 1) * width];
+            let (mut row_sum, mut row_sq) = (0u64, 0u64);
+            for x in 0..width {
+                let v = src[x] as u64;
+                row_sum += v;
+                row_sq += v * v;
+                rows[next].sum[x + 1] = rows[prev].sum[x + 1] + row_sum;
+                rows[next].sq_sum[x + 1] = rows[prev].sq_sum[x + 1] + row_sq;
+            }
+            computed += 1;
+        }
+
+        let (top, bottom) = (&rows[y0 % ring], &rows[y1 % ring]);
+        let src = &luma[y * width..(y + 1) * width];
+        let dst = &mut out[y * width..(y + 1) * width];
+        for x in 0..width {
+            let x0 = x.saturating_sub(radius);
+            let x1 = (x + radius + 1).min(width);
+            let area = ((x1 - x0) * (y1 - y0)) as f32;
+            let sum = (bottom.sum[x1] + top.sum[x0] - bottom.sum[x0] - top.sum[x1]) as f32;
+            let sq_sum = (bottom.sq_sum[x1] + top.sq_sum[x0] - bottom.sq_sum[x0] - top.sq_sum[x1]) as f32;
+
+            let mean = sum / area;
+            let std = (sq_sum / area - mean * mean).max(0.0).sqrt();
+            let threshold = mean * (1.0 + k * (std / SAUVOLA_R - 1.0));
+            if (src[x] as f32) <= threshold {
+                dst[x] = 0;
+            }
+        }
+    }
+    out
+}
+
+/// 投影轮廓法检测倾斜角（度）
+///
+/// 把前景像素按候选角度投影到纵轴，文字行与投影方向平行时行间空白最干净，
+/// 投影直方图的平方和最大。先 1° 粗搜，再在最优角附近 0.1° 细搜。
+fn detect_skew(binary: &[u8], width: usize, height: usize, max_degrees: f32) -> f32 {
+    let foreground = binary.iter().filter(|&&p| p == 0).count();
+    if foreground == 0 {
+        return 0.0;
+    }
+    let step = foreground.div_ceil(MAX_SKEW_SAMPLES);
+    let points: Vec<(f32, f32)> = binary
+        .iter()
+        .enumerate()
+        .filter(|(_, &p)| p == 0)
+        .step_by(step)
+        .map(|(i, _)| ((i % width) as f32 - width as f32 / 2.0, (i / width) as f32 - height as f32 / 2.0))
+        .collect();
+
+    let bins = width + height + 1;
+    let offset = bins as f32 / 2.0;
+    let mut histogram = vec![0u32; bins];
+    let mut score = |degrees: f32| -> u64 {
+        let (sin, cos) = degrees.to_radians().sin_cos();
+        histogram.iter_mut().for_each(|h| *h = 0);
+        for &(x, y) in &points {
+            // 按 -degrees 旋转后的纵坐标
+            let row = (y * cos - x * sin + offset) as usize;
+            histogram[row.min(bins - 1)] += 1;
+        }
+        histogram.iter().map(|&h| h as u64 * h as u64).sum()
+    };
+
+    let search = |score: &mut dyn FnMut(f32) -> u64, from: f32, to: f32, step: f32| -> f32 {
+        let mut best = (0.0f32, 0u64);
+        let mut angle = from;
+        while angle <= to + 1e-4 {
+            let s = score(angle);
+            // 同分时取绝对值更小的角度
+            if s > best.1 || (s == best.1 && angle.abs() < best.0.abs()) {
+                best = (angle, s);
+            }
+            angle += step;
+        }
+        best.0
+    };
+
+    let max = max_degrees.abs();
+    let coarse = search(&mut score, -max, max, 1.0);
+    search(&mut score, (coarse - 1.0).max(-max), (coarse + 1.0).min(max), 0.1)
+}
+
+/// 旋转二值图（最近邻），画布扩大到能容纳整张图，空白处填背景色
+fn rotate_binary(binary: &[u8], width: usize, height: usize, degrees: f32) -> (Vec<u8>, usize, usize) {
+    let (sin, cos) = degrees.to_radians().sin_cos();
+    let out_w = (width as f32 * cos.abs() + height as f32 * sin.abs()).ceil() as usize;
+    let out_h = (width as f32 * sin.abs() + height as f32 * cos.abs()).ceil() as usize;
+    let (cx, cy) = (width as f32 / 2.0, height as f32 / 2.0);
+    let (ocx, ocy) = (out_w as f32 / 2.0, out_h as f32 / 2.0);
+
+    let mut out = vec![255u8; out_w * out_h];
+    for (oy, row) in out.chunks_exact_mut(out_w).enumerate() {
+        let dy = oy as f32 + 0.5 - ocy;
+        for (ox, pixel) in row.iter_mut().enumerate() {
+            let dx = ox as f32 + 0.5 - ocx;
+            // 逆映射：输出像素绕中心转回 +degrees 得到源坐标
+            let sx = dx * cos - dy * sin + cx;
+            let sy = dx * sin + dy * cos + cy;
+            if sx >= 0.0 && sy >= 0.0 && (sx as usize) < width && (sy as usize) < height {
+                *pixel = binary[sy as usize * width + sx as usize];
+            }
+        }
+    }
+    (out, out_w, out_h)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// 浅灰背景上的若干行“文字”（深色短横），背景从左到右逐渐变暗模拟光照不均
+    fn document(width: u32, height: u32) -> GrayImage {
+        GrayImage::from_fn(width, height, |x, y| {
+            let background = 230 - (x * 80 / width) as u8;
+            let in_line = (y % 40) >= 15 && (y % 40) < 25;
+            let in_word = (x % 30) >= 5 && (x % 30) < 25;
+            if in_line && in_word && x > 20 && x < width - 20 {
+                image::Luma([background.saturating_sub(110)])
+            } else {
+                image::Luma([background])
+            }
+        })
+    }
+
+    /// 二值图中文字行的前景比例
+    fn ink_ratio(image: &OcrImage) -> f64 {
+        image.pixels.iter().filter(|&&p| p == 0).count() as f64 / image.pixels.len() as f64
+    }
+
+    #[test]
+    fn test_sauvola_handles_uneven_lighting() {
+        let gray = document(400, 200);
+        let options = OcrPreprocessOptions {
+            deskew: false,
+            ..Default::default()
+        };
+        let result = preprocess_gray(&gray, &options);
+
+        // 文字像素全部变黑，明暗不同的背景全部变白
+        for y in 0..200u32 {
+            for x in 0..400u32 {
+                let expected_ink = gray.get_pixel(x, y)[0] < 230 - (x * 80 / 400) as u8;
+                let ink = result.pixels[(y * 400 + x) as usize] == 0;
+                assert_eq!(ink, expected_ink, "({}, {})", x, y);
+            }
+        }
+    }
+
+    #[test]
+    fn test_deskew_recovers_rotation() {
+        let gray = document(600, 400);
+        let options = OcrPreprocessOptions::default();
+        let straight = preprocess_gray(&gray, &options);
+        assert_eq!(straight.skew_degrees, 0.0);
+
+        // 把文字旋转 3°，预处理应检测出约 -3° 并转回
+        let binary = sauvola_binarize(gray.as_raw(), 600, 400, 31, 0.35);
+        let (tilted, w, h) = rotate_binary(&binary, 600, 400, 3.0);
+        let tilted_gray = GrayImage::from_raw(w as u32, h as u32, tilted).unwrap();
+        let corrected = preprocess_gray(&tilted_gray, &options);
+        assert!((corrected.skew_degrees + 3.0).abs() <= 0.2, "{}", corrected.skew_degrees);
+        assert!(ink_ratio(&corrected) > 0.0);
+    }
+
+    #[test]
+    fn test_blank_page() {
+        let gray = GrayImage::from_pixel(120, 80, image::Luma([200]));
+        let result = preprocess_gray(&gray, &OcrPreprocessOptions::default());
+        assert_eq!(ink_ratio(&result), 0.0);
+        assert_eq!(result.skew_degrees, 0.0);
+        assert_eq!((result.width, result.height), (120, 80));
+    }
+
+    #[test]
+    fn test_load_unprocessed_keeps_gray_pixels() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("page.png");
+        document(90, 60).save(&path).unwrap();
+
+        let image = load_unprocessed(&path, 300).unwrap();
+        assert_eq!((image.width, image.height, image.dpi), (90, 60, 300));
+        assert_eq!(image.pixels, document(90, 60).into_raw());
+        assert!(load_unprocessed(&dir.path().join("missing.png"), 300).is_err());
+    }
+
+    #[test]
+    fn test_target_long_edge() {
+        let options = OcrPreprocessOptions::default();
+        assert_eq!(options.target_long_edge(), 3507);
+        assert_eq!(options.effective_window(), 31);
+    }
+}
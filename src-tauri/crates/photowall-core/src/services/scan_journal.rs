@@ -0,0 +1,337 @@
+//! 增量扫描服务
+//!
+//! 基于扫描日志遍历目录：目录修改时间与日志一致时不读取目录内容，
+//! 直接沿用日志中的文件数和子目录；变化的目录逐个比对文件戳记，
+//! 只有新增或戳记变化的文件才交给索引器处理。
+
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+use crate::db::{Database, FileStamp, JournalDir, JournalDirSnapshot, JournalEntry};
+use crate::utils::error::{AppError, AppResult};
+
+use super::scanner::{ScanOptions, Scanner};
+
+/// 修改时间距扫描开始不足此时长的目录不写入日志
+///
+/// 文件系统时间戳精度有限，同一时钟周期内读取目录之后的修改不会改变其修改时间，
+/// 这类目录下次扫描时必须重新读取。
+const RACY_WINDOW: Duration = Duration::from_secs(2);
+
+/// 增量扫描结果
+#[derive(Debug, Clone, Default)]
+pub struct JournalScanResult {
+    /// 需要处理的文件（新增或戳记变化）
+    pub candidates: Vec<JournalEntry>,
+    /// 内容有变化的目录，索引完成后回写日志
+    pub changed_dirs: Vec<JournalDirSnapshot>,
+    /// 访问的目录数
+    pub dirs_scanned: usize,
+    /// 修改时间未变化、未读取内容的目录数
+    pub dirs_unchanged: usize,
+    /// 未变化的文件数
+    pub files_unchanged: usize,
+}
+
+impl JournalScanResult {
+    /// 合并另一次扫描的结果
+    pub fn merge(&mut self, other: JournalScanResult) {
+        self.candidates.extend(other.candidates);
+        self.changed_dirs.extend(other.changed_dirs);
+        self.dirs_scanned += other.dirs_scanned;
+        self.dirs_unchanged += other.dirs_unchanged;
+        self.files_unchanged += other.files_unchanged;
+    }
+}
+
+/// 增量扫描器
+pub struct JournalScanner<'a> {
+    scanner: Scanner,
+    db: &'a Database,
+}
+
+impl<'a> JournalScanner<'a> {
+    /// 创建新的增量扫描器
+    pub fn new(options: ScanOptions, db: &'a Database) -> Self {
+        Self {
+            scanner: Scanner::new(options),
+            db,
+        }
+    }
+
+    /// 增量扫描单个目录
+    pub fn scan_directory(&self, path: &Path) -> AppResult<JournalScanResult> {
+        if !path.exists() {
+            return Err(AppError::InvalidPath(format!(
+                "目录不存在: {}",
+                path.display()
+            )));
+        }
+
+        if !path.is_dir() {
+            return Err(AppError::InvalidPath(format!(
+                "路径不是目录: {}",
+                path.display()
+            )));
+        }
+
+        let scan_started = SystemTime::now();
+        let depth_limit = self.scanner.depth_limit();
+        let mut result = JournalScanResult::default();
+        let mut stack = vec![(path.to_path_buf(), 0usize)];
+
+        while let Some((dir, depth)) = stack.pop() {
+            let can_descend = depth + 1 < depth_limit;
+            let mut subdirs = Vec::new();
+
+            if let Err(e) = self.scan_one(&dir, scan_started, &mut subdirs, &mut result) {
+                tracing::warn!("扫描错误 {}: {}", dir.display(), e);
+                continue;
+            }
+
+            if can_descend {
+                stack.extend(
+                    subdirs
+                        .into_iter()
+                        .filter(|sub| {
+                            sub.file_name()
+                                .map(|name| self.scanner.should_descend(&name.to_string_lossy()))
+                                .unwrap_or(false)
+                        })
+                        .map(|sub| (sub, depth + 1)),
+                );
+            }
+        }
+
+        tracing::info!(
+            "增量扫描完成: {} 个目录（{} 个未变化）, {} 个文件未变化, {} 个待处理",
+            result.dirs_scanned,
+            result.dirs_unchanged,
+            result.files_unchanged,
+            result.candidates.len()
+        );
+
+        Ok(result)
+    }
+
+    /// 增量扫描多个目录
+    pub fn scan_directories(&self, paths: &[PathBuf]) -> AppResult<JournalScanResult> {
+        let mut combined = JournalScanResult::default();
+
+        for path in paths {
+            match self.scan_directory(path) {
+                Ok(result) => combined.merge(result),
+                Err(e) => tracing::error!("扫描目录失败: {}", e),
+            }
+        }
+
+        Ok(combined)
+    }
+
+    /// 扫描一个目录（不递归），子目录路径写入 `subdirs`
+    fn scan_one(
+        &self,
+        dir: &Path,
+        scan_started: SystemTime,
+        subdirs: &mut Vec<PathBuf>,
+        result: &mut JournalScanResult,
+    ) -> AppResult<()> {
+        // 先取目录修改时间再读取内容，读取期间的改动会体现为更新的修改时间
+        let mut mtime_ns = FileStamp::from_metadata(&fs::metadata(dir)?).mtime_ns;
+        let dir_path = dir.to_string_lossy().to_string();
+        result.dirs_scanned += 1;
+
+        if let Some(journal) = self.db.get_journal_dir(&dir_path)? {
+            if journal.mtime_ns != 0 && journal.mtime_ns == mtime_ns {
+                result.dirs_unchanged += 1;
+                result.files_unchanged += journal.file_count.max(0) as usize;
+                subdirs.extend(self.db.get_journal_subdirs(&dir_path)?.into_iter().map(PathBuf::from));
+                return Ok(());
+            }
+        }
+
+        let racy_after = scan_started
+            .checked_sub(RACY_WINDOW)
+            .and_then(|t| t.duration_since(UNIX_EPOCH).ok())
+            .map(|d| d.as_nanos() as i64)
+            .unwrap_or(0);
+        if mtime_ns >= racy_after {
+            mtime_ns = 0;
+        }
+
+        let mut previous = self.db.get_journal_entries(&dir_path)?;
+        let mut snapshot = JournalDirSnapshot {
+            dir: JournalDir {
+                dir_path: dir_path.clone(),
+                mtime_ns,
+                file_count: 0,
+            },
+            subdirs: Vec::new(),
+            removed: Vec::new(),
+        };
+
+        for entry in fs::read_dir(dir)? {
+            // 目录读取不完整时不能信任其修改时间
+            let (entry, file_type) = match entry.and_then(|e| e.file_type().map(|t| (e, t))) {
+                Ok(pair) => pair,
+                Err(e) => {
+                    tracing::warn!("扫描错误 {}: {}", dir.display(), e);
+                    snapshot.dir.mtime_ns = 0;
+                    continue;
+                }
+            };
+
+            let path = entry.path();
+            let is_dir = file_type.is_dir();
+            if !is_dir && !self.scanner.is_supported_image(&path) {
+                continue;
+            }
+
+            // 跟随符号链接，与索引器读取文件的方式一致
+            let stamp = match fs::metadata(&path) {
+                Ok(metadata) => FileStamp::from_metadata(&metadata),
+                Err(e) => {
+                    tracing::warn!("扫描错误 {}: {}", path.display(), e);
+                    snapshot.dir.mtime_ns = 0;
+                    continue;
+                }
+            };
+
+            let journal_entry = JournalEntry {
+                file_path: path.to_string_lossy().to_string(),
+                dir_path: dir_path.clone(),
+                is_dir,
+                stamp,
+            };
+
+            let previous_entry = previous.remove(&journal_entry.file_path);
+            if let Some(prev) = &previous_entry {
+                if prev.is_dir != is_dir {
+                    snapshot.removed.push(prev.clone());
+                }
+            }
+
+            if is_dir {
+                subdirs.push(path);
+                snapshot.subdirs.push(journal_entry);
+            } else {
+                snapshot.dir.file_count += 1;
+                match previous_entry {
+                    Some(prev) if !prev.is_dir && prev.stamp == stamp => result.files_unchanged += 1,
+                    _ => result.candidates.push(journal_entry),
+                }
+            }
+        }
+
+        snapshot.removed.extend(previous.into_values());
+        result.changed_dirs.push(snapshot);
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    fn setup_db() -> Database {
+        let db = Database::open_in_memory().unwrap();
+        db.init().unwrap();
+        db
+    }
+
+    fn recursive_options() -> ScanOptions {
+        ScanOptions::new()
+    }
+
+    /// 把目录修改时间调到一分钟前，避开 RACY_WINDOW
+    fn backdate(path: &Path) {
+        let past = SystemTime::now() - Duration::from_secs(60);
+        // Windows 上 File::open 打不开目录，经 filetime 设置
+        filetime::set_file_mtime(path, filetime::FileTime::from_system_time(past)).unwrap();
+    }
+
+    /// 模拟索引器：所有候选文件处理成功后回写日志
+    fn commit(db: &Database, result: &JournalScanResult) {
+        db.upsert_journal_entries(&result.candidates).unwrap();
+        for snapshot in &result.changed_dirs {
+            db.commit_journal_dir(snapshot, true).unwrap();
+        }
+    }
+
+    #[test]
+    fn test_unchanged_tree_reads_only_directory_metadata() {
+        let temp_dir = TempDir::new().unwrap();
+        let base = temp_dir.path();
+        let sub = base.join("2024");
+        fs::create_dir(&sub).unwrap();
+        fs::write(base.join("a.jpg"), b"a").unwrap();
+        fs::write(sub.join("b.png"), b"b").unwrap();
+        fs::write(sub.join("notes.txt"), b"text").unwrap();
+        backdate(&sub);
+        backdate(base);
+
+        let db = setup_db();
+        let scanner = JournalScanner::new(recursive_options(), &db);
+
+        let first = scanner.scan_directory(base).unwrap();
+        assert_eq!(first.candidates.len(), 2);
+        assert_eq!(first.dirs_unchanged, 0);
+        commit(&db, &first);
+
+        let second = scanner.scan_directory(base).unwrap();
+        assert!(second.candidates.is_empty());
+        assert!(second.changed_dirs.is_empty());
+        assert_eq!(second.dirs_scanned, 2);
+        assert_eq!(second.dirs_unchanged, 2);
+        assert_eq!(second.files_unchanged, 2);
+    }
+
+    #[test]
+    fn test_changed_directory_yields_only_new_files() {
+        let temp_dir = TempDir::new().unwrap();
+        let base = temp_dir.path();
+        fs::write(base.join("a.jpg"), b"a").unwrap();
+        backdate(base);
+
+        let db = setup_db();
+        let scanner = JournalScanner::new(recursive_options(), &db);
+        commit(&db, &scanner.scan_directory(base).unwrap());
+
+        fs::write(base.join("b.jpg"), b"b").unwrap();
+
+        let result = scanner.scan_directory(base).unwrap();
+        assert_eq!(result.files_unchanged, 1);
+        assert_eq!(result.candidates.len(), 1);
+        assert!(result.candidates[0].file_path.ends_with("b.jpg"));
+        // 刚修改过的目录不写入修改时间，下次仍会重新读取
+        assert_eq!(result.changed_dirs[0].dir.mtime_ns, 0);
+    }
+
+    #[test]
+    fn test_removed_subdirectory_is_pruned() {
+        let temp_dir = TempDir::new().unwrap();
+        let base = temp_dir.path();
+        let sub = base.join("old");
+        fs::create_dir(&sub).unwrap();
+        fs::write(sub.join("a.jpg"), b"a").unwrap();
+        backdate(&sub);
+        backdate(base);
+
+        let db = setup_db();
+        let scanner = JournalScanner::new(recursive_options(), &db);
+        commit(&db, &scanner.scan_directory(base).unwrap());
+
+        fs::remove_dir_all(&sub).unwrap();
+
+        let result = scanner.scan_directory(base).unwrap();
+        assert_eq!(result.changed_dirs.len(), 1);
+        assert_eq!(result.changed_dirs[0].removed.len(), 1);
+        commit(&db, &result);
+
+        let sub_path = sub.to_string_lossy().to_string();
+        assert!(db.get_journal_dir(&sub_path).unwrap().is_none());
+        assert!(db.get_journal_entries(&sub_path).unwrap().is_empty());
+    }
+}
@@ -196,23 +196,37 @@ impl Scanner {
             return true;
         }
 
-        let name = entry.file_name().to_string_lossy();
+        self.should_descend(&entry.file_name().to_string_lossy())
+    }
 
+    /// 检查是否应该进入名为 `name` 的子目录
+    pub(crate) fn should_descend(&self, name: &str) -> bool {
         // 跳过隐藏目录（以 . 开头，但不是 . 或 ..）
         if name.starts_with('.') && name != "." && name != ".." {
             return false;
         }
 
         // 跳过排除列表中的目录
-        if self.options.exclude_dirs.iter().any(|d| d == &*name) {
+        if self.options.exclude_dirs.iter().any(|d| d == name) {
             return false;
         }
 
         true
     }
 
+    /// 目录遍历深度上限（根目录深度为 0，与 WalkDir 的 max_depth 含义一致）
+    pub(crate) fn depth_limit(&self) -> usize {
+        if !self.options.recursive {
+            1
+        } else if self.options.max_depth > 0 {
+            self.options.max_depth
+        } else {
+            usize::MAX
+        }
+    }
+
     /// 检查文件是否是支持的图片格式
-    fn is_supported_image(&self, path: &Path) -> bool {
+    pub(crate) fn is_supported_image(&self, path: &Path) -> bool {
         path.extension()
             .and_then(|ext| ext.to_str())
             .map(|ext| {
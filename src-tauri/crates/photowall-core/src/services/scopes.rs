@@ -0,0 +1,227 @@
+//! 示波器
+//!
+//! 在编辑预览的输出遍历中顺带统计亮度波形、RGB 分量（parade）和矢量示波器。
+//! 每个工作线程累加到自己的部分计数（[`ScopeAccumulator`]），遍历结束后合并，避免原子操作；
+//! 部分计数跨帧复用，不随分块数量分配和清零。
+//! 所有计数都是固定尺寸的 `u32` 二维数组，与图像分辨率无关，便于直接交给显示层。
+//! 大图按固定步长抽样，样本数约 [`SCOPE_SAMPLES`]，远多于计数格数，形状与逐像素统计无异。
+
+use std::sync::Mutex;
+
+/// 波形和分量图的列数（图像横向均分）
+pub const SCOPE_COLUMNS: usize = 256;
+/// 波形和分量图的纵向级数
+pub const SCOPE_LEVELS: usize = 128;
+/// 矢量示波器的边长
+pub const VECTORSCOPE_SIZE: usize = 128;
+
+/// 每帧目标样本数
+pub const SCOPE_SAMPLES: u64 = 1 << 18;
+
+const WAVEFORM_LEN: usize = SCOPE_COLUMNS * SCOPE_LEVELS;
+
+/// 一帧的示波器计数
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Scopes {
+    /// 亮度波形：`SCOPE_LEVELS` 行 × `SCOPE_COLUMNS` 列，第 0 行为亮度 0
+    pub waveform: Vec<u32>,
+    /// RGB 分量：依次为 R、G、B 三块，每块布局与波形相同
+    pub parade: Vec<u32>,
+    /// 矢量示波器：`VECTORSCOPE_SIZE` 行 × `VECTORSCOPE_SIZE` 列，
+    /// 列为 Cb、行为 Cr，中心为无彩色
+    pub vectorscope: Vec<u32>,
+}
+
+impl Default for Scopes {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Scopes {
+    pub fn new() -> Self {
+        Self {
+            waveform: vec![0; WAVEFORM_LEN],
+            parade: vec![0; WAVEFORM_LEN * 3],
+            vectorscope: vec![0; VECTORSCOPE_SIZE * VECTORSCOPE_SIZE],
+        }
+    }
+
+    /// 清零，保留已分配的内存
+    pub fn clear(&mut self) {
+        self.waveform.fill(0);
+        self.parade.fill(0);
+        self.vectorscope.fill(0);
+    }
+
+    /// 累加另一份部分计数
+    pub fn merge(&mut self, other: &Scopes) {
+        let add = |dst: &mut [u32], src: &[u32]| dst.iter_mut().zip(src).for_each(|(d, s)| *d += s);
+        add(&mut self.waveform, &other.waveform);
+        add(&mut self.parade, &other.parade);
+        add(&mut self.vectorscope, &other.vectorscope);
+    }
+
+    /// 像素所在的列
+    #[inline]
+    pub(crate) fn column(x: u32, width: u32) -> usize {
+        x as usize * SCOPE_COLUMNS / width.max(1) as usize
+    }
+
+    /// 抽样步长：横纵都每隔 `step` 个像素取一个样本
+    pub(crate) fn sample_step(width: u32, height: u32) -> u32 {
+        let pixels = width as u64 * height as u64;
+        ((pixels as f64 / SCOPE_SAMPLES as f64).sqrt() as u32).max(1)
+    }
+
+    /// 统计一个像素（0..1 sRGB）；亮度和色差按 BT.709 从伽马编码值计算，与视频示波器一致
+    #[inline]
+    pub(crate) fn add(&mut self, [r, g, b]: [f32; 3], column: usize) {
+        let level = |v: f32| (v.clamp(0.0, 1.0) * (SCOPE_LEVELS - 1) as f32 + 0.5) as usize;
+        let luma = 0.2126 * r + 0.7152 * g + 0.0722 * b;
+        self.waveform[level(luma) * SCOPE_COLUMNS + column] += 1;
+        for (channel, v) in [r, g, b].into_iter().enumerate() {
+            self.parade[channel * WAVEFORM_LEN + level(v) * SCOPE_COLUMNS + column] += 1;
+        }
+
+        let cb = (b - luma) / 1.8556;
+        let cr = (r - luma) / 1.5748;
+        let cell = |v: f32| ((v + 0.5).clamp(0.0, 1.0) * (VECTORSCOPE_SIZE - 1) as f32 + 0.5) as usize;
+        self.vectorscope[cell(cr) * VECTORSCOPE_SIZE + cell(cb)] += 1;
+    }
+}
+
+/// 示波器累加器：合并结果加上每个 rayon 工作线程一份部分计数
+///
+/// 同一线程上的分块依次执行，按线程编号取部分计数几乎不会争用锁；
+/// 由调用方跨帧持有，内存只在首次使用或线程数变化时分配。
+#[derive(Debug, Default)]
+pub struct ScopeAccumulator {
+    scopes: Scopes,
+    partials: Vec<Mutex<Partial>>,
+}
+
+#[derive(Debug, Default)]
+struct Partial {
+    /// 本帧是否已清零并累加过
+    used: bool,
+    counts: Scopes,
+}
+
+impl ScopeAccumulator {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// 最近一次合并的结果
+    pub fn scopes(&self) -> &Scopes {
+        &self.scopes
+    }
+
+    /// 开始一帧：按当前线程池大小准备部分计数，另留一份给池外线程
+    pub(crate) fn begin(&mut self) {
+        let slots = rayon::current_num_threads() + 1;
+        if self.partials.len() != slots {
+            self.partials.resize_with(slots, Default::default);
+        }
+        for partial in &mut self.partials {
+            partial.get_mut().unwrap_or_else(|e| e.into_inner()).used = false;
+        }
+    }
+
+    /// 在当前线程的部分计数上累加；本帧首次取用时清零
+    pub(crate) fn with_partial<R>(&self, f: impl FnOnce(&mut Scopes) -> R) -> R {
+        let last = self.partials.len() - 1;
+        let slot = rayon::current_thread_index().filter(|&i| i < last).unwrap_or(last);
+        let mut partial = self.partials[slot].lock().unwrap_or_else(|e| e.into_inner());
+        if !partial.used {
+            partial.used = true;
+            partial.counts.clear();
+        }
+        f(&mut partial.counts)
+    }
+
+    /// 结束一帧：合并本帧用到的部分计数
+    pub(crate) fn finish(&mut self) {
+        self.scopes.clear();
+        for partial in &mut self.partials {
+            let partial = partial.get_mut().unwrap_or_else(|e| e.into_inner());
+            if partial.used {
+                self.scopes.merge(&partial.counts);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_pixel_placement() {
+        let mut scopes = Scopes::new();
+        scopes.add([1.0, 1.0, 1.0], 0);
+        scopes.add([0.0, 0.0, 0.0], SCOPE_COLUMNS - 1);
+
+        let top = (SCOPE_LEVELS - 1) * SCOPE_COLUMNS;
+        assert_eq!(scopes.waveform[top], 1);
+        assert_eq!(scopes.waveform[SCOPE_COLUMNS - 1], 1);
+        for channel in 0..3 {
+            assert_eq!(scopes.parade[channel * WAVEFORM_LEN + top], 1);
+        }
+        // 无彩色落在中心
+        let center = VECTORSCOPE_SIZE / 2;
+        assert_eq!(scopes.vectorscope[center * VECTORSCOPE_SIZE + center], 2);
+
+        // 纯红：Cr 最大，Cb 为负
+        let mut red = Scopes::new();
+        red.add([1.0, 0.0, 0.0], 10);
+        let cell = red.vectorscope.iter().position(|&c| c == 1).unwrap();
+        let (row, col) = (cell / VECTORSCOPE_SIZE, cell % VECTORSCOPE_SIZE);
+        assert_eq!(row, VECTORSCOPE_SIZE - 1);
+        assert!(col < center);
+        assert_eq!(red.parade[10 + top], 1);
+        assert_eq!(red.parade[WAVEFORM_LEN + 10], 1);
+    }
+
+    #[test]
+    fn test_sample_step() {
+        assert_eq!(Scopes::sample_step(400, 267), 1);
+        assert_eq!(Scopes::sample_step(1600, 1067), 2);
+        assert_eq!(Scopes::sample_step(6000, 4000), 9);
+        assert_eq!(Scopes::sample_step(0, 0), 1);
+    }
+
+    #[test]
+    fn test_merge_and_clear() {
+        let mut a = Scopes::new();
+        let mut b = Scopes::new();
+        a.add([0.5, 0.2, 0.9], Scopes::column(3, 10));
+        b.add([0.5, 0.2, 0.9], Scopes::column(3, 10));
+        b.add([0.1, 0.1, 0.1], Scopes::column(9, 10));
+        a.merge(&b);
+        assert_eq!(a.waveform.iter().sum::<u32>(), 3);
+        assert_eq!(a.parade.iter().sum::<u32>(), 9);
+        assert_eq!(a.vectorscope.iter().sum::<u32>(), 3);
+        assert_eq!(*a.waveform.iter().max().unwrap(), 2);
+
+        a.clear();
+        assert_eq!(a, Scopes::new());
+    }
+
+    #[test]
+    fn test_accumulator_reuses_partials() {
+        let mut acc = ScopeAccumulator::new();
+        acc.begin();
+        acc.with_partial(|p| p.add([0.5, 0.5, 0.5], 0));
+        acc.with_partial(|p| p.add([0.2, 0.2, 0.2], 1));
+        acc.finish();
+        assert_eq!(acc.scopes().waveform.iter().sum::<u32>(), 2);
+
+        // 下一帧只计本帧的样本
+        acc.begin();
+        acc.with_partial(|p| p.add([0.5, 0.5, 0.5], 0));
+        acc.finish();
+        assert_eq!(acc.scopes().waveform.iter().sum::<u32>(), 1);
+    }
+}
@@ -5,13 +5,33 @@
 use std::collections::HashSet;
 use std::fs;
 use std::path::{Path, PathBuf};
-use std::sync::{Arc, Mutex, Condvar};
+use std::sync::{Arc, Mutex, Condvar, RwLock};
 use image::{DynamicImage, ImageFormat, imageops::FilterType, Rgb, RgbImage};
+use crate::metrics;
 use crate::utils::error::{AppError, AppResult};
 use crate::utils::sanitize_file_hash;
+use crate::utils::color_signature::{rgba_to_color_signature, ColorSignature};
+use crate::utils::image_quality::{
+    rgba_to_quality_scores, QualityScores, QUALITY_MIN_DIMENSION, QUALITY_PROXY_DIMENSION,
+};
+use crate::utils::perceptual_hash::{luma_to_perceptual_hash, PerceptualHash};
+use crate::utils::thumbhash::{rgba_to_thumbhash, THUMBHASH_MAX_DIMENSION};
+use super::thumbnail_pack::{PackedThumbnail, ThumbnailPackStore};
 
 // 引入 WIC 服务
 use super::wic::WicProcessor;
+#[cfg(target_os = "windows")]
+use super::native_editor::NativeEditor;
+
+/// libvips 缩略图的 WebP 质量
+const NATIVE_WEBP_QUALITY: i32 = 82;
+
+/// 计算 ThumbHash、感知哈希、质量评分和颜色签名的缩略图尺寸
+///
+/// 每张照片只在生成这一档时计算一次，其他尺寸不重复计算；
+/// 数据库按首次写入保存，也不会混入不同尺寸算出的值。
+/// 质量评分因此总是出自同一档缩略图，连拍筛选比较的是同一来源的分数。
+const HASH_SOURCE_SIZE: ThumbnailSize = ThumbnailSize::Small;
 
 /// 缩略图尺寸
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -48,6 +68,16 @@ impl ThumbnailSize {
         }
     }
 
+    /// 尺寸序号（用于按尺寸分槽的索引）
+    pub(crate) fn slot(&self) -> usize {
+        match self {
+            ThumbnailSize::Tiny => 0,
+            ThumbnailSize::Small => 1,
+            ThumbnailSize::Medium => 2,
+            ThumbnailSize::Large => 3,
+        }
+    }
+
     /// 从字符串解析
     pub fn from_str(s: &str) -> Option<Self> {
         match s.to_lowercase().as_str() {
@@ -67,8 +97,10 @@ pub const SMALL_IMAGE_PIXEL_THRESHOLD: u64 = 2_000_000;
 /// 缩略图生成结果
 #[derive(Debug, Clone)]
 pub struct ThumbnailResult {
-    /// 缩略图路径（占位图时为空）
+    /// 缩略图路径（占位图或存放在打包存储时为空）
     pub path: PathBuf,
+    /// 缩略图存放在打包存储中，通过 [`ThumbnailService::get_packed`] 读取
+    pub packed: bool,
     /// 是否命中缓存
     pub hit_cache: bool,
     /// 生成耗时（毫秒）
@@ -79,6 +111,23 @@ pub struct ThumbnailResult {
     pub placeholder_bytes: Option<Vec<u8>>,
     /// 是否直接使用原图（小图跳过缩略图生成）
     pub use_original: bool,
+    /// 本次生成时计算的 ThumbHash（命中缓存或非 Small 尺寸时为 None）
+    pub thumbhash: Option<Vec<u8>>,
+    /// 本次生成时计算的感知哈希（命中缓存或非 Small 尺寸时为 None）
+    pub perceptual_hash: Option<PerceptualHash>,
+    /// 本次生成时计算的质量评分（命中缓存或非 Small 尺寸时为 None）
+    pub quality: Option<QualityScores>,
+    /// 本次生成时计算的颜色签名（命中缓存或非 Small 尺寸时为 None）
+    pub color_signature: Option<ColorSignature>,
+}
+
+/// 生成缩略图时顺带计算的哈希、质量评分和颜色签名
+#[derive(Debug, Clone, Default)]
+struct ThumbnailHashes {
+    thumbhash: Option<Vec<u8>>,
+    perceptual_hash: Option<PerceptualHash>,
+    quality: Option<QualityScores>,
+    color_signature: Option<ColorSignature>,
 }
 
 /// 正在生成中的缩略图追踪（用于去重）
@@ -87,6 +136,12 @@ struct InFlightTracker {
     in_flight: HashSet<String>,
 }
 
+/// 单文件缓存的内存索引（按尺寸分槽，首次查询时扫描目录加载）
+#[derive(Default)]
+struct CachedIndex {
+    sizes: Option<[HashSet<String>; 4]>,
+}
+
 /// 缩略图服务
 #[derive(Clone)]
 pub struct ThumbnailService {
@@ -94,6 +149,10 @@ pub struct ThumbnailService {
     cache_dir: PathBuf,
     /// 正在生成中的缩略图追踪（全局去重）
     in_flight: Arc<(Mutex<InFlightTracker>, Condvar)>,
+    /// 打包缩略图存储（打开失败时为 None，仅使用单文件缓存）
+    pack: Option<Arc<ThumbnailPackStore>>,
+    /// 单文件缓存索引
+    cached: Arc<RwLock<CachedIndex>>,
 }
 
 /// CFA 信息结构（用于 Bayer 去马赛克）
@@ -119,8 +178,17 @@ impl ThumbnailService {
     pub fn new(cache_dir: PathBuf) -> AppResult<Self> {
         // 确保缓存目录存在
         Self::ensure_cache_dirs(&cache_dir)?;
+        let pack = match ThumbnailPackStore::open(&cache_dir.join("packs")) {
+            Ok(store) => Some(Arc::new(store)),
+            Err(e) => {
+                tracing::warn!("打开缩略图 pack 存储失败，仅使用单文件缓存: {}", e);
+                None
+            }
+        };
         Ok(Self {
             cache_dir,
+            pack,
+            cached: Arc::new(RwLock::new(CachedIndex::default())),
             in_flight: Arc::new((
                 Mutex::new(InFlightTracker {
                     in_flight: HashSet::new(),
@@ -164,9 +232,282 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
         .join(format!("{}.webp", file_hash))
 }
 
-    /// 检查缩略图是否存在于缓存中
+    /// 获取打包缩略图存储
+    pub fn pack_store(&self) -> Option<&Arc<ThumbnailPackStore>> {
+        self.pack.as_ref()
+    }
+
+    /// 从打包存储读取缩略图
+    ///
+    /// 未命中但单文件缓存中存在时，导入 pack 并删除单文件后返回（旧缓存的一次性迁移）。
+    pub fn get_packed(&self, file_hash: &str, size: ThumbnailSize) -> Option<PackedThumbnail> {
+        let pack = self.pack.as_ref()?;
+        if let Some(thumb) = pack.get(file_hash, size) {
+            metrics::global().incr("thumbnail.pack.hit", 1);
+            return Some(thumb);
+        }
+        metrics::global().incr("thumbnail.pack.miss", 1);
+
+        let cache_path = self.get_cache_path(file_hash, size);
+        let bytes = fs::read(&cache_path).ok()?;
+        if !self.insert_packed(&bytes, file_hash, size, &cache_path) {
+            return None;
+        }
+        pack.get(file_hash, size)
+    }
+
+    /// 编码为 WebP 并存入打包存储；打包存储不可用时原子写入单文件缓存
+    ///
+    /// 返回单文件缓存路径，存入打包存储时为 None
+    fn write_thumbnail(
+        &self,
+        img: &DynamicImage,
+        file_hash: &str,
+        size: ThumbnailSize,
+        tmp_path: &Path,
+        cache_path: &Path,
+    ) -> AppResult<(Option<PathBuf>, ThumbnailHashes)> {
+        let mut bytes = Vec::new();
+        img.write_to(&mut std::io::Cursor::new(&mut bytes), ImageFormat::WebP)?;
+
+        let path = if self.insert_packed(&bytes, file_hash, size, cache_path) {
+            None
+        } else {
+            // 确保父目录存在
+            if let Some(parent) = cache_path.parent() {
+                fs::create_dir_all(parent)?;
+            }
+            // 先写入临时文件，再原子重命名到最终路径
+            fs::write(tmp_path, &bytes)?;
+            self.commit_file(file_hash, size, tmp_path, cache_path)?;
+            Some(cache_path.to_path_buf())
+        };
+        Ok((path, Self::compute_hashes(img, size)))
+    }
+
+    /// 写入打包存储；成功时删除同名的旧单文件缓存，同一缩略图不存两份
+    fn insert_packed(&self, bytes: &[u8], file_hash: &str, size: ThumbnailSize, cache_path: &Path) -> bool {
+        let Some(pack) = &self.pack else {
+            return false;
+        };
+        if let Err(e) = pack.insert(file_hash, size, bytes) {
+            tracing::warn!("写入缩略图 pack 失败，改用单文件缓存: {}", e);
+            return false;
+        }
+        if fs::remove_file(cache_path).is_ok() {
+            if let Ok(mut index) = self.cached.write() {
+                if let Some(sizes) = index.sizes.as_mut() {
+                    sizes[size.slot()].remove(&sanitize_file_hash(file_hash));
+                }
+            }
+        }
+        true
+    }
+
+    /// 将已写好的临时文件重命名到缓存路径，并登记到缓存索引
+    fn commit_file(&self, file_hash: &str, size: ThumbnailSize, tmp_path: &Path, cache_path: &Path) -> AppResult<()> {
+        fs::rename(tmp_path, cache_path)?;
+        if let Ok(mut index) = self.cached.write() {
+            if let Some(sizes) = index.sizes.as_mut() {
+                sizes[size.slot()].insert(sanitize_file_hash(file_hash));
+            }
+        }
+        Ok(())
+    }
+
+    /// 已缓存时返回命中结果，打包存储优先
+    fn cache_hit(&self, file_hash: &str, size: ThumbnailSize, cache_path: &Path) -> Option<ThumbnailResult> {
+        let packed = self.pack.as_ref().map_or(false, |p| p.contains(file_hash, size));
+        if !packed && !cache_path.exists() {
+            return None;
+        }
+        Some(ThumbnailResult {
+            path: if packed { PathBuf::new() } else { cache_path.to_path_buf() },
+            packed,
+            hit_cache: true,
+            generation_time_ms: None,
+            is_placeholder: false,
+            placeholder_bytes: None,
+            use_original: false,
+            thumbhash: None,
+            perceptual_hash: None,
+            quality: None,
+            color_signature: None,
+        })
+    }
+
+    /// 使用 libvips 生成缩略图
+    ///
+    /// 解码时即缩小、校正方向并转换到 sRGB，直接编码为 WebP 写入临时文件。
+    /// ThumbHash / 感知哈希 / 质量评分由 libvips 同时返回的编码前像素计算，
+    /// 与 WIC / image crate 路径一样基于无损像素，分数可以相互比较。
+    #[cfg(target_os = "windows")]
+    fn generate_native(
+        &self,
+        source_path: &Path,
+        file_hash: &str,
+        size: ThumbnailSize,
+        tmp_path: &Path,
+        cache_path: &Path,
+    ) -> AppResult<(Option<PathBuf>, ThumbnailHashes)> {
+        let editor = NativeEditor::load()?;
+        if !editor.supports_thumbnail() {
+            return Err(AppError::General("pw_thumbnail not available".to_string()));
+        }
+
+        if let Some(parent) = cache_path.parent() {
+            fs::create_dir_all(parent)?;
+        }
+        let result = (|| -> AppResult<(Option<PathBuf>, ThumbnailHashes)> {
+            let (width, height, pixels) =
+                editor.thumbnail(source_path, tmp_path, size.dimensions(), NATIVE_WEBP_QUALITY)?;
+            let img = image::RgbaImage::from_raw(width, height, pixels)
+                .map(DynamicImage::ImageRgba8)
+                .ok_or_else(|| AppError::General("pw_thumbnail 像素缓冲区尺寸不符".to_string()))?;
+            let bytes = fs::read(tmp_path)?;
+            let path = if self.insert_packed(&bytes, file_hash, size, cache_path) {
+                let _ = fs::remove_file(tmp_path);
+                None
+            } else {
+                self.commit_file(file_hash, size, tmp_path, cache_path)?;
+                Some(cache_path.to_path_buf())
+            };
+            Ok((path, Self::compute_hashes(&img, size)))
+        })();
+
+        if result.is_err() {
+            let _ = fs::remove_file(tmp_path);
+        }
+        result
+    }
+
+    /// 计算 ThumbHash 占位图、感知哈希和颜色签名（共用同一张 100px 以内的小图）
+    ///
+    /// 质量评分也在这里计算。只有 [`HASH_SOURCE_SIZE`] 计算，其他尺寸全部返回 None。
+    fn compute_hashes(img: &DynamicImage, size: ThumbnailSize) -> ThumbnailHashes {
+        if size != HASH_SOURCE_SIZE {
+            return ThumbnailHashes::default();
+        }
+        let small = if img.width() > THUMBHASH_MAX_DIMENSION || img.height() > THUMBHASH_MAX_DIMENSION {
+            img.thumbnail(THUMBHASH_MAX_DIMENSION, THUMBHASH_MAX_DIMENSION)
+        } else {
+            img.clone()
+        };
+        let rgba = small.to_rgba8();
+        let thumbhash = rgba_to_thumbhash(rgba.width() as usize, rgba.height() as usize, rgba.as_raw());
+
+        // Rec.601 灰度，直接由已有的 RGBA 像素计算
+        let luma: Vec<u8> = rgba
+            .pixels()
+            .map(|p| ((p[0] as u32 * 299 + p[1] as u32 * 587 + p[2] as u32 * 114) / 1000) as u8)
+            .collect();
+        let perceptual_hash = luma_to_perceptual_hash(rgba.width() as usize, rgba.height() as usize, &luma);
+        let color_signature = rgba_to_color_signature(rgba.width() as usize, rgba.height() as usize, rgba.as_raw());
+
+        ThumbnailHashes {
+            thumbhash,
+            perceptual_hash,
+            quality: Self::compute_quality(img),
+            color_signature,
+        }
+    }
+
+    /// 计算质量评分
+    ///
+    /// 输入是 [`HASH_SOURCE_SIZE`] 的缩略图（WIC 缩放 / 内嵌预览 / 缩放后的图像），
+    /// 这里再统一重采样到最长边 QUALITY_PROXY_DIMENSION（较小的图放大），
+    /// 使不同照片在同一像素尺度上评分，分数可以相互比较。
+    fn compute_quality(img: &DynamicImage) -> Option<QualityScores> {
+        let longest = img.width().max(img.height());
+        if longest < QUALITY_MIN_DIMENSION {
+            return None;
+        }
+        let proxy = if longest == QUALITY_PROXY_DIMENSION {
+            img.to_rgba8()
+        } else {
+            img.resize(QUALITY_PROXY_DIMENSION, QUALITY_PROXY_DIMENSION, FilterType::Triangle)
+                .to_rgba8()
+        };
+        rgba_to_quality_scores(proxy.width() as usize, proxy.height() as usize, proxy.as_raw())
+    }
+
+    /// 扫描缓存目录构建单文件缓存索引
+    fn load_cached_index(&self) -> [HashSet<String>; 4] {
+        let mut sizes: [HashSet<String>; 4] = Default::default();
+        for size in [ThumbnailSize::Tiny, ThumbnailSize::Small, ThumbnailSize::Medium, ThumbnailSize::Large] {
+            let Ok(entries) = fs::read_dir(self.cache_dir.join(size.name())) else {
+                continue;
+            };
+            let set = &mut sizes[size.slot()];
+            for entry in entries.flatten() {
+                let name = entry.file_name();
+                if let Some(hash) = name.to_str().and_then(|n| n.strip_suffix(".webp")) {
+                    set.insert(hash.to_string());
+                }
+            }
+        }
+        sizes
+    }
+
+    /// 批量检查缩略图是否已缓存（单文件缓存或打包存储）
+    ///
+    /// 只查询内存索引；索引在首次调用时扫描一次缓存目录，
+    /// 之后随生成和删除同步更新。
+    pub fn cached_flags<S: AsRef<str>>(&self, file_hashes: &[S], size: ThumbnailSize) -> Vec<bool> {
+        let needs_load = self.cached.read().map(|i| i.sizes.is_none()).unwrap_or(false);
+        if needs_load {
+            // 扫描期间持有写锁：并发的生成和删除会等待扫描完成后再更新索引，
+            // 不会因索引尚未加载而被跳过，随后又被扫描前的旧结果覆盖
+            if let Ok(mut index) = self.cached.write() {
+                if index.sizes.is_none() {
+                    index.sizes = Some(self.load_cached_index());
+                }
+            }
+        }
+
+        let index = match self.cached.read() {
+            Ok(index) => index,
+            Err(_) => return vec![false; file_hashes.len()],
+        };
+        let files = index.sizes.as_ref().map(|sizes| &sizes[size.slot()]);
+
+        file_hashes
+            .iter()
+            .map(|hash| {
+                let hash = hash.as_ref();
+                self.pack.as_ref().map_or(false, |p| p.contains(hash, size))
+                    || files.map_or(false, |set| set.contains(&sanitize_file_hash(hash)))
+            })
+            .collect()
+    }
+
+    /// 检查缩略图是否存在于缓存中（打包存储或单文件缓存）
     pub fn is_cached(&self, file_hash: &str, size: ThumbnailSize) -> bool {
-        self.get_cache_path(file_hash, size).exists()
+        self.pack.as_ref().map_or(false, |p| p.contains(file_hash, size))
+            || self.get_cache_path(file_hash, size).exists()
+    }
+
+    /// 获取缩略图文件路径，供只能按路径读取的调用方使用
+    ///
+    /// 只在打包存储中时导出为单文件缓存；导出的文件只是副本，过期后由清理删除。
+    pub fn thumbnail_path(&self, file_hash: &str, size: ThumbnailSize) -> Option<PathBuf> {
+        let cache_path = self.get_cache_path(file_hash, size);
+        if cache_path.exists() {
+            return Some(cache_path);
+        }
+        let thumb = self.pack.as_ref()?.get(file_hash, size)?;
+        let tmp_path = cache_path.with_extension("webp.tmp");
+        let exported = fs::write(&tmp_path, thumb.as_bytes())
+            .map_err(AppError::from)
+            .and_then(|_| self.commit_file(file_hash, size, &tmp_path, &cache_path));
+        match exported {
+            Ok(()) => Some(cache_path),
+            Err(e) => {
+                tracing::warn!("导出缩略图文件失败: {}", e);
+                let _ = fs::remove_file(&tmp_path);
+                None
+            }
+        }
     }
 
     /// 生成或获取缩略图
@@ -193,11 +534,16 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
                 );
                 return Ok(ThumbnailResult {
                     path: source_path.to_path_buf(),
+                    packed: false,
                     hit_cache: false,
                     generation_time_ms: None,
                     is_placeholder: false,
                     placeholder_bytes: None,
                     use_original: true,
+                    thumbhash: None,
+                    perceptual_hash: None,
+                    quality: None,
+                    color_signature: None,
                 });
             }
         }
@@ -205,16 +551,9 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
         let cache_path = self.get_cache_path(file_hash, size);
 
         // 检查缓存
-        if cache_path.exists() {
-            tracing::debug!("缩略图缓存命中: {:?}", cache_path);
-            return Ok(ThumbnailResult {
-                path: cache_path,
-                hit_cache: true,
-                generation_time_ms: None,
-                is_placeholder: false,
-                placeholder_bytes: None,
-                use_original: false,
-            });
+        if let Some(hit) = self.cache_hit(file_hash, size, &cache_path) {
+            tracing::debug!("缩略图缓存命中: {} ({})", file_hash, size.name());
+            return Ok(hit);
         }
 
         let key = Self::cache_key(file_hash, size);
@@ -227,15 +566,8 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
                 // 等待其他线程完成生成
                 tracker = cvar.wait(tracker).unwrap();
                 // 再次检查缓存（可能已被其他线程生成）
-                if cache_path.exists() {
-                    return Ok(ThumbnailResult {
-                        path: cache_path,
-                        hit_cache: true,
-                        generation_time_ms: None,
-                        is_placeholder: false,
-                        placeholder_bytes: None,
-                        use_original: false,
-                    });
+                if let Some(hit) = self.cache_hit(file_hash, size, &cache_path) {
+                    return Ok(hit);
                 }
             }
             // 标记为正在生成
@@ -244,7 +576,7 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
 
         // 生成缩略图（在锁外执行，避免阻塞其他任务）
         let start = std::time::Instant::now();
-        let result = self.generate(source_path, file_hash, size);
+        let result = self.generate_with_hashes(source_path, file_hash, size);
 
         // 生成完成，移除标记并通知等待的线程
         {
@@ -257,20 +589,25 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
 
         // 处理占位图情况（RAW 提取失败）
         match result {
-            Ok(path) => {
+            Ok((path, hashes)) => {
                 tracing::info!(
-                    "生成缩略图: {:?} -> {:?} ({}ms)",
+                    "生成缩略图: {:?} -> {} ({}ms)",
                     source_path,
-                    path,
+                    path.as_deref().map_or_else(|| "pack".into(), |p| p.to_string_lossy()),
                     elapsed
                 );
                 Ok(ThumbnailResult {
-                    path,
+                    packed: path.is_none(),
+                    path: path.unwrap_or_default(),
                     hit_cache: false,
                     generation_time_ms: Some(elapsed),
                     is_placeholder: false,
                     placeholder_bytes: None,
                     use_original: false,
+                    thumbhash: hashes.thumbhash,
+                    perceptual_hash: hashes.perceptual_hash,
+                    quality: hashes.quality,
+                    color_signature: hashes.color_signature,
                 })
             }
             Err(AppError::PlaceholderGenerated(bytes)) => {
@@ -282,24 +619,44 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
                 );
                 Ok(ThumbnailResult {
                     path: PathBuf::new(),
+                    packed: false,
                     hit_cache: false,
                     generation_time_ms: Some(elapsed),
                     is_placeholder: true,
                     placeholder_bytes: Some(bytes),
                     use_original: false,
+                    thumbhash: None,
+                    perceptual_hash: None,
+                    quality: None,
+                    color_signature: None,
                 })
             }
             Err(e) => Err(e),
         }
     }
 
-    /// 生成缩略图 (优化版: 优先使用 WIC)
+    /// 生成缩略图 (优先 libvips，其次 WIC，最后 image crate)
+    ///
+    /// 返回单文件缓存路径；存入打包存储时为 None
     pub fn generate(
         &self,
         source_path: &Path,
         file_hash: &str,
         size: ThumbnailSize,
-    ) -> AppResult<PathBuf> {
+    ) -> AppResult<Option<PathBuf>> {
+        self.generate_with_hashes(source_path, file_hash, size)
+            .map(|(path, _)| path)
+    }
+
+    /// 生成缩略图，同时返回计算出的 ThumbHash 和感知哈希
+    ///
+    /// 路径为单文件缓存路径，存入打包存储时为 None
+    fn generate_with_hashes(
+        &self,
+        source_path: &Path,
+        file_hash: &str,
+        size: ThumbnailSize,
+    ) -> AppResult<(Option<PathBuf>, ThumbnailHashes)> {
         // 检查源文件是否存在
         if !source_path.exists() {
             return Err(AppError::FileNotFound(source_path.display().to_string()));
@@ -309,28 +666,37 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
         let cache_path = self.get_cache_path(file_hash, size);
         let tmp_path = cache_path.with_extension("webp.tmp");
 
+        // libvips 支持的格式（RAW 除外，RAW 走内嵌预览链路）优先使用 pw_thumbnail
+        #[cfg(target_os = "windows")]
+        if !self.is_raw(source_path) {
+            let start = std::time::Instant::now();
+            match self.generate_native(source_path, file_hash, size, &tmp_path, &cache_path) {
+                Ok(generated) => {
+                    metrics::global().record("thumbnail.native", start.elapsed());
+                    return Ok(generated);
+                }
+                Err(e) => {
+                    metrics::global().incr("thumbnail.native_fallback", 1);
+                    tracing::debug!("libvips 生成失败，回退到 WIC: {}", e);
+                }
+            }
+        }
+
         // 尝试使用 WIC 加速加载和缩放
         // 注意：WIC 需要 Windows 环境。如果在非 Windows 编译，需要条件编译，但目前需求明确是 Windows。
-        let wic_result = (|| -> AppResult<()> {
+        let wic_result = (|| -> AppResult<(Option<PathBuf>, ThumbnailHashes)> {
             let processor = WicProcessor::new()?;
             // 直接加载并缩放到目标尺寸
             let (buffer, w, h) = processor.load_and_resize(source_path, dim, dim)?;
             let img = WicProcessor::buffer_to_dynamic_image(buffer, w, h)?;
 
-            // 确保父目录存在
-            if let Some(parent) = cache_path.parent() {
-                fs::create_dir_all(parent)?;
-            }
             // 保存为 WebP
-            img.save_with_format(&tmp_path, ImageFormat::WebP)?;
-            Ok(())
+            self.write_thumbnail(&img, file_hash, size, &tmp_path, &cache_path)
         })();
 
-        if let Ok(_) = wic_result {
+        if let Ok(generated) = wic_result {
             tracing::debug!("使用 WIC 成功生成缩略图: {:?}", source_path);
-            // 原子重命名
-            fs::rename(&tmp_path, &cache_path)?;
-            return Ok(cache_path);
+            return Ok(generated);
         } else {
             if let Err(e) = &wic_result {
                 tracing::warn!("WIC 生成失败，回退到 Rust Image: {}", e);
@@ -373,7 +739,7 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
         };
 
         // 应用 EXIF 方向校正
-        let img = self.apply_orientation(source_path, img);
+        let img = apply_exif_orientation(source_path, img);
 
         // 生成缩略图（保持宽高比）
         // 使用 Triangle 滤波器替代 Lanczos3，性能更好且网格缩略图观感差异很小
@@ -383,18 +749,7 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
             img.resize(dim, dim, FilterType::Triangle)
         };
 
-        // 确保父目录存在
-        if let Some(parent) = cache_path.parent() {
-            fs::create_dir_all(parent)?;
-        }
-
-        // 先写入临时文件
-        thumbnail.save_with_format(&tmp_path, ImageFormat::WebP)?;
-
-        // 原子重命名到最终路径
-        fs::rename(&tmp_path, &cache_path)?;
-
-        Ok(cache_path)
+        self.write_thumbnail(&thumbnail, file_hash, size, &tmp_path, &cache_path)
     }
 
     /// 判断文件是否为 JPEG 格式
@@ -928,35 +1283,6 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
         image::load_from_memory(&thumb_data).ok()
     }
 
-    /// 应用 EXIF 方向校正
-    fn apply_orientation(&self, source_path: &Path, img: DynamicImage) -> DynamicImage {
-        // 尝试读取 EXIF 方向信息
-        let orientation = self.read_exif_orientation(source_path).unwrap_or(1);
-
-        match orientation {
-            1 => img, // 正常
-            2 => img.fliph(), // 水平翻转
-            3 => img.rotate180(), // 旋转 180°
-            4 => img.flipv(), // 垂直翻转
-            5 => img.rotate90().fliph(), // 旋转 90° 顺时针 + 水平翻转
-            6 => img.rotate90(), // 旋转 90° 顺时针
-            7 => img.rotate270().fliph(), // 旋转 270° 顺时针 + 水平翻转
-            8 => img.rotate270(), // 旋转 270° 顺时针
-            _ => img,
-        }
-    }
-
-    /// 读取 EXIF 方向信息
-    fn read_exif_orientation(&self, path: &Path) -> Option<u32> {
-        let file = std::fs::File::open(path).ok()?;
-        let mut bufreader = std::io::BufReader::new(file);
-        let exifreader = exif::Reader::new();
-        let exif = exifreader.read_from_container(&mut bufreader).ok()?;
-
-        exif.get_field(exif::Tag::Orientation, exif::In::PRIMARY)
-            .and_then(|f| f.value.get_uint(0))
-    }
-
     /// 批量生成缩略图
     pub fn generate_batch(
         &self,
@@ -980,10 +1306,23 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
                 tracing::debug!("删除缩略图: {:?}", path);
             }
         }
+        if let Some(pack) = &self.pack {
+            pack.remove(file_hash)?;
+        }
+        if let Ok(mut index) = self.cached.write() {
+            if let Some(sizes) = index.sizes.as_mut() {
+                let key = sanitize_file_hash(file_hash);
+                for set in sizes.iter_mut() {
+                    set.remove(&key);
+                }
+            }
+        }
         Ok(())
     }
 
     /// 清理过期缩略图（超过指定天数未访问）
+    ///
+    /// 打包存储中有条目过期时会压缩 pack，此前取得的裸指针随之失效。
     pub fn cleanup_old_thumbnails(&self, max_age_days: u64) -> AppResult<CleanupStats> {
         let mut stats = CleanupStats::default();
         let max_age = std::time::Duration::from_secs(max_age_days * 24 * 60 * 60);
@@ -1019,6 +1358,22 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
             }
         }
 
+        // 清理后索引可能过期，下次查询时重新加载
+        if let Ok(mut index) = self.cached.write() {
+            index.sizes = None;
+        }
+
+        // 打包存储按写入时间过期，删除后压缩回收空间
+        if let Some(pack) = &self.pack {
+            stats.total_files += pack.usage().0;
+            let cutoff = now.checked_sub(max_age).unwrap_or(std::time::UNIX_EPOCH);
+            let (removed, _) = pack.remove_older_than(cutoff)?;
+            if removed > 0 {
+                stats.deleted_files += removed;
+                stats.freed_bytes += pack.compact()?.reclaimed_bytes;
+            }
+        }
+
         tracing::info!(
             "缩略图清理完成: 删除 {} 个文件，释放 {} 字节",
             stats.deleted_files,
@@ -1049,6 +1404,13 @@ pub fn get_cache_path(&self, file_hash: &str, size: ThumbnailSize) -> PathBuf {
             }
         }
 
+        // 打包存储：存活条目数和数据区占用（含尚未回收的废弃数据）
+        if let Some(pack) = &self.pack {
+            let (entries, bytes) = pack.usage();
+            stats.total_files += entries;
+            stats.total_bytes += bytes;
+        }
+
         Ok(stats)
     }
 }
@@ -1069,6 +1431,35 @@ pub struct CacheStats {
     pub total_bytes: u64,
 }
 
+/// 应用 EXIF 方向校正
+pub(crate) fn apply_exif_orientation(source_path: &Path, img: DynamicImage) -> DynamicImage {
+    // 尝试读取 EXIF 方向信息
+    let orientation = read_exif_orientation(source_path).unwrap_or(1);
+
+    match orientation {
+        1 => img, // 正常
+        2 => img.fliph(), // 水平翻转
+        3 => img.rotate180(), // 旋转 180°
+        4 => img.flipv(), // 垂直翻转
+        5 => img.rotate90().fliph(), // 旋转 90° 顺时针 + 水平翻转
+        6 => img.rotate90(), // 旋转 90° 顺时针
+        7 => img.rotate270().fliph(), // 旋转 270° 顺时针 + 水平翻转
+        8 => img.rotate270(), // 旋转 270° 顺时针
+        _ => img,
+    }
+}
+
+/// 读取 EXIF 方向信息
+fn read_exif_orientation(path: &Path) -> Option<u32> {
+    let file = std::fs::File::open(path).ok()?;
+    let mut bufreader = std::io::BufReader::new(file);
+    let exifreader = exif::Reader::new();
+    let exif = exifreader.read_from_container(&mut bufreader).ok()?;
+
+    exif.get_field(exif::Tag::Orientation, exif::In::PRIMARY)
+        .and_then(|f| f.value.get_uint(0))
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -1111,9 +1502,17 @@ mod tests {
             .unwrap();
 
         assert!(!result.hit_cache);
-        assert!(result.path.exists());
         assert!(result.generation_time_ms.is_some());
         assert!(!result.use_original);
+        assert!(result.thumbhash.is_some());
+        assert!(result.perceptual_hash.is_some());
+
+        // 只存入打包存储，不再写单文件
+        assert!(result.packed);
+        assert!(result.path.as_os_str().is_empty());
+        let cache_path = service.get_cache_path("testhash123", ThumbnailSize::Small);
+        assert!(!cache_path.exists());
+        let packed_len = service.get_packed("testhash123", ThumbnailSize::Small).unwrap().as_bytes().len();
 
         // 再次获取应该命中缓存
         let result2 = service
@@ -1121,6 +1520,26 @@ mod tests {
             .unwrap();
 
         assert!(result2.hit_cache);
+        assert!(result2.packed);
+
+        // 统计计入打包存储
+        let stats = service.get_cache_stats().unwrap();
+        assert_eq!(stats.total_files, 1);
+        assert_eq!(stats.total_bytes, packed_len as u64);
+
+        // 按路径读取时导出单文件
+        assert_eq!(service.thumbnail_path("testhash123", ThumbnailSize::Small), Some(cache_path.clone()));
+        assert_eq!(fs::read(&cache_path).unwrap().len(), packed_len);
+
+        // 其他尺寸不再重复计算哈希
+        let medium = service
+            .get_or_generate(&source_path, "testhash123", ThumbnailSize::Medium, None)
+            .unwrap();
+        assert!(!medium.hit_cache);
+        assert!(medium.thumbhash.is_none());
+        assert!(medium.perceptual_hash.is_none());
+        assert!(medium.color_signature.is_none());
+        assert!(medium.quality.is_none());
     }
 
     #[test]
@@ -1189,4 +1608,34 @@ mod tests {
         assert!(!service.is_cached("deletehash", ThumbnailSize::Medium));
         assert!(!service.is_cached("deletehash", ThumbnailSize::Large));
     }
+
+    #[test]
+    fn test_cached_flags() {
+        let temp_dir = TempDir::new().unwrap();
+        let cache_dir = temp_dir.path().join("cache");
+        let source_path = temp_dir.path().join("test.jpg");
+
+        create_test_image(&source_path);
+
+        let service = ThumbnailService::new(cache_dir).unwrap();
+        service.generate(&source_path, "hash1", ThumbnailSize::Small).unwrap();
+
+        // 首次查询加载索引
+        assert_eq!(
+            service.cached_flags(&["hash1", "hash2"], ThumbnailSize::Small),
+            vec![true, false]
+        );
+
+        // 索引随生成和删除更新
+        service.generate(&source_path, "hash2", ThumbnailSize::Small).unwrap();
+        service.delete_thumbnails("hash1").unwrap();
+        assert_eq!(
+            service.cached_flags(&["hash1", "hash2"], ThumbnailSize::Small),
+            vec![false, true]
+        );
+        assert_eq!(
+            service.cached_flags(&["hash2"], ThumbnailSize::Large),
+            vec![false]
+        );
+    }
 }
@@ -0,0 +1,369 @@
+//! 缩略图纹理图集
+//!
+//! 将一组已缓存的缩略图按固定单元格尺寸拼接到一张或多张图集页中，
+//! 并返回每张缩略图所在的页与 UV 坐标。照片墙前端每页只需解码、上传一次纹理，
+//! 而不是逐张解码上传几百张小图。
+//!
+//! 单元格之间留有间隔，缩略图边缘像素向外复制填满间隔，
+//! 双线性采样或 mipmap 取到相邻纹素时仍是本图颜色，不会混入邻格。
+
+use image::{imageops, imageops::FilterType, DynamicImage, ImageFormat, RgbaImage};
+use rayon::prelude::*;
+
+use super::thumbnail::{ThumbnailService, ThumbnailSize};
+use crate::utils::error::{AppError, AppResult};
+
+/// 单页默认最大边长（主流 GPU 都支持的纹理尺寸）
+pub const DEFAULT_ATLAS_PAGE_SIZE: u32 = 4096;
+
+/// 单元格最大边长
+pub const MAX_ATLAS_CELL_SIZE: u32 = 1024;
+
+/// 单元格每侧的间隔宽度（像素）
+pub const ATLAS_GUTTER: u32 = 2;
+
+/// 图集页输出格式
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum AtlasFormat {
+    /// 原始 RGBA8 像素
+    Rgba,
+    Png,
+    /// 无损 WebP
+    WebP,
+}
+
+/// 图集构建参数
+#[derive(Debug, Clone, Copy)]
+pub struct AtlasOptions {
+    /// 读取的缩略图尺寸
+    pub size: ThumbnailSize,
+    /// 单元格边长（像素，不含间隔），缩略图等比缩放后居中放入
+    pub cell_size: u32,
+    /// 单页最大边长（像素）
+    pub max_page_size: u32,
+}
+
+impl Default for AtlasOptions {
+    fn default() -> Self {
+        Self {
+            size: ThumbnailSize::Small,
+            cell_size: 128,
+            max_page_size: DEFAULT_ATLAS_PAGE_SIZE,
+        }
+    }
+}
+
+/// 图集中一张缩略图的位置
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct AtlasCell {
+    /// 所在页序号
+    pub page: u32,
+    /// 图像在页内的像素矩形（不含单元格留白）
+    pub x: u32,
+    pub y: u32,
+    pub width: u32,
+    pub height: u32,
+    /// 归一化纹理坐标
+    pub u0: f32,
+    pub v0: f32,
+    pub u1: f32,
+    pub v1: f32,
+}
+
+/// 图集页（RGBA8，未占用区域全透明）
+pub struct AtlasPage {
+    pub image: RgbaImage,
+}
+
+impl AtlasPage {
+    pub fn width(&self) -> u32 {
+        self.image.width()
+    }
+
+    pub fn height(&self) -> u32 {
+        self.image.height()
+    }
+
+    /// 按指定格式输出页面字节
+    pub fn into_bytes(self, format: AtlasFormat) -> AppResult<Vec<u8>> {
+        let image_format = match format {
+            AtlasFormat::Rgba => return Ok(self.image.into_raw()),
+            AtlasFormat::Png => ImageFormat::Png,
+            AtlasFormat::WebP => ImageFormat::WebP,
+        };
+        let mut bytes = Vec::new();
+        self.image.write_to(&mut std::io::Cursor::new(&mut bytes), image_format)?;
+        Ok(bytes)
+    }
+}
+
+/// 图集构建结果
+pub struct ThumbnailAtlas {
+    pub pages: Vec<AtlasPage>,
+    /// 与输入顺序一一对应；未缓存或解码失败的为 None，不占用单元格
+    pub cells: Vec<Option<AtlasCell>>,
+}
+
+/// 网格间距：单元格加两侧间隔
+fn cell_pitch(cell_size: u32) -> u32 {
+    cell_size + 2 * ATLAS_GUTTER
+}
+
+/// 网格布局：每页列数、行数
+fn grid_dims(options: &AtlasOptions) -> (u32, u32) {
+    let per_side = (options.max_page_size / cell_pitch(options.cell_size)).max(1);
+    (per_side, per_side)
+}
+
+/// 第 `count` 张缩略图所需页面尺寸（最后一页按实际行数收缩）
+fn page_dims(count: u32, cols: u32, pitch: u32) -> (u32, u32) {
+    let used_cols = count.min(cols);
+    let rows = count.div_ceil(cols);
+    (used_cols * pitch, rows * pitch)
+}
+
+/// 从缓存读取并解码缩略图（优先打包存储，其次单文件缓存）
+fn load_thumbnail(service: &ThumbnailService, file_hash: &str, size: ThumbnailSize) -> Option<DynamicImage> {
+    let decoded = match service.get_packed(file_hash, size) {
+        Some(thumb) => image::load_from_memory(thumb.as_bytes()),
+        None => {
+            let path = service.get_cache_path(file_hash, size);
+            if !path.exists() {
+                return None;
+            }
+            image::open(path)
+        }
+    };
+    match decoded {
+        Ok(img) => Some(img),
+        Err(e) => {
+            tracing::debug!("图集解码缩略图失败 {}: {}", file_hash, e);
+            None
+        }
+    }
+}
+
+/// 将缩略图等比缩放到单元格内
+fn fit_to_cell(img: &DynamicImage, cell_size: u32) -> RgbaImage {
+    if img.width() <= cell_size && img.height() <= cell_size {
+        return img.to_rgba8();
+    }
+    img.resize(cell_size, cell_size, FilterType::Triangle).to_rgba8()
+}
+
+/// 将 (x, y, width, height) 矩形的边缘像素向外复制 `ATLAS_GUTTER` 像素
+///
+/// 先左右扩展每一行，再把扩展后的首末行向上下复制，四角取角点颜色。
+/// 调用方保证矩形四周留有足够间隔。
+fn extrude_edges(page: &mut RgbaImage, x: u32, y: u32, width: u32, height: u32) {
+    let g = ATLAS_GUTTER;
+    for row in y..y + height {
+        let left = *page.get_pixel(x, row);
+        let right = *page.get_pixel(x + width - 1, row);
+        for i in 1..=g {
+            page.put_pixel(x - i, row, left);
+            page.put_pixel(x + width - 1 + i, row, right);
+        }
+    }
+    for col in x - g..x + width + g {
+        let top = *page.get_pixel(col, y);
+        let bottom = *page.get_pixel(col, y + height - 1);
+        for i in 1..=g {
+            page.put_pixel(col, y - i, top);
+            page.put_pixel(col, y + height - 1 + i, bottom);
+        }
+    }
+}
+
+/// 构建缩略图图集
+///
+/// 缩略图并行解码缩放，按输入顺序逐行填入网格；一页放满后换页。
+/// 每个单元格四周留 [`ATLAS_GUTTER`] 像素间隔并填入缩略图的边缘像素，
+/// 返回的 UV 仍落在缩略图自身的像素边界上。
+pub fn build_atlas<S: AsRef<str> + Sync>(
+    service: &ThumbnailService,
+    file_hashes: &[S],
+    options: &AtlasOptions,
+) -> AppResult<ThumbnailAtlas> {
+    if options.cell_size == 0 || options.cell_size > MAX_ATLAS_CELL_SIZE {
+        return Err(AppError::General(format!(
+            "单元格尺寸必须在 1..={} 之间",
+            MAX_ATLAS_CELL_SIZE
+        )));
+    }
+    let cell_size = options.cell_size;
+    let pitch = cell_pitch(cell_size);
+    if options.max_page_size < pitch {
+        return Err(AppError::General(format!(
+            "页面尺寸不能小于单元格尺寸加间隔（{}）",
+            pitch
+        )));
+    }
+
+    let tiles: Vec<Option<RgbaImage>> = file_hashes
+        .par_iter()
+        .map(|hash| {
+            load_thumbnail(service, hash.as_ref(), options.size).map(|img| fit_to_cell(&img, cell_size))
+        })
+        .collect();
+
+    let (cols, rows) = grid_dims(options);
+    let per_page = cols * rows;
+    let total = tiles.iter().filter(|t| t.is_some()).count() as u32;
+
+    let mut pages = Vec::new();
+    let mut cells = Vec::with_capacity(tiles.len());
+    let mut placed = 0u32;
+
+    for tile in tiles {
+        let Some(tile) = tile else {
+            cells.push(None);
+            continue;
+        };
+
+        let slot = placed % per_page;
+        if slot == 0 {
+            let remaining = (total - placed).min(per_page);
+            let (w, h) = page_dims(remaining, cols, pitch);
+            pages.push(AtlasPage {
+                image: RgbaImage::new(w, h),
+            });
+        }
+        let page_index = pages.len() - 1;
+        let page = &mut pages[page_index];
+
+        let x = (slot % cols) * pitch + ATLAS_GUTTER + (cell_size - tile.width()) / 2;
+        let y = (slot / cols) * pitch + ATLAS_GUTTER + (cell_size - tile.height()) / 2;
+        imageops::replace(&mut page.image, &tile, x as i64, y as i64);
+        extrude_edges(&mut page.image, x, y, tile.width(), tile.height());
+
+        let (pw, ph) = (page.width() as f32, page.height() as f32);
+        cells.push(Some(AtlasCell {
+            page: page_index as u32,
+            x,
+            y,
+            width: tile.width(),
+            height: tile.height(),
+            u0: x as f32 / pw,
+            v0: y as f32 / ph,
+            u1: (x + tile.width()) as f32 / pw,
+            v1: (y + tile.height()) as f32 / ph,
+        }));
+        placed += 1;
+    }
+
+    Ok(ThumbnailAtlas { pages, cells })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use image::Rgba;
+    use tempfile::tempdir;
+
+    fn write_cached(service: &ThumbnailService, hash: &str, w: u32, h: u32, color: [u8; 4]) {
+        let path = service.get_cache_path(hash, ThumbnailSize::Small);
+        std::fs::create_dir_all(path.parent().unwrap()).unwrap();
+        let img = DynamicImage::ImageRgba8(RgbaImage::from_pixel(w, h, Rgba(color)));
+        img.save_with_format(&path, ImageFormat::WebP).unwrap();
+    }
+
+    #[test]
+    fn test_page_dims() {
+        assert_eq!(page_dims(3, 4, 68), (204, 68));
+        assert_eq!(page_dims(5, 4, 68), (272, 136));
+        assert_eq!(page_dims(16, 4, 68), (272, 272));
+        assert_eq!(cell_pitch(64), 68);
+    }
+
+    #[test]
+    fn test_build_atlas_layout() {
+        let dir = tempdir().unwrap();
+        let service = ThumbnailService::new(dir.path().to_path_buf()).unwrap();
+        write_cached(&service, "aa", 64, 32, [255, 0, 0, 255]);
+        write_cached(&service, "bb", 16, 16, [0, 255, 0, 255]);
+        write_cached(&service, "cc", 32, 32, [0, 0, 255, 255]);
+
+        let options = AtlasOptions {
+            size: ThumbnailSize::Small,
+            cell_size: 32,
+            max_page_size: 72,
+        };
+        let atlas = build_atlas(&service, &["aa", "missing", "bb", "cc"], &options).unwrap();
+
+        assert_eq!(atlas.cells.len(), 4);
+        assert!(atlas.cells[1].is_none());
+        assert_eq!(atlas.pages.len(), 1);
+        assert_eq!((atlas.pages[0].width(), atlas.pages[0].height()), (72, 72));
+
+        // 64x32 缩放为 32x16 并垂直居中（单元格从间隔之后开始）
+        let a = atlas.cells[0].unwrap();
+        assert_eq!((a.x, a.y, a.width, a.height), (2, 10, 32, 16));
+        // 16x16 不放大，居中于第二格
+        let b = atlas.cells[2].unwrap();
+        assert_eq!((b.x, b.y, b.width, b.height), (46, 10, 16, 16));
+        assert_eq!(b.u0, 46.0 / 72.0);
+        // 第三张换行
+        let c = atlas.cells[3].unwrap();
+        assert_eq!((c.page, c.x, c.y), (0, 2, 38));
+
+        let px = atlas.pages[0].image.get_pixel(4, 40);
+        assert!(px[2] > 200 && px[3] == 255);
+        assert_eq!(atlas.pages[0].image.get_pixel(0, 0)[3], 0);
+    }
+
+    #[test]
+    fn test_build_atlas_extrudes_gutters() {
+        let dir = tempdir().unwrap();
+        let service = ThumbnailService::new(dir.path().to_path_buf()).unwrap();
+        write_cached(&service, "aa", 32, 32, [255, 0, 0, 255]);
+        write_cached(&service, "bb", 32, 32, [0, 255, 0, 255]);
+
+        let options = AtlasOptions {
+            size: ThumbnailSize::Small,
+            cell_size: 32,
+            max_page_size: 72,
+        };
+        let atlas = build_atlas(&service, &["aa", "bb"], &options).unwrap();
+        let page = &atlas.pages[0].image;
+        let a = atlas.cells[0].unwrap();
+        let b = atlas.cells[1].unwrap();
+
+        // UV 仍落在图像自身的像素边界上
+        assert_eq!((a.u0, a.u1), (2.0 / 72.0, 34.0 / 72.0));
+        assert_eq!(b.x - (a.x + a.width), 2 * ATLAS_GUTTER);
+
+        let red = |p: &Rgba<u8>| p[0] > 200 && p[1] < 50 && p[3] == 255;
+        let green = |p: &Rgba<u8>| p[1] > 200 && p[0] < 50 && p[3] == 255;
+        // 两图之间的间隔各自由本图边缘填满，不会采样到邻格或透明背景
+        for col in a.x + a.width..a.x + a.width + ATLAS_GUTTER {
+            assert!(red(page.get_pixel(col, a.y)));
+        }
+        for col in b.x - ATLAS_GUTTER..b.x {
+            assert!(green(page.get_pixel(col, b.y + b.height - 1)));
+        }
+        // 上下间隔和四角
+        assert!(red(page.get_pixel(a.x, 0)));
+        assert!(red(page.get_pixel(0, 0)));
+        assert!(green(page.get_pixel(b.x + b.width + ATLAS_GUTTER - 1, b.y + b.height + ATLAS_GUTTER - 1)));
+    }
+
+    #[test]
+    fn test_build_atlas_rejects_bad_cell_size() {
+        let dir = tempdir().unwrap();
+        let service = ThumbnailService::new(dir.path().to_path_buf()).unwrap();
+        let options = AtlasOptions {
+            cell_size: 0,
+            ..Default::default()
+        };
+        assert!(build_atlas(&service, &["aa"], &options).is_err());
+
+        // 页面放不下一个单元格加间隔
+        let options = AtlasOptions {
+            cell_size: 64,
+            max_page_size: 66,
+            ..Default::default()
+        };
+        assert!(build_atlas(&service, &["aa"], &options).is_err());
+    }
+}
@@ -0,0 +1,686 @@
+//! 打包缩略图存储
+//!
+//! 每个尺寸一个只追加的 pack 文件（缩略图 WebP 字节首尾相接）加一个索引文件。
+//! pack 文件通过内存映射读取，查询只是一次哈希表查找，不产生任何文件系统调用。
+//!
+//! # 文件格式
+//! - `<size>.pack`：数据区，按容量倍增预分配，文件长度不代表已写入的数据
+//! - `<size>.idx`：16 字节文件头（`PWTI` + 版本号 + 已落盘的数据末尾）后跟定长 88 字节记录：
+//!   64 字节 key（NUL 填充）、u64 偏移、u32 长度、u32 标志、u64 写入时间（Unix 秒，小端）
+//!
+//! 索引记录成批提交：先 `sync_data` 数据区，再更新文件头中的数据末尾，最后追加记录。
+//! 加载时丢弃残缺记录和超出该末尾的记录，崩溃后不会把未落盘的零字节当作缩略图；
+//! 未提交的记录随之丢失，对应缩略图下次请求时重新生成。
+//! 删除只追加墓碑记录，空间由 [`ThumbnailPackStore::compact`] 回收。
+
+use std::collections::HashMap;
+use std::fs::{self, File, OpenOptions};
+use std::io::{Read, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, RwLock};
+use std::time::{SystemTime, UNIX_EPOCH};
+
+use memmap2::Mmap;
+
+use super::thumbnail::ThumbnailSize;
+use crate::utils::error::{AppError, AppResult};
+use crate::utils::sanitize_file_hash;
+
+const INDEX_MAGIC: &[u8; 4] = b"PWTI";
+const INDEX_VERSION: u32 = 2;
+const INDEX_HEADER_LEN: u64 = 16;
+const KEY_LEN: usize = 64;
+const RECORD_LEN: usize = KEY_LEN + 24;
+
+/// 攒够这么多条索引记录后提交一次（一次 `sync_data`）
+const INDEX_BATCH: usize = 32;
+
+/// 墓碑记录：该 key 已被删除
+const FLAG_TOMBSTONE: u32 = 1;
+
+/// pack 文件最小预分配容量（16 MB）
+const MIN_PACK_CAPACITY: u64 = 16 * 1024 * 1024;
+
+const ALL_SIZES: [ThumbnailSize; 4] = [
+    ThumbnailSize::Tiny,
+    ThumbnailSize::Small,
+    ThumbnailSize::Medium,
+    ThumbnailSize::Large,
+];
+
+/// 打包存储中的一张缩略图
+///
+/// 持有映射的引用计数，字节在本对象存活期间始终有效。
+#[derive(Clone)]
+pub struct PackedThumbnail {
+    map: Arc<Mmap>,
+    offset: usize,
+    len: usize,
+}
+
+impl PackedThumbnail {
+    /// 缩略图 WebP 字节
+    pub fn as_bytes(&self) -> &[u8] {
+        &self.map[self.offset..self.offset + self.len]
+    }
+}
+
+/// 压缩统计
+#[derive(Debug, Default, Clone, Copy, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct PackCompactStats {
+    pub live_entries: usize,
+    pub live_bytes: u64,
+    pub reclaimed_bytes: u64,
+}
+
+/// 索引中的一条存活记录
+#[derive(Debug, Clone, Copy)]
+struct Entry {
+    offset: u64,
+    len: u32,
+    /// 写入时间（Unix 秒）
+    written: u64,
+}
+
+/// 一条索引记录
+struct Record<'a> {
+    key: &'a str,
+    offset: u64,
+    len: u32,
+    flags: u32,
+    written: u64,
+}
+
+impl Record<'_> {
+    fn encode(&self) -> [u8; RECORD_LEN] {
+        let mut record = [0u8; RECORD_LEN];
+        record[..self.key.len()].copy_from_slice(self.key.as_bytes());
+        record[KEY_LEN..KEY_LEN + 8].copy_from_slice(&self.offset.to_le_bytes());
+        record[KEY_LEN + 8..KEY_LEN + 12].copy_from_slice(&self.len.to_le_bytes());
+        record[KEY_LEN + 12..KEY_LEN + 16].copy_from_slice(&self.flags.to_le_bytes());
+        record[KEY_LEN + 16..].copy_from_slice(&self.written.to_le_bytes());
+        record
+    }
+
+    fn decode(record: &[u8]) -> Record<'_> {
+        let key_end = record[..KEY_LEN].iter().position(|&b| b == 0).unwrap_or(KEY_LEN);
+        let field = |at: usize| -> [u8; 8] { record[at..at + 8].try_into().unwrap() };
+        Record {
+            key: std::str::from_utf8(&record[..key_end]).unwrap_or(""),
+            offset: u64::from_le_bytes(field(KEY_LEN)),
+            len: u32::from_le_bytes(record[KEY_LEN + 8..KEY_LEN + 12].try_into().unwrap()),
+            flags: u32::from_le_bytes(record[KEY_LEN + 12..KEY_LEN + 16].try_into().unwrap()),
+            written: u64::from_le_bytes(field(KEY_LEN + 16)),
+        }
+    }
+}
+
+fn unix_now() -> u64 {
+    SystemTime::now().duration_since(UNIX_EPOCH).map_or(0, |d| d.as_secs())
+}
+
+fn index_header(durable_end: u64) -> [u8; INDEX_HEADER_LEN as usize] {
+    let mut header = [0u8; INDEX_HEADER_LEN as usize];
+    header[..4].copy_from_slice(INDEX_MAGIC);
+    header[4..8].copy_from_slice(&INDEX_VERSION.to_le_bytes());
+    header[8..].copy_from_slice(&durable_end.to_le_bytes());
+    header
+}
+
+/// 单个尺寸的 pack
+struct Pack {
+    pack_path: PathBuf,
+    index_path: PathBuf,
+    file: File,
+    index_file: File,
+    entries: HashMap<String, Entry>,
+    /// 数据区逻辑末尾
+    end: u64,
+    /// 已 `sync_data` 并记入索引文件头的数据末尾
+    durable_end: u64,
+    /// 尚未写入索引文件的记录（按发生顺序）
+    pending: Vec<[u8; RECORD_LEN]>,
+    /// 已被覆盖或删除的数据字节数
+    dead_bytes: u64,
+    map: Option<Arc<Mmap>>,
+    /// 扩容前的旧映射，保留到下次压缩，保证已返回的指针不失效
+    retired: Vec<Arc<Mmap>>,
+}
+
+impl Pack {
+    fn open(pack_path: PathBuf, index_path: PathBuf) -> AppResult<Self> {
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .truncate(false)
+            .open(&pack_path)?;
+        let mut index_file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .truncate(false)
+            .open(&index_path)?;
+
+        let pack_len = file.metadata()?.len();
+        let mut raw = Vec::new();
+        index_file.read_to_end(&mut raw)?;
+
+        let mut entries = HashMap::new();
+        let mut end = 0u64;
+        let mut dead_bytes = 0u64;
+        let mut valid_len = INDEX_HEADER_LEN;
+
+        let header_ok = raw.len() >= INDEX_HEADER_LEN as usize
+            && &raw[0..4] == INDEX_MAGIC
+            && raw[4..8] == INDEX_VERSION.to_le_bytes();
+        if !header_ok {
+            // 新文件、头部损坏或旧版本：重建空索引，旧数据由单文件缓存迁移或重新生成
+            if !raw.is_empty() {
+                tracing::warn!("缩略图索引 {:?} 无法识别，重建空索引", index_path);
+            }
+            file.set_len(0)?;
+            index_file.set_len(0)?;
+            index_file.seek(SeekFrom::Start(0))?;
+            index_file.write_all(&index_header(0))?;
+        } else {
+            // 只信任文件头记录的已落盘末尾：预分配使文件长度总是大于已写入的数据
+            let durable_end = u64::from_le_bytes(raw[8..16].try_into().unwrap()).min(pack_len);
+            for record in raw[INDEX_HEADER_LEN as usize..].chunks_exact(RECORD_LEN) {
+                let record = Record::decode(record);
+                let tombstone = record.flags & FLAG_TOMBSTONE != 0;
+                if !tombstone && (record.len == 0 || record.offset + record.len as u64 > durable_end) {
+                    // 数据未确认落盘的记录，其后的记录也不可信
+                    break;
+                }
+                valid_len += RECORD_LEN as u64;
+
+                let replaced = if tombstone {
+                    entries.remove(record.key)
+                } else {
+                    end = end.max(record.offset + record.len as u64);
+                    let entry = Entry {
+                        offset: record.offset,
+                        len: record.len,
+                        written: record.written,
+                    };
+                    entries.insert(record.key.to_string(), entry)
+                };
+                if let Some(old) = replaced {
+                    dead_bytes += old.len as u64;
+                }
+            }
+
+            if valid_len != raw.len() as u64 {
+                tracing::warn!(
+                    "缩略图索引 {:?} 尾部不完整，截断 {} 字节",
+                    index_path,
+                    raw.len() as u64 - valid_len
+                );
+                index_file.set_len(valid_len)?;
+            }
+        }
+        index_file.seek(SeekFrom::End(0))?;
+
+        let map = if file.metadata()?.len() > 0 {
+            // SAFETY: pack 文件只由本进程追加写入，已映射区间内的数据不会被改写
+            Some(Arc::new(unsafe { Mmap::map(&file)? }))
+        } else {
+            None
+        };
+
+        Ok(Self {
+            pack_path,
+            index_path,
+            file,
+            index_file,
+            entries,
+            end,
+            durable_end: end,
+            pending: Vec::new(),
+            dead_bytes,
+            map,
+            retired: Vec::new(),
+        })
+    }
+
+    fn capacity(&self) -> u64 {
+        self.map.as_ref().map_or(0, |m| m.len() as u64)
+    }
+
+    /// 提交待写的索引记录：数据落盘后先推进文件头中的末尾，再追加记录
+    fn commit(&mut self) -> AppResult<()> {
+        if self.pending.is_empty() {
+            return Ok(());
+        }
+        if self.end > self.durable_end {
+            self.file.sync_data()?;
+            self.index_file.seek(SeekFrom::Start(8))?;
+            self.index_file.write_all(&self.end.to_le_bytes())?;
+            self.index_file.seek(SeekFrom::End(0))?;
+            self.durable_end = self.end;
+        }
+        self.index_file.write_all(&self.pending.concat())?;
+        self.pending.clear();
+        Ok(())
+    }
+
+    fn insert(&mut self, key: String, bytes: &[u8]) -> AppResult<()> {
+        let len = bytes.len() as u64;
+        let needed = self.end + len;
+
+        if needed > self.capacity() {
+            let mut capacity = self.capacity().max(MIN_PACK_CAPACITY);
+            while capacity < needed {
+                capacity *= 2;
+            }
+            self.file.set_len(capacity)?;
+            // SAFETY: 同 Pack::open
+            let map = Arc::new(unsafe { Mmap::map(&self.file)? });
+            if let Some(old) = self.map.replace(map) {
+                self.retired.push(old);
+            }
+        }
+
+        self.file.seek(SeekFrom::Start(self.end))?;
+        self.file.write_all(bytes)?;
+
+        let entry = Entry {
+            offset: self.end,
+            len: bytes.len() as u32,
+            written: unix_now(),
+        };
+        self.pending.push(
+            Record {
+                key: &key,
+                offset: entry.offset,
+                len: entry.len,
+                flags: 0,
+                written: entry.written,
+            }
+            .encode(),
+        );
+        if let Some(old) = self.entries.insert(key, entry) {
+            self.dead_bytes += old.len as u64;
+        }
+        self.end += len;
+        if self.pending.len() >= INDEX_BATCH {
+            self.commit()?;
+        }
+        Ok(())
+    }
+
+    /// 移除条目并登记墓碑记录（不提交）
+    fn tombstone(&mut self, key: &str) -> Option<Entry> {
+        let entry = self.entries.remove(key)?;
+        let record = Record {
+            key,
+            offset: 0,
+            len: 0,
+            flags: FLAG_TOMBSTONE,
+            written: unix_now(),
+        };
+        self.pending.push(record.encode());
+        self.dead_bytes += entry.len as u64;
+        Some(entry)
+    }
+
+    fn remove(&mut self, key: &str) -> AppResult<bool> {
+        let removed = self.tombstone(key).is_some();
+        // 删除立即提交，避免崩溃后已删除的缩略图重新出现
+        self.commit()?;
+        Ok(removed)
+    }
+
+    fn get(&self, key: &str) -> Option<PackedThumbnail> {
+        let entry = self.entries.get(key)?;
+        let map = self.map.as_ref()?;
+        Some(PackedThumbnail {
+            map: map.clone(),
+            offset: entry.offset as usize,
+            len: entry.len as usize,
+        })
+    }
+
+    /// 将存活条目重写到新文件并替换当前 pack
+    fn compact(&mut self) -> AppResult<PackCompactStats> {
+        let mut live: Vec<(String, Entry)> = self.entries.iter().map(|(k, &e)| (k.clone(), e)).collect();
+        live.sort_by_key(|(_, entry)| entry.offset);
+
+        let pack_tmp = self.pack_path.with_extension("pack.tmp");
+        let index_tmp = self.index_path.with_extension("idx.tmp");
+
+        let live_bytes: u64 = live.iter().map(|(_, entry)| entry.len as u64).sum();
+        let reclaimed = self.end.saturating_sub(live_bytes);
+
+        {
+            let mut pack_out = File::create(&pack_tmp)?;
+            let mut index_out = File::create(&index_tmp)?;
+            index_out.write_all(&index_header(live_bytes))?;
+
+            let mut cursor = 0u64;
+            if let Some(map) = &self.map {
+                for (key, entry) in &live {
+                    let start = entry.offset as usize;
+                    pack_out.write_all(&map[start..start + entry.len as usize])?;
+
+                    let record = Record {
+                        key,
+                        offset: cursor,
+                        len: entry.len,
+                        flags: 0,
+                        written: entry.written,
+                    };
+                    index_out.write_all(&record.encode())?;
+                    cursor += entry.len as u64;
+                }
+            }
+            pack_out.sync_all()?;
+            index_out.sync_all()?;
+        }
+
+        // 新文件已包含所有存活条目，旧索引中未提交的记录不再需要
+        self.pending.clear();
+        // Windows 上被映射的文件无法被替换，先释放所有映射
+        self.map = None;
+        self.retired.clear();
+
+        let swapped = fs::rename(&pack_tmp, &self.pack_path)
+            .and_then(|_| fs::rename(&index_tmp, &self.index_path));
+
+        // 无论替换成功与否都重新打开，保证 pack 始终可用
+        let reopened = Pack::open(self.pack_path.clone(), self.index_path.clone())?;
+        *self = reopened;
+        swapped?;
+
+        Ok(PackCompactStats {
+            live_entries: live.len(),
+            live_bytes,
+            reclaimed_bytes: reclaimed,
+        })
+    }
+}
+
+impl Drop for Pack {
+    fn drop(&mut self) {
+        if let Err(e) = self.commit() {
+            tracing::warn!("提交缩略图索引 {:?} 失败: {}", self.index_path, e);
+        }
+    }
+}
+
+/// 打包缩略图存储
+pub struct ThumbnailPackStore {
+    dir: PathBuf,
+    packs: Vec<RwLock<Pack>>,
+}
+
+impl ThumbnailPackStore {
+    /// 打开（或创建）目录下的 pack 文件
+    pub fn open(dir: &Path) -> AppResult<Self> {
+        fs::create_dir_all(dir)?;
+        let packs = ALL_SIZES
+            .iter()
+            .map(|size| {
+                Pack::open(
+                    dir.join(format!("{}.pack", size.name())),
+                    dir.join(format!("{}.idx", size.name())),
+                )
+                .map(RwLock::new)
+            })
+            .collect::<AppResult<Vec<_>>>()?;
+
+        Ok(Self {
+            dir: dir.to_path_buf(),
+            packs,
+        })
+    }
+
+    /// 存储目录
+    pub fn dir(&self) -> &Path {
+        &self.dir
+    }
+
+    fn pack_key(file_hash: &str) -> Option<String> {
+        let key = sanitize_file_hash(file_hash);
+        (key.len() <= KEY_LEN).then_some(key)
+    }
+
+    /// 追加一张缩略图（已存在时覆盖）
+    pub fn insert(&self, file_hash: &str, size: ThumbnailSize, bytes: &[u8]) -> AppResult<()> {
+        let key = Self::pack_key(file_hash)
+            .ok_or_else(|| AppError::General(format!("缩略图 key 过长: {}", file_hash)))?;
+        if bytes.is_empty() || bytes.len() > u32::MAX as usize {
+            return Err(AppError::General("缩略图数据长度无效".to_string()));
+        }
+        let mut pack = self.packs[size.slot()]
+            .write()
+            .map_err(|_| AppError::General("缩略图 pack 锁已损坏".to_string()))?;
+        pack.insert(key, bytes)
+    }
+
+    /// 查询缩略图
+    pub fn get(&self, file_hash: &str, size: ThumbnailSize) -> Option<PackedThumbnail> {
+        let key = Self::pack_key(file_hash)?;
+        self.packs[size.slot()].read().ok()?.get(&key)
+    }
+
+    /// 是否包含缩略图
+    pub fn contains(&self, file_hash: &str, size: ThumbnailSize) -> bool {
+        let Some(key) = Self::pack_key(file_hash) else {
+            return false;
+        };
+        self.packs[size.slot()]
+            .read()
+            .map(|pack| pack.entries.contains_key(&key))
+            .unwrap_or(false)
+    }
+
+    /// 提交所有尚未写入索引的记录
+    pub fn flush(&self) -> AppResult<()> {
+        for lock in &self.packs {
+            let mut pack = lock
+                .write()
+                .map_err(|_| AppError::General("缩略图 pack 锁已损坏".to_string()))?;
+            pack.commit()?;
+        }
+        Ok(())
+    }
+
+    /// 存活条目数和数据区占用字节数（含尚未压缩回收的废弃数据）
+    pub fn usage(&self) -> (usize, u64) {
+        self.packs.iter().fold((0, 0), |(entries, bytes), lock| match lock.read() {
+            Ok(pack) => (entries + pack.entries.len(), bytes + pack.end),
+            Err(_) => (entries, bytes),
+        })
+    }
+
+    /// 删除写入时间早于 `cutoff` 的缩略图，返回删除的条目数和字节数
+    ///
+    /// 只追加墓碑记录，空间要等 [`Self::compact`] 回收。
+    pub fn remove_older_than(&self, cutoff: SystemTime) -> AppResult<(usize, u64)> {
+        let cutoff = cutoff.duration_since(UNIX_EPOCH).map_or(0, |d| d.as_secs());
+        let mut removed = (0usize, 0u64);
+        for lock in &self.packs {
+            let mut pack = lock
+                .write()
+                .map_err(|_| AppError::General("缩略图 pack 锁已损坏".to_string()))?;
+            let expired: Vec<String> = pack
+                .entries
+                .iter()
+                .filter(|(_, entry)| entry.written < cutoff)
+                .map(|(key, _)| key.clone())
+                .collect();
+            for key in expired {
+                if let Some(entry) = pack.tombstone(&key) {
+                    removed.0 += 1;
+                    removed.1 += entry.len as u64;
+                }
+            }
+            pack.commit()?;
+        }
+        Ok(removed)
+    }
+
+    /// 删除某张照片所有尺寸的缩略图
+    pub fn remove(&self, file_hash: &str) -> AppResult<()> {
+        let Some(key) = Self::pack_key(file_hash) else {
+            return Ok(());
+        };
+        for lock in &self.packs {
+            let mut pack = lock
+                .write()
+                .map_err(|_| AppError::General("缩略图 pack 锁已损坏".to_string()))?;
+            pack.remove(&key)?;
+        }
+        Ok(())
+    }
+
+    /// 删除某张照片单个尺寸的缩略图
+    pub fn remove_one(&self, file_hash: &str, size: ThumbnailSize) -> AppResult<bool> {
+        let Some(key) = Self::pack_key(file_hash) else {
+            return Ok(false);
+        };
+        let mut pack = self.packs[size.slot()]
+            .write()
+            .map_err(|_| AppError::General("缩略图 pack 锁已损坏".to_string()))?;
+        pack.remove(&key)
+    }
+
+    /// 已废弃数据占比（0.0 - 1.0），可据此决定何时压缩
+    pub fn dead_ratio(&self) -> f64 {
+        let (dead, total) = self.packs.iter().fold((0u64, 0u64), |(dead, total), lock| {
+            match lock.read() {
+                Ok(pack) => (dead + pack.dead_bytes, total + pack.end),
+                Err(_) => (dead, total),
+            }
+        });
+        if total == 0 {
+            0.0
+        } else {
+            dead as f64 / total as f64
+        }
+    }
+
+    /// 压缩所有 pack，回收被覆盖和删除条目占用的空间
+    ///
+    /// 压缩会使此前通过裸指针取得的缩略图数据失效；
+    /// 持有 [`PackedThumbnail`] 的调用方不受影响（Windows 上会导致替换失败并返回错误）。
+    pub fn compact(&self) -> AppResult<PackCompactStats> {
+        let mut stats = PackCompactStats::default();
+        for lock in &self.packs {
+            let mut pack = lock
+                .write()
+                .map_err(|_| AppError::General("缩略图 pack 锁已损坏".to_string()))?;
+            let s = pack.compact()?;
+            stats.live_entries += s.live_entries;
+            stats.live_bytes += s.live_bytes;
+            stats.reclaimed_bytes += s.reclaimed_bytes;
+        }
+        tracing::info!(
+            "缩略图 pack 压缩完成: {} 条, 回收 {} 字节",
+            stats.live_entries,
+            stats.reclaimed_bytes
+        );
+        Ok(stats)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    #[test]
+    fn test_pack_insert_get_reopen() {
+        let temp_dir = TempDir::new().unwrap();
+        {
+            let store = ThumbnailPackStore::open(temp_dir.path()).unwrap();
+            store.insert("aaaa", ThumbnailSize::Small, b"first").unwrap();
+            store.insert("bbbb", ThumbnailSize::Small, b"second").unwrap();
+            store.insert("aaaa", ThumbnailSize::Large, b"large").unwrap();
+
+            assert_eq!(store.get("aaaa", ThumbnailSize::Small).unwrap().as_bytes(), b"first");
+            assert!(store.get("bbbb", ThumbnailSize::Large).is_none());
+        }
+
+        // 重新打开后索引从磁盘恢复
+        let store = ThumbnailPackStore::open(temp_dir.path()).unwrap();
+        assert_eq!(store.get("bbbb", ThumbnailSize::Small).unwrap().as_bytes(), b"second");
+        assert_eq!(store.get("aaaa", ThumbnailSize::Large).unwrap().as_bytes(), b"large");
+    }
+
+    #[test]
+    fn test_pack_recovery_ignores_unsynced_records() {
+        let temp_dir = TempDir::new().unwrap();
+        {
+            let store = ThumbnailPackStore::open(temp_dir.path()).unwrap();
+            store.insert("kept", ThumbnailSize::Small, b"kept-bytes").unwrap();
+            store.flush().unwrap();
+            store.insert("lost", ThumbnailSize::Small, b"lost-bytes").unwrap();
+            // 模拟崩溃：未提交的记录没有写入索引
+            std::mem::forget(store);
+        }
+
+        // 数据未确认落盘的记录：在预分配的文件长度之内，但超出文件头记录的末尾
+        let index_path = temp_dir.path().join("small.idx");
+        let record = Record {
+            key: "zeros",
+            offset: 4096,
+            len: 10,
+            flags: 0,
+            written: unix_now(),
+        };
+        let mut index = OpenOptions::new().append(true).open(&index_path).unwrap();
+        index.write_all(&record.encode()).unwrap();
+        drop(index);
+
+        let store = ThumbnailPackStore::open(temp_dir.path()).unwrap();
+        assert_eq!(store.get("kept", ThumbnailSize::Small).unwrap().as_bytes(), b"kept-bytes");
+        assert!(store.get("lost", ThumbnailSize::Small).is_none());
+        assert!(store.get("zeros", ThumbnailSize::Small).is_none());
+        assert_eq!(
+            fs::metadata(&index_path).unwrap().len(),
+            INDEX_HEADER_LEN + RECORD_LEN as u64
+        );
+    }
+
+    #[test]
+    fn test_pack_remove_older_than() {
+        let temp_dir = TempDir::new().unwrap();
+        let store = ThumbnailPackStore::open(temp_dir.path()).unwrap();
+        store.insert("old", ThumbnailSize::Small, b"old-bytes").unwrap();
+        store.insert("old", ThumbnailSize::Tiny, b"tiny").unwrap();
+        assert_eq!(store.usage(), (2, 13));
+
+        let future = SystemTime::now() + std::time::Duration::from_secs(60);
+        assert_eq!(store.remove_older_than(future).unwrap(), (2, 13));
+        assert_eq!(store.remove_older_than(future).unwrap(), (0, 0));
+        assert_eq!(store.usage().0, 0);
+        assert_eq!(store.compact().unwrap().reclaimed_bytes, 13);
+    }
+
+    #[test]
+    fn test_pack_remove_and_compact() {
+        let temp_dir = TempDir::new().unwrap();
+        let store = ThumbnailPackStore::open(temp_dir.path()).unwrap();
+        store.insert("keep", ThumbnailSize::Small, b"keep-bytes").unwrap();
+        store.insert("drop", ThumbnailSize::Small, b"drop-bytes").unwrap();
+        store.insert("keep", ThumbnailSize::Small, b"keep-v2").unwrap();
+        store.remove("drop").unwrap();
+
+        assert!(!store.contains("drop", ThumbnailSize::Small));
+        assert!(store.dead_ratio() > 0.0);
+
+        let stats = store.compact().unwrap();
+        assert_eq!(stats.live_entries, 1);
+        assert_eq!(stats.live_bytes, 7);
+        assert_eq!(stats.reclaimed_bytes, 20);
+        assert_eq!(store.get("keep", ThumbnailSize::Small).unwrap().as_bytes(), b"keep-v2");
+
+        let store = ThumbnailPackStore::open(temp_dir.path()).unwrap();
+        assert_eq!(store.get("keep", ThumbnailSize::Small).unwrap().as_bytes(), b"keep-v2");
+        assert!(store.get("drop", ThumbnailSize::Small).is_none());
+    }
+}
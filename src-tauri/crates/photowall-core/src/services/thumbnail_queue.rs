@@ -1,15 +1,19 @@
 //! 缩略图优先级队列
 
-use std::cmp::Ordering;
-use std::collections::{BinaryHeap, HashSet};
+use std::cmp::{Ordering as CmpOrdering, Reverse};
+use std::collections::{BinaryHeap, HashMap, HashSet};
 use std::path::PathBuf;
-use std::sync::{Arc, Condvar, Mutex, RwLock};
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering as AtomicOrdering};
+use std::sync::{Arc, Condvar, Mutex, MutexGuard, RwLock};
 use std::thread;
+use std::time::Instant;
 
 use serde::Serialize;
 
+use crate::db::Database;
 use crate::events::{EventSinkExt, SharedEventSink};
-use crate::services::{ThumbnailService, ThumbnailSize};
+use crate::metrics;
+use crate::services::{ColorIndex, DuplicateIndex, ThumbnailResult, ThumbnailService, ThumbnailSize};
 use crate::utils::error::AppResult;
 
 /// 缩略图生成完成事件的 payload
@@ -18,7 +22,10 @@ use crate::utils::error::AppResult;
 pub struct ThumbnailReadyPayload {
     pub file_hash: String,
     pub size: String,
+    /// 单文件缓存路径（占位图或存放在打包存储时为空）
     pub path: String,
+    /// 缩略图存放在打包存储中，按 hash 和尺寸读取
+    pub packed: bool,
     /// 是否为占位图（RAW 提取失败时生成，不缓存到磁盘）
     pub is_placeholder: bool,
     /// 占位图 Base64 编码（WebP 格式，仅占位图时有值）
@@ -26,6 +33,9 @@ pub struct ThumbnailReadyPayload {
     pub placeholder_base64: Option<String>,
     /// 是否直接使用原图（小图跳过缩略图生成）
     pub use_original: bool,
+    /// ThumbHash 占位图 Base64 编码（仅本次新生成时有值）
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub thumbhash_base64: Option<String>,
 }
 
 /// 全局 EventSink 存储（用于 worker 线程发送事件）
@@ -50,27 +60,30 @@ fn emit_thumbnail_ready(
     file_hash: &str,
     size: ThumbnailSize,
     path: &str,
+    packed: bool,
     is_placeholder: bool,
     placeholder_bytes: Option<&[u8]>,
     use_original: bool,
+    thumbhash: Option<&[u8]>,
 ) {
-    if let Ok(guard) = EVENT_SINK.read() {
-        if let Some(ref sink) = *guard {
-            let placeholder_base64 = placeholder_bytes.map(|bytes| {
-                use base64::{Engine as _, engine::general_purpose::STANDARD};
-                STANDARD.encode(bytes)
-            });
-            let payload = ThumbnailReadyPayload {
-                file_hash: file_hash.to_string(),
-                size: size.name().to_string(),
-                path: path.to_string(),
-                is_placeholder,
-                placeholder_base64,
-                use_original,
-            };
-            sink.emit_typed("thumbnail-ready", &payload);
-        }
-    }
+    // 在锁外发送：回调可能重入并再次发送事件
+    let Some(sink) = EVENT_SINK.read().ok().and_then(|guard| guard.clone()) else {
+        return;
+    };
+    use base64::{Engine as _, engine::general_purpose::STANDARD};
+    let placeholder_base64 = placeholder_bytes.map(|bytes| STANDARD.encode(bytes));
+    let thumbhash_base64 = thumbhash.map(|bytes| STANDARD.encode(bytes));
+    let payload = ThumbnailReadyPayload {
+        file_hash: file_hash.to_string(),
+        size: size.name().to_string(),
+        path: path.to_string(),
+        packed,
+        is_placeholder,
+        placeholder_base64,
+        use_original,
+        thumbhash_base64,
+    };
+    sink.emit_typed("thumbnail-ready", &payload);
 }
 
 #[derive(Debug, Clone)]
@@ -84,6 +97,8 @@ pub struct ThumbnailTask {
     pub(crate) seq: u64,
     /// 原图尺寸（用于小图跳过逻辑）
     pub original_dimensions: Option<(u32, u32)>,
+    /// 入队时间（由队列设置，用于统计排队耗时）
+    pub(crate) enqueued_at: Option<Instant>,
 }
 
 impl ThumbnailTask {
@@ -101,6 +116,7 @@ impl ThumbnailTask {
             priority,
             seq: 0,
             original_dimensions: None,
+            enqueued_at: None,
         }
     }
 
@@ -124,45 +140,417 @@ impl ThumbnailTask {
             priority,
             seq: 0,
             original_dimensions,
+            enqueued_at: None,
+        }
+    }
+}
+
+/// 视口外任务的处理方式
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum OffscreenPolicy {
+    /// 降到所有视口内任务之后
+    #[default]
+    Demote,
+    /// 直接丢弃
+    Drop,
+}
+
+/// 视口外任务的层级
+const TIER_OFFSCREEN: u8 = 0;
+/// 没有视口时所有任务的层级
+const TIER_DEFAULT: u8 = 1;
+/// 视口内任务的层级
+const TIER_VISIBLE: u8 = 2;
+/// 堆顶提示中表示空堆的值
+const HINT_EMPTY: u64 = 0;
+
+/// 当前视口（按显示顺序排列的 file_hash）
+#[derive(Debug, Default)]
+struct Viewport {
+    ranks: HashMap<String, usize>,
+    policy: OffscreenPolicy,
+}
+
+impl Viewport {
+    /// 任务在堆中的排序键 (层级, 层内顺序)，`None` 表示丢弃
+    ///
+    /// 没有视口时按入队优先级排序；视口内任务排最前，按在视口中的位置从上到下；
+    /// 视口外任务排在最后或丢弃。
+    fn place(&self, task: &ThumbnailTask) -> Option<(u8, i64)> {
+        if self.ranks.is_empty() {
+            return Some((TIER_DEFAULT, task.priority as i64));
+        }
+        match self.ranks.get(&task.file_hash) {
+            Some(&rank) => Some((TIER_VISIBLE, -(rank as i64))),
+            None if self.policy == OffscreenPolicy::Drop => None,
+            None => Some((TIER_OFFSCREEN, task.priority as i64)),
         }
     }
 }
 
-impl PartialEq for ThumbnailTask {
+/// 堆中的任务
+struct Queued {
+    tier: u8,
+    order: i64,
+    task: ThumbnailTask,
+}
+
+impl Queued {
+    /// 排序键，与 `Ord` 一致；用于在不同时持有两把锁的情况下比较不同堆的堆顶
+    fn key(&self) -> (u8, i64, Reverse<u64>) {
+        (self.tier, self.order, Reverse(self.task.seq))
+    }
+}
+
+impl PartialEq for Queued {
     fn eq(&self, other: &Self) -> bool {
-        self.priority == other.priority && self.seq == other.seq
+        self.cmp(other) == CmpOrdering::Equal
     }
 }
 
-impl Eq for ThumbnailTask {}
+impl Eq for Queued {}
 
-impl PartialOrd for ThumbnailTask {
-    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+impl PartialOrd for Queued {
+    fn partial_cmp(&self, other: &Self) -> Option<CmpOrdering> {
         Some(self.cmp(other))
     }
 }
 
-impl Ord for ThumbnailTask {
-    fn cmp(&self, other: &Self) -> Ordering {
-        // 优先级高的先出，其次按序号小的先出
-        self.priority.cmp(&other.priority).then(self.seq.cmp(&other.seq)).reverse()
+impl Ord for Queued {
+    fn cmp(&self, other: &Self) -> CmpOrdering {
+        // 层级高、层内顺序大的先出，其次按序号小的先出
+        self.key().cmp(&other.key())
+    }
+}
+
+/// 单个工作线程的任务堆
+struct WorkerQueue {
+    heap: BinaryHeap<Queued>,
+    /// 已应用的视口版本
+    generation: u64,
+}
+
+/// 多队列调度器
+///
+/// 每个工作线程有自己的优先级堆，入队轮流分配，自己的堆空了就从其他线程的堆顶窃取。
+/// 调整视口只发布一个新版本号和视口快照；各堆在下次被访问时（持有自己的锁）
+/// 才按新视口重排或丢弃任务，滚动时不需要锁住所有队列。
+///
+/// 每个堆在自己的锁内把堆顶层级和已应用的视口版本发布到 `hints`，
+/// 取任务时先看提示，只锁可能有更靠前任务的堆。
+struct Scheduler {
+    queues: Vec<Mutex<WorkerQueue>>,
+    /// 各堆的堆顶提示：`视口版本 << 8 | (堆顶层级 + 1)`，空堆低 8 位为 0
+    hints: Vec<AtomicU64>,
+    /// 最新视口版本，堆的版本落后时需要重排
+    generation: AtomicU64,
+    viewport: RwLock<(u64, Arc<Viewport>)>,
+    /// 所有堆中的任务总数
+    pending: AtomicUsize,
+    seq: AtomicU64,
+    next_queue: AtomicUsize,
+}
+
+impl Scheduler {
+    fn new(queue_count: usize) -> Self {
+        Self {
+            queues: (0..queue_count.max(1))
+                .map(|_| {
+                    Mutex::new(WorkerQueue {
+                        heap: BinaryHeap::new(),
+                        generation: 0,
+                    })
+                })
+                .collect(),
+            hints: (0..queue_count.max(1)).map(|_| AtomicU64::new(HINT_EMPTY)).collect(),
+            generation: AtomicU64::new(0),
+            viewport: RwLock::new((0, Arc::new(Viewport::default()))),
+            pending: AtomicUsize::new(0),
+            seq: AtomicU64::new(0),
+            next_queue: AtomicUsize::new(0),
+        }
+    }
+
+    fn lock_queue(&self, index: usize) -> MutexGuard<'_, WorkerQueue> {
+        let mut queue = self.queues[index].lock().unwrap_or_else(|e| e.into_inner());
+        self.sync(&mut queue);
+        self.publish(index, &queue);
+        queue
+    }
+
+    /// 更新堆顶提示，调用方持有该堆的锁
+    fn publish(&self, index: usize, queue: &WorkerQueue) {
+        let top = queue.heap.peek().map_or(HINT_EMPTY, |q| q.tier as u64 + 1);
+        self.hints[index].store(queue.generation << 8 | top, AtomicOrdering::Release);
+    }
+
+    /// 按提示判断堆中是否可能有层级高于 `floor` 的任务（`None` 表示任意任务）
+    ///
+    /// 提示的视口版本落后时堆顶层级未知，需要加锁重排后再看。
+    fn may_outrank(&self, index: usize, floor: Option<u8>) -> bool {
+        let hint = self.hints[index].load(AtomicOrdering::Acquire);
+        if hint >> 8 != self.generation.load(AtomicOrdering::Acquire) {
+            return true;
+        }
+        match (hint & 0xff, floor) {
+            (HINT_EMPTY, _) => false,
+            (_, None) => true,
+            (top, Some(tier)) => top - 1 > tier as u64,
+        }
+    }
+
+    /// 视口版本落后时按最新视口重排堆
+    fn sync(&self, queue: &mut WorkerQueue) {
+        if queue.generation == self.generation.load(AtomicOrdering::Acquire) {
+            return;
+        }
+        let (generation, viewport) = match self.viewport.read() {
+            Ok(guard) => (guard.0, guard.1.clone()),
+            Err(_) => return,
+        };
+
+        let before = queue.heap.len();
+        let requeued: Vec<Queued> = std::mem::take(&mut queue.heap)
+            .into_vec()
+            .into_iter()
+            .filter_map(|q| viewport.place(&q.task).map(|(tier, order)| Queued { tier, order, task: q.task }))
+            .collect();
+        queue.heap = BinaryHeap::from(requeued);
+        queue.generation = generation;
+
+        let dropped = before - queue.heap.len();
+        if dropped > 0 {
+            self.pending.fetch_sub(dropped, AtomicOrdering::SeqCst);
+            metrics::global().incr("thumbnail.dropped", dropped as u64);
+        }
+    }
+
+    /// 入队，返回 false 表示按当前视口被丢弃
+    fn push(&self, mut task: ThumbnailTask) -> bool {
+        task.seq = self.seq.fetch_add(1, AtomicOrdering::Relaxed) + 1;
+        task.enqueued_at = Some(Instant::now());
+
+        let index = self.next_queue.fetch_add(1, AtomicOrdering::Relaxed) % self.queues.len();
+        let mut queue = self.lock_queue(index);
+        let placed = match self.viewport.read() {
+            Ok(guard) if guard.0 == queue.generation => guard.1.place(&task),
+            // 视口在 sync 之后又变了，先按入队优先级放入，下次访问时重排
+            _ => Some((TIER_DEFAULT, task.priority as i64)),
+        };
+        match placed {
+            Some((tier, order)) => {
+                queue.heap.push(Queued { tier, order, task });
+                self.publish(index, &queue);
+                self.pending.fetch_add(1, AtomicOrdering::SeqCst);
+                true
+            }
+            None => {
+                metrics::global().incr("thumbnail.dropped", 1);
+                false
+            }
+        }
+    }
+
+    /// 取下一个任务
+    ///
+    /// 自己的堆顶已是视口内任务时直接取；否则查看其他堆的堆顶（一次只持有一把锁），
+    /// 其中最靠前的任务层级高于自己的堆顶（或自己的堆已空）时从那个堆窃取。
+    /// 这样别的堆里还有视口内任务时，不会先做完自己堆里的视口外任务。
+    /// 按堆顶提示跳过不可能更靠前的堆，平时不去碰其他线程的锁。
+    fn pop(&self, worker: usize) -> Option<ThumbnailTask> {
+        let count = self.queues.len();
+        let local = self.lock_queue(worker).heap.peek().map(Queued::key);
+        let floor = local.as_ref().map(|(tier, ..)| *tier);
+
+        if !matches!(floor, Some(tier) if tier >= TIER_VISIBLE) {
+            let mut best: Option<(usize, (u8, i64, Reverse<u64>))> = None;
+            for offset in 1..count {
+                let index = (worker + offset) % count;
+                if !self.may_outrank(index, floor) {
+                    continue;
+                }
+                if let Some(key) = self.lock_queue(index).heap.peek().map(Queued::key) {
+                    if best.as_ref().map_or(true, |(_, top)| key > *top) {
+                        best = Some((index, key));
+                    }
+                }
+            }
+            if let Some((index, (tier, ..))) = best {
+                if local.as_ref().map_or(true, |(local_tier, ..)| tier > *local_tier) {
+                    if let Some(task) = self.pop_from(index) {
+                        metrics::global().incr("thumbnail.stolen", 1);
+                        return Some(task);
+                    }
+                }
+            }
+        }
+
+        if let Some(task) = self.pop_from(worker) {
+            return Some(task);
+        }
+        // 查看堆顶后各堆可能已被其他线程取走，依次再试一遍
+        (1..count)
+            .map(|offset| (worker + offset) % count)
+            .filter(|&index| self.may_outrank(index, None))
+            .find_map(|index| self.pop_from(index))
+            .map(|task| {
+                metrics::global().incr("thumbnail.stolen", 1);
+                task
+            })
+    }
+
+    /// 从指定的堆取出堆顶任务
+    fn pop_from(&self, index: usize) -> Option<ThumbnailTask> {
+        let mut queue = self.lock_queue(index);
+        let queued = queue.heap.pop()?;
+        self.publish(index, &queue);
+        drop(queue);
+        self.pending.fetch_sub(1, AtomicOrdering::SeqCst);
+        Some(queued.task)
+    }
+
+    /// 发布新视口，`hashes` 按显示顺序排列，为空时恢复入队优先级
+    fn set_viewport(&self, hashes: &[String], policy: OffscreenPolicy) {
+        let ranks = hashes
+            .iter()
+            .enumerate()
+            .rev()
+            .map(|(rank, hash)| (hash.clone(), rank))
+            .collect();
+        let viewport = Arc::new(Viewport { ranks, policy });
+
+        if let Ok(mut guard) = self.viewport.write() {
+            let generation = guard.0 + 1;
+            *guard = (generation, viewport);
+            self.generation.store(generation, AtomicOrdering::Release);
+        }
+    }
+
+    fn len(&self) -> usize {
+        self.pending.load(AtomicOrdering::SeqCst)
+    }
+}
+
+/// 工作线程休眠与唤醒
+///
+/// 休眠前在锁内登记并复查任务数，入队方看到有线程休眠才加锁通知，不会丢失唤醒。
+#[derive(Default)]
+struct Parking {
+    lock: Mutex<()>,
+    cvar: Condvar,
+    sleepers: AtomicUsize,
+    stopped: AtomicBool,
+}
+
+impl Parking {
+    fn notify_one(&self) {
+        if self.sleepers.load(AtomicOrdering::SeqCst) > 0 {
+            let _guard = self.lock.lock().unwrap_or_else(|e| e.into_inner());
+            self.cvar.notify_one();
+        }
+    }
+
+    fn notify_all(&self) {
+        let _guard = self.lock.lock().unwrap_or_else(|e| e.into_inner());
+        self.cvar.notify_all();
+    }
+
+    /// 没有任务且未停止时休眠
+    fn park(&self, scheduler: &Scheduler) {
+        let guard = self.lock.lock().unwrap_or_else(|e| e.into_inner());
+        self.sleepers.fetch_add(1, AtomicOrdering::SeqCst);
+        if scheduler.len() == 0 && !self.stopped.load(AtomicOrdering::SeqCst) {
+            drop(self.cvar.wait(guard));
+        }
+        self.sleepers.fetch_sub(1, AtomicOrdering::SeqCst);
     }
 }
 
 /// 队列内部共享状态
 struct Inner {
-    heap: BinaryHeap<ThumbnailTask>,
-    seq: u64,
+    scheduler: Scheduler,
+    parking: Parking,
     /// 被取消的 file_hash 集合
-    cancelled: HashSet<String>,
-    /// 停止标志
-    stopped: bool,
+    cancelled: RwLock<HashSet<String>>,
+}
+
+/// 需要随新缩略图数据同步更新的内存检索索引
+#[derive(Default, Clone)]
+struct SearchIndexes {
+    duplicates: Option<Arc<DuplicateIndex>>,
+    colors: Option<Arc<ColorIndex>>,
+}
+
+/// 保存生成缩略图时顺带计算的数据，后续查询随照片行一起返回
+///
+/// 感知哈希和颜色签名首次写入时同步加入内存检索索引。
+fn save_thumbnail_data(
+    db: &Database,
+    indexes: &RwLock<SearchIndexes>,
+    file_hash: &str,
+    result: &ThumbnailResult,
+) {
+    if let Some(ref thumbhash) = result.thumbhash {
+        if let Err(e) = db.set_thumbhash(file_hash, thumbhash) {
+            tracing::warn!("保存 ThumbHash 失败: {} -> {}", file_hash, e);
+        }
+    }
+    if let Some(ref scores) = result.quality {
+        if let Err(e) = db.set_quality_scores(file_hash, scores) {
+            tracing::warn!("保存质量评分失败: {} -> {}", file_hash, e);
+        }
+    }
+
+    let mut new_hash = None;
+    if let Some(ref hash) = result.perceptual_hash {
+        match db.set_perceptual_hash(file_hash, hash) {
+            Ok(0) => {}
+            Ok(_) => new_hash = Some(hash),
+            Err(e) => tracing::warn!("保存感知哈希失败: {} -> {}", file_hash, e),
+        }
+    }
+    let mut new_signature = None;
+    if let Some(ref signature) = result.color_signature {
+        match db.set_color_signature(file_hash, &signature.to_bytes()) {
+            Ok(0) => {}
+            Ok(_) => new_signature = Some(signature),
+            Err(e) => tracing::warn!("保存颜色签名失败: {} -> {}", file_hash, e),
+        }
+    }
+    if new_hash.is_none() && new_signature.is_none() {
+        return;
+    }
+
+    let indexes = indexes.read().map(|guard| guard.clone()).unwrap_or_default();
+    if indexes.duplicates.is_none() && indexes.colors.is_none() {
+        return;
+    }
+    let ids = match db.get_photo_ids_by_file_hash(file_hash) {
+        Ok(ids) => ids,
+        Err(e) => {
+            tracing::warn!("更新检索索引失败: {} -> {}", file_hash, e);
+            return;
+        }
+    };
+    for id in ids {
+        if let (Some(index), Some(hash)) = (&indexes.duplicates, new_hash) {
+            index.upsert(id, hash);
+        }
+        if let (Some(index), Some(signature)) = (&indexes.colors, new_signature) {
+            index.upsert(id, signature.embedding);
+        }
+    }
 }
 
 /// 缩略图优先级队列服务（多工作线程并行处理）
+#[derive(Clone)]
 pub struct ThumbnailQueue {
     service: ThumbnailService,
-    inner: Arc<(Mutex<Inner>, Condvar)>,
+    inner: Arc<Inner>,
+    /// 用于保存 ThumbHash 的数据库（未设置时只随事件发送）
+    database: Arc<RwLock<Option<Arc<Database>>>>,
+    /// 新算出的感知哈希和颜色签名同步加入的检索索引
+    indexes: Arc<RwLock<SearchIndexes>>,
     /// 工作线程数量
     worker_count: usize,
 }
@@ -178,14 +566,15 @@ impl ThumbnailQueue {
     pub fn with_worker_count(service: ThumbnailService, worker_count: usize) -> AppResult<Self> {
         let count = worker_count.max(1).min(8); // 限制 1-8 个线程
         let inner = Inner {
-            heap: BinaryHeap::new(),
-            seq: 0,
-            cancelled: HashSet::new(),
-            stopped: false,
+            scheduler: Scheduler::new(count),
+            parking: Parking::default(),
+            cancelled: RwLock::new(HashSet::new()),
         };
         let queue = Self {
             service,
-            inner: Arc::new((Mutex::new(inner), Condvar::new())),
+            inner: Arc::new(inner),
+            database: Arc::new(RwLock::new(None)),
+            indexes: Arc::new(RwLock::new(SearchIndexes::default())),
             worker_count: count,
         };
 
@@ -199,64 +588,108 @@ impl ThumbnailQueue {
     fn spawn_worker(&self, worker_id: usize) {
         let inner = self.inner.clone();
         let service = self.service.clone();
+        let database = self.database.clone();
+        let indexes = self.indexes.clone();
         thread::spawn(move || {
             tracing::debug!("Thumbnail worker {} started", worker_id);
             loop {
-                // 取任务
-                let task_opt = {
-                    let (lock, cvar) = &*inner;
-                    let mut state = lock.lock().unwrap();
-                    // 等待直到有任务或停止
-                    while state.heap.is_empty() && !state.stopped {
-                        state = cvar.wait(state).unwrap();
-                    }
-                    if state.stopped {
-                        return;
+                if inner.parking.stopped.load(AtomicOrdering::SeqCst) {
+                    return;
+                }
+
+                // 取任务（自己的堆为空时从其他线程窃取），没有任务时休眠
+                let task = match inner.scheduler.pop(worker_id) {
+                    Some(task) => task,
+                    None => {
+                        inner.parking.park(&inner.scheduler);
+                        continue;
                     }
-                    state.heap.pop()
                 };
 
-                if let Some(task) = task_opt {
-                    // 取消检查
-                    {
-                        let (lock, _) = &*inner;
-                        let state = lock.lock().unwrap();
-                        if state.cancelled.contains(&task.file_hash) {
-                            tracing::debug!("跳过已取消任务: {}", task.file_hash);
-                            continue;
-                        }
-                    }
+                let m = metrics::global();
+                if let Some(enqueued_at) = task.enqueued_at {
+                    m.record("thumbnail.queue_wait", enqueued_at.elapsed());
+                }
+
+                // 取消检查
+                let cancelled = inner
+                    .cancelled
+                    .read()
+                    .map(|set| !set.is_empty() && set.contains(&task.file_hash))
+                    .unwrap_or(false);
+                if cancelled {
+                    tracing::debug!("跳过已取消任务: {}", task.file_hash);
+                    m.incr("thumbnail.cancelled", 1);
+                    continue;
+                }
 
-                    // 执行
-                    match service.get_or_generate(&task.source_path, &task.file_hash, task.size, task.original_dimensions) {
-                        Ok(result) => {
-                            // 发送 thumbnail-ready 事件
-                            emit_thumbnail_ready(
-                                &task.file_hash,
-                                task.size,
-                                &result.path.to_string_lossy(),
-                                result.is_placeholder,
-                                result.placeholder_bytes.as_deref(),
-                                result.use_original,
-                            );
+                // 执行
+                let started = Instant::now();
+                match service.get_or_generate(&task.source_path, &task.file_hash, task.size, task.original_dimensions) {
+                    Ok(result) => {
+                        m.incr("thumbnail.completed", 1);
+                        if result.hit_cache {
+                            m.incr("thumbnail.cache.hit", 1);
+                        } else if !result.use_original {
+                            m.incr("thumbnail.cache.miss", 1);
+                            m.record("thumbnail.generate", started.elapsed());
                         }
-                        Err(e) => {
-                            tracing::warn!("缩略图任务失败: {} -> {}", task.source_path.display(), e);
+
+                        if !result.hit_cache && !result.use_original {
+                            let db = database.read().ok().and_then(|guard| guard.clone());
+                            if let Some(db) = db {
+                                save_thumbnail_data(&db, &indexes, &task.file_hash, &result);
+                            }
                         }
+
+                        // 发送 thumbnail-ready 事件
+                        emit_thumbnail_ready(
+                            &task.file_hash,
+                            task.size,
+                            &result.path.to_string_lossy(),
+                            result.packed,
+                            result.is_placeholder,
+                            result.placeholder_bytes.as_deref(),
+                            result.use_original,
+                            result.thumbhash.as_deref(),
+                        );
+                    }
+                    Err(e) => {
+                        m.incr("thumbnail.failed", 1);
+                        tracing::warn!("缩略图任务失败: {} -> {}", task.source_path.display(), e);
                     }
                 }
             }
         });
     }
 
+    /// 设置数据库，新生成的 ThumbHash 会写入 photos 表
+    pub fn set_database(&self, db: Arc<Database>) {
+        if let Ok(mut guard) = self.database.write() {
+            *guard = Some(db);
+        }
+    }
+
+    /// 设置近似重复索引，新写入的感知哈希会同步加入索引
+    pub fn set_duplicate_index(&self, index: Arc<DuplicateIndex>) {
+        if let Ok(mut guard) = self.indexes.write() {
+            guard.duplicates = Some(index);
+        }
+    }
+
+    /// 设置颜色索引，新写入的颜色签名会同步加入索引
+    pub fn set_color_index(&self, index: Arc<ColorIndex>) {
+        if let Ok(mut guard) = self.indexes.write() {
+            guard.colors = Some(index);
+        }
+    }
+
     /// 入队
-    pub fn enqueue(&self, mut task: ThumbnailTask) {
-        let (lock, cvar) = &*self.inner;
-        let mut state = lock.lock().unwrap();
-        state.seq += 1;
-        task.seq = state.seq;
-        state.heap.push(task);
-        cvar.notify_one();
+    pub fn enqueue(&self, task: ThumbnailTask) {
+        if self.inner.scheduler.push(task) {
+            metrics::global().incr("thumbnail.enqueued", 1);
+            self.inner.parking.notify_one();
+        }
     }
 
     /// 批量入队
@@ -266,33 +699,42 @@ impl ThumbnailQueue {
         }
     }
 
+    /// 按当前可见视口调整排队任务的优先级
+    ///
+    /// `visible_hashes` 按显示顺序排列（靠前的先生成），视口外的任务按 `policy`
+    /// 降级或丢弃；之后入队的任务同样按此视口排序。传入空列表恢复入队时的优先级。
+    pub fn reprioritize(&self, visible_hashes: &[String], policy: OffscreenPolicy) {
+        self.inner.scheduler.set_viewport(visible_hashes, policy);
+        metrics::global().incr("thumbnail.reprioritized", 1);
+    }
+
     /// 按 file_hash 取消后续任务
     pub fn cancel_by_hash(&self, file_hash: &str) {
-        let (lock, _) = &*self.inner;
-        let mut state = lock.lock().unwrap();
-        state.cancelled.insert(file_hash.to_string());
+        if let Ok(mut set) = self.inner.cancelled.write() {
+            set.insert(file_hash.to_string());
+        }
     }
 
     /// 清空取消列表（可选）
     pub fn clear_cancellations(&self) {
-        let (lock, _) = &*self.inner;
-        let mut state = lock.lock().unwrap();
-        state.cancelled.clear();
+        if let Ok(mut set) = self.inner.cancelled.write() {
+            set.clear();
+        }
     }
 
     /// 获取当前队列长度
     pub fn len(&self) -> usize {
-        let (lock, _) = &*self.inner;
-        let state = lock.lock().unwrap();
-        state.heap.len()
+        self.inner.scheduler.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
     }
 
     /// 停止工作线程
     pub fn stop(&self) {
-        let (lock, cvar) = &*self.inner;
-        let mut state = lock.lock().unwrap();
-        state.stopped = true;
-        cvar.notify_all();
+        self.inner.parking.stopped.store(true, AtomicOrdering::SeqCst);
+        self.inner.parking.notify_all();
     }
 }
 
@@ -302,16 +744,6 @@ impl Drop for ThumbnailQueue {
     }
 }
 
-impl Clone for ThumbnailQueue {
-    fn clone(&self) -> Self {
-        Self {
-            service: self.service.clone(),
-            inner: self.inner.clone(),
-            worker_count: self.worker_count,
-        }
-    }
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -338,6 +770,7 @@ mod tests {
             priority: 10,
             seq: 0,
             original_dimensions: None,
+            enqueued_at: None,
         });
 
         // 简单等待处理
@@ -345,4 +778,102 @@ mod tests {
 
         assert!(queue.service.is_cached("hash1", ThumbnailSize::Small));
     }
+
+    fn task(hash: &str, priority: i32) -> ThumbnailTask {
+        ThumbnailTask::new(PathBuf::from(format!("{}.jpg", hash)), hash.to_string(), ThumbnailSize::Small, priority)
+    }
+
+    fn drain(scheduler: &Scheduler, worker: usize) -> Vec<String> {
+        std::iter::from_fn(|| scheduler.pop(worker)).map(|t| t.file_hash).collect()
+    }
+
+    #[test]
+    fn test_scheduler_priority_and_stealing() {
+        let scheduler = Scheduler::new(3);
+        for (hash, priority) in [("a", 1), ("b", 5), ("c", 5), ("d", 9), ("e", 1)] {
+            assert!(scheduler.push(task(hash, priority)));
+        }
+        assert_eq!(scheduler.len(), 5);
+
+        // 任务轮流分到三个堆（a、d | b、e | c），层级相同时工作线程 0 先取完自己的堆，
+        // 再从其他堆中堆顶最靠前的窃取
+        assert_eq!(drain(&scheduler, 0), ["d", "a", "b", "c", "e"]);
+        assert_eq!(scheduler.len(), 0);
+        assert!(scheduler.pop(1).is_none());
+
+        // 自己的堆只剩视口外任务时，先窃取其他堆中的视口内任务，
+        // 视口内任务全部取完后才回到自己的视口外任务
+        let scheduler = Scheduler::new(3);
+        for (hash, priority) in [("a", 1), ("b", 5), ("c", 5), ("d", 9), ("e", 1), ("f", 3)] {
+            assert!(scheduler.push(task(hash, priority)));
+        }
+        // 堆分配：a、d | b、e | c、f
+        scheduler.set_viewport(
+            &["e".to_string(), "c".to_string(), "f".to_string()],
+            OffscreenPolicy::Demote,
+        );
+        assert_eq!(drain(&scheduler, 0), ["e", "c", "f", "d", "a", "b"]);
+        assert_eq!(scheduler.len(), 0);
+    }
+
+    #[test]
+    fn test_scheduler_viewport_reorders_and_drops() {
+        let scheduler = Scheduler::new(1);
+        for (i, hash) in ["a", "b", "c", "d", "e"].iter().enumerate() {
+            scheduler.push(task(hash, 10 - i as i32));
+        }
+
+        // 视口内按显示顺序，视口外降到最后并保持原优先级
+        scheduler.set_viewport(&["e".to_string(), "c".to_string()], OffscreenPolicy::Demote);
+        scheduler.push(task("f", 100));
+        scheduler.push(task("d2", 0));
+        assert_eq!(drain(&scheduler, 0), ["e", "c", "f", "a", "b", "d", "d2"]);
+
+        for hash in ["a", "b", "c"] {
+            scheduler.push(task(hash, 1));
+        }
+        scheduler.set_viewport(&["b".to_string()], OffscreenPolicy::Drop);
+        assert!(!scheduler.push(task("z", 50)));
+        assert_eq!(scheduler.len(), 1);
+        assert_eq!(drain(&scheduler, 0), ["b"]);
+
+        // 空视口恢复入队优先级
+        scheduler.set_viewport(&[], OffscreenPolicy::Drop);
+        scheduler.push(task("x", 1));
+        scheduler.push(task("y", 2));
+        assert_eq!(drain(&scheduler, 0), ["y", "x"]);
+    }
+
+    #[test]
+    fn test_viewport_applies_lazily_per_queue() {
+        let scheduler = Scheduler::new(2);
+        for hash in ["a", "b", "c", "d"] {
+            scheduler.push(task(hash, 0));
+        }
+        scheduler.set_viewport(&["d".to_string(), "a".to_string()], OffscreenPolicy::Drop);
+        // 计数在各堆被访问时才扣除
+        assert_eq!(scheduler.len(), 4);
+        let mut order = drain(&scheduler, 1);
+        order.sort();
+        assert_eq!(order, ["a", "d"]);
+        assert_eq!(scheduler.len(), 0);
+    }
+
+    #[test]
+    fn test_hints_track_queue_tops() {
+        let scheduler = Scheduler::new(2);
+        assert!(!scheduler.may_outrank(1, None));
+        // 堆分配：a | b
+        scheduler.push(task("a", 0));
+        scheduler.push(task("b", 0));
+        assert!(scheduler.may_outrank(1, None));
+        assert!(!scheduler.may_outrank(1, Some(TIER_DEFAULT)));
+
+        // 视口变化后提示过期，必须加锁查看；重排后提示反映新的堆顶层级
+        scheduler.set_viewport(&["b".to_string()], OffscreenPolicy::Demote);
+        assert!(scheduler.may_outrank(1, Some(TIER_VISIBLE)));
+        assert_eq!(drain(&scheduler, 0), ["b", "a"]);
+        assert!(!scheduler.may_outrank(0, None));
+        assert!(!scheduler.may_outrank(1, None));
+    }
 }
@@ -0,0 +1,696 @@
+//! 全屏查看器预取
+//!
+//! 调用方提供浏览顺序（文件路径列表）和当前位置，后台线程按浏览方向
+//! 预先解码前后各 `radius` 张照片的显示分辨率版本，放入按字节数限制的 LRU 缓存。
+//! 每次导航都会重建待解码队列；已离开预取窗口的解码任务被取消，
+//! 解码完成后结果直接丢弃，不占用缓存。取消后又回到窗口的任务恢复，结果照常缓存。
+
+use std::cell::Cell;
+use std::collections::{HashMap, HashSet, VecDeque};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Condvar, Mutex, MutexGuard};
+use std::thread::{self, JoinHandle};
+use std::time::Instant;
+
+use image::imageops::FilterType;
+
+use crate::metrics;
+use crate::utils::error::{AppError, AppResult};
+
+use super::thumbnail::apply_exif_orientation;
+use super::wic::WicProcessor;
+
+/// 预取选项
+#[derive(Debug, Clone)]
+pub struct PrefetchOptions {
+    /// 当前照片前后各预取的张数
+    pub radius: usize,
+    /// 显示版本的最长边（像素），原图更小时不放大
+    pub max_dimension: u32,
+    /// 缓存上限（字节）
+    pub cache_bytes: usize,
+    /// 后台解码线程数
+    pub threads: usize,
+}
+
+impl Default for PrefetchOptions {
+    fn default() -> Self {
+        Self {
+            radius: 3,
+            max_dimension: 2560,
+            cache_bytes: 256 * 1024 * 1024,
+            threads: 2,
+        }
+    }
+}
+
+/// 显示分辨率的解码结果（RGBA8，已按 EXIF 方向校正）
+#[derive(Debug, Clone)]
+pub struct Rendition {
+    pub width: u32,
+    pub height: u32,
+    /// `width * height * 4` 字节，行间无填充
+    pub pixels: Vec<u8>,
+}
+
+impl Rendition {
+    pub fn byte_len(&self) -> usize {
+        self.pixels.len()
+    }
+}
+
+/// 解码函数：路径、最长边、取消检查
+type DecodeFn = dyn Fn(&Path, u32, &dyn Fn() -> bool) -> AppResult<Rendition> + Send + Sync;
+
+/// 解码为显示分辨率
+///
+/// 需要缩小时优先用 WIC 在解码阶段缩放（JPEG 按 DCT 比例解码，50MP 原图只解出
+/// 所需的像素量），失败再回退到 image crate 全尺寸解码后缩放。
+/// `cancelled` 在解码和缩放之间检查，已取消的任务不再做后续工作。
+pub fn decode_display(path: &Path, max_dimension: u32, cancelled: &dyn Fn() -> bool) -> AppResult<Rendition> {
+    if !path.exists() {
+        return Err(AppError::FileNotFound(path.display().to_string()));
+    }
+
+    let (orig_w, orig_h) = image::image_dimensions(path)?;
+    let long_edge = orig_w.max(orig_h).max(1);
+    let scale = (max_dimension.max(1) as f64 / long_edge as f64).min(1.0);
+    let (new_w, new_h) = (
+        ((orig_w as f64 * scale).round() as u32).max(1),
+        ((orig_h as f64 * scale).round() as u32).max(1),
+    );
+
+    let img = if scale < 1.0 {
+        let wic = WicProcessor::new().and_then(|processor| {
+            let (buffer, w, h) = processor.load_and_resize(path, new_w, new_h)?;
+            WicProcessor::buffer_to_dynamic_image(buffer, w, h)
+        });
+        match wic {
+            Ok(img) => img,
+            Err(_) => {
+                let full = image::open(path)?;
+                if cancelled() {
+                    return Err(AppError::General("prefetch cancelled".to_string()));
+                }
+                full.resize(new_w, new_h, FilterType::Triangle)
+            }
+        }
+    } else {
+        image::open(path)?
+    };
+    if cancelled() {
+        return Err(AppError::General("prefetch cancelled".to_string()));
+    }
+
+    let rgba = apply_exif_orientation(path, img).to_rgba8();
+    Ok(Rendition {
+        width: rgba.width(),
+        height: rgba.height(),
+        pixels: rgba.into_raw(),
+    })
+}
+
+/// 按字节数限制的 LRU 缓存
+struct RenditionCache {
+    entries: HashMap<PathBuf, Arc<Rendition>>,
+    /// 最近使用的在末尾
+    lru: VecDeque<PathBuf>,
+    bytes: usize,
+    capacity: usize,
+}
+
+impl RenditionCache {
+    fn new(capacity: usize) -> Self {
+        Self {
+            entries: HashMap::new(),
+            lru: VecDeque::new(),
+            bytes: 0,
+            capacity,
+        }
+    }
+
+    fn contains(&self, path: &Path) -> bool {
+        self.entries.contains_key(path)
+    }
+
+    fn touch(&mut self, path: &Path) {
+        if let Some(pos) = self.lru.iter().position(|p| p == path) {
+            let key = self.lru.remove(pos).unwrap();
+            self.lru.push_back(key);
+        }
+    }
+
+    fn get(&mut self, path: &Path) -> Option<Arc<Rendition>> {
+        let rendition = self.entries.get(path).cloned()?;
+        self.touch(path);
+        Some(rendition)
+    }
+
+    fn insert(&mut self, path: PathBuf, rendition: Arc<Rendition>) {
+        if let Some(old) = self.entries.remove(&path) {
+            self.bytes -= old.byte_len();
+            self.lru.retain(|p| p != &path);
+        }
+        self.bytes += rendition.byte_len();
+        self.entries.insert(path.clone(), rendition);
+        self.lru.push_back(path);
+
+        // 至少保留刚插入的一张，即使它本身超过上限
+        while self.bytes > self.capacity && self.lru.len() > 1 {
+            if let Some(evicted) = self.lru.pop_front() {
+                if let Some(old) = self.entries.remove(&evicted) {
+                    self.bytes -= old.byte_len();
+                }
+            }
+        }
+        metrics::global().set_gauge("viewer.prefetch.cache_bytes", self.bytes as i64);
+    }
+
+    fn clear(&mut self) {
+        self.entries.clear();
+        self.lru.clear();
+        self.bytes = 0;
+    }
+}
+
+struct State {
+    order: Vec<PathBuf>,
+    current: usize,
+    /// 最近一次移动的方向：1 向后，-1 向前，0 未知
+    direction: i32,
+    /// 待解码的路径，按优先级排列
+    queue: VecDeque<PathBuf>,
+    /// 正在解码的路径及其取消标志
+    in_flight: HashMap<PathBuf, Arc<AtomicBool>>,
+    /// 解码失败的路径，重设顺序前不再预取
+    failed: HashSet<PathBuf>,
+    cache: RenditionCache,
+    stopped: bool,
+}
+
+impl State {
+    /// 预取窗口内的索引，按优先级排列：当前、浏览方向上的 1..=radius、反方向的 1..=radius。
+    /// 方向未知时两侧交替。
+    fn window(&self, radius: usize) -> Vec<usize> {
+        let len = self.order.len();
+        if len == 0 {
+            return Vec::new();
+        }
+        let current = self.current as isize;
+        let mut offsets = vec![0isize];
+        if self.direction == 0 {
+            for d in 1..=radius as isize {
+                offsets.push(d);
+                offsets.push(-d);
+            }
+        } else {
+            let dir = self.direction as isize;
+            offsets.extend((1..=radius as isize).map(|d| d * dir));
+            offsets.extend((1..=radius as isize).map(|d| -d * dir));
+        }
+        offsets
+            .into_iter()
+            .map(|d| current + d)
+            .filter(|&i| i >= 0 && (i as usize) < len)
+            .map(|i| i as usize)
+            .collect()
+    }
+}
+
+struct Shared {
+    options: PrefetchOptions,
+    decode: Box<DecodeFn>,
+    state: Mutex<State>,
+    /// 有新任务或停止时唤醒解码线程
+    work: Condvar,
+    /// 有解码任务结束时唤醒等待中的 `get`
+    done: Condvar,
+}
+
+impl Shared {
+    fn lock(&self) -> MutexGuard<'_, State> {
+        self.state.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// 根据当前位置和方向重建待解码队列，取消离开窗口的解码任务，
+    /// 恢复重新回到窗口的解码任务
+    fn schedule(&self, state: &mut State) {
+        let window: Vec<PathBuf> = state
+            .window(self.options.radius)
+            .into_iter()
+            .map(|i| state.order[i].clone())
+            .collect();
+        let in_window: HashSet<&PathBuf> = window.iter().collect();
+
+        let (mut cancelled, mut resumed) = (0u64, 0u64);
+        for (path, flag) in &state.in_flight {
+            let wanted = in_window.contains(path);
+            if flag.swap(!wanted, Ordering::Relaxed) == wanted {
+                if wanted {
+                    resumed += 1;
+                } else {
+                    cancelled += 1;
+                }
+            }
+        }
+        if cancelled > 0 {
+            metrics::global().incr("viewer.prefetch.cancelled", cancelled);
+        }
+        if resumed > 0 {
+            metrics::global().incr("viewer.prefetch.resumed", resumed);
+        }
+
+        // 低优先级先 touch，当前照片最后 touch，淘汰时最后才轮到它
+        for path in window.iter().rev() {
+            if state.cache.contains(path) {
+                state.cache.touch(path);
+            }
+        }
+
+        state.queue = window
+            .iter()
+            .filter(|p| !state.cache.contains(p) && !state.in_flight.contains_key(*p) && !state.failed.contains(*p))
+            .cloned()
+            .collect();
+        if !state.queue.is_empty() {
+            self.work.notify_all();
+        }
+    }
+
+    fn worker_loop(&self) {
+        loop {
+            let (path, flag) = {
+                let mut state = self.lock();
+                loop {
+                    if state.stopped {
+                        return;
+                    }
+                    if let Some(path) = state.queue.pop_front() {
+                        if state.cache.contains(&path) || state.in_flight.contains_key(&path) {
+                            continue;
+                        }
+                        let flag = Arc::new(AtomicBool::new(false));
+                        state.in_flight.insert(path.clone(), flag.clone());
+                        break (path, flag);
+                    }
+                    state = self.work.wait(state).unwrap_or_else(|e| e.into_inner());
+                }
+            };
+
+            let start = Instant::now();
+            // 记录解码是否看到过取消：看到后提前返回的错误不算解码失败
+            let saw_cancel = Cell::new(false);
+            let result = (self.decode)(&path, self.options.max_dimension, &|| {
+                let cancelled = flag.load(Ordering::Relaxed);
+                saw_cancel.set(saw_cancel.get() || cancelled);
+                cancelled
+            });
+
+            let mut state = self.lock();
+            state.in_flight.remove(&path);
+            let cancelled = flag.load(Ordering::Relaxed);
+            if cancelled || (saw_cancel.get() && result.is_err()) {
+                metrics::global().incr("viewer.prefetch.discarded", 1);
+                // 解码已放弃但照片又回到了窗口，重新排队
+                if !cancelled {
+                    self.schedule(&mut state);
+                }
+            } else {
+                match result {
+                    Ok(rendition) => {
+                        metrics::global().record("viewer.prefetch.decode", start.elapsed());
+                        state.cache.insert(path, Arc::new(rendition));
+                    }
+                    Err(e) => {
+                        tracing::debug!("预取解码失败 {:?}: {}", path, e);
+                        state.failed.insert(path);
+                    }
+                }
+            }
+            drop(state);
+            self.done.notify_all();
+        }
+    }
+}
+
+/// 全屏查看器预取器
+pub struct ViewerPrefetcher {
+    shared: Arc<Shared>,
+    workers: Vec<JoinHandle<()>>,
+}
+
+impl ViewerPrefetcher {
+    pub fn new(options: PrefetchOptions) -> Self {
+        Self::with_decoder(options, Box::new(decode_display))
+    }
+
+    fn with_decoder(options: PrefetchOptions, decode: Box<DecodeFn>) -> Self {
+        let threads = options.threads.max(1);
+        let shared = Arc::new(Shared {
+            state: Mutex::new(State {
+                order: Vec::new(),
+                current: 0,
+                direction: 0,
+                queue: VecDeque::new(),
+                in_flight: HashMap::new(),
+                failed: HashSet::new(),
+                cache: RenditionCache::new(options.cache_bytes),
+                stopped: false,
+            }),
+            options,
+            decode,
+            work: Condvar::new(),
+            done: Condvar::new(),
+        });
+
+        let workers = (0..threads)
+            .map(|i| {
+                let shared = shared.clone();
+                thread::Builder::new()
+                    .name(format!("viewer-prefetch-{}", i))
+                    .spawn(move || shared.worker_loop())
+                    .expect("failed to spawn prefetch worker")
+            })
+            .collect();
+
+        Self { shared, workers }
+    }
+
+    /// 设置浏览顺序和当前位置
+    ///
+    /// 仍在新顺序中的缓存保留，其余淘汰。
+    pub fn set_order(&self, order: Vec<PathBuf>, current: usize) {
+        let mut state = self.shared.lock();
+        let keep: HashSet<&PathBuf> = order.iter().collect();
+        let stale: Vec<PathBuf> = state.cache.entries.keys().filter(|p| !keep.contains(p)).cloned().collect();
+        if stale.len() == state.cache.entries.len() {
+            state.cache.clear();
+        } else {
+            for path in stale {
+                if let Some(old) = state.cache.entries.remove(&path) {
+                    state.cache.bytes -= old.byte_len();
+                }
+                state.cache.lru.retain(|p| p != &path);
+            }
+        }
+        state.current = current.min(order.len().saturating_sub(1));
+        state.order = order;
+        state.direction = 0;
+        state.failed.clear();
+        self.shared.schedule(&mut state);
+    }
+
+    /// 移动到 `index`，按移动方向重新安排预取
+    pub fn navigate(&self, index: usize) {
+        let mut state = self.shared.lock();
+        if state.order.is_empty() {
+            return;
+        }
+        let index = index.min(state.order.len() - 1);
+        let direction = (index as isize - state.current as isize).signum() as i32;
+        // 窗口两侧各 radius 张，方向只决定先后：反转后原方向上的照片仍在窗口内，
+        // 排到新方向之后。schedule 按新窗口重建队列，离开窗口的任务随之丢弃或取消
+        if direction != 0 {
+            state.direction = direction;
+        }
+        state.current = index;
+        self.shared.schedule(&mut state);
+    }
+
+    /// 取 `index` 处照片的显示版本
+    ///
+    /// 已缓存时立即返回；`wait` 为 false 且未缓存时返回 `None`；
+    /// `wait` 为 true 时等待正在进行的预取，或在调用线程上直接解码。
+    pub fn get(&self, index: usize, wait: bool) -> AppResult<Option<Arc<Rendition>>> {
+        let mut state = self.shared.lock();
+        let path = match state.order.get(index) {
+            Some(path) => path.clone(),
+            None => return Err(AppError::General(format!("index {} out of range", index))),
+        };
+
+        loop {
+            if let Some(rendition) = state.cache.get(&path) {
+                metrics::global().incr("viewer.prefetch.hit", 1);
+                return Ok(Some(rendition));
+            }
+            if !wait {
+                metrics::global().incr("viewer.prefetch.miss", 1);
+                return Ok(None);
+            }
+            match state.in_flight.get(&path) {
+                Some(flag) if !flag.load(Ordering::Relaxed) => {
+                    state = self.shared.done.wait(state).unwrap_or_else(|e| e.into_inner());
+                }
+                _ => break,
+            }
+        }
+
+        // 未在预取中（或已取消）：在调用线程上解码，并登记为进行中，避免解码线程重复解码
+        metrics::global().incr("viewer.prefetch.miss", 1);
+        let registered = !state.in_flight.contains_key(&path);
+        if registered {
+            state.in_flight.insert(path.clone(), Arc::new(AtomicBool::new(false)));
+            state.queue.retain(|p| p != &path);
+        }
+        drop(state);
+        let result = (self.shared.decode)(&path, self.shared.options.max_dimension, &|| false);
+
+        let mut state = self.shared.lock();
+        if registered {
+            state.in_flight.remove(&path);
+        }
+        let rendition = match result {
+            Ok(rendition) => Arc::new(rendition),
+            Err(e) => {
+                drop(state);
+                self.shared.done.notify_all();
+                return Err(e);
+            }
+        };
+        state.failed.remove(&path);
+        state.cache.insert(path, rendition.clone());
+        drop(state);
+        self.shared.done.notify_all();
+        Ok(Some(rendition))
+    }
+
+    /// 已缓存的字节数
+    pub fn cached_bytes(&self) -> usize {
+        self.shared.lock().cache.bytes
+    }
+}
+
+impl Drop for ViewerPrefetcher {
+    fn drop(&mut self) {
+        self.shared.lock().stopped = true;
+        self.shared.work.notify_all();
+        for worker in self.workers.drain(..) {
+            let _ = worker.join();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::AtomicUsize;
+    use std::sync::{mpsc, Barrier};
+    use std::time::Duration;
+
+    fn paths(n: usize) -> Vec<PathBuf> {
+        (0..n).map(|i| PathBuf::from(format!("photo-{}.jpg", i))).collect()
+    }
+
+    fn index_of(path: &Path) -> usize {
+        path.to_string_lossy()
+            .trim_start_matches("photo-")
+            .trim_end_matches(".jpg")
+            .parse()
+            .unwrap()
+    }
+
+    fn fake_decoder(delay: Duration, decoded: Arc<Mutex<Vec<usize>>>) -> Box<DecodeFn> {
+        Box::new(move |path: &Path, _max: u32, _cancelled: &dyn Fn() -> bool| {
+            thread::sleep(delay);
+            decoded.lock().unwrap().push(index_of(path));
+            Ok(Rendition {
+                width: 2,
+                height: 2,
+                pixels: vec![index_of(path) as u8; 16],
+            })
+        })
+    }
+
+    fn wait_cached(prefetcher: &ViewerPrefetcher, indices: impl Iterator<Item = usize> + Clone) {
+        for _ in 0..1000 {
+            if indices.clone().all(|i| prefetcher.get(i, false).unwrap().is_some()) {
+                return;
+            }
+            thread::sleep(Duration::from_millis(2));
+        }
+        panic!("prefetch did not finish");
+    }
+
+    #[test]
+    fn test_window_follows_direction() {
+        let mut state = State {
+            order: paths(10),
+            current: 5,
+            direction: 1,
+            queue: VecDeque::new(),
+            in_flight: HashMap::new(),
+            failed: HashSet::new(),
+            cache: RenditionCache::new(usize::MAX),
+            stopped: false,
+        };
+        assert_eq!(state.window(2), vec![5, 6, 7, 4, 3]);
+        state.direction = -1;
+        assert_eq!(state.window(2), vec![5, 4, 3, 6, 7]);
+        state.direction = 0;
+        state.current = 0;
+        assert_eq!(state.window(2), vec![0, 1, 2]);
+    }
+
+    #[test]
+    fn test_prefetches_neighbours_and_serves_from_cache() {
+        let decoded = Arc::new(Mutex::new(Vec::new()));
+        let options = PrefetchOptions {
+            radius: 2,
+            threads: 1,
+            ..Default::default()
+        };
+        let prefetcher = ViewerPrefetcher::with_decoder(options, fake_decoder(Duration::ZERO, decoded.clone()));
+
+        prefetcher.set_order(paths(10), 4);
+        wait_cached(&prefetcher, 2..=6);
+        let mut seen = decoded.lock().unwrap().clone();
+        seen.sort();
+        assert_eq!(seen, vec![2, 3, 4, 5, 6]);
+
+        let rendition = prefetcher.get(5, false).unwrap().expect("neighbour should be cached");
+        assert_eq!(rendition.pixels[0], 5);
+        assert!(prefetcher.get(9, false).unwrap().is_none());
+        assert_eq!(prefetcher.get(9, true).unwrap().unwrap().pixels[0], 9);
+    }
+
+    #[test]
+    fn test_cache_is_bounded() {
+        let decoded = Arc::new(Mutex::new(Vec::new()));
+        let options = PrefetchOptions {
+            radius: 1,
+            threads: 1,
+            cache_bytes: 3 * 16,
+            ..Default::default()
+        };
+        let prefetcher = ViewerPrefetcher::with_decoder(options, fake_decoder(Duration::ZERO, decoded));
+
+        prefetcher.set_order(paths(20), 0);
+        for i in 1..20 {
+            prefetcher.navigate(i);
+            prefetcher.get(i, true).unwrap();
+            assert!(prefetcher.cached_bytes() <= 3 * 16);
+        }
+        // 当前照片总是最近使用的，不会被淘汰
+        assert!(prefetcher.get(19, false).unwrap().is_some());
+    }
+
+    #[test]
+    fn test_direction_change_cancels_stale_work() {
+        // 第一个前方照片（51）开始解码后停在屏障上，直到测试线程完成反向跳转
+        let (started_tx, started_rx) = mpsc::channel();
+        let started_tx = Mutex::new(started_tx);
+        let barrier = Arc::new(Barrier::new(2));
+        let trapped = AtomicBool::new(false);
+        let cancelled = Arc::new(AtomicUsize::new(0));
+        let (b, c) = (barrier.clone(), cancelled.clone());
+        let decoder: Box<DecodeFn> = Box::new(move |path: &Path, _max: u32, is_cancelled: &dyn Fn() -> bool| {
+            let index = index_of(path);
+            started_tx.lock().unwrap().send(index).unwrap();
+            if index > 50 && !trapped.swap(true, Ordering::SeqCst) {
+                b.wait();
+                if is_cancelled() {
+                    c.fetch_add(1, Ordering::SeqCst);
+                }
+            }
+            // 无论是否取消都返回成功：结果能否进入缓存完全取决于预取器是否丢弃它
+            Ok(Rendition {
+                width: 1,
+                height: 1,
+                pixels: vec![index as u8; 4],
+            })
+        });
+        let options = PrefetchOptions {
+            radius: 3,
+            threads: 1,
+            ..Default::default()
+        };
+        let prefetcher = ViewerPrefetcher::with_decoder(options, decoder);
+
+        prefetcher.set_order(paths(100), 50);
+        assert_eq!(started_rx.recv().unwrap(), 50);
+        assert_eq!(started_rx.recv().unwrap(), 51);
+        // 向前浏览时 51 仍在窗口内，不取消
+        prefetcher.navigate(51);
+        prefetcher.navigate(52);
+        // 反向跳回：正在解码的 51 已不在新窗口内
+        prefetcher.navigate(40);
+        barrier.wait();
+
+        prefetcher.get(40, true).unwrap();
+        wait_cached(&prefetcher, 37..=43);
+
+        assert_eq!(cancelled.load(Ordering::SeqCst), 1);
+        // 被取消的结果没有进入缓存
+        assert!(prefetcher.get(51, false).unwrap().is_none());
+        // 跳转后离开窗口、尚未开始的任务（52..=55）不再解码
+        let later: Vec<usize> = started_rx.try_iter().collect();
+        assert!(later.iter().all(|i| (37..=43).contains(i)), "{:?}", later);
+    }
+
+    #[test]
+    fn test_reentering_window_resumes_cancelled_work() {
+        // 51 的第一次解码与测试线程逐步同步：离开窗口后看到取消并放弃，
+        // 返回前照片又回到窗口
+        let (started_tx, started_rx) = mpsc::channel();
+        let started_tx = Mutex::new(started_tx);
+        let step = Arc::new(Barrier::new(2));
+        let attempts = Arc::new(AtomicUsize::new(0));
+        let (b, n) = (step.clone(), attempts.clone());
+        let decoder: Box<DecodeFn> = Box::new(move |path: &Path, _max: u32, is_cancelled: &dyn Fn() -> bool| {
+            let index = index_of(path);
+            if index == 51 && n.fetch_add(1, Ordering::SeqCst) == 0 {
+                started_tx.lock().unwrap().send(index).unwrap();
+                b.wait();
+                assert!(is_cancelled());
+                b.wait();
+                b.wait();
+                return Err(AppError::General("prefetch cancelled".to_string()));
+            }
+            Ok(Rendition {
+                width: 1,
+                height: 1,
+                pixels: vec![index as u8; 4],
+            })
+        });
+        let options = PrefetchOptions {
+            radius: 1,
+            threads: 1,
+            ..Default::default()
+        };
+        let prefetcher = ViewerPrefetcher::with_decoder(options, decoder);
+
+        prefetcher.set_order(paths(100), 50);
+        assert_eq!(started_rx.recv().unwrap(), 51);
+        prefetcher.navigate(10);
+        step.wait();
+        step.wait();
+        prefetcher.navigate(50);
+        step.wait();
+
+        // 放弃的解码不记为失败，重新排队后解码成功
+        wait_cached(&prefetcher, 49..=51);
+        assert_eq!(attempts.load(Ordering::SeqCst), 2);
+        assert_eq!(prefetcher.get(51, false).unwrap().unwrap().pixels[0], 51);
+    }
+}
@@ -0,0 +1,444 @@
+//! 颜色签名（主色调色板 + 颜色直方图嵌入）
+//!
+//! 由缩略图小图采样数千个像素，在 CIE Lab 空间计算：
+//! - 调色板：k-means 聚类得到最多 5 个主色及其占比，供界面展示
+//! - 嵌入向量：4x4x4 的 Lab 软直方图，每格取平方根后量化为 u8（Hellinger 嵌入），
+//!   两个嵌入的 L1 距离即颜色分布差异，可整库暴力比较
+//!
+//! 两者打包为一个二进制列：
+//! `[版本 1][颜色数 n][n x (R, G, B, 占比)][64 字节嵌入]`
+
+use std::sync::OnceLock;
+
+/// 嵌入向量维数（L、a、b 各 4 格）
+pub const EMBEDDING_DIM: usize = 64;
+/// 调色板最大颜色数
+pub const MAX_PALETTE_COLORS: usize = 5;
+
+/// 签名格式版本
+const SIGNATURE_VERSION: u8 = 1;
+/// 最多采样的像素数
+const MAX_SAMPLES: usize = 4096;
+/// k-means 最大迭代次数
+const KMEANS_ITERATIONS: usize = 10;
+/// 每轴格数
+const BINS: usize = 4;
+/// a / b 轴参与分格的范围（超出部分归入两端格子）
+const AB_RANGE: f32 = 48.0;
+
+/// 颜色嵌入向量
+pub type ColorEmbedding = [u8; EMBEDDING_DIM];
+
+/// 调色板中的一个颜色
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct PaletteColor {
+    pub rgb: [u8; 3],
+    /// 占比（0-1）
+    pub weight: f32,
+}
+
+impl PaletteColor {
+    /// `#rrggbb` 形式
+    pub fn hex(&self) -> String {
+        format!("#{:02x}{:02x}{:02x}", self.rgb[0], self.rgb[1], self.rgb[2])
+    }
+
+    /// 解析 `#rrggbb` 或 `rrggbb`
+    pub fn parse_hex(s: &str, weight: f32) -> Option<Self> {
+        let s = s.trim().trim_start_matches('#');
+        if s.len() != 6 || !s.is_ascii() {
+            return None;
+        }
+        let channel = |i: usize| u8::from_str_radix(&s[i..i + 2], 16).ok();
+        Some(Self {
+            rgb: [channel(0)?, channel(2)?, channel(4)?],
+            weight,
+        })
+    }
+}
+
+/// 一张图片的颜色签名
+#[derive(Debug, Clone, PartialEq)]
+pub struct ColorSignature {
+    /// 主色，按占比降序
+    pub palette: Vec<PaletteColor>,
+    pub embedding: ColorEmbedding,
+}
+
+impl ColorSignature {
+    /// 打包为二进制
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let count = self.palette.len().min(MAX_PALETTE_COLORS);
+        let mut bytes = Vec::with_capacity(2 + count * 4 + EMBEDDING_DIM);
+        bytes.push(SIGNATURE_VERSION);
+        bytes.push(count as u8);
+        for color in &self.palette[..count] {
+            bytes.extend_from_slice(&color.rgb);
+            bytes.push((color.weight.clamp(0.0, 1.0) * 255.0).round() as u8);
+        }
+        bytes.extend_from_slice(&self.embedding);
+        bytes
+    }
+
+    /// 从二进制解包，格式不符时返回 None
+    pub fn from_bytes(bytes: &[u8]) -> Option<Self> {
+        let (&version, rest) = bytes.split_first()?;
+        let (&count, rest) = rest.split_first()?;
+        let count = count as usize;
+        if version != SIGNATURE_VERSION || count > MAX_PALETTE_COLORS || rest.len() != count * 4 + EMBEDDING_DIM {
+            return None;
+        }
+
+        let (palette_bytes, embedding_bytes) = rest.split_at(count * 4);
+        let palette = palette_bytes
+            .chunks_exact(4)
+            .map(|c| PaletteColor {
+                rgb: [c[0], c[1], c[2]],
+                weight: c[3] as f32 / 255.0,
+            })
+            .collect();
+        let mut embedding = [0u8; EMBEDDING_DIM];
+        embedding.copy_from_slice(embedding_bytes);
+
+        Some(Self { palette, embedding })
+    }
+}
+
+/// 两个嵌入的 L1 距离（0 表示颜色分布相同）
+///
+/// 逐字节绝对差求和，编译器可直接生成 SSE2 `psadbw` / NEON `uabal` 向量指令。
+#[inline]
+pub fn embedding_distance(a: &ColorEmbedding, b: &ColorEmbedding) -> u32 {
+    a.iter().zip(b.iter()).map(|(&x, &y)| x.abs_diff(y) as u32).sum()
+}
+
+/// 由 RGBA 像素计算颜色签名
+///
+/// `rgba` 为按行存储的 `width * height * 4` 字节，透明度不参与计算。
+pub fn rgba_to_color_signature(width: usize, height: usize, rgba: &[u8]) -> Option<ColorSignature> {
+    let total = width * height;
+    if total == 0 || rgba.len() < total * 4 {
+        return None;
+    }
+
+    // 等间距采样，像素数不多时全部使用
+    let step = total.div_ceil(MAX_SAMPLES);
+    let samples: Vec<[f32; 3]> = rgba[..total * 4]
+        .chunks_exact(4)
+        .step_by(step)
+        .map(|p| srgb_to_lab([p[0], p[1], p[2]]))
+        .collect();
+
+    let palette = kmeans_palette(&samples);
+    let weighted = samples.iter().map(|&lab| (lab, 1.0));
+    let embedding = histogram_embedding(weighted);
+
+    Some(ColorSignature { palette, embedding })
+}
+
+/// 由调色板构造嵌入向量（用于按颜色搜索）
+///
+/// 各颜色按占比计入直方图；占比全为 0 时按等权处理。
+pub fn palette_to_embedding(palette: &[PaletteColor]) -> Option<ColorEmbedding> {
+    if palette.is_empty() {
+        return None;
+    }
+    let uniform = palette.iter().all(|c| c.weight <= 0.0);
+    let weighted = palette
+        .iter()
+        .map(|c| (srgb_to_lab(c.rgb), if uniform { 1.0 } else { c.weight.max(0.0) }));
+    Some(histogram_embedding(weighted))
+}
+
+/// sRGB 到线性值的查找表
+fn srgb_to_linear_table() -> &'static [f32; 256] {
+    static TABLE: OnceLock<[f32; 256]> = OnceLock::new();
+    TABLE.get_or_init(|| {
+        let mut table = [0f32; 256];
+        for (i, v) in table.iter_mut().enumerate() {
+            let c = i as f32 / 255.0;
+            *v = if c <= 0.04045 {
+                c / 12.92
+            } else {
+                ((c + 0.055) / 1.055).powf(2.4)
+            };
+        }
+        table
+    })
+}
+
+/// sRGB (D65) 转 CIE Lab
+fn srgb_to_lab(rgb: [u8; 3]) -> [f32; 3] {
+    let table = srgb_to_linear_table();
+    let (r, g, b) = (table[rgb[0] as usize], table[rgb[1] as usize], table[rgb[2] as usize]);
+
+    // 已按 D65 白点归一化的 XYZ
+    let x = (0.4124 * r + 0.3576 * g + 0.1805 * b) / 0.95047;
+    let y = 0.2126 * r + 0.7152 * g + 0.0722 * b;
+    let z = (0.0193 * r + 0.1192 * g + 0.9505 * b) / 1.08883;
+
+    let f = |t: f32| {
+        if t > 0.008_856 {
+            t.cbrt()
+        } else {
+            7.787 * t + 16.0 / 116.0
+        }
+    };
+    let (fx, fy, fz) = (f(x), f(y), f(z));
+    [116.0 * fy - 16.0, 500.0 * (fx - fy), 200.0 * (fy - fz)]
+}
+
+/// CIE Lab 转 sRGB (D65)
+fn lab_to_srgb(lab: [f32; 3]) -> [u8; 3] {
+    let fy = (lab[0] + 16.0) / 116.0;
+    let fx = fy + lab[1] / 500.0;
+    let fz = fy - lab[2] / 200.0;
+    let f_inv = |t: f32| {
+        if t > 0.206_893 {
+            t * t * t
+        } else {
+            (t - 16.0 / 116.0) / 7.787
+        }
+    };
+    let (x, y, z) = (f_inv(fx) * 0.95047, f_inv(fy), f_inv(fz) * 1.08883);
+
+    let r = 3.2406 * x - 1.5372 * y - 0.4986 * z;
+    let g = -0.9689 * x + 1.8758 * y + 0.0415 * z;
+    let b = 0.0557 * x - 0.2040 * y + 1.0570 * z;
+
+    let encode = |c: f32| {
+        let c = c.clamp(0.0, 1.0);
+        let v = if c <= 0.003_130_8 {
+            12.92 * c
+        } else {
+            1.055 * c.powf(1.0 / 2.4) - 0.055
+        };
+        (v * 255.0).round() as u8
+    };
+    [encode(r), encode(g), encode(b)]
+}
+
+#[inline]
+fn lab_distance_sq(a: &[f32; 3], b: &[f32; 3]) -> f32 {
+    let (dl, da, db) = (a[0] - b[0], a[1] - b[1], a[2] - b[2]);
+    dl * dl + da * da + db * db
+}
+
+/// k-means 聚类，返回按占比降序的主色
+///
+/// 初始中心用 k-means++ 选取，随机数由固定种子生成，同一张图结果稳定。
+fn kmeans_palette(samples: &[[f32; 3]]) -> Vec<PaletteColor> {
+    if samples.is_empty() {
+        return Vec::new();
+    }
+
+    let mut rng = 0x853C_49E6_748F_EA9Bu64;
+    let mut next_unit = || {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        (rng >> 40) as f32 / (1u64 << 24) as f32
+    };
+
+    let mut centers = vec![samples[0]];
+    let mut nearest: Vec<f32> = samples.iter().map(|s| lab_distance_sq(s, &samples[0])).collect();
+    while centers.len() < MAX_PALETTE_COLORS {
+        let total: f32 = nearest.iter().sum();
+        // 剩余样本都与已有中心重合（颜色数不足 k）
+        if total <= f32::EPSILON {
+            break;
+        }
+        let mut target = next_unit() * total;
+        let mut chosen = samples.len() - 1;
+        for (i, d) in nearest.iter().enumerate() {
+            target -= d;
+            if target <= 0.0 {
+                chosen = i;
+                break;
+            }
+        }
+        let center = samples[chosen];
+        for (d, s) in nearest.iter_mut().zip(samples) {
+            *d = d.min(lab_distance_sq(s, &center));
+        }
+        centers.push(center);
+    }
+
+    let k = centers.len();
+    let mut assignment = vec![0usize; samples.len()];
+    let mut counts = vec![0usize; k];
+    for iteration in 0..KMEANS_ITERATIONS {
+        let mut changed = false;
+        for (a, s) in assignment.iter_mut().zip(samples) {
+            let best = (0..k)
+                .min_by(|&i, &j| lab_distance_sq(s, &centers[i]).total_cmp(&lab_distance_sq(s, &centers[j])))
+                .unwrap_or(0);
+            if *a != best {
+                *a = best;
+                changed = true;
+            }
+        }
+        if iteration > 0 && !changed {
+            break;
+        }
+
+        let mut sums = vec![[0f32; 3]; k];
+        counts.iter_mut().for_each(|c| *c = 0);
+        for (&a, s) in assignment.iter().zip(samples) {
+            counts[a] += 1;
+            for c in 0..3 {
+                sums[a][c] += s[c];
+            }
+        }
+        for ((center, sum), &count) in centers.iter_mut().zip(&sums).zip(&counts) {
+            if count > 0 {
+                *center = [sum[0] / count as f32, sum[1] / count as f32, sum[2] / count as f32];
+            }
+        }
+    }
+
+    let mut palette: Vec<PaletteColor> = centers
+        .iter()
+        .zip(&counts)
+        .filter(|(_, &count)| count > 0)
+        .map(|(center, &count)| PaletteColor {
+            rgb: lab_to_srgb(*center),
+            weight: count as f32 / samples.len() as f32,
+        })
+        .collect();
+    palette.sort_by(|a, b| b.weight.total_cmp(&a.weight));
+    palette
+}
+
+/// 格子坐标：返回下界格子序号和落入上一格的比例（软分配）
+#[inline]
+fn bin_position(value: f32, min: f32, max: f32) -> (usize, f32) {
+    let t = ((value - min) / (max - min)).clamp(0.0, 1.0) * BINS as f32 - 0.5;
+    if t <= 0.0 {
+        return (0, 0.0);
+    }
+    if t >= (BINS - 1) as f32 {
+        return (BINS - 1, 0.0);
+    }
+    let lower = t.floor();
+    (lower as usize, t - lower)
+}
+
+/// 由带权 Lab 颜色生成软直方图嵌入
+///
+/// 每个颜色按三线性插值分配到相邻格子，避免颜色落在格子边界附近时嵌入跳变。
+fn histogram_embedding(colors: impl Iterator<Item = ([f32; 3], f32)>) -> ColorEmbedding {
+    let mut histogram = [0f32; EMBEDDING_DIM];
+    for (lab, weight) in colors {
+        let axes = [
+            bin_position(lab[0], 0.0, 100.0),
+            bin_position(lab[1], -AB_RANGE, AB_RANGE),
+            bin_position(lab[2], -AB_RANGE, AB_RANGE),
+        ];
+        for corner in 0..8 {
+            let mut index = 0;
+            let mut w = weight;
+            for (axis, &(lower, frac)) in axes.iter().enumerate() {
+                let upper = corner >> axis & 1 == 1;
+                if upper && frac == 0.0 {
+                    w = 0.0;
+                    break;
+                }
+                index = index * BINS + lower + upper as usize;
+                w *= if upper { frac } else { 1.0 - frac };
+            }
+            if w > 0.0 {
+                histogram[index] += w;
+            }
+        }
+    }
+
+    let total: f32 = histogram.iter().sum();
+    let mut embedding = [0u8; EMBEDDING_DIM];
+    if total > 0.0 {
+        for (e, h) in embedding.iter_mut().zip(&histogram) {
+            *e = ((h / total).sqrt() * 255.0).round() as u8;
+        }
+    }
+    embedding
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn solid_blocks(width: usize, height: usize, colors: &[[u8; 3]]) -> Vec<u8> {
+        let mut rgba = Vec::with_capacity(width * height * 4);
+        for _ in 0..height {
+            for x in 0..width {
+                let c = colors[x * colors.len() / width];
+                rgba.extend_from_slice(&[c[0], c[1], c[2], 255]);
+            }
+        }
+        rgba
+    }
+
+    #[test]
+    fn test_lab_round_trip() {
+        for rgb in [[0u8, 0, 0], [255, 255, 255], [200, 30, 40], [20, 120, 230], [128, 128, 128]] {
+            let back = lab_to_srgb(srgb_to_lab(rgb));
+            for c in 0..3 {
+                assert!(back[c].abs_diff(rgb[c]) <= 1, "{:?} -> {:?}", rgb, back);
+            }
+        }
+    }
+
+    #[test]
+    fn test_palette_finds_block_colors() {
+        let red = [220, 30, 30];
+        let blue = [30, 60, 200];
+        // 红色占 3/4，蓝色占 1/4
+        let rgba = solid_blocks(80, 60, &[red, red, red, blue]);
+        let signature = rgba_to_color_signature(80, 60, &rgba).unwrap();
+
+        assert_eq!(signature.palette.len(), 2);
+        assert_eq!(signature.palette[0].rgb, red);
+        assert_eq!(signature.palette[1].rgb, blue);
+        assert!((signature.palette[0].weight - 0.75).abs() < 0.01);
+    }
+
+    #[test]
+    fn test_similar_images_are_closer() {
+        let beach = rgba_to_color_signature(60, 40, &solid_blocks(60, 40, &[[90, 170, 230], [230, 210, 160]])).unwrap();
+        let beach2 = rgba_to_color_signature(60, 40, &solid_blocks(60, 40, &[[80, 160, 235], [225, 205, 150]])).unwrap();
+        let forest = rgba_to_color_signature(60, 40, &solid_blocks(60, 40, &[[30, 90, 40], [60, 50, 30]])).unwrap();
+
+        let near = embedding_distance(&beach.embedding, &beach2.embedding);
+        let far = embedding_distance(&beach.embedding, &forest.embedding);
+        assert!(near * 3 < far, "near={} far={}", near, far);
+
+        // 按调色板搜索与整图签名处于同一嵌入空间
+        let query = palette_to_embedding(&beach.palette).unwrap();
+        assert!(embedding_distance(&query, &beach2.embedding) < embedding_distance(&query, &forest.embedding));
+    }
+
+    #[test]
+    fn test_pack_round_trip() {
+        let rgba = solid_blocks(50, 50, &[[10, 20, 30], [200, 100, 50], [90, 90, 90]]);
+        let signature = rgba_to_color_signature(50, 50, &rgba).unwrap();
+        let bytes = signature.to_bytes();
+        assert_eq!(bytes.len(), 2 + signature.palette.len() * 4 + EMBEDDING_DIM);
+
+        let unpacked = ColorSignature::from_bytes(&bytes).unwrap();
+        assert_eq!(unpacked.embedding, signature.embedding);
+        assert_eq!(unpacked.palette.len(), signature.palette.len());
+        assert_eq!(unpacked.palette[0].rgb, signature.palette[0].rgb);
+
+        assert!(ColorSignature::from_bytes(&bytes[..bytes.len() - 1]).is_none());
+        assert!(ColorSignature::from_bytes(&[]).is_none());
+    }
+
+    #[test]
+    fn test_parse_hex() {
+        let color = PaletteColor::parse_hex("#1E90ff", 0.5).unwrap();
+        assert_eq!(color.rgb, [0x1e, 0x90, 0xff]);
+        assert_eq!(color.hex(), "#1e90ff");
+        assert!(PaletteColor::parse_hex("#12345", 1.0).is_none());
+        assert!(PaletteColor::parse_hex("zzzzzz", 1.0).is_none());
+    }
+}
@@ -0,0 +1,228 @@
+//! 图像质量评分（清晰度 / 曝光裁切 / 噪点）
+//!
+//! 在缩略图生成时由小尺寸代理图计算，用于连拍筛选：
+//! - 清晰度：灰度图 4 邻域拉普拉斯响应的方差，越大越清晰
+//! - 高光 / 暗部裁切：RGB 最大通道不低于 250 / 不高于 5 的像素比例
+//! - 噪点：Immerkær 快速噪声估计，输出灰度标准差（0-255 刻度）
+//!
+//! 各分数依赖代理图尺寸，只适合在同一批照片间相对比较。
+
+/// 代理图最长边，所有输入都先重采样到此尺寸再计算
+pub const QUALITY_PROXY_DIMENSION: u32 = 256;
+/// 代理图最长边下限，更小的图（如 Tiny 缩略图）不计算
+pub const QUALITY_MIN_DIMENSION: u32 = 128;
+
+/// 高光裁切阈值（RGB 最大通道）
+const HIGHLIGHT_CLIP: u8 = 250;
+/// 暗部裁切阈值（RGB 最大通道）
+const SHADOW_CLIP: u8 = 5;
+
+/// 一张图片的质量评分
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct QualityScores {
+    /// 拉普拉斯方差
+    pub sharpness: f64,
+    /// 高光裁切像素比例（0-1）
+    pub highlight_clip: f64,
+    /// 暗部裁切像素比例（0-1）
+    pub shadow_clip: f64,
+    /// 噪声标准差估计
+    pub noise: f64,
+}
+
+/// 由 RGBA 像素计算质量评分
+///
+/// `rgba` 为按行存储的 `width * height * 4` 字节。宽或高小于 3 时返回 None。
+pub fn rgba_to_quality_scores(width: usize, height: usize, rgba: &[u8]) -> Option<QualityScores> {
+    if width < 3 || height < 3 || rgba.len() < width * height * 4 {
+        return None;
+    }
+
+    let pixels = &rgba[..width * height * 4];
+    let mut highlights = 0usize;
+    let mut shadows = 0usize;
+    let mut luma = Vec::with_capacity(width * height);
+    for p in pixels.chunks_exact(4) {
+        let max = p[0].max(p[1]).max(p[2]);
+        highlights += (max >= HIGHLIGHT_CLIP) as usize;
+        shadows += (max <= SHADOW_CLIP) as usize;
+        // Rec.601 灰度，与感知哈希一致
+        luma.push((p[0] as f32 * 0.299) + (p[1] as f32 * 0.587) + (p[2] as f32 * 0.114));
+    }
+
+    let interior = ((width - 2) * (height - 2)) as f64;
+    let mut lap_sum = 0f64;
+    let mut lap_sq_sum = 0f64;
+    let mut noise_sum = 0f64;
+    for y in 1..height - 1 {
+        let up = &luma[(y - 1) * width..y * width];
+        let cur = &luma[y * width..(y + 1) * width];
+        let down = &luma[(y + 1) * width..(y + 2) * width];
+
+        let (sum, sq_sum) = laplacian_row(up, cur, down);
+        lap_sum += sum as f64;
+        lap_sq_sum += sq_sum as f64;
+        noise_sum += noise_row(up, cur, down) as f64;
+    }
+
+    let lap_mean = lap_sum / interior;
+    let sharpness = (lap_sq_sum / interior - lap_mean * lap_mean).max(0.0);
+    // Immerkær: sigma = sqrt(pi / 2) * sum|I * N| / (6 (W - 2)(H - 2))
+    let noise = (std::f64::consts::FRAC_PI_2).sqrt() * noise_sum / (6.0 * interior);
+
+    let total = (width * height) as f64;
+    Some(QualityScores {
+        sharpness,
+        highlight_clip: highlights as f64 / total,
+        shadow_clip: shadows as f64 / total,
+        noise,
+    })
+}
+
+/// 一行内部像素的拉普拉斯响应之和与平方和
+///
+/// 核为 `[0 -1 0; -1 4 -1; 0 -1 0]`。邻域按切片错位对齐后逐元素计算，
+/// 拆成 8 路独立累加，编译器可直接生成 SSE/AVX/NEON 向量指令。
+#[inline]
+fn laplacian_row(up: &[f32], cur: &[f32], down: &[f32]) -> (f32, f32) {
+    let n = cur.len() - 2;
+    let (up, down) = (&up[1..=n], &down[1..=n]);
+    let (left, center, right) = (&cur[..n], &cur[1..=n], &cur[2..]);
+
+    let mut sum = [0f32; 8];
+    let mut sq_sum = [0f32; 8];
+    let mut i = 0;
+    while i + 8 <= n {
+        for lane in 0..8 {
+            let k = i + lane;
+            let v = 4.0 * center[k] - left[k] - right[k] - up[k] - down[k];
+            sum[lane] += v;
+            sq_sum[lane] += v * v;
+        }
+        i += 8;
+    }
+    for k in i..n {
+        let v = 4.0 * center[k] - left[k] - right[k] - up[k] - down[k];
+        sum[0] += v;
+        sq_sum[0] += v * v;
+    }
+
+    (sum.iter().sum(), sq_sum.iter().sum())
+}
+
+/// 一行内部像素的 Immerkær 噪声核响应绝对值之和
+///
+/// 核为 `[1 -2 1; -2 4 -2; 1 -2 1]`，两个拉普拉斯之差，对边缘和平滑渐变基本无响应。
+#[inline]
+fn noise_row(up: &[f32], cur: &[f32], down: &[f32]) -> f32 {
+    let n = cur.len() - 2;
+    let kernel = |k: usize| {
+        let corners = up[k] + up[k + 2] + down[k] + down[k + 2];
+        let edges = up[k + 1] + down[k + 1] + cur[k] + cur[k + 2];
+        (corners - 2.0 * edges + 4.0 * cur[k + 1]).abs()
+    };
+
+    let mut sum = [0f32; 8];
+    let mut i = 0;
+    while i + 8 <= n {
+        for (lane, acc) in sum.iter_mut().enumerate() {
+            *acc += kernel(i + lane);
+        }
+        i += 8;
+    }
+    for k in i..n {
+        sum[0] += kernel(k);
+    }
+
+    sum.iter().sum()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn gray_rgba(width: usize, height: usize, f: impl Fn(usize, usize) -> u8) -> Vec<u8> {
+        let mut rgba = Vec::with_capacity(width * height * 4);
+        for y in 0..height {
+            for x in 0..width {
+                let v = f(x, y);
+                rgba.extend_from_slice(&[v, v, v, 255]);
+            }
+        }
+        rgba
+    }
+
+    /// 确定性的伪随机噪声（-amp..=amp）
+    fn noise_at(x: usize, y: usize, amp: i32) -> i32 {
+        let mut z = (x as u64) << 32 | y as u64;
+        z = (z ^ (z >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+        z = (z ^ (z >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+        ((z >> 33) % (2 * amp as u64 + 1)) as i32 - amp
+    }
+
+    #[test]
+    fn test_flat_image() {
+        let scores = rgba_to_quality_scores(64, 48, &gray_rgba(64, 48, |_, _| 128)).unwrap();
+        assert_eq!(scores.sharpness, 0.0);
+        assert_eq!(scores.noise, 0.0);
+        assert_eq!(scores.highlight_clip, 0.0);
+        assert_eq!(scores.shadow_clip, 0.0);
+    }
+
+    #[test]
+    fn test_sharp_edges_score_higher_than_blurred() {
+        let sharp = gray_rgba(67, 50, |x, y| if (x / 6 + y / 6) % 2 == 0 { 40 } else { 210 });
+        // 同一图案做 5x5 均值模糊
+        let blurred = gray_rgba(67, 50, |x, y| {
+            let mut sum = 0u32;
+            let mut count = 0u32;
+            for dy in -2i32..=2 {
+                for dx in -2i32..=2 {
+                    let (sx, sy) = (x as i32 + dx, y as i32 + dy);
+                    if sx >= 0 && sy >= 0 && sx < 67 && sy < 50 {
+                        sum += if (sx / 6 + sy / 6) % 2 == 0 { 40 } else { 210 };
+                        count += 1;
+                    }
+                }
+            }
+            (sum / count) as u8
+        });
+
+        let a = rgba_to_quality_scores(67, 50, &sharp).unwrap();
+        let b = rgba_to_quality_scores(67, 50, &blurred).unwrap();
+        assert!(a.sharpness > b.sharpness * 4.0, "{} vs {}", a.sharpness, b.sharpness);
+    }
+
+    #[test]
+    fn test_noise_estimate_tracks_noise_level() {
+        let gradient = |x: usize, y: usize| (60 + x + y) as i32;
+        let clean = gray_rgba(100, 80, |x, y| gradient(x, y) as u8);
+        let noisy = gray_rgba(100, 80, |x, y| (gradient(x, y) + noise_at(x, y, 12)) as u8);
+
+        let a = rgba_to_quality_scores(100, 80, &clean).unwrap();
+        let b = rgba_to_quality_scores(100, 80, &noisy).unwrap();
+        // 线性渐变对噪声核无响应
+        assert!(a.noise < 0.5, "{}", a.noise);
+        // 均匀分布 [-12, 12] 的标准差约为 7.2
+        assert!(b.noise > 5.0 && b.noise < 10.0, "{}", b.noise);
+    }
+
+    #[test]
+    fn test_clipping_fractions() {
+        // 左侧四分之一过曝，右侧四分之一死黑
+        let rgba = gray_rgba(40, 10, |x, _| match x {
+            0..=9 => 255,
+            30..=39 => 0,
+            _ => 128,
+        });
+        let scores = rgba_to_quality_scores(40, 10, &rgba).unwrap();
+        assert!((scores.highlight_clip - 0.25).abs() < 1e-9);
+        assert!((scores.shadow_clip - 0.25).abs() < 1e-9);
+    }
+
+    #[test]
+    fn test_invalid_input() {
+        assert!(rgba_to_quality_scores(2, 10, &[0u8; 80]).is_none());
+        assert!(rgba_to_quality_scores(10, 10, &[0u8; 100]).is_none());
+    }
+}
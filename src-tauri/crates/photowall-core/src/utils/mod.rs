@@ -2,8 +2,12 @@
 //!
 //! 包含通用工具函数
 
+pub mod color_signature;
 pub mod error;
+pub mod image_quality;
+pub mod perceptual_hash;
 pub mod sanitize;
+pub mod thumbhash;
 
 pub use error::*;
 pub use sanitize::*;
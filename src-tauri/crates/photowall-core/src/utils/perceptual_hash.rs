@@ -0,0 +1,231 @@
+//! 感知哈希（dHash / pHash）
+//!
+//! 两者都是 64 位指纹，缩放、重新编码后的副本汉明距离很小，用于查找近似重复照片：
+//! - dHash：灰度图缩到 9x8，比较每行相邻像素的明暗
+//! - pHash：灰度图缩到 32x32 做 DCT，取左上 8x8 低频系数与其中位数比较
+
+use std::sync::OnceLock;
+
+/// pHash 的 DCT 输入边长
+const DCT_SIZE: usize = 32;
+/// pHash 保留的低频系数边长
+const DCT_KEEP: usize = 8;
+
+/// 一张图片的感知哈希
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct PerceptualHash {
+    pub dhash: u64,
+    pub phash: u64,
+}
+
+/// 两个 64 位哈希的汉明距离
+#[inline]
+pub fn hamming_distance(a: u64, b: u64) -> u32 {
+    (a ^ b).count_ones()
+}
+
+/// 由灰度图计算感知哈希
+///
+/// `luma` 为按行存储的 `width * height` 个灰度值。输入越小越快，
+/// 缩略图流程中传入的是 ThumbHash 用的 100px 小图。
+pub fn luma_to_perceptual_hash(width: usize, height: usize, luma: &[u8]) -> Option<PerceptualHash> {
+    if width == 0 || height == 0 || luma.len() < width * height {
+        return None;
+    }
+
+    // 取整到 8 位灰度再比较，避免浮点误差让纯色区域产生随机位
+    let small = box_resize::<9, 8>(width, height, luma);
+    let mut dhash = 0u64;
+    for row in &small {
+        for x in 0..8 {
+            dhash = (dhash << 1) | (row[x].round() > row[x + 1].round()) as u64;
+        }
+    }
+
+    let pixels = box_resize::<DCT_SIZE, DCT_SIZE>(width, height, luma);
+    let coeffs = low_frequency_dct(&pixels);
+    let mut sorted: Vec<f32> = coeffs.iter().flatten().copied().collect();
+    sorted.sort_by(|a, b| a.total_cmp(b));
+    let median = (sorted[31] + sorted[32]) / 2.0;
+
+    let mut phash = 0u64;
+    for &c in coeffs.iter().flatten() {
+        phash = (phash << 1) | (c > median) as u64;
+    }
+
+    Some(PerceptualHash { dhash, phash })
+}
+
+/// 按面积加权缩放到 W x H
+///
+/// 源像素按与目标格子的重叠比例计权，缩放倍数不是整数时也不会产生混叠，
+/// 同一张图的不同尺寸副本得到几乎相同的结果。
+fn box_resize<const W: usize, const H: usize>(width: usize, height: usize, luma: &[u8]) -> [[f32; W]; H] {
+    let x_weights = area_weights(W, width);
+    let y_weights = area_weights(H, height);
+
+    // 先横向缩放，每行缩成 W 个值
+    let mut columns = vec![[0f32; W]; height];
+    for (y, out) in columns.iter_mut().enumerate() {
+        let row = &luma[y * width..(y + 1) * width];
+        for (value, (start, weights)) in out.iter_mut().zip(&x_weights) {
+            *value = weights
+                .iter()
+                .zip(&row[*start..])
+                .map(|(w, &v)| w * v as f32)
+                .sum();
+        }
+    }
+
+    // 再纵向缩放
+    let mut out = [[0f32; W]; H];
+    for (out_row, (start, weights)) in out.iter_mut().zip(&y_weights) {
+        for (w, row) in weights.iter().zip(&columns[*start..]) {
+            for (o, v) in out_row.iter_mut().zip(row) {
+                *o += w * v;
+            }
+        }
+    }
+    out
+}
+
+/// 每个目标格子覆盖的源像素起点及其权重（权重和为 1）
+fn area_weights(n: usize, len: usize) -> Vec<(usize, Vec<f32>)> {
+    let scale = len as f64 / n as f64;
+    (0..n)
+        .map(|i| {
+            let lo = i as f64 * scale;
+            let hi = (i as f64 + 1.0) * scale;
+            let start = (lo.floor() as usize).min(len - 1);
+            let end = (hi.ceil() as usize).clamp(start + 1, len);
+            let weights = (start..end)
+                .map(|p| ((p as f64 + 1.0).min(hi) - (p as f64).max(lo)).max(0.0) / (hi - lo))
+                .map(|w| w as f32)
+                .collect();
+            (start, weights)
+        })
+        .collect()
+}
+
+/// DCT-II 余弦表，只保留前 DCT_KEEP 个频率
+fn dct_table() -> &'static [[f32; DCT_SIZE]; DCT_KEEP] {
+    static TABLE: OnceLock<[[f32; DCT_SIZE]; DCT_KEEP]> = OnceLock::new();
+    TABLE.get_or_init(|| {
+        let mut table = [[0f32; DCT_SIZE]; DCT_KEEP];
+        for (u, row) in table.iter_mut().enumerate() {
+            for (x, c) in row.iter_mut().enumerate() {
+                let angle = std::f64::consts::PI / DCT_SIZE as f64 * (x as f64 + 0.5) * u as f64;
+                *c = angle.cos() as f32;
+            }
+        }
+        table
+    })
+}
+
+/// 可分离 DCT，只计算左上 DCT_KEEP x DCT_KEEP 个低频系数
+fn low_frequency_dct(pixels: &[[f32; DCT_SIZE]; DCT_SIZE]) -> [[f32; DCT_KEEP]; DCT_KEEP] {
+    let table = dct_table();
+
+    // 行变换，结果转置存放，列变换时两边都是连续内存
+    let mut rows = [[0f32; DCT_SIZE]; DCT_KEEP];
+    for (u, basis) in table.iter().enumerate() {
+        for (y, row) in pixels.iter().enumerate() {
+            rows[u][y] = dot(row, basis);
+        }
+    }
+
+    let mut out = [[0f32; DCT_KEEP]; DCT_KEEP];
+    for (v, basis) in table.iter().enumerate() {
+        for (u, column) in rows.iter().enumerate() {
+            out[v][u] = dot(column, basis);
+        }
+    }
+    out
+}
+
+/// 32 维点积
+///
+/// 拆成 8 路独立累加，编译器可直接生成 SSE/AVX/NEON 向量指令，无需 unsafe 内建函数。
+#[inline]
+fn dot(a: &[f32; DCT_SIZE], b: &[f32; DCT_SIZE]) -> f32 {
+    let mut acc = [0f32; 8];
+    for (ca, cb) in a.chunks_exact(8).zip(b.chunks_exact(8)) {
+        for i in 0..8 {
+            acc[i] += ca[i] * cb[i];
+        }
+    }
+    acc.iter().sum()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// 带一个亮块的渐变测试图
+    fn test_image(width: usize, height: usize) -> Vec<u8> {
+        let mut luma = Vec::with_capacity(width * height);
+        for y in 0..height {
+            for x in 0..width {
+                let gradient = (x * 160 / width + y * 60 / height) as u8;
+                let in_block = x > width / 2 && x < width * 3 / 4 && y > height / 4 && y < height / 2;
+                luma.push(if in_block { 250 } else { gradient });
+            }
+        }
+        luma
+    }
+
+    fn downscale_by_two(width: usize, height: usize, luma: &[u8]) -> Vec<u8> {
+        let mut out = Vec::with_capacity(width / 2 * height / 2);
+        for y in 0..height / 2 {
+            for x in 0..width / 2 {
+                let sum: u32 = [(0, 0), (1, 0), (0, 1), (1, 1)]
+                    .iter()
+                    .map(|&(dx, dy)| luma[(y * 2 + dy) * width + x * 2 + dx] as u32)
+                    .sum();
+                out.push((sum / 4) as u8);
+            }
+        }
+        out
+    }
+
+    #[test]
+    fn test_flat_image_has_zero_dhash() {
+        let hash = luma_to_perceptual_hash(40, 30, &vec![128u8; 40 * 30]).unwrap();
+        assert_eq!(hash.dhash, 0);
+    }
+
+    #[test]
+    fn test_resized_copy_is_near() {
+        let original = test_image(100, 80);
+        let resized = downscale_by_two(100, 80, &original);
+
+        let a = luma_to_perceptual_hash(100, 80, &original).unwrap();
+        let b = luma_to_perceptual_hash(50, 40, &resized).unwrap();
+
+        assert!(hamming_distance(a.dhash, b.dhash) <= 4);
+        assert!(hamming_distance(a.phash, b.phash) <= 4);
+    }
+
+    #[test]
+    fn test_different_images_are_far() {
+        let original = test_image(100, 80);
+        let mirrored: Vec<u8> = original
+            .chunks(100)
+            .flat_map(|row| row.iter().rev().copied())
+            .collect();
+
+        let a = luma_to_perceptual_hash(100, 80, &original).unwrap();
+        let b = luma_to_perceptual_hash(100, 80, &mirrored).unwrap();
+
+        assert!(hamming_distance(a.dhash, b.dhash) > 20);
+        assert!(hamming_distance(a.phash, b.phash) > 10);
+    }
+
+    #[test]
+    fn test_tiny_and_invalid_input() {
+        // 小于 9x8 的图也能计算
+        assert!(luma_to_perceptual_hash(4, 4, &[0u8; 16]).is_some());
+        assert!(luma_to_perceptual_hash(0, 4, &[]).is_none());
+        assert!(luma_to_perceptual_hash(4, 4, &[0u8; 8]).is_none());
+    }
+}
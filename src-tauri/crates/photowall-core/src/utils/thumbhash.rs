@@ -0,0 +1,177 @@
+//! ThumbHash 占位图编码
+//!
+//! 将不超过 100x100 的 RGBA 图像压缩为约 25 字节的 ThumbHash
+//! （https://evanw.github.io/thumbhash/），前端可在微秒级解码为模糊占位图。
+
+use std::f64::consts::PI;
+
+/// ThumbHash 输入图像的最大边长
+pub const THUMBHASH_MAX_DIMENSION: u32 = 100;
+
+/// 与 JavaScript 参考实现一致的四舍五入
+fn round(x: f64) -> i32 {
+    (x + 0.5).floor() as i32
+}
+
+/// 对单个通道做 DCT，返回 (直流分量, 归一化交流分量, 缩放系数)
+fn encode_channel(channel: &[f64], w: usize, h: usize, nx: usize, ny: usize) -> (f64, Vec<f64>, f64) {
+    let mut dc = 0.0;
+    let mut ac = Vec::with_capacity(nx * ny);
+    let mut scale = 0.0f64;
+    let mut fx = vec![0.0f64; w];
+
+    for cy in 0..ny {
+        let mut cx = 0;
+        while cx * ny < nx * (ny - cy) {
+            for (x, f) in fx.iter_mut().enumerate() {
+                *f = (PI / w as f64 * cx as f64 * (x as f64 + 0.5)).cos();
+            }
+            let mut f = 0.0;
+            for y in 0..h {
+                let fy = (PI / h as f64 * cy as f64 * (y as f64 + 0.5)).cos();
+                let row = &channel[y * w..(y + 1) * w];
+                for x in 0..w {
+                    f += row[x] * fx[x] * fy;
+                }
+            }
+            f /= (w * h) as f64;
+
+            if cx > 0 || cy > 0 {
+                ac.push(f);
+                scale = scale.max(f.abs());
+            } else {
+                dc = f;
+            }
+            cx += 1;
+        }
+    }
+
+    if scale > 0.0 {
+        for v in ac.iter_mut() {
+            *v = 0.5 + 0.5 / scale * *v;
+        }
+    }
+    (dc, ac, scale)
+}
+
+/// 将 RGBA 图像编码为 ThumbHash
+///
+/// `w`、`h` 不能超过 [`THUMBHASH_MAX_DIMENSION`]，超出或数据长度不符时返回 None。
+pub fn rgba_to_thumbhash(w: usize, h: usize, rgba: &[u8]) -> Option<Vec<u8>> {
+    if w == 0
+        || h == 0
+        || w > THUMBHASH_MAX_DIMENSION as usize
+        || h > THUMBHASH_MAX_DIMENSION as usize
+        || rgba.len() != w * h * 4
+    {
+        return None;
+    }
+
+    // 平均颜色
+    let (mut avg_r, mut avg_g, mut avg_b, mut avg_a) = (0.0f64, 0.0f64, 0.0f64, 0.0f64);
+    for px in rgba.chunks_exact(4) {
+        let alpha = px[3] as f64 / 255.0;
+        avg_r += alpha / 255.0 * px[0] as f64;
+        avg_g += alpha / 255.0 * px[1] as f64;
+        avg_b += alpha / 255.0 * px[2] as f64;
+        avg_a += alpha;
+    }
+    if avg_a > 0.0 {
+        avg_r /= avg_a;
+        avg_g /= avg_a;
+        avg_b /= avg_a;
+    }
+
+    let has_alpha = avg_a < (w * h) as f64;
+    let l_limit = if has_alpha { 5.0 } else { 7.0 };
+    let max_dim = w.max(h) as f64;
+    let lx = round(l_limit * w as f64 / max_dim).max(1) as usize;
+    let ly = round(l_limit * h as f64 / max_dim).max(1) as usize;
+
+    // RGBA -> LPQA（以平均颜色为底合成透明像素）
+    let n = w * h;
+    let mut l = Vec::with_capacity(n);
+    let mut p = Vec::with_capacity(n);
+    let mut q = Vec::with_capacity(n);
+    let mut a = Vec::with_capacity(n);
+    for px in rgba.chunks_exact(4) {
+        let alpha = px[3] as f64 / 255.0;
+        let r = avg_r * (1.0 - alpha) + alpha / 255.0 * px[0] as f64;
+        let g = avg_g * (1.0 - alpha) + alpha / 255.0 * px[1] as f64;
+        let b = avg_b * (1.0 - alpha) + alpha / 255.0 * px[2] as f64;
+        l.push((r + g + b) / 3.0);
+        p.push((r + g) / 2.0 - b);
+        q.push(r - g);
+        a.push(alpha);
+    }
+
+    let (l_dc, l_ac, l_scale) = encode_channel(&l, w, h, lx.max(3), ly.max(3));
+    let (p_dc, p_ac, p_scale) = encode_channel(&p, w, h, 3, 3);
+    let (q_dc, q_ac, q_scale) = encode_channel(&q, w, h, 3, 3);
+    let alpha_channel = has_alpha.then(|| encode_channel(&a, w, h, 5, 5));
+
+    // 头部常量
+    let is_landscape = w > h;
+    let header24 = round(63.0 * l_dc) as u32
+        | (round(31.5 + 31.5 * p_dc) as u32) << 6
+        | (round(31.5 + 31.5 * q_dc) as u32) << 12
+        | (round(31.0 * l_scale) as u32) << 18
+        | (has_alpha as u32) << 23;
+    let header16 = (if is_landscape { ly } else { lx }) as u32
+        | (round(63.0 * p_scale) as u32) << 3
+        | (round(63.0 * q_scale) as u32) << 9
+        | (is_landscape as u32) << 15;
+
+    let mut hash = vec![
+        (header24 & 255) as u8,
+        ((header24 >> 8) & 255) as u8,
+        (header24 >> 16) as u8,
+        (header16 & 255) as u8,
+        (header16 >> 8) as u8,
+    ];
+    if let Some((a_dc, _, a_scale)) = &alpha_channel {
+        hash.push((round(15.0 * a_dc) | round(15.0 * a_scale) << 4) as u8);
+    }
+
+    // 交流分量，每个 4 bit
+    let ac_start = hash.len();
+    let mut ac_index = 0usize;
+    let mut channels = vec![&l_ac, &p_ac, &q_ac];
+    if let Some((_, a_ac, _)) = &alpha_channel {
+        channels.push(a_ac);
+    }
+    for ac in channels {
+        for &f in ac {
+            let i = ac_start + (ac_index >> 1);
+            if hash.len() <= i {
+                hash.resize(i + 1, 0);
+            }
+            hash[i] |= (round(15.0 * f) as u8) << ((ac_index & 1) << 2);
+            ac_index += 1;
+        }
+    }
+    Some(hash)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_thumbhash_solid_color() {
+        let rgba: Vec<u8> = [200u8, 100, 50, 255].repeat(32 * 24);
+        let hash = rgba_to_thumbhash(32, 24, &rgba).unwrap();
+
+        // 不透明横图：5 字节头部 + 交流分量
+        assert!(hash.len() >= 5 && hash.len() <= 30);
+        assert_eq!(hash[4] >> 7, 1);
+        assert_eq!(hash[2] >> 7, 0);
+    }
+
+    #[test]
+    fn test_thumbhash_rejects_large_input() {
+        let rgba = vec![0u8; 101 * 10 * 4];
+        assert!(rgba_to_thumbhash(101, 10, &rgba).is_none());
+        assert!(rgba_to_thumbhash(10, 10, &rgba[..8]).is_none());
+    }
+}
@@ -0,0 +1,335 @@
+/**
+ * @file photowall_bench.cpp
+ * @brief Load and latency benchmark for the PhotoWall C API
+ *
+ * Generates (or reuses) a synthetic library with
+ * photowall_bench_generate_library(), then replays a mix of grid scrolling,
+ * searches, tagging and folder browsing from N threads sharing one handle,
+ * and reports per-API latency percentiles and throughput.
+ *
+ * Build the library with the bench feature first:
+ *
+ *     cargo build --release -p photowall-ffi --features bench
+ *
+ * Usage:
+ *
+ *     photowall_bench [--data-dir DIR] [--photos N] [--tags N] [--albums N]
+ *                     [--folders N] [--threads N] [--duration SECONDS]
+ *                     [--seed N]
+ */
+
+#include "photowall.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string data_dir = "photowall-bench-data";
+    uint32_t photos = 1000000;
+    uint32_t tags = 200;
+    uint32_t albums = 100;
+    uint32_t folders = 2000;
+    uint32_t threads = 8;
+    uint32_t duration_s = 30;
+    uint64_t seed = 42;
+};
+
+/** Latency samples (microseconds) and error count of one API. */
+struct ApiSamples {
+    std::vector<double> latencies_us;
+    uint64_t errors = 0;
+};
+
+using SampleMap = std::map<std::string, ApiSamples>;
+
+/** Time one C API call and record it under `api`; `ok` is the call's success. */
+template <typename F>
+void measure(SampleMap& samples, const char* api, F&& call) {
+    auto start = Clock::now();
+    bool ok = call();
+    auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    ApiSamples& s = samples[api];
+    s.latencies_us.push_back(elapsed);
+    if (!ok) {
+        s.errors++;
+    }
+}
+
+void free_json(char* json) {
+    if (json) {
+        photowall_free_string(json);
+    }
+}
+
+std::string folder_path(uint32_t folder) {
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "/photowall-bench/group_%02u/folder_%05u", folder % 32, folder);
+    return buf;
+}
+
+std::string group_path(uint32_t group) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "/photowall-bench/group_%02u", group);
+    return buf;
+}
+
+/** Extract every `"tagId":N` from the tag list JSON. */
+std::vector<int64_t> parse_tag_ids(const char* json) {
+    std::vector<int64_t> ids;
+    const char* key = "\"tagId\":";
+    for (const char* p = std::strstr(json, key); p; p = std::strstr(p, key)) {
+        p += std::strlen(key);
+        ids.push_back(std::strtoll(p, nullptr, 10));
+    }
+    return ids;
+}
+
+/** Scroll the grid: fetch consecutive pages and check their thumbnail cache state. */
+void scroll_grid(PhotowallHandle* handle, SampleMap& samples, std::mt19937_64& rng) {
+    std::string cursor;
+    uint32_t pages = 1 + rng() % 10;
+
+    for (uint32_t i = 0; i < pages; i++) {
+        PhotowallPhotoBatch* batch = nullptr;
+        measure(samples, "get_photos_cursor_bin", [&] {
+            return photowall_get_photos_cursor_bin(handle, 200, cursor.empty() ? nullptr : cursor.c_str(), nullptr,
+                                                   &batch) == 0;
+        });
+        if (!batch) {
+            return;
+        }
+
+        std::vector<const char*> hashes(batch->count);
+        for (uint32_t j = 0; j < batch->count; j++) {
+            hashes[j] = batch->strings + batch->file_hashes[j];
+        }
+        std::vector<uint8_t> bits((batch->count + 7) / 8);
+        measure(samples, "thumbnails_cached_bitset", [&] {
+            return photowall_thumbnails_cached_bitset(handle, hashes.data(), batch->count, "small", bits.data()) >= 0;
+        });
+
+        bool has_more = batch->has_more != 0 && batch->next_cursor != PHOTOWALL_BATCH_NO_STRING;
+        if (has_more) {
+            cursor = batch->strings + batch->next_cursor;
+        }
+        photowall_free_photo_batch(batch);
+        if (!has_more) {
+            return;
+        }
+    }
+}
+
+void search(PhotowallHandle* handle, SampleMap& samples, std::mt19937_64& rng, const std::vector<int64_t>& tag_ids) {
+    static const char* cameras[] = {"Canon EOS R5", "Sony ILCE-7M4", "iPhone 15 Pro"};
+    char filters[160];
+
+    switch (rng() % 3) {
+    case 0:
+        std::snprintf(filters, sizeof(filters), "{\"query\":\"IMG_%04u\"}", static_cast<unsigned>(rng() % 10000));
+        break;
+    case 1:
+        std::snprintf(filters, sizeof(filters), "{\"cameraModel\":\"%s\",\"favoritesOnly\":true}",
+                      cameras[rng() % 3]);
+        break;
+    default:
+        if (tag_ids.empty()) {
+            std::snprintf(filters, sizeof(filters), "{\"minRating\":0}");
+        } else {
+            std::snprintf(filters, sizeof(filters), "{\"tagIds\":[%" PRId64 "]}", tag_ids[rng() % tag_ids.size()]);
+        }
+        break;
+    }
+
+    PhotowallPhotoBatch* batch = nullptr;
+    int include_total = rng() % 4 == 0;
+    measure(samples, include_total ? "search_photos_cursor_bin+total" : "search_photos_cursor_bin", [&] {
+        return photowall_search_photos_cursor_bin(handle, filters, 200, nullptr, nullptr, include_total, &batch) == 0;
+    });
+    photowall_free_photo_batch(batch);
+}
+
+void tag_photos(PhotowallHandle* handle, SampleMap& samples, std::mt19937_64& rng, uint32_t photo_count,
+                const std::vector<int64_t>& tag_ids) {
+    if (tag_ids.empty() || photo_count == 0) {
+        return;
+    }
+
+    std::vector<int64_t> photo_ids(1 + rng() % 50);
+    for (auto& id : photo_ids) {
+        id = 1 + static_cast<int64_t>(rng() % photo_count);
+    }
+    int64_t tag = tag_ids[rng() % tag_ids.size()];
+    uint32_t n = static_cast<uint32_t>(photo_ids.size());
+
+    measure(samples, "tags_add_to_photos", [&] {
+        return photowall_tags_add_to_photos(handle, photo_ids.data(), n, &tag, 1, nullptr) >= 0;
+    });
+    measure(samples, "tags_remove_from_photos", [&] {
+        return photowall_tags_remove_from_photos(handle, photo_ids.data(), n, &tag, 1, nullptr) >= 0;
+    });
+}
+
+void browse_folders(PhotowallHandle* handle, SampleMap& samples, std::mt19937_64& rng, uint32_t folder_count) {
+    char* json = nullptr;
+    std::string group = group_path(static_cast<uint32_t>(rng() % 32));
+    measure(samples, "get_folder_children_json", [&] {
+        return photowall_get_folder_children_json(handle, group.c_str(), &json) == 0;
+    });
+    free_json(json);
+
+    json = nullptr;
+    std::string folder = folder_path(static_cast<uint32_t>(rng() % std::max(folder_count, 1u)));
+    measure(samples, "get_folder_photos_json", [&] {
+        return photowall_get_folder_photos_json(handle, folder.c_str(), 0, 1, 100, nullptr, &json) == 0;
+    });
+    free_json(json);
+}
+
+void run_worker(PhotowallHandle* handle, const Options& opts, uint32_t photo_count, const std::vector<int64_t>& tag_ids,
+                uint32_t worker, Clock::time_point deadline, SampleMap& samples) {
+    std::mt19937_64 rng(opts.seed + worker + 1);
+
+    while (Clock::now() < deadline) {
+        // Mix: 50% scrolling, 20% search, 15% tagging, 15% folder browsing
+        uint32_t pick = static_cast<uint32_t>(rng() % 100);
+        if (pick < 50) {
+            scroll_grid(handle, samples, rng);
+        } else if (pick < 70) {
+            search(handle, samples, rng, tag_ids);
+        } else if (pick < 85) {
+            tag_photos(handle, samples, rng, photo_count, tag_ids);
+        } else {
+            browse_folders(handle, samples, rng, opts.folders);
+        }
+    }
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void report(SampleMap& merged, double elapsed_s) {
+    std::printf("\n%-32s %9s %7s %10s %10s %10s %10s %10s\n", "api", "calls", "errors", "p50 ms", "p95 ms", "p99 ms",
+                "max ms", "ops/s");
+    for (auto& [api, s] : merged) {
+        std::sort(s.latencies_us.begin(), s.latencies_us.end());
+        std::printf("%-32s %9zu %7" PRIu64 " %10.3f %10.3f %10.3f %10.3f %10.1f\n", api.c_str(), s.latencies_us.size(),
+                    s.errors, percentile(s.latencies_us, 0.50) / 1000.0, percentile(s.latencies_us, 0.95) / 1000.0,
+                    percentile(s.latencies_us, 0.99) / 1000.0,
+                    s.latencies_us.empty() ? 0.0 : s.latencies_us.back() / 1000.0,
+                    static_cast<double>(s.latencies_us.size()) / elapsed_s);
+    }
+}
+
+bool parse_args(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--data-dir") {
+            opts.data_dir = value;
+        } else if (arg == "--photos") {
+            opts.photos = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--tags") {
+            opts.tags = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--albums") {
+            opts.albums = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--folders") {
+            opts.folders = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--threads") {
+            opts.threads = std::max(1u, static_cast<uint32_t>(std::strtoul(value, nullptr, 10)));
+        } else if (arg == "--duration") {
+            opts.duration_s = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--seed") {
+            opts.seed = std::strtoull(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parse_args(argc, argv, opts)) {
+        std::fprintf(stderr,
+                     "usage: %s [--data-dir DIR] [--photos N] [--tags N] [--albums N] [--folders N]\n"
+                     "          [--threads N] [--duration SECONDS] [--seed N]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    PhotowallHandle* handle = photowall_init_with_data_dir(opts.data_dir.c_str());
+    if (!handle) {
+        std::fprintf(stderr, "photowall_init_with_data_dir failed: %s\n", photowall_last_error());
+        return 1;
+    }
+
+    std::printf("Preparing library in %s ...\n", opts.data_dir.c_str());
+    auto gen_start = Clock::now();
+    int64_t photo_count =
+        photowall_bench_generate_library(handle, opts.photos, opts.tags, opts.albums, opts.folders, opts.seed);
+    if (photo_count < 0) {
+        std::fprintf(stderr, "photowall_bench_generate_library failed: %s\n", photowall_last_error());
+        photowall_shutdown(handle);
+        return 1;
+    }
+    std::printf("Library ready: %" PRId64 " photos (%.1f s)\n", photo_count,
+                std::chrono::duration<double>(Clock::now() - gen_start).count());
+
+    std::vector<int64_t> tag_ids;
+    char* tags_json = nullptr;
+    if (photowall_tags_get_all_json(handle, &tags_json) == 0 && tags_json) {
+        tag_ids = parse_tag_ids(tags_json);
+    }
+    free_json(tags_json);
+
+    std::printf("Running %u threads for %u s ...\n", opts.threads, opts.duration_s);
+    std::vector<SampleMap> per_thread(opts.threads);
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::seconds(opts.duration_s);
+    for (uint32_t t = 0; t < opts.threads; t++) {
+        workers.emplace_back(run_worker, handle, std::cref(opts), static_cast<uint32_t>(photo_count),
+                             std::cref(tag_ids), t, deadline, std::ref(per_thread[t]));
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    SampleMap merged;
+    for (auto& samples : per_thread) {
+        for (auto& [api, s] : samples) {
+            ApiSamples& m = merged[api];
+            m.latencies_us.insert(m.latencies_us.end(), s.latencies_us.begin(), s.latencies_us.end());
+            m.errors += s.errors;
+        }
+    }
+    report(merged, elapsed_s);
+
+    photowall_shutdown(handle);
+    return 0;
+}
@@ -20,6 +20,8 @@
  * ## Memory Management
  *
  * - Strings returned via out_json must be freed with photowall_free_string()
+ * - Batches returned by *_bin functions must be freed with photowall_free_photo_batch()
+ * - Iterators must be closed with photowall_photo_iter_close()
  * - The handle must be freed with photowall_shutdown()
  * - Input strings are borrowed (not freed by the library)
  *
@@ -33,6 +35,7 @@
 #ifndef PHOTOWALL_H
 #define PHOTOWALL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -65,9 +68,69 @@ typedef uint64_t JobId;
  * Note: This callback may be invoked from background threads.
  * Qt applications should use Qt::QueuedConnection or similar
  * to marshal to the UI thread.
+ *
+ * Events are delivered one at a time, in order, and no library lock is held
+ * while the callback runs. The callback may call back into the library on
+ * the same thread, e.g. photowall_flush_events() or an API that emits events.
+ * Events emitted that way are delivered after the callback returns. The
+ * callback must not block waiting for another thread that emits events,
+ * because that thread's events are queued behind the running callback.
  */
 typedef void (*EventCallback)(const char* name, const char* payload, void* user_data);
 
+/**
+ * Opaque streaming photo iterator.
+ * Created by photowall_photo_iter_open(), freed by photowall_photo_iter_close().
+ */
+typedef struct PhotowallPhotoIter PhotowallPhotoIter;
+
+/** Per-item status codes written by the bulk tag/album functions. */
+#define PHOTOWALL_BATCH_APPLIED   0u  /**< Association written / removed */
+#define PHOTOWALL_BATCH_UNCHANGED 1u  /**< Already present / not present */
+#define PHOTOWALL_BATCH_FAILED    2u  /**< Photo, tag or album does not exist */
+
+/** String offset value meaning "NULL" in a PhotowallPhotoBatch. */
+#define PHOTOWALL_BATCH_NO_STRING 0xFFFFFFFFu
+
+/** PhotowallPhotoBatch.flags bits. */
+#define PHOTOWALL_PHOTO_FLAG_FAVORITE 0x01u
+#define PHOTOWALL_PHOTO_FLAG_DELETED  0x02u
+#define PHOTOWALL_PHOTO_FLAG_HAS_GPS  0x04u
+#define PHOTOWALL_PHOTO_FLAG_HAS_PHASH 0x08u  /**< dhashes/phashes are valid */
+
+/**
+ * Columnar (struct-of-arrays) photo query result.
+ *
+ * All arrays hold `count` elements and live in one library-owned buffer
+ * together with the string pool, so the result can be read in place.
+ * String columns hold byte offsets into `strings`; each string is
+ * NUL-terminated. An offset of PHOTOWALL_BATCH_NO_STRING means NULL.
+ *
+ * Example: `const char* hash = batch->strings + batch->file_hashes[i];`
+ */
+typedef struct PhotowallPhotoBatch {
+    uint32_t count;
+    int32_t has_more;           /**< 1 if another page is available */
+    int64_t total;              /**< Total matching photos, -1 if not computed */
+    const int64_t* photo_ids;
+    const int64_t* file_sizes;
+    const int32_t* widths;      /**< 0 if unknown */
+    const int32_t* heights;     /**< 0 if unknown */
+    const uint32_t* file_hashes;
+    const uint32_t* file_paths;
+    const uint32_t* dates_taken;
+    const uint32_t* dates_added;
+    const uint8_t* ratings;     /**< 0-5 */
+    const uint8_t* flags;       /**< PHOTOWALL_PHOTO_FLAG_* bits */
+    const char* strings;
+    uint32_t strings_len;
+    uint32_t next_cursor;       /**< Offset of the next-page cursor JSON */
+    const uint32_t* thumbhashes;    /**< Offset of raw ThumbHash bytes in strings, or PHOTOWALL_BATCH_NO_STRING */
+    const uint8_t* thumbhash_lens;  /**< ThumbHash length in bytes (not NUL-terminated), 0 if none */
+    const uint64_t* dhashes;    /**< 64-bit dHash, valid with PHOTOWALL_PHOTO_FLAG_HAS_PHASH */
+    const uint64_t* phashes;    /**< 64-bit DCT pHash, valid with PHOTOWALL_PHOTO_FLAG_HAS_PHASH */
+} PhotowallPhotoBatch;
+
 /* ============================================================================
  * Initialization and Lifecycle
  * ============================================================================ */
@@ -82,6 +145,19 @@ typedef void (*EventCallback)(const char* name, const char* payload, void* user_
  */
 PhotowallHandle* photowall_init(void);
 
+/**
+ * Initialize the PhotoWall library with a custom data directory.
+ *
+ * The database, thumbnails and settings are kept under data_dir instead of
+ * the per-user default. Useful for tests, benchmarks and portable installs.
+ *
+ * @param data_dir  Data directory (UTF-8, created if missing)
+ * @return Valid handle pointer on success, NULL on error.
+ *
+ * The returned handle must be freed with photowall_shutdown().
+ */
+PhotowallHandle* photowall_init_with_data_dir(const char* data_dir);
+
 /**
  * Shutdown the PhotoWall library and free resources.
  *
@@ -132,7 +208,8 @@ char* photowall_version(void);
  * - "index-progress": Indexing progress updates
  * - "index-finished": Indexing completed
  * - "index-cancelled": Indexing was cancelled
- * - "thumbnail-ready": Thumbnail generation completed
+ * - "thumbnail-ready": Thumbnail generation completed; "path" is empty and
+ *   "packed" is true when the thumbnail lives in the packed store
  * - "settings-changed": Settings were updated
  */
 int photowall_set_event_callback(
@@ -149,6 +226,47 @@ int photowall_set_event_callback(
  */
 int photowall_clear_event_callback(PhotowallHandle* handle);
 
+/* Event coalescing modes for photowall_set_event_coalescing() */
+#define PHOTOWALL_COALESCE_OFF    0
+#define PHOTOWALL_COALESCE_LATEST 1
+#define PHOTOWALL_COALESCE_BATCH  2
+
+/**
+ * Configure coalescing for one event type.
+ *
+ * Coalesced events are delivered at most max_rate_hz times per second. The
+ * first event after a quiet period is delivered immediately; later events in
+ * the same tick are merged and delivered from a background thread. Events that
+ * are not coalesced flush pending coalesced events first, so ordering between
+ * event types is preserved.
+ *
+ * @param handle       Valid handle from photowall_init()
+ * @param event_name   Event name (e.g. "index-progress")
+ * @param mode         PHOTOWALL_COALESCE_OFF, _LATEST (keep last payload) or
+ *                     _BATCH (deliver a JSON array as "<event_name>-batch",
+ *                     e.g. "thumbnail-ready-batch")
+ * @param max_rate_hz  Maximum deliveries per second (0 turns coalescing off)
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_set_event_coalescing(
+    PhotowallHandle* handle,
+    const char* event_name,
+    int mode,
+    uint32_t max_rate_hz
+);
+
+/**
+ * Deliver all pending coalesced events immediately.
+ *
+ * Returns after the events were delivered. When called from inside the event
+ * callback, the events are delivered once that callback returns.
+ *
+ * @param handle  Valid handle from photowall_init()
+ * @return 0 on success, -1 on error
+ */
+int photowall_flush_events(PhotowallHandle* handle);
+
 /* ============================================================================
  * Photo Query API
  * ============================================================================ */
@@ -175,6 +293,13 @@ int photowall_get_photos_cursor_json(
 /**
  * Search photos with filters and cursor-based pagination.
  *
+ * Besides the text, date, tag, album, folder and rating filters, photos can
+ * be culled by the quality scores computed during thumbnail generation:
+ * minSharpness (variance of Laplacian on a 256px proxy), maxHighlightClip
+ * and maxShadowClip (clipped pixel fractions, 0-1) and maxNoise (noise
+ * standard deviation in 8-bit levels). Photos not yet scored never match a
+ * quality filter. Scores are relative; compare frames of the same burst.
+ *
  * @param handle        Valid handle
  * @param filters_json  JSON search filters
  * @param limit         Maximum number of photos to return
@@ -195,6 +320,107 @@ int photowall_search_photos_cursor_json(
     char** out_json
 );
 
+/**
+ * Get photos with cursor-based pagination as a columnar binary batch.
+ *
+ * Same query as photowall_get_photos_cursor_json(). Pass the string at
+ * `strings + next_cursor` as cursor_json to fetch the next page.
+ *
+ * @param handle       Valid handle
+ * @param limit        Maximum number of photos to return
+ * @param cursor_json  JSON cursor from previous call (NULL for first page)
+ * @param sort_json    JSON sort options (NULL for defaults)
+ * @param out_batch    Output: batch (free with photowall_free_photo_batch)
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_get_photos_cursor_bin(
+    PhotowallHandle* handle,
+    uint32_t limit,
+    const char* cursor_json,
+    const char* sort_json,
+    PhotowallPhotoBatch** out_batch
+);
+
+/**
+ * Search photos with filters as a columnar binary batch.
+ *
+ * Same query as photowall_search_photos_cursor_json().
+ *
+ * @param out_batch  Output: batch (free with photowall_free_photo_batch)
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_search_photos_cursor_bin(
+    PhotowallHandle* handle,
+    const char* filters_json,
+    uint32_t limit,
+    const char* cursor_json,
+    const char* sort_json,
+    int include_total,
+    PhotowallPhotoBatch** out_batch
+);
+
+/**
+ * Free a batch returned by a *_bin function.
+ *
+ * @param batch  Batch pointer (may be NULL)
+ */
+void photowall_free_photo_batch(PhotowallPhotoBatch* batch);
+
+/**
+ * Open a streaming iterator over photos.
+ *
+ * The query runs once on a dedicated read-only connection and its cursor
+ * state stays alive on the library side until the iterator is closed.
+ * The iterator sees a consistent snapshot of the library.
+ *
+ * @param handle        Valid handle
+ * @param filters_json  JSON search filters (NULL for all photos not in trash)
+ * @param sort_json     JSON sort options (NULL for defaults)
+ * @param out_iter      Output: iterator (close with photowall_photo_iter_close)
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_photo_iter_open(
+    PhotowallHandle* handle,
+    const char* filters_json,
+    const char* sort_json,
+    PhotowallPhotoIter** out_iter
+);
+
+/**
+ * Fill a caller-provided buffer with the next rows.
+ *
+ * Rows are written into `buffer` using the PhotowallPhotoBatch layout and
+ * `out_batch` is filled with a header whose arrays point into `buffer`.
+ * The header stays valid as long as the buffer is not reused.
+ * `out_batch->has_more` tells whether another call will return rows.
+ *
+ * @param iter        Iterator from photowall_photo_iter_open()
+ * @param max_rows    Maximum number of rows to write
+ * @param buffer      Caller-owned output buffer
+ * @param buffer_len  Size of buffer in bytes
+ * @param out_batch   Output: header describing the rows in buffer
+ *
+ * @return Number of rows written (0 when exhausted),
+ *         -1 on error (including a buffer too small for one row)
+ */
+int photowall_photo_iter_next_batch(
+    PhotowallPhotoIter* iter,
+    uint32_t max_rows,
+    uint8_t* buffer,
+    size_t buffer_len,
+    PhotowallPhotoBatch* out_batch
+);
+
+/**
+ * Close an iterator and release its query.
+ *
+ * @param iter  Iterator (may be NULL)
+ */
+void photowall_photo_iter_close(PhotowallPhotoIter* iter);
+
 /**
  * Get a single photo by ID.
  *
@@ -210,6 +436,133 @@ int photowall_get_photo_json(
     char** out_json
 );
 
+/**
+ * Get the perceptual hashes of a photo.
+ *
+ * Both hashes are computed from the small image used for the ThumbHash
+ * whenever a thumbnail is generated. Compare them with
+ * `__builtin_popcountll(a ^ b)`: a dHash or pHash distance of 10 or less
+ * usually means a resized or re-encoded copy.
+ *
+ * @param handle     Valid handle
+ * @param photo_id   Photo ID
+ * @param out_dhash  Output: 64-bit dHash
+ * @param out_phash  Output: 64-bit DCT pHash
+ *
+ * @return 0 on success, 1 if the photo does not exist or has no hashes yet,
+ *         -1 on error
+ */
+int photowall_get_perceptual_hash(
+    PhotowallHandle* handle,
+    int64_t photo_id,
+    uint64_t* out_dhash,
+    uint64_t* out_phash
+);
+
+/* ============================================================================
+ * Near-Duplicate API
+ * ============================================================================ */
+
+/** Perceptual hash used by the near-duplicate functions. */
+#define PHOTOWALL_HASH_PHASH 0  /**< DCT pHash: robust to resizing and recompression */
+#define PHOTOWALL_HASH_DHASH 1  /**< dHash */
+
+/**
+ * Find photos whose perceptual hash is within max_distance bits of a photo.
+ *
+ * Served from an in-memory multi-index Hamming table loaded at
+ * photowall_init and kept current as thumbnails are generated and photos
+ * are trashed or restored. Trashed photos are never returned.
+ *
+ * @param handle        Valid handle
+ * @param photo_id      Photo ID
+ * @param kind          PHOTOWALL_HASH_PHASH or PHOTOWALL_HASH_DHASH
+ * @param max_distance  Hamming distance (clamped to 27; 6-10 finds copies)
+ * @param limit         Maximum number of results, 0 for no limit
+ * @param out_json      Output: [{"photoId": 12, "distance": 3}, ...]
+ *                      sorted by distance, excluding the photo itself
+ *
+ * @return 0 on success, 1 if the photo is not indexed (missing, trashed or
+ *         no hash yet), -1 on error
+ */
+int photowall_find_similar_photos_json(
+    PhotowallHandle* handle,
+    int64_t photo_id,
+    int kind,
+    uint32_t max_distance,
+    uint32_t limit,
+    char** out_json
+);
+
+/**
+ * Group the whole library into near-duplicate clusters.
+ *
+ * Photos within max_distance bits of each other are linked; every connected
+ * group of two or more photos is one cluster (single linkage).
+ *
+ * @param handle        Valid handle
+ * @param kind          PHOTOWALL_HASH_PHASH or PHOTOWALL_HASH_DHASH
+ * @param max_distance  Hamming distance (clamped to 27)
+ * @param out_json      Output: [[1, 5, 9], [3, 4], ...], largest cluster
+ *                      first, photo IDs ascending
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_get_duplicate_clusters_json(
+    PhotowallHandle* handle,
+    int kind,
+    uint32_t max_distance,
+    char** out_json
+);
+
+/* ============================================================================
+ * Colour Similarity API
+ * ============================================================================ */
+
+/**
+ * Find the photos whose colour distribution is closest to a photo's.
+ *
+ * Every photo gets a palette (up to 5 dominant colours, k-means in CIE Lab)
+ * and a 64-byte Lab histogram embedding when its thumbnail is generated.
+ * Queries brute-force the L1 distance over all embeddings held in memory;
+ * the palette itself is returned as "palette" by photowall_get_photo_json().
+ *
+ * @param handle    Valid handle
+ * @param photo_id  Query photo
+ * @param limit     Maximum number of results, 0 for no limit
+ * @param out_json  Output: [{"photoId": 12, "distance": 85}, ...] sorted by
+ *                  distance, excluding the photo itself
+ *
+ * @return 0 on success, 1 if the photo is not indexed (missing, trashed or
+ *         not analysed yet), -1 on error
+ */
+int photowall_find_similar_colors_json(
+    PhotowallHandle* handle,
+    int64_t photo_id,
+    uint32_t limit,
+    char** out_json
+);
+
+/**
+ * Find the photos whose colour distribution best matches a palette.
+ *
+ * @param handle        Valid handle
+ * @param palette_json  ["#1e90ff", "#f5deb3"] or
+ *                      [{"color": "#1e90ff", "weight": 0.7}, ...]
+ *                      (weights default to equal)
+ * @param limit         Maximum number of results, 0 for no limit
+ * @param out_json      Output: [{"photoId": 12, "distance": 85}, ...]
+ *                      sorted by distance
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_find_photos_by_palette_json(
+    PhotowallHandle* handle,
+    const char* palette_json,
+    uint32_t limit,
+    char** out_json
+);
+
 /* ============================================================================
  * Indexing API
  * ============================================================================ */
@@ -254,9 +607,41 @@ int photowall_enqueue_thumbnails_batch(
     const char* requests_json
 );
 
+/* Off-screen policies for photowall_reprioritize_thumbnails() */
+#define PHOTOWALL_OFFSCREEN_DEMOTE 0
+#define PHOTOWALL_OFFSCREEN_DROP   1
+
+/**
+ * Reorder queued thumbnail requests around the current viewport.
+ *
+ * Call whenever the visible range changes (e.g. on scroll). Queued requests
+ * for visible_hashes run first, in array order; the rest are demoted behind
+ * them or dropped. Requests enqueued later are ordered the same way. Each
+ * worker applies the new viewport to its own queue the next time it touches
+ * it, so this call does not block on the queues.
+ *
+ * @param handle            Valid handle
+ * @param visible_hashes    Array of count file hash strings, top-left first
+ *                          (NULL entries are ignored)
+ * @param count             Number of hashes (0 restores enqueue priorities)
+ * @param offscreen_policy  PHOTOWALL_OFFSCREEN_DEMOTE or PHOTOWALL_OFFSCREEN_DROP
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_reprioritize_thumbnails(
+    PhotowallHandle* handle,
+    const char* const* visible_hashes,
+    uint32_t count,
+    int offscreen_policy
+);
+
 /**
  * Get the path to a cached thumbnail.
  *
+ * Thumbnails are stored in the packed store; one that only exists there is
+ * exported to a file on the first call. Prefer photowall_get_thumbnail_packed()
+ * where the bytes can be consumed directly.
+ *
  * @param handle     Valid handle
  * @param file_hash  File hash
  * @param size       Size name ("tiny", "small", "medium", "large")
@@ -284,6 +669,146 @@ int photowall_is_thumbnail_cached(
     const char* size
 );
 
+/**
+ * Check which of many thumbnails are cached, without touching the disk.
+ *
+ * Answers from an in-memory index of cached thumbnails (per-file cache and
+ * packed store); the cache directory is scanned once on the first call.
+ *
+ * @param handle       Valid handle
+ * @param file_hashes  Array of count file hash strings (NULL entries are not cached)
+ * @param count        Number of hashes
+ * @param size         Size name
+ * @param out_bits     Output bitset of at least (count + 7) / 8 bytes; bit i,
+ *                     (out_bits[i / 8] >> (i % 8)) & 1, is set if file_hashes[i] is cached
+ *
+ * @return Number of cached thumbnails (>= 0), -1 on error
+ */
+int photowall_thumbnails_cached_bitset(
+    PhotowallHandle* handle,
+    const char* const* file_hashes,
+    uint32_t count,
+    const char* size,
+    uint8_t* out_bits
+);
+
+/**
+ * Get a thumbnail from the packed store without opening any file.
+ *
+ * Thumbnails are kept in append-only pack files that are memory-mapped; the
+ * returned pointer points directly into the mapping. Thumbnails found only in
+ * the per-file cache are imported into the pack on first access.
+ *
+ * @param handle     Valid handle
+ * @param file_hash  File hash
+ * @param size       Size name
+ * @param out_data   Output pointer to WebP bytes (library-owned, do not free)
+ * @param out_len    Output length in bytes
+ *
+ * @return 1 if found, 0 if not cached, -1 on error
+ *
+ * The data stays valid until the next photowall_compact_thumbnail_packs()
+ * call or photowall_shutdown().
+ */
+int photowall_get_thumbnail_packed(
+    PhotowallHandle* handle,
+    const char* file_hash,
+    const char* size,
+    const uint8_t** out_data,
+    size_t* out_len
+);
+
+/**
+ * Compact the packed thumbnail store, reclaiming space of replaced and
+ * deleted thumbnails. Invalidates all pointers returned by
+ * photowall_get_thumbnail_packed().
+ *
+ * @param handle  Valid handle
+ * @return Number of bytes reclaimed (>= 0), -1 on error
+ */
+int64_t photowall_compact_thumbnail_packs(PhotowallHandle* handle);
+
+/** Page data formats for photowall_build_thumbnail_atlas(). */
+#define PHOTOWALL_ATLAS_FORMAT_RGBA 0u  /**< Raw RGBA8, width * height * 4 bytes */
+#define PHOTOWALL_ATLAS_FORMAT_PNG  1u  /**< PNG-encoded */
+#define PHOTOWALL_ATLAS_FORMAT_WEBP 2u  /**< Lossless WebP-encoded */
+
+/** Cell page index for thumbnails that are not cached. */
+#define PHOTOWALL_ATLAS_NO_PAGE 0xFFFFFFFFu
+
+/**
+ * Placement of one thumbnail in an atlas.
+ *
+ * x/y/width/height is the image rectangle in page pixels (without the
+ * letterbox padding of the cell); u0..v1 is the same rectangle in
+ * normalized texture coordinates.
+ */
+typedef struct PhotowallAtlasCell {
+    uint32_t page;              /**< Page index, or PHOTOWALL_ATLAS_NO_PAGE */
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+} PhotowallAtlasCell;
+
+typedef struct PhotowallAtlasPage {
+    uint32_t width;
+    uint32_t height;
+    const uint8_t* data;
+    size_t len;
+} PhotowallAtlasPage;
+
+/** Thumbnail atlas; all arrays are library-owned. */
+typedef struct PhotowallAtlas {
+    uint32_t format;            /**< PHOTOWALL_ATLAS_FORMAT_* of the page data */
+    uint32_t page_count;
+    const PhotowallAtlasPage* pages;
+    uint32_t cell_count;        /**< Equal to the number of requested hashes */
+    const PhotowallAtlasCell* cells;
+} PhotowallAtlas;
+
+/**
+ * Composite cached thumbnails into one or more texture atlas pages, so the
+ * host can decode and upload one texture per page instead of one per photo.
+ *
+ * Each thumbnail is scaled to fit a cell_size square (never upscaled),
+ * centered in its cell, and cells are filled row by row in request order.
+ * Every cell is surrounded by a 2 px gutter filled with the thumbnail's edge
+ * pixels, so bilinear filtering at the UV edges never picks up a neighbour.
+ * A page holds (max_page_size / (cell_size + 4))^2 cells; the last page is
+ * shrunk to the rows actually used. Thumbnails that are not cached do not take a
+ * cell and get page == PHOTOWALL_ATLAS_NO_PAGE.
+ *
+ * @param handle         Valid handle
+ * @param file_hashes    Array of count file hash strings
+ * @param count          Number of hashes
+ * @param size           Thumbnail size to read ("tiny", "small", "medium", "large")
+ * @param cell_size      Cell edge in pixels (1..1024)
+ * @param max_page_size  Maximum page edge in pixels, 0 for 4096
+ * @param format         PHOTOWALL_ATLAS_FORMAT_*
+ *
+ * @return Atlas on success (free with photowall_free_thumbnail_atlas()),
+ *         NULL on error.
+ */
+PhotowallAtlas* photowall_build_thumbnail_atlas(
+    PhotowallHandle* handle,
+    const char* const* file_hashes,
+    uint32_t count,
+    const char* size,
+    uint32_t cell_size,
+    uint32_t max_page_size,
+    uint32_t format
+);
+
+/**
+ * Free an atlas returned by photowall_build_thumbnail_atlas().
+ */
+void photowall_free_thumbnail_atlas(PhotowallAtlas* atlas);
+
 /* ============================================================================
  * Tag API
  * ============================================================================ */
@@ -312,6 +837,42 @@ int photowall_tags_add_to_photo(PhotowallHandle* handle, int64_t photo_id, int64
  */
 int photowall_tags_remove_from_photo(PhotowallHandle* handle, int64_t photo_id, int64_t tag_id);
 
+/**
+ * Add tags to multiple photos in one transaction.
+ *
+ * Every photo is paired with every tag. If out_status is not NULL it must
+ * hold photo_count * tag_count bytes and receives one PHOTOWALL_BATCH_*
+ * code per pair, photo-major: out_status[photo_index * tag_count + tag_index].
+ *
+ * @return Number of pairs applied (>= 0), -1 on error (nothing written)
+ */
+int photowall_tags_add_to_photos(
+    PhotowallHandle* handle,
+    const int64_t* photo_ids,
+    uint32_t photo_count,
+    const int64_t* tag_ids,
+    uint32_t tag_count,
+    uint8_t* out_status
+);
+
+/**
+ * Remove tags from multiple photos in one transaction.
+ *
+ * Every photo is paired with every tag. If out_status is not NULL it must
+ * hold photo_count * tag_count bytes and receives one PHOTOWALL_BATCH_*
+ * code per pair, photo-major: out_status[photo_index * tag_count + tag_index].
+ *
+ * @return Number of pairs applied (>= 0), -1 on error (nothing written)
+ */
+int photowall_tags_remove_from_photos(
+    PhotowallHandle* handle,
+    const int64_t* photo_ids,
+    uint32_t photo_count,
+    const int64_t* tag_ids,
+    uint32_t tag_count,
+    uint8_t* out_status
+);
+
 /**
  * Create a new tag.
  *
@@ -380,6 +941,42 @@ int photowall_albums_add_photo(PhotowallHandle* handle, int64_t album_id, int64_
  */
 int photowall_albums_remove_photo(PhotowallHandle* handle, int64_t album_id, int64_t photo_id);
 
+/**
+ * Add multiple photos to albums in one transaction.
+ *
+ * Every photo is paired with every album. If out_status is not NULL it must
+ * hold photo_count * album_count bytes and receives one PHOTOWALL_BATCH_*
+ * code per pair, photo-major: out_status[photo_index * album_count + album_index].
+ *
+ * @return Number of pairs applied (>= 0), -1 on error (nothing written)
+ */
+int photowall_albums_add_photos(
+    PhotowallHandle* handle,
+    const int64_t* photo_ids,
+    uint32_t photo_count,
+    const int64_t* album_ids,
+    uint32_t album_count,
+    uint8_t* out_status
+);
+
+/**
+ * Remove multiple photos from albums in one transaction.
+ *
+ * Every photo is paired with every album. If out_status is not NULL it must
+ * hold photo_count * album_count bytes and receives one PHOTOWALL_BATCH_*
+ * code per pair, photo-major: out_status[photo_index * album_count + album_index].
+ *
+ * @return Number of pairs applied (>= 0), -1 on error (nothing written)
+ */
+int photowall_albums_remove_photos(
+    PhotowallHandle* handle,
+    const int64_t* photo_ids,
+    uint32_t photo_count,
+    const int64_t* album_ids,
+    uint32_t album_count,
+    uint8_t* out_status
+);
+
 /**
  * Create a new album.
  *
@@ -603,6 +1200,406 @@ int photowall_update_photo_json(
     const char* updates_json
 );
 
+/* ============================================================================
+ * OCR API
+ * ============================================================================ */
+
+/**
+ * Text slot passed to the recognizer callback.
+ * Filled with photowall_ocr_text_set() from inside the callback.
+ */
+typedef struct PhotowallOcrText PhotowallOcrText;
+
+/**
+ * Recognizer callback function type.
+ *
+ * @param pixels     width * height bytes of 8-bit luma (0 = ink, 255 = paper),
+ *                   valid only during the call
+ * @param width      Image width in pixels
+ * @param height     Image height in pixels
+ * @param dpi        Resolution the image was scaled to
+ * @param out_text   Slot for the recognised text
+ * @param user_data  User-provided context pointer
+ *
+ * @return 0 on success (leave out_text empty when there is no text),
+ *         non-zero on failure
+ *
+ * Note: Called concurrently from several background threads.
+ */
+typedef int (*PhotowallOcrRecognizeCallback)(
+    const uint8_t* pixels,
+    uint32_t width,
+    uint32_t height,
+    uint32_t dpi,
+    PhotowallOcrText* out_text,
+    void* user_data
+);
+
+/**
+ * Set the text produced by a recognizer callback.
+ *
+ * May only be called from inside the callback with the out_text it received.
+ * Calling it again replaces the previous text.
+ *
+ * @param out_text   Slot passed to the callback
+ * @param text_utf8  Recognised text (copied)
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_ocr_text_set(PhotowallOcrText* out_text, const char* text_utf8);
+
+/**
+ * Run OCR on every photo that has not been processed yet.
+ *
+ * Photos are decoded, scaled to target_dpi, binarised and deskewed on a
+ * dedicated preprocessing pool; at most 2 * recognizer_threads preprocessed
+ * pages wait for recognition at any time. A photo that fails preprocessing is
+ * recognised from its unprocessed grayscale image. Results are stored in the database and the
+ * text becomes searchable through the full-text query. Cancel with
+ * photowall_cancel_job(); photos not yet recognised stay pending.
+ *
+ * @param handle              Valid handle
+ * @param recognize           Recognizer callback
+ * @param user_data           Passed to every callback; must stay valid until
+ *                            "ocr-finished" or "ocr-cancelled"
+ * @param recognizer_threads  Concurrent recognitions (0 = half the CPU cores,
+ *                            between 1 and 4); preprocessing uses the rest
+ * @param target_dpi          Preprocessing resolution (0 = 300)
+ *
+ * @return Job ID (> 0) on success, 0 on error
+ *
+ * Events emitted:
+ * - "ocr-progress": {jobId, total, processed, recognized, noText, failed, percentage}
+ * - "ocr-finished": {jobId, total, recognized, noText, failed}
+ * - "ocr-cancelled": {jobId, total, recognized, noText, failed}
+ */
+JobId photowall_ocr_pending_async(
+    PhotowallHandle* handle,
+    PhotowallOcrRecognizeCallback recognize,
+    void* user_data,
+    uint32_t recognizer_threads,
+    uint32_t target_dpi
+);
+
+/* ============================================================================
+ * Viewer API
+ * ============================================================================ */
+
+/**
+ * Opaque full-screen viewer with predictive decoding.
+ * Created by photowall_viewer_open(), freed by photowall_viewer_close().
+ */
+typedef struct PhotowallViewer PhotowallViewer;
+
+/**
+ * Display-resolution rendition of one photo.
+ * RGBA8, orientation applied, stride == width * 4.
+ */
+typedef struct PhotowallRendition {
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    const uint8_t* data;
+    size_t len;
+} PhotowallRendition;
+
+/**
+ * Create a viewer.
+ *
+ * Background threads decode the neighbours of the current photo (favouring
+ * the direction of travel) into a bounded cache, so arrow-key browsing is
+ * served from memory. Large JPEGs are scaled during decode.
+ *
+ * @param radius         Photos decoded ahead and behind (0 = 3)
+ * @param max_dimension  Longest rendition edge in pixels (0 = 2560)
+ * @param cache_mb       Cache limit in MiB (0 = 256)
+ * @param threads        Decode threads (0 = 2)
+ *
+ * @return Viewer (close with photowall_viewer_close()), NULL on error
+ */
+PhotowallViewer* photowall_viewer_open(
+    uint32_t radius,
+    uint32_t max_dimension,
+    uint32_t cache_mb,
+    uint32_t threads
+);
+
+/**
+ * Set the navigation order and the current position.
+ * Cached renditions of photos still in the order are kept.
+ *
+ * @param viewer   Viewer
+ * @param paths    Array of count file paths in navigation order
+ * @param count    Number of paths
+ * @param current  Index of the photo shown now
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_viewer_set_order(
+    PhotowallViewer* viewer,
+    const char* const* paths,
+    uint32_t count,
+    uint32_t current
+);
+
+/**
+ * Report a move to index.
+ *
+ * When the direction of travel reverses, queued decodes are dropped and
+ * in-flight decodes that left the prefetch window are cancelled.
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_viewer_navigate(PhotowallViewer* viewer, uint32_t index);
+
+/**
+ * Get the rendition of the photo at index.
+ *
+ * @param viewer         Viewer
+ * @param index          Position in the navigation order
+ * @param wait           1 to wait for (or perform) the decode,
+ *                       0 to return only a cached rendition
+ * @param out_rendition  Output: rendition (free with photowall_free_rendition())
+ *
+ * @return 0 on success, 1 if wait == 0 and not ready, -1 on error
+ */
+int photowall_viewer_get(
+    PhotowallViewer* viewer,
+    uint32_t index,
+    int wait,
+    PhotowallRendition** out_rendition
+);
+
+/**
+ * Free a rendition. It stays valid after the viewer is closed.
+ *
+ * @param rendition  Rendition (may be NULL)
+ */
+void photowall_free_rendition(PhotowallRendition* rendition);
+
+/**
+ * Close a viewer and stop its decode threads.
+ *
+ * @param viewer  Viewer (may be NULL)
+ */
+void photowall_viewer_close(PhotowallViewer* viewer);
+
+/* ============================================================================
+ * Edit Session API
+ * ============================================================================ */
+
+/**
+ * Opaque edit session with progressive preview rendering.
+ * Created by photowall_edit_session_open(), freed by photowall_edit_session_close().
+ */
+typedef struct PhotowallEditSession PhotowallEditSession;
+
+/** Preview frame levels. */
+#define PHOTOWALL_PREVIEW_COARSE 0u  /**< Quarter of the preview edge length */
+#define PHOTOWALL_PREVIEW_FULL   1u  /**< Full preview resolution */
+
+/** Output pixel formats. */
+#define PHOTOWALL_PIXEL_RGBA8    0u  /**< 8 bits per channel */
+#define PHOTOWALL_PIXEL_RGBA16F  1u  /**< Half float per channel, native byte order, 0..1 sRGB */
+
+/** Display modes, composed in the same pass as the edit. */
+#define PHOTOWALL_DISPLAY_EDITED        0u  /**< Edited result only */
+#define PHOTOWALL_DISPLAY_SPLIT         1u  /**< Before left of the split line, edited right */
+#define PHOTOWALL_DISPLAY_SIDE_BY_SIDE  2u  /**< Before and edited side by side (double width) */
+#define PHOTOWALL_DISPLAY_CLIPPING      3u  /**< Clipped highlights red, clipped shadows blue */
+
+/**
+ * Preview frame callback function type.
+ *
+ * @param generation  Value returned by the submit this frame belongs to
+ * @param level       PHOTOWALL_PREVIEW_*
+ * @param is_final    1 for the last frame of this generation
+ * @param width       Frame width in pixels
+ * @param height      Frame height in pixels
+ * @param stride      Bytes per row
+ * @param pixels      Frame pixels, valid only during the call. RGBA8 unless an
+ *                    output buffer is set; then this points to the start of
+ *                    that buffer and uses its format
+ * @param user_data   User-provided context pointer
+ *
+ * Note: Called on the session's render thread.
+ */
+typedef void (*PhotowallPreviewFrameCallback)(
+    uint64_t generation,
+    uint32_t level,
+    int is_final,
+    uint32_t width,
+    uint32_t height,
+    uint32_t stride,
+    const uint8_t* pixels,
+    void* user_data
+);
+
+/**
+ * Scope counts of one frame (edited result, sampled on large previews).
+ * Valid only during the scopes callback.
+ */
+typedef struct PhotowallScopes {
+    uint32_t columns;            /**< Waveform/parade columns across the image width */
+    uint32_t levels;             /**< Waveform/parade levels, row 0 = black */
+    uint32_t vectorscope_size;   /**< Vectorscope edge length */
+    const uint32_t* waveform;    /**< Luma: levels rows x columns counts */
+    const uint32_t* parade;      /**< R, G, B blocks, each laid out like waveform */
+    const uint32_t* vectorscope; /**< Rows = Cr, columns = Cb, neutral at centre */
+} PhotowallScopes;
+
+/**
+ * Scopes callback function type.
+ *
+ * @param generation  Generation of the frame these counts belong to
+ * @param level       PHOTOWALL_PREVIEW_*
+ * @param scopes      Counts, valid only during the call
+ * @param user_data   User-provided context pointer
+ *
+ * Note: Called on the render thread right before the frame callback.
+ */
+typedef void (*PhotowallScopesCallback)(
+    uint64_t generation,
+    uint32_t level,
+    const PhotowallScopes* scopes,
+    void* user_data
+);
+
+/**
+ * Open an edit session.
+ *
+ * The photo is decoded once. Each submit renders a coarse frame first and
+ * then refines it to the full preview; consecutive point adjustments
+ * (exposure, contrast, colour, vignette, ...) run as one fused pass.
+ *
+ * @param path              Image file path (RAW is not supported)
+ * @param preview_max_size  Longest edge of the full preview (0 = 1600)
+ * @param callback          Frame callback
+ * @param user_data         Passed to the callback; must stay valid until close
+ *
+ * @return Session (close with photowall_edit_session_close()), NULL on error
+ */
+PhotowallEditSession* photowall_edit_session_open(
+    const char* path,
+    uint32_t preview_max_size,
+    PhotowallPreviewFrameCallback callback,
+    void* user_data
+);
+
+/**
+ * Submit new edit parameters. Returns immediately.
+ *
+ * A later submit abandons the pending refinement of this one, so frames
+ * of an older generation may stop after the coarse level.
+ *
+ * @param session      Session
+ * @param params_json  JSON edit parameters ({"operations": [...]})
+ *
+ * @return Generation (> 0), 0 on error
+ */
+uint64_t photowall_edit_session_submit(PhotowallEditSession* session, const char* params_json);
+
+/**
+ * Get the largest frame a session can produce in its current display mode
+ * (a square of the preview's longest edge, twice as wide side by side).
+ * Output buffers must hold a frame of this size.
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_edit_session_get_max_frame_size(
+    PhotowallEditSession* session,
+    uint32_t* out_width,
+    uint32_t* out_height
+);
+
+/**
+ * Render frames straight into caller-owned memory, e.g. a mapped staging
+ * texture. Takes effect after the frame in progress; do not call from the
+ * frame callback. Read the buffer only inside the frame callback.
+ *
+ * @param session  Session
+ * @param format   PHOTOWALL_PIXEL_*
+ * @param pixels   Buffer, or NULL to return to internal RGBA8 frames.
+ *                 Must stay valid until replaced or the session is closed
+ * @param stride   Bytes per row
+ * @param len      Buffer size in bytes
+ *
+ * @return 0 on success, -1 on error (e.g. buffer too small)
+ */
+int photowall_edit_session_set_output_buffer(
+    PhotowallEditSession* session,
+    uint32_t format,
+    uint8_t* pixels,
+    uint32_t stride,
+    size_t len
+);
+
+/**
+ * Render frames into a shared file mapping the host maps as well.
+ * The file is created (or truncated) with rows of max_width pixels and
+ * removed when the output is replaced or the session is closed.
+ *
+ * @param session     Session
+ * @param path        File to create (e.g. under /dev/shm)
+ * @param format      PHOTOWALL_PIXEL_*
+ * @param out_stride  Receives the bytes per row (may be NULL)
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_edit_session_create_shared_output(
+    PhotowallEditSession* session,
+    const char* path,
+    uint32_t format,
+    uint32_t* out_stride
+);
+
+/**
+ * Switch the display mode and re-render the last submitted parameters.
+ * "Before" is the photo with only rotation, flip and crop applied.
+ * Does not wait for the frame in progress, which is abandoned; safe to call
+ * from the frame callback.
+ *
+ * @param session              Session
+ * @param mode                 PHOTOWALL_DISPLAY_*
+ * @param split_position       Split line position 0.0-1.0 (SPLIT only)
+ * @param shadow_threshold     Channel value 0-255 at or below which shadows
+ *                             are marked (CLIPPING only)
+ * @param highlight_threshold  Channel value 0-255 at or above which
+ *                             highlights are marked (CLIPPING only)
+ *
+ * @return Generation (> 0), 0 on error (e.g. output buffer too small)
+ */
+uint64_t photowall_edit_session_set_display_mode(
+    PhotowallEditSession* session,
+    uint32_t mode,
+    float split_position,
+    uint32_t shadow_threshold,
+    uint32_t highlight_threshold
+);
+
+/**
+ * Set or clear the scopes callback. While set, every frame also computes
+ * a luma waveform, RGB parade and vectorscope in the same pass.
+ *
+ * @param session    Session
+ * @param callback   Scopes callback, NULL to stop computing scopes
+ * @param user_data  Passed to the callback; must stay valid until replaced or close
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_edit_session_set_scopes_callback(
+    PhotowallEditSession* session,
+    PhotowallScopesCallback callback,
+    void* user_data
+);
+
+/**
+ * Close a session. Waits for the render thread; no callback runs afterwards.
+ *
+ * @param session  Session (may be NULL)
+ */
+void photowall_edit_session_close(PhotowallEditSession* session);
+
 /* ============================================================================
  * Job Management API
  * ============================================================================ */
@@ -631,6 +1628,70 @@ int photowall_get_active_job_count(PhotowallHandle* handle);
  */
 int photowall_is_job_active(PhotowallHandle* handle, JobId job_id);
 
+/* ============================================================================
+ * Metrics API
+ * ============================================================================ */
+
+/**
+ * Get a snapshot of the runtime metrics as JSON.
+ *
+ * Cheap enough to poll every second. The snapshot holds:
+ * - counters: monotonic counts since the last reset (thumbnail.enqueued,
+ *   thumbnail.completed, indexer.files_processed, ...). Rates are the
+ *   difference between two snapshots divided by the polling interval.
+ * - gauges: current values (thumbnail.queue_depth, jobs.active,
+ *   indexer.last_run_files_per_sec)
+ * - hitRates: hit / (hit + miss) for cache counters (thumbnail.cache,
+ *   thumbnail.pack)
+ * - histograms: latency in microseconds {count, sumUs, meanUs, p50Us,
+ *   p90Us, p99Us, p999Us, maxUs, buckets?} for every FFI function
+ *   ("ffi.<name>"), DB connection wait and hold time (db.lock_wait,
+ *   db.query), thumbnail queue wait and generation time, and per-file
+ *   indexing time
+ *
+ * Histograms are log-linear with at most 12.5% relative error.
+ *
+ * @param handle           Valid handle
+ * @param include_buckets  1 to include non-empty buckets as [lowerUs, count]
+ * @param out_json         Output: JSON snapshot
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_get_metrics_json(PhotowallHandle* handle, int include_buckets, char** out_json);
+
+/**
+ * Reset all counters and histograms. Gauges keep their current value.
+ *
+ * @return 0 on success, -1 on error
+ */
+int photowall_reset_metrics(PhotowallHandle* handle);
+
+/* ============================================================================
+ * Benchmark Support (only exported when built with the `bench` feature)
+ * ============================================================================ */
+
+/**
+ * Populate an empty library with synthetic photos, tags, albums and folders.
+ *
+ * Photos are spread over folder_count folders in a two-level tree under
+ * /photowall-bench. Each photo gets 0-3 random tags and lands in a random
+ * album with 20% probability; 5% are marked favorite. The same seed always
+ * produces the same library. No image files are created.
+ *
+ * If the library already contains photos nothing is generated and the
+ * existing photo count is returned.
+ *
+ * @return Number of photos in the library (>= 0), -1 on error
+ */
+int64_t photowall_bench_generate_library(
+    PhotowallHandle* handle,
+    uint32_t photo_count,
+    uint32_t tag_count,
+    uint32_t album_count,
+    uint32_t folder_count,
+    uint64_t seed
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,7 +2,8 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
-use photowall_core::models::{CreateAlbum, PaginationParams, PhotoSortOptions};
+use photowall_core::metrics::Timer;
+use photowall_core::models::{BatchItemStatus, CreateAlbum, PaginationParams, PhotoSortOptions};
 use std::ffi::{c_char, CStr, CString};
 use std::panic::{catch_unwind, AssertUnwindSafe};
 
@@ -21,6 +22,30 @@ fn string_to_cstr(s: &str) -> *mut c_char {
         .unwrap_or(std::ptr::null_mut())
 }
 
+/// Helper to view a C id array as a slice (null is allowed when `count` is 0).
+unsafe fn id_slice<'a>(ptr: *const i64, count: u32) -> Option<&'a [i64]> {
+    if count == 0 {
+        return Some(&[]);
+    }
+    if ptr.is_null() {
+        return None;
+    }
+    Some(std::slice::from_raw_parts(ptr, count as usize))
+}
+
+/// Helper to copy per-item statuses to a C array; returns the applied count.
+unsafe fn write_statuses(statuses: &[BatchItemStatus], out_status: *mut u8) -> i32 {
+    if !out_status.is_null() {
+        for (i, status) in statuses.iter().enumerate() {
+            *out_status.add(i) = *status as u8;
+        }
+    }
+    statuses
+        .iter()
+        .filter(|s| **s == BatchItemStatus::Applied)
+        .count() as i32
+}
+
 /// Get all albums as JSON.
 #[no_mangle]
 pub unsafe extern "C" fn photowall_albums_get_all_json(
@@ -28,6 +53,7 @@ pub unsafe extern "C" fn photowall_albums_get_all_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.albums_get_all_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -65,6 +91,7 @@ pub unsafe extern "C" fn photowall_albums_add_photo(
     photo_id: i64,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.albums_add_photo");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -99,6 +126,7 @@ pub unsafe extern "C" fn photowall_albums_remove_photo(
     photo_id: i64,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.albums_remove_photo");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -125,6 +153,118 @@ pub unsafe extern "C" fn photowall_albums_remove_photo(
     })
 }
 
+/// Add photos to albums in one transaction.
+///
+/// Every photo is paired with every album. `out_status` (may be null) receives
+/// one `BatchItemStatus` byte per pair, photo-major:
+/// `out_status[photo_index * album_count + album_index]`.
+///
+/// # Returns
+/// - Number of pairs applied (>= 0)
+/// - `-1` on error (nothing is written)
+#[no_mangle]
+pub unsafe extern "C" fn photowall_albums_add_photos(
+    handle: *mut PhotowallHandle,
+    photo_ids: *const i64,
+    photo_count: u32,
+    album_ids: *const i64,
+    album_count: u32,
+    out_status: *mut u8,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.albums_add_photos");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return -1;
+        }
+
+        let (photo_ids, album_ids) = match (
+            id_slice(photo_ids, photo_count),
+            id_slice(album_ids, album_count),
+        ) {
+            (Some(p), Some(a)) => (p, a),
+            _ => {
+                set_last_error("photo_ids or album_ids is null");
+                return -1;
+            }
+        };
+
+        let handle = &*handle;
+        let db = handle.core.database();
+
+        match db.add_photos_to_albums(photo_ids, album_ids) {
+            Ok(statuses) => write_statuses(&statuses, out_status),
+            Err(e) => {
+                set_last_error(format!("add_photos_to_albums failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_albums_add_photos");
+        -1
+    })
+}
+
+/// Remove photos from albums in one transaction.
+///
+/// Every photo is paired with every album. `out_status` (may be null) receives
+/// one `BatchItemStatus` byte per pair, photo-major:
+/// `out_status[photo_index * album_count + album_index]`.
+///
+/// # Returns
+/// - Number of pairs applied (>= 0)
+/// - `-1` on error (nothing is written)
+#[no_mangle]
+pub unsafe extern "C" fn photowall_albums_remove_photos(
+    handle: *mut PhotowallHandle,
+    photo_ids: *const i64,
+    photo_count: u32,
+    album_ids: *const i64,
+    album_count: u32,
+    out_status: *mut u8,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.albums_remove_photos");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return -1;
+        }
+
+        let (photo_ids, album_ids) = match (
+            id_slice(photo_ids, photo_count),
+            id_slice(album_ids, album_count),
+        ) {
+            (Some(p), Some(a)) => (p, a),
+            _ => {
+                set_last_error("photo_ids or album_ids is null");
+                return -1;
+            }
+        };
+
+        let handle = &*handle;
+        let db = handle.core.database();
+
+        match db.remove_photos_from_albums(photo_ids, album_ids) {
+            Ok(statuses) => write_statuses(&statuses, out_status),
+            Err(e) => {
+                set_last_error(format!("remove_photos_from_albums failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_albums_remove_photos");
+        -1
+    })
+}
+
 /// Create a new album.
 #[no_mangle]
 pub unsafe extern "C" fn photowall_albums_create_json(
@@ -134,6 +274,7 @@ pub unsafe extern "C" fn photowall_albums_create_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.albums_create_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || name.is_null() || out_json.is_null() {
@@ -190,6 +331,7 @@ pub unsafe extern "C" fn photowall_albums_create_json(
 #[no_mangle]
 pub unsafe extern "C" fn photowall_albums_delete(handle: *mut PhotowallHandle, album_id: i64) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.albums_delete");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -227,6 +369,7 @@ pub unsafe extern "C" fn photowall_albums_get_photos_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.albums_get_photos_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
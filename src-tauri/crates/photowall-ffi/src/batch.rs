@@ -0,0 +1,343 @@
+//! Columnar binary photo batches.
+//!
+//! A `PhotowallPhotoBatch` is a struct-of-arrays view over a single
+//! library-owned allocation. Every column is a plain C array of `count`
+//! elements and all strings live NUL-terminated in one pool, so the host can
+//! read the result in place without parsing.
+
+use photowall_core::models::Photo;
+use std::ffi::c_char;
+
+/// Sentinel string offset for missing (NULL) values.
+pub const PHOTOWALL_BATCH_NO_STRING: u32 = u32::MAX;
+
+/// Photo is marked as favorite.
+pub const PHOTOWALL_PHOTO_FLAG_FAVORITE: u8 = 1 << 0;
+/// Photo is in the trash.
+pub const PHOTOWALL_PHOTO_FLAG_DELETED: u8 = 1 << 1;
+/// Photo has GPS coordinates.
+pub const PHOTOWALL_PHOTO_FLAG_HAS_GPS: u8 = 1 << 2;
+/// `dhashes` / `phashes` hold computed perceptual hashes.
+pub const PHOTOWALL_PHOTO_FLAG_HAS_PHASH: u8 = 1 << 3;
+
+/// Struct-of-arrays photo batch exposed to C.
+///
+/// String columns hold byte offsets into `strings`, or
+/// `PHOTOWALL_BATCH_NO_STRING` when the value is NULL. ThumbHash bytes are
+/// stored raw (not NUL-terminated) in the same pool; their length is in
+/// `thumbhash_lens`. Perceptual hashes are only meaningful when the row has
+/// `PHOTOWALL_PHOTO_FLAG_HAS_PHASH` set.
+#[repr(C)]
+pub struct PhotowallPhotoBatch {
+    pub count: u32,
+    pub has_more: i32,
+    /// Total matching photos, `-1` if not computed.
+    pub total: i64,
+    pub photo_ids: *const i64,
+    pub file_sizes: *const i64,
+    pub widths: *const i32,
+    pub heights: *const i32,
+    pub file_hashes: *const u32,
+    pub file_paths: *const u32,
+    pub dates_taken: *const u32,
+    pub dates_added: *const u32,
+    pub ratings: *const u8,
+    pub flags: *const u8,
+    pub strings: *const c_char,
+    pub strings_len: u32,
+    /// Offset of the next-page cursor JSON in `strings`.
+    pub next_cursor: u32,
+    pub thumbhashes: *const u32,
+    pub thumbhash_lens: *const u8,
+    pub dhashes: *const u64,
+    pub phashes: *const u64,
+}
+
+/// Owned batch allocation. The header must stay the first field so a pointer
+/// to the allocation can be handed out as `*mut PhotowallPhotoBatch`.
+#[repr(C)]
+struct OwnedPhotoBatch {
+    header: PhotowallPhotoBatch,
+    storage: Vec<u64>,
+}
+
+/// Columns gathered from query rows before they are laid out.
+#[derive(Default)]
+pub struct PhotoColumns {
+    photo_ids: Vec<i64>,
+    file_sizes: Vec<i64>,
+    dhashes: Vec<u64>,
+    phashes: Vec<u64>,
+    widths: Vec<i32>,
+    heights: Vec<i32>,
+    file_hashes: Vec<u32>,
+    file_paths: Vec<u32>,
+    dates_taken: Vec<u32>,
+    dates_added: Vec<u32>,
+    ratings: Vec<u8>,
+    flags: Vec<u8>,
+    thumbhashes: Vec<u32>,
+    thumbhash_lens: Vec<u8>,
+    strings: Vec<u8>,
+}
+
+impl PhotoColumns {
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            photo_ids: Vec::with_capacity(capacity),
+            file_sizes: Vec::with_capacity(capacity),
+            dhashes: Vec::with_capacity(capacity),
+            phashes: Vec::with_capacity(capacity),
+            widths: Vec::with_capacity(capacity),
+            heights: Vec::with_capacity(capacity),
+            file_hashes: Vec::with_capacity(capacity),
+            file_paths: Vec::with_capacity(capacity),
+            dates_taken: Vec::with_capacity(capacity),
+            dates_added: Vec::with_capacity(capacity),
+            ratings: Vec::with_capacity(capacity),
+            flags: Vec::with_capacity(capacity),
+            thumbhashes: Vec::with_capacity(capacity),
+            thumbhash_lens: Vec::with_capacity(capacity),
+            strings: Vec::with_capacity(capacity * 128),
+        }
+    }
+
+    pub fn from_photos(photos: &[Photo]) -> Self {
+        let mut columns = Self::with_capacity(photos.len());
+        for photo in photos {
+            columns.push(photo);
+        }
+        columns
+    }
+
+    pub fn len(&self) -> usize {
+        self.photo_ids.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.photo_ids.is_empty()
+    }
+
+    pub fn strings_len(&self) -> usize {
+        self.strings.len()
+    }
+
+    /// Bytes needed to lay out the current rows.
+    pub fn encoded_len(&self) -> usize {
+        BatchLayout::new(self.len(), self.strings.len()).total_len
+    }
+
+    /// Bytes that `push(photo)` would add to `encoded_len()`.
+    pub fn row_len(photo: &Photo) -> usize {
+        let strings = photo.file_hash.len()
+            + photo.file_path.len()
+            + photo.date_taken.as_ref().map_or(0, |s| s.len() + 1)
+            + photo.date_added.len()
+            + photo.thumbhash.as_ref().map_or(0, |t| t.len().min(u8::MAX as usize))
+            + 3;
+        BatchLayout::new(1, strings).total_len
+    }
+
+    /// Append one photo row.
+    pub fn push(&mut self, photo: &Photo) {
+        let mut flags = 0u8;
+        if photo.is_favorite {
+            flags |= PHOTOWALL_PHOTO_FLAG_FAVORITE;
+        }
+        if photo.is_deleted {
+            flags |= PHOTOWALL_PHOTO_FLAG_DELETED;
+        }
+        if photo.gps_latitude.is_some() && photo.gps_longitude.is_some() {
+            flags |= PHOTOWALL_PHOTO_FLAG_HAS_GPS;
+        }
+        if let (Some(_), Some(_)) = (photo.dhash, photo.phash) {
+            flags |= PHOTOWALL_PHOTO_FLAG_HAS_PHASH;
+        }
+
+        self.photo_ids.push(photo.photo_id);
+        self.file_sizes.push(photo.file_size);
+        self.dhashes.push(photo.dhash.unwrap_or(0));
+        self.phashes.push(photo.phash.unwrap_or(0));
+        self.widths.push(photo.width.unwrap_or(0));
+        self.heights.push(photo.height.unwrap_or(0));
+        let hash = self.intern(Some(&photo.file_hash));
+        self.file_hashes.push(hash);
+        let path = self.intern(Some(&photo.file_path));
+        self.file_paths.push(path);
+        let taken = self.intern(photo.date_taken.as_deref());
+        self.dates_taken.push(taken);
+        let added = self.intern(Some(&photo.date_added));
+        self.dates_added.push(added);
+        self.ratings.push(photo.rating.clamp(0, 5) as u8);
+        self.flags.push(flags);
+        match photo.thumbhash.as_deref() {
+            Some(bytes) if bytes.len() <= u8::MAX as usize => {
+                self.thumbhashes.push(self.strings.len() as u32);
+                self.thumbhash_lens.push(bytes.len() as u8);
+                self.strings.extend_from_slice(bytes);
+            }
+            _ => {
+                self.thumbhashes.push(PHOTOWALL_BATCH_NO_STRING);
+                self.thumbhash_lens.push(0);
+            }
+        }
+    }
+
+    /// Append a NUL-terminated string to the pool and return its offset.
+    pub fn intern(&mut self, value: Option<&str>) -> u32 {
+        match value {
+            Some(s) => {
+                let offset = self.strings.len() as u32;
+                self.strings.extend(s.bytes().filter(|&b| b != 0));
+                self.strings.push(0);
+                offset
+            }
+            None => PHOTOWALL_BATCH_NO_STRING,
+        }
+    }
+}
+
+/// Byte offsets of each column inside a batch buffer.
+pub struct BatchLayout {
+    photo_ids: usize,
+    file_sizes: usize,
+    dhashes: usize,
+    phashes: usize,
+    widths: usize,
+    heights: usize,
+    file_hashes: usize,
+    file_paths: usize,
+    dates_taken: usize,
+    dates_added: usize,
+    thumbhashes: usize,
+    ratings: usize,
+    flags: usize,
+    thumbhash_lens: usize,
+    strings: usize,
+    pub total_len: usize,
+}
+
+impl BatchLayout {
+    /// Compute the layout for `count` rows and `strings_len` pool bytes.
+    ///
+    /// Columns are ordered by decreasing alignment, so an 8-byte aligned base
+    /// keeps every column naturally aligned.
+    pub fn new(count: usize, strings_len: usize) -> Self {
+        let photo_ids = 0;
+        let file_sizes = photo_ids + count * 8;
+        let dhashes = file_sizes + count * 8;
+        let phashes = dhashes + count * 8;
+        let widths = phashes + count * 8;
+        let heights = widths + count * 4;
+        let file_hashes = heights + count * 4;
+        let file_paths = file_hashes + count * 4;
+        let dates_taken = file_paths + count * 4;
+        let dates_added = dates_taken + count * 4;
+        let thumbhashes = dates_added + count * 4;
+        let ratings = thumbhashes + count * 4;
+        let flags = ratings + count;
+        let thumbhash_lens = flags + count;
+        let strings = thumbhash_lens + count;
+        Self {
+            photo_ids,
+            file_sizes,
+            dhashes,
+            phashes,
+            widths,
+            heights,
+            file_hashes,
+            file_paths,
+            dates_taken,
+            dates_added,
+            thumbhashes,
+            ratings,
+            flags,
+            thumbhash_lens,
+            strings,
+            total_len: strings + strings_len,
+        }
+    }
+}
+
+unsafe fn copy_column<T: Copy>(base: *mut u8, offset: usize, column: &[T]) -> *const T {
+    let dst = base.add(offset) as *mut T;
+    std::ptr::copy_nonoverlapping(column.as_ptr(), dst, column.len());
+    dst
+}
+
+/// Write `columns` into `base` and return a header pointing into it.
+///
+/// # Safety
+/// `base` must be 8-byte aligned and valid for `layout.total_len` bytes.
+pub unsafe fn write_batch(
+    base: *mut u8,
+    layout: &BatchLayout,
+    columns: &PhotoColumns,
+    has_more: bool,
+    total: Option<i64>,
+    next_cursor: u32,
+) -> PhotowallPhotoBatch {
+    PhotowallPhotoBatch {
+        count: columns.len() as u32,
+        has_more: has_more as i32,
+        total: total.unwrap_or(-1),
+        photo_ids: copy_column(base, layout.photo_ids, &columns.photo_ids),
+        file_sizes: copy_column(base, layout.file_sizes, &columns.file_sizes),
+        widths: copy_column(base, layout.widths, &columns.widths),
+        heights: copy_column(base, layout.heights, &columns.heights),
+        file_hashes: copy_column(base, layout.file_hashes, &columns.file_hashes),
+        file_paths: copy_column(base, layout.file_paths, &columns.file_paths),
+        dates_taken: copy_column(base, layout.dates_taken, &columns.dates_taken),
+        dates_added: copy_column(base, layout.dates_added, &columns.dates_added),
+        ratings: copy_column(base, layout.ratings, &columns.ratings),
+        flags: copy_column(base, layout.flags, &columns.flags),
+        strings: copy_column(base, layout.strings, &columns.strings) as *const c_char,
+        strings_len: columns.strings.len() as u32,
+        next_cursor,
+        thumbhashes: copy_column(base, layout.thumbhashes, &columns.thumbhashes),
+        thumbhash_lens: copy_column(base, layout.thumbhash_lens, &columns.thumbhash_lens),
+        dhashes: copy_column(base, layout.dhashes, &columns.dhashes),
+        phashes: copy_column(base, layout.phashes, &columns.phashes),
+    }
+}
+
+/// Lay out `columns` in a fresh library-owned allocation.
+///
+/// The result must be released with `photowall_free_photo_batch`.
+pub fn into_owned_batch(
+    mut columns: PhotoColumns,
+    has_more: bool,
+    total: Option<i64>,
+    next_cursor_json: Option<&str>,
+) -> *mut PhotowallPhotoBatch {
+    let next_cursor = columns.intern(next_cursor_json);
+    let layout = BatchLayout::new(columns.len(), columns.strings_len());
+    let mut storage = vec![0u64; layout.total_len.div_ceil(8).max(1)];
+
+    let header = unsafe {
+        write_batch(
+            storage.as_mut_ptr() as *mut u8,
+            &layout,
+            &columns,
+            has_more,
+            total,
+            next_cursor,
+        )
+    };
+
+    // Moving the Vec does not move its heap buffer, so the column pointers
+    // stay valid.
+    Box::into_raw(Box::new(OwnedPhotoBatch { header, storage })) as *mut PhotowallPhotoBatch
+}
+
+/// Free a photo batch returned by a `_bin` function.
+///
+/// # Safety
+/// - `batch` must be a pointer returned by a photowall `_bin` function
+/// - After calling this function, the pointer and all column pointers are invalid
+#[no_mangle]
+pub unsafe extern "C" fn photowall_free_photo_batch(batch: *mut PhotowallPhotoBatch) {
+    if !batch.is_null() {
+        let _ = Box::from_raw(batch as *mut OwnedPhotoBatch);
+    }
+}
@@ -0,0 +1,201 @@
+//! Synthetic library generation for the C API benchmark driver.
+//!
+//! Only compiled with the `bench` feature; see `bench/photowall_bench.cpp`.
+
+use crate::error::{clear_last_error, set_last_error};
+use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
+use photowall_core::models::{CreateAlbum, CreatePhoto, CreateTag};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+
+/// Photos inserted per transaction.
+const INSERT_CHUNK: usize = 10_000;
+
+const CAMERAS: [&str; 6] = [
+    "Canon EOS R5",
+    "Nikon Z 6II",
+    "Sony ILCE-7M4",
+    "FUJIFILM X-T5",
+    "iPhone 15 Pro",
+    "Pixel 8",
+];
+
+const LENSES: [&str; 4] = ["RF24-105mm F4 L IS USM", "NIKKOR Z 50mm f/1.8 S", "FE 35mm F1.8", "XF23mmF2 R WR"];
+
+const DIMENSIONS: [(i32, i32); 4] = [(6000, 4000), (4000, 6000), (4032, 3024), (8192, 5464)];
+
+/// SplitMix64, so a given seed always produces the same library.
+struct Rng(u64);
+
+impl Rng {
+    fn next(&mut self) -> u64 {
+        self.0 = self.0.wrapping_add(0x9E37_79B9_7F4A_7C15);
+        let mut z = self.0;
+        z = (z ^ (z >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+        z = (z ^ (z >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+        z ^ (z >> 31)
+    }
+
+    fn below(&mut self, n: u64) -> u64 {
+        self.next() % n.max(1)
+    }
+}
+
+fn synthetic_photo(rng: &mut Rng, index: u32, folder_count: u32) -> CreatePhoto {
+    // Two-level tree: /photowall-bench/group_NN/folder_NNNNN
+    let folder = rng.below(folder_count as u64) as u32;
+    let file_name = format!("IMG_{:07}.jpg", index);
+    let (width, height) = DIMENSIONS[rng.below(DIMENSIONS.len() as u64) as usize];
+    let camera = rng.below(CAMERAS.len() as u64) as usize;
+
+    let day = rng.below(3650);
+    let (year, day_of_year) = (2015 + day / 365, day % 365);
+    let date_taken = format!(
+        "{:04}-{:02}-{:02}T{:02}:{:02}:{:02}Z",
+        year,
+        day_of_year / 31 % 12 + 1,
+        day_of_year % 28 + 1,
+        rng.below(24),
+        rng.below(60),
+        rng.below(60)
+    );
+
+    CreatePhoto {
+        file_path: format!("/photowall-bench/group_{:02}/folder_{:05}/{}", folder % 32, folder, file_name),
+        file_name,
+        file_size: 1_000_000 + rng.below(11_000_000) as i64,
+        file_hash: format!("{:016x}{:016x}", rng.next(), index),
+        width: Some(width),
+        height: Some(height),
+        format: Some("jpg".to_string()),
+        date_taken: Some(date_taken),
+        camera_model: Some(CAMERAS[camera].to_string()),
+        lens_model: (camera < LENSES.len()).then(|| LENSES[camera].to_string()),
+        focal_length: Some(24.0 + rng.below(80) as f64),
+        aperture: Some(1.8 + rng.below(60) as f64 / 10.0),
+        iso: Some(100 << rng.below(6)),
+        shutter_speed: Some(format!("1/{}", 30 << rng.below(6))),
+        gps_latitude: None,
+        gps_longitude: None,
+        orientation: Some(1),
+    }
+}
+
+/// Populate an empty library with synthetic photos, tags, albums and folders.
+///
+/// Photos are spread over `folder_count` folders in a two-level tree under
+/// `/photowall-bench`. Each photo gets 0-3 random tags and lands in a random
+/// album with 20% probability; 5% are marked favorite. The same `seed`
+/// always produces the same library. No image files are created.
+///
+/// If the library already contains photos nothing is generated and the
+/// existing photo count is returned, so the driver can reuse a library
+/// between runs.
+///
+/// # Returns
+/// - Number of photos in the library (>= 0)
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_bench_generate_library(
+    handle: *mut PhotowallHandle,
+    photo_count: u32,
+    tag_count: u32,
+    album_count: u32,
+    folder_count: u32,
+    seed: u64,
+) -> i64 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.bench_generate_library");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        let db = handle.core.database();
+
+        match db.count_photos() {
+            Ok(0) => {}
+            Ok(existing) => return existing,
+            Err(e) => {
+                set_last_error(format!("count_photos failed: {}", e));
+                return -1;
+            }
+        }
+
+        let mut rng = Rng(seed);
+        let mut generate = || -> photowall_core::utils::AppResult<i64> {
+            let mut tag_ids = Vec::with_capacity(tag_count as usize);
+            for i in 0..tag_count {
+                tag_ids.push(db.create_tag(&CreateTag {
+                    tag_name: format!("bench-tag-{:04}", i),
+                    color: None,
+                })?);
+            }
+            let mut album_ids = Vec::with_capacity(album_count as usize);
+            for i in 0..album_count {
+                album_ids.push(db.create_album(&CreateAlbum {
+                    album_name: format!("bench-album-{:04}", i),
+                    description: None,
+                })?);
+            }
+
+            let mut inserted = 0i64;
+            let mut next_index = 0u32;
+            while next_index < photo_count {
+                let end = (next_index as usize + INSERT_CHUNK).min(photo_count as usize) as u32;
+                let photos: Vec<CreatePhoto> = (next_index..end)
+                    .map(|i| synthetic_photo(&mut rng, i, folder_count.max(1)))
+                    .collect();
+                let ids = db.create_photos_batch(&photos)?;
+                inserted += ids.len() as i64;
+                next_index = end;
+
+                let mut by_tag: Vec<Vec<i64>> = vec![Vec::new(); tag_ids.len()];
+                let mut by_album: Vec<Vec<i64>> = vec![Vec::new(); album_ids.len()];
+                let mut favorites = Vec::new();
+                for &id in &ids {
+                    if !by_tag.is_empty() {
+                        for _ in 0..rng.below(4) {
+                            let tag = rng.below(by_tag.len() as u64) as usize;
+                            if by_tag[tag].last() != Some(&id) {
+                                by_tag[tag].push(id);
+                            }
+                        }
+                    }
+                    if !by_album.is_empty() && rng.below(5) == 0 {
+                        let album = rng.below(by_album.len() as u64) as usize;
+                        by_album[album].push(id);
+                    }
+                    if rng.below(20) == 0 {
+                        favorites.push(id);
+                    }
+                }
+
+                for (tag_id, photo_ids) in tag_ids.iter().zip(&by_tag) {
+                    db.add_tags_to_photos(photo_ids, &[*tag_id])?;
+                }
+                for (album_id, photo_ids) in album_ids.iter().zip(&by_album) {
+                    db.add_photos_to_album(*album_id, photo_ids)?;
+                }
+                db.set_photos_favorite(&favorites, true)?;
+            }
+            Ok(inserted)
+        };
+
+        match generate() {
+            Ok(inserted) => inserted,
+            Err(e) => {
+                set_last_error(format!("generate_library failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_bench_generate_library");
+        -1
+    })
+}
@@ -2,7 +2,9 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::{EventCallback, PhotowallHandle};
-use std::ffi::c_void;
+use photowall_core::metrics::Timer;
+use photowall_core::events::CoalesceMode;
+use std::ffi::{c_char, c_void, CStr};
 use std::panic::{catch_unwind, AssertUnwindSafe};
 
 /// Register an event callback.
@@ -22,6 +24,7 @@ pub unsafe extern "C" fn photowall_set_event_callback(
     user_data: *mut c_void,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.set_event_callback");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -52,6 +55,7 @@ pub unsafe extern "C" fn photowall_set_event_callback(
 #[no_mangle]
 pub unsafe extern "C" fn photowall_clear_event_callback(handle: *mut PhotowallHandle) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.clear_event_callback");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -70,3 +74,97 @@ pub unsafe extern "C" fn photowall_clear_event_callback(handle: *mut PhotowallHa
         -1
     })
 }
+
+/// Configure coalescing for one event type.
+///
+/// Coalesced events are delivered at most `max_rate_hz` times per second.
+/// `mode` selects how events within one tick are merged:
+/// - `0`: off, deliver every event immediately (default for all events)
+/// - `1`: latest, deliver only the most recent payload
+/// - `2`: batch, deliver all payloads as one JSON array under `"<name>-batch"`
+///
+/// # Safety
+/// - `handle` must be a valid pointer from `photowall_init`.
+/// - `event_name` must be a valid null-terminated UTF-8 string.
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_set_event_coalescing(
+    handle: *mut PhotowallHandle,
+    event_name: *const c_char,
+    mode: i32,
+    max_rate_hz: u32,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.set_event_coalescing");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || event_name.is_null() {
+            set_last_error("handle or event_name is null");
+            return -1;
+        }
+
+        let name = match CStr::from_ptr(event_name).to_str() {
+            Ok(s) => s,
+            Err(_) => {
+                set_last_error("invalid UTF-8 in event_name");
+                return -1;
+            }
+        };
+
+        let mode = match mode {
+            0 => CoalesceMode::Immediate,
+            1 => CoalesceMode::Latest,
+            2 => CoalesceMode::Batch,
+            _ => {
+                set_last_error(format!("invalid coalescing mode: {}", mode));
+                return -1;
+            }
+        };
+
+        let handle = &*handle;
+        handle.events.configure(name, mode, max_rate_hz);
+        tracing::debug!("Event coalescing for {}: {:?} @ {} Hz", name, mode, max_rate_hz);
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_set_event_coalescing");
+        -1
+    })
+}
+
+/// Deliver all pending coalesced events immediately.
+///
+/// Safe to call from inside the event callback; the events are then
+/// delivered once that callback returns.
+///
+/// # Safety
+/// - `handle` must be a valid pointer from `photowall_init`.
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_flush_events(handle: *mut PhotowallHandle) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.flush_events");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        handle.events.flush();
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_flush_events");
+        -1
+    })
+}
@@ -0,0 +1,164 @@
+//! Colour-similarity search API.
+//!
+//! Queries scan the in-memory colour embeddings loaded at `photowall_init`;
+//! no image data is read at query time.
+
+use crate::error::{clear_last_error, set_last_error};
+use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
+use photowall_core::utils::color_signature::{palette_to_embedding, PaletteColor};
+use serde::Deserialize;
+use std::ffi::{c_char, CStr, CString};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+
+fn string_to_cstr(s: &str) -> *mut c_char {
+    CString::new(s)
+        .map(|cs| cs.into_raw())
+        .unwrap_or(std::ptr::null_mut())
+}
+
+/// One palette entry: either `"#rrggbb"` or `{"color": "#rrggbb", "weight": 0.6}`.
+#[derive(Deserialize)]
+#[serde(untagged)]
+enum PaletteEntry {
+    Hex(String),
+    Weighted { color: String, weight: Option<f32> },
+}
+
+impl PaletteEntry {
+    fn to_color(&self) -> Option<PaletteColor> {
+        match self {
+            PaletteEntry::Hex(hex) => PaletteColor::parse_hex(hex, 1.0),
+            PaletteEntry::Weighted { color, weight } => PaletteColor::parse_hex(color, weight.unwrap_or(1.0)),
+        }
+    }
+}
+
+/// Find the photos whose colour distribution is closest to a photo's.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `photo_id`: Query photo
+/// - `limit`: Maximum number of results, `0` for no limit
+/// - `out_json`: Output `[{"photoId": 12, "distance": 85}, ...]` sorted by
+///   distance (must be freed with `photowall_free_string`)
+///
+/// # Returns
+/// - `0` on success
+/// - `1` if the photo is not in the index (missing, trashed or not analysed yet)
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_find_similar_colors_json(
+    handle: *mut PhotowallHandle,
+    photo_id: i64,
+    limit: u32,
+    out_json: *mut *mut c_char,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.find_similar_colors_json");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || out_json.is_null() {
+            set_last_error("handle or out_json is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+
+        match handle.core.colors().similar_to_photo(photo_id, limit as usize) {
+            Ok(Some(matches)) => {
+                let json = serde_json::to_string(&matches).unwrap_or_else(|_| "[]".to_string());
+                *out_json = string_to_cstr(&json);
+                0
+            }
+            Ok(None) => {
+                *out_json = std::ptr::null_mut();
+                1
+            }
+            Err(e) => {
+                set_last_error(format!("find_similar_colors failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_find_similar_colors_json");
+        -1
+    })
+}
+
+/// Find the photos whose colour distribution best matches a palette.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `palette_json`: `["#1e90ff", "#f5deb3"]` or
+///   `[{"color": "#1e90ff", "weight": 0.7}, ...]`; weights default to equal
+/// - `limit`: Maximum number of results, `0` for no limit
+/// - `out_json`: Output `[{"photoId": 12, "distance": 85}, ...]` sorted by
+///   distance (must be freed with `photowall_free_string`)
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_find_photos_by_palette_json(
+    handle: *mut PhotowallHandle,
+    palette_json: *const c_char,
+    limit: u32,
+    out_json: *mut *mut c_char,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.find_photos_by_palette_json");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || palette_json.is_null() || out_json.is_null() {
+            set_last_error("handle, palette_json or out_json is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+
+        let json_str = match CStr::from_ptr(palette_json).to_str() {
+            Ok(s) => s,
+            Err(_) => {
+                set_last_error("invalid UTF-8 in palette_json");
+                return -1;
+            }
+        };
+
+        let entries: Vec<PaletteEntry> = match serde_json::from_str(json_str) {
+            Ok(entries) => entries,
+            Err(e) => {
+                set_last_error(format!("invalid palette JSON: {}", e));
+                return -1;
+            }
+        };
+
+        let palette: Option<Vec<PaletteColor>> = entries.iter().map(PaletteEntry::to_color).collect();
+        let embedding = match palette.as_deref().and_then(palette_to_embedding) {
+            Some(embedding) => embedding,
+            None => {
+                set_last_error("palette must contain at least one #rrggbb colour");
+                return -1;
+            }
+        };
+
+        match handle.core.colors().similar_to_embedding(&embedding, limit as usize) {
+            Ok(matches) => {
+                let json = serde_json::to_string(&matches).unwrap_or_else(|_| "[]".to_string());
+                *out_json = string_to_cstr(&json);
+                0
+            }
+            Err(e) => {
+                set_last_error(format!("find_photos_by_palette failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_find_photos_by_palette_json");
+        -1
+    })
+}
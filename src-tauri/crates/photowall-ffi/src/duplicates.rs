@@ -0,0 +1,156 @@
+//! Near-duplicate search API.
+//!
+//! Queries go to the in-memory Hamming index loaded at `photowall_init`;
+//! no database access is needed.
+
+use crate::error::{clear_last_error, set_last_error};
+use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
+use photowall_core::services::PerceptualHashKind;
+use std::ffi::{c_char, CString};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+
+/// Search by DCT pHash (robust to resizing, recompression, mild edits).
+pub const PHOTOWALL_HASH_PHASH: i32 = 0;
+/// Search by dHash.
+pub const PHOTOWALL_HASH_DHASH: i32 = 1;
+
+fn string_to_cstr(s: &str) -> *mut c_char {
+    CString::new(s)
+        .map(|cs| cs.into_raw())
+        .unwrap_or(std::ptr::null_mut())
+}
+
+fn hash_kind(kind: i32) -> Option<PerceptualHashKind> {
+    match kind {
+        PHOTOWALL_HASH_PHASH => Some(PerceptualHashKind::PHash),
+        PHOTOWALL_HASH_DHASH => Some(PerceptualHashKind::DHash),
+        _ => None,
+    }
+}
+
+/// Find photos whose perceptual hash is within `max_distance` bits of a photo.
+///
+/// # Parameters
+/// - `kind`: `PHOTOWALL_HASH_PHASH` or `PHOTOWALL_HASH_DHASH`
+/// - `max_distance`: Hamming distance, clamped to 27
+/// - `limit`: Maximum number of results, `0` for no limit
+/// - `out_json`: Output `[{"photoId": 12, "distance": 3}, ...]` sorted by
+///   distance (must be freed with `photowall_free_string`)
+///
+/// # Returns
+/// - `0` on success
+/// - `1` if the photo is not in the index (missing, trashed or no hash yet)
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_find_similar_photos_json(
+    handle: *mut PhotowallHandle,
+    photo_id: i64,
+    kind: i32,
+    max_distance: u32,
+    limit: u32,
+    out_json: *mut *mut c_char,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.find_similar_photos_json");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || out_json.is_null() {
+            set_last_error("handle or out_json is null");
+            return -1;
+        }
+
+        let kind = match hash_kind(kind) {
+            Some(kind) => kind,
+            None => {
+                set_last_error(format!("invalid hash kind: {}", kind));
+                return -1;
+            }
+        };
+
+        let handle = &*handle;
+
+        match handle.core.duplicates().neighbors(photo_id, kind, max_distance) {
+            Ok(Some(mut neighbors)) => {
+                if limit > 0 {
+                    neighbors.truncate(limit as usize);
+                }
+                let json = serde_json::to_string(&neighbors).unwrap_or_else(|_| "[]".to_string());
+                *out_json = string_to_cstr(&json);
+                0
+            }
+            Ok(None) => {
+                *out_json = std::ptr::null_mut();
+                1
+            }
+            Err(e) => {
+                set_last_error(format!("find_similar_photos failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_find_similar_photos_json");
+        -1
+    })
+}
+
+/// Group the whole library into near-duplicate clusters.
+///
+/// Photos within `max_distance` bits of each other are linked and each
+/// connected group of two or more photos is one cluster.
+///
+/// # Parameters
+/// - `kind`: `PHOTOWALL_HASH_PHASH` or `PHOTOWALL_HASH_DHASH`
+/// - `max_distance`: Hamming distance, clamped to 27
+/// - `out_json`: Output `[[1, 5, 9], [3, 4], ...]`, largest cluster first,
+///   photo IDs ascending (must be freed with `photowall_free_string`)
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_get_duplicate_clusters_json(
+    handle: *mut PhotowallHandle,
+    kind: i32,
+    max_distance: u32,
+    out_json: *mut *mut c_char,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.get_duplicate_clusters_json");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || out_json.is_null() {
+            set_last_error("handle or out_json is null");
+            return -1;
+        }
+
+        let kind = match hash_kind(kind) {
+            Some(kind) => kind,
+            None => {
+                set_last_error(format!("invalid hash kind: {}", kind));
+                return -1;
+            }
+        };
+
+        let handle = &*handle;
+
+        match handle.core.duplicates().clusters(kind, max_distance) {
+            Ok(clusters) => {
+                let json = serde_json::to_string(&clusters).unwrap_or_else(|_| "[]".to_string());
+                *out_json = string_to_cstr(&json);
+                0
+            }
+            Err(e) => {
+                set_last_error(format!("get_duplicate_clusters failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_get_duplicate_clusters_json");
+        -1
+    })
+}
@@ -0,0 +1,553 @@
+//! Edit session API - progressive preview rendering.
+//!
+//! A session decodes the photo once and keeps two preview sources in memory.
+//! Every parameter change is rendered coarse-to-fine on a background thread:
+//! a quarter-resolution frame first, then the full preview. A newer change
+//! abandons the refinement of the older one.
+//!
+//! Frames can be written straight into memory owned by the host (or a
+//! file mapping the host maps) in RGBA8 or RGBA16F, so the display layer
+//! uploads them to a texture without another copy.
+//!
+//! Before/after comparisons and clipping warnings are composed inside the
+//! same output pass, so switching display modes costs one normal render.
+//! Waveform, RGB parade and vectorscope counts are accumulated in that pass
+//! too and delivered with every frame when a scopes callback is set.
+
+use crate::error::{clear_last_error, set_last_error};
+use photowall_core::metrics::Timer;
+use photowall_core::services::{
+    DisplayMode, EditParams, EditSession, EditSessionOptions, OutputBuffer, PixelFormat, PreviewFrame,
+    PreviewLevel, SCOPE_COLUMNS, SCOPE_LEVELS, VECTORSCOPE_SIZE,
+};
+use std::ffi::{c_char, c_void, CStr};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::path::PathBuf;
+use std::sync::{Arc, Mutex};
+
+/// Coarse preview frame (quarter of the preview edge length).
+pub const PHOTOWALL_PREVIEW_COARSE: u32 = 0;
+/// Full-resolution preview frame.
+pub const PHOTOWALL_PREVIEW_FULL: u32 = 1;
+
+/// 8-bit RGBA output.
+pub const PHOTOWALL_PIXEL_RGBA8: u32 = 0;
+/// Half-float RGBA output (native byte order, sRGB-encoded 0..1).
+pub const PHOTOWALL_PIXEL_RGBA16F: u32 = 1;
+
+/// Edited result only.
+pub const PHOTOWALL_DISPLAY_EDITED: u32 = 0;
+/// Before on the left of a vertical split line, edited on the right.
+pub const PHOTOWALL_DISPLAY_SPLIT: u32 = 1;
+/// Before and edited side by side; frames are twice as wide.
+pub const PHOTOWALL_DISPLAY_SIDE_BY_SIDE: u32 = 2;
+/// Edited result with clipped highlights in red and clipped shadows in blue.
+pub const PHOTOWALL_DISPLAY_CLIPPING: u32 = 3;
+
+fn pixel_format(format: u32) -> Option<PixelFormat> {
+    match format {
+        PHOTOWALL_PIXEL_RGBA8 => Some(PixelFormat::Rgba8),
+        PHOTOWALL_PIXEL_RGBA16F => Some(PixelFormat::Rgba16F),
+        _ => None,
+    }
+}
+
+/// Preview frame callback type.
+/// - `generation`: Value returned by the `photowall_edit_session_submit` call
+///   this frame belongs to
+/// - `level`: `PHOTOWALL_PREVIEW_*`
+/// - `is_final`: `1` for the last frame of this generation
+/// - `pixels`: Rows of `stride` bytes, valid only during the call. RGBA8
+///   unless an output buffer is set, in which case this points to the start
+///   of that buffer and uses its format
+/// - `user_data`: user-provided context pointer
+pub type PreviewFrameCallback = extern "C" fn(
+    generation: u64,
+    level: u32,
+    is_final: i32,
+    width: u32,
+    height: u32,
+    stride: u32,
+    pixels: *const u8,
+    user_data: *mut c_void,
+);
+
+/// Callback with its user data.
+struct FrameTarget {
+    callback: PreviewFrameCallback,
+    user_data: *mut c_void,
+}
+
+// SAFETY: the caller guarantees the callback and user_data are thread-safe
+unsafe impl Send for FrameTarget {}
+unsafe impl Sync for FrameTarget {}
+
+/// Scope counts of one frame, valid only during the scopes callback.
+#[repr(C)]
+pub struct PhotowallScopes {
+    /// Waveform and parade columns (image width split evenly)
+    pub columns: u32,
+    /// Waveform and parade levels (row 0 = black)
+    pub levels: u32,
+    /// Vectorscope edge length
+    pub vectorscope_size: u32,
+    /// Luma waveform, `levels` rows of `columns` counts
+    pub waveform: *const u32,
+    /// R, G and B blocks, each laid out like the waveform
+    pub parade: *const u32,
+    /// `vectorscope_size` rows (Cr) of `vectorscope_size` counts (Cb);
+    /// neutral colours land in the centre
+    pub vectorscope: *const u32,
+}
+
+/// Scopes callback type.
+/// - `generation`, `level`: Same as the frame these counts belong to
+/// - `scopes`: Counts, valid only during the call
+/// - `user_data`: user-provided context pointer
+pub type ScopesCallback =
+    extern "C" fn(generation: u64, level: u32, scopes: *const PhotowallScopes, user_data: *mut c_void);
+
+/// Scopes callback with its user data.
+struct ScopesTarget {
+    callback: ScopesCallback,
+    user_data: *mut c_void,
+}
+
+// SAFETY: the caller guarantees the callback and user_data are thread-safe
+unsafe impl Send for ScopesTarget {}
+
+/// Opaque edit session handle exposed to C.
+pub struct PhotowallEditSession {
+    session: EditSession,
+    scopes_target: Arc<Mutex<Option<ScopesTarget>>>,
+}
+
+/// Open an edit session for a photo.
+///
+/// # Parameters
+/// - `path`: Image file path (RAW files are not supported)
+/// - `preview_max_size`: Longest edge of the full preview (0 = 1600)
+/// - `callback`: Called on the render thread for every frame
+/// - `user_data`: Passed to the callback; must stay valid until the session is closed
+///
+/// # Returns
+/// - Session (must be closed with `photowall_edit_session_close`)
+/// - `NULL` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_edit_session_open(
+    path: *const c_char,
+    preview_max_size: u32,
+    callback: Option<PreviewFrameCallback>,
+    user_data: *mut c_void,
+) -> *mut PhotowallEditSession {
+    clear_last_error();
+    let _timer = Timer::start("ffi.edit_session_open");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        let (path, callback) = match (path.is_null(), callback) {
+            (false, Some(callback)) => (CStr::from_ptr(path), callback),
+            _ => {
+                set_last_error("path or callback is null");
+                return std::ptr::null_mut();
+            }
+        };
+        let path = match path.to_str() {
+            Ok(s) => PathBuf::from(s),
+            Err(_) => {
+                set_last_error("invalid UTF-8 in path");
+                return std::ptr::null_mut();
+            }
+        };
+
+        let mut options = EditSessionOptions::default();
+        if preview_max_size > 0 {
+            options.preview_max_size = preview_max_size;
+        }
+
+        let target = FrameTarget { callback, user_data };
+        let scopes_target: Arc<Mutex<Option<ScopesTarget>>> = Arc::new(Mutex::new(None));
+        let frame_scopes_target = scopes_target.clone();
+        let on_frame = Box::new(move |frame: &PreviewFrame| {
+            let level = match frame.level {
+                PreviewLevel::Coarse => PHOTOWALL_PREVIEW_COARSE,
+                PreviewLevel::Full => PHOTOWALL_PREVIEW_FULL,
+            };
+            // Scopes first, so the host can draw them together with the frame.
+            if let Some(scopes) = frame.scopes {
+                let guard = frame_scopes_target.lock().unwrap_or_else(|e| e.into_inner());
+                if let Some(scopes_cb) = guard.as_ref() {
+                    let counts = PhotowallScopes {
+                        columns: SCOPE_COLUMNS as u32,
+                        levels: SCOPE_LEVELS as u32,
+                        vectorscope_size: VECTORSCOPE_SIZE as u32,
+                        waveform: scopes.waveform.as_ptr(),
+                        parade: scopes.parade.as_ptr(),
+                        vectorscope: scopes.vectorscope.as_ptr(),
+                    };
+                    (scopes_cb.callback)(frame.generation, level, &counts, scopes_cb.user_data);
+                }
+            }
+            (target.callback)(
+                frame.generation,
+                level,
+                frame.is_final as i32,
+                frame.width,
+                frame.height,
+                frame.stride as u32,
+                frame.pixels.as_ptr(),
+                target.user_data,
+            );
+        });
+
+        match EditSession::open(&path, options, on_frame) {
+            Ok(session) => Box::into_raw(Box::new(PhotowallEditSession { session, scopes_target })),
+            Err(e) => {
+                set_last_error(format!("failed to open edit session: {}", e));
+                std::ptr::null_mut()
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_edit_session_open");
+        std::ptr::null_mut()
+    })
+}
+
+/// Submit new edit parameters for rendering.
+///
+/// Returns immediately. Frames for these parameters arrive through the
+/// session callback; a later submit abandons any refinement still pending.
+///
+/// # Parameters
+/// - `session`: Session from `photowall_edit_session_open`
+/// - `params_json`: JSON edit parameters (`{"operations": [...]}`)
+///
+/// # Returns
+/// - Generation (> 0) identifying the frames of this submit
+/// - `0` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_edit_session_submit(
+    session: *mut PhotowallEditSession,
+    params_json: *const c_char,
+) -> u64 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.edit_session_submit");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if session.is_null() || params_json.is_null() {
+            set_last_error("session or params_json is null");
+            return 0;
+        }
+
+        let params: EditParams = match CStr::from_ptr(params_json)
+            .to_str()
+            .map_err(|e| e.to_string())
+            .and_then(|s| serde_json::from_str(s).map_err(|e| e.to_string()))
+        {
+            Ok(params) => params,
+            Err(e) => {
+                set_last_error(format!("invalid edit params: {}", e));
+                return 0;
+            }
+        };
+
+        (*session).session.submit(params)
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_edit_session_submit");
+        0
+    })
+}
+
+/// Get the largest frame the session can produce in its current display mode.
+///
+/// Output buffers must hold a frame of this size; rotation swaps width and
+/// height and cropping only shrinks, so the size is a square (twice as wide
+/// side by side).
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_edit_session_get_max_frame_size(
+    session: *mut PhotowallEditSession,
+    out_width: *mut u32,
+    out_height: *mut u32,
+) -> i32 {
+    clear_last_error();
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if session.is_null() || out_width.is_null() || out_height.is_null() {
+            set_last_error("session or output pointer is null");
+            return -1;
+        }
+
+        let (width, height) = (*session).session.max_frame_size();
+        *out_width = width;
+        *out_height = height;
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_edit_session_get_max_frame_size");
+        -1
+    })
+}
+
+/// Render frames into caller-owned memory.
+///
+/// Takes effect once the frame currently being rendered is delivered, so it
+/// must not be called from the frame callback. The previous output buffer
+/// (if any) is no longer touched after this returns.
+///
+/// # Parameters
+/// - `session`: Session from `photowall_edit_session_open`
+/// - `format`: `PHOTOWALL_PIXEL_*`
+/// - `pixels`: Buffer of `len` bytes, or `NULL` to go back to internal RGBA8 frames
+/// - `stride`: Bytes per row
+/// - `len`: Buffer size; must hold a frame of the maximum frame size
+///
+/// # Safety
+/// `pixels` must stay valid and writable until it is replaced or the
+/// session is closed; read it only inside the frame callback.
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_edit_session_set_output_buffer(
+    session: *mut PhotowallEditSession,
+    format: u32,
+    pixels: *mut u8,
+    stride: u32,
+    len: usize,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.edit_session_set_output_buffer");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if session.is_null() {
+            set_last_error("session is null");
+            return -1;
+        }
+        let buffer = if pixels.is_null() {
+            None
+        } else {
+            let Some(format) = pixel_format(format) else {
+                set_last_error(format!("unknown pixel format: {}", format));
+                return -1;
+            };
+            Some(OutputBuffer::from_raw(pixels, len, stride as usize, format))
+        };
+
+        match (*session).session.set_output(buffer) {
+            Ok(_) => 0,
+            Err(e) => {
+                set_last_error(format!("failed to set output buffer: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_edit_session_set_output_buffer");
+        -1
+    })
+}
+
+/// Render frames into a shared file mapping.
+///
+/// Creates (or truncates) the file at `path`, sized for the maximum frame
+/// with rows of `max_width * bytes_per_pixel`, and maps it. The host maps
+/// the same file (e.g. under `/dev/shm`, or any path on Windows) and reads
+/// it when the frame callback fires. The file is removed when the output
+/// is replaced or the session is closed.
+///
+/// # Parameters
+/// - `session`: Session from `photowall_edit_session_open`
+/// - `path`: File to create
+/// - `format`: `PHOTOWALL_PIXEL_*`
+/// - `out_stride`: Output for the bytes per row (may be NULL)
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_edit_session_create_shared_output(
+    session: *mut PhotowallEditSession,
+    path: *const c_char,
+    format: u32,
+    out_stride: *mut u32,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.edit_session_create_shared_output");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if session.is_null() || path.is_null() {
+            set_last_error("session or path is null");
+            return -1;
+        }
+        let path = match CStr::from_ptr(path).to_str() {
+            Ok(s) => PathBuf::from(s),
+            Err(_) => {
+                set_last_error("invalid UTF-8 in path");
+                return -1;
+            }
+        };
+        let Some(format) = pixel_format(format) else {
+            set_last_error(format!("unknown pixel format: {}", format));
+            return -1;
+        };
+
+        let session = &(*session).session;
+        let (width, height) = session.max_frame_size();
+        let buffer = match OutputBuffer::create_shared(&path, width, height, format) {
+            Ok(buffer) => buffer,
+            Err(e) => {
+                set_last_error(format!("failed to create shared output: {}", e));
+                return -1;
+            }
+        };
+        let stride = buffer.stride() as u32;
+
+        match session.set_output(Some(buffer)) {
+            Ok(_) => {
+                if !out_stride.is_null() {
+                    *out_stride = stride;
+                }
+                0
+            }
+            Err(e) => {
+                set_last_error(format!("failed to set output buffer: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_edit_session_create_shared_output");
+        -1
+    })
+}
+
+/// Switch the display mode and re-render the last submitted parameters.
+///
+/// Does not wait for the frame in progress, so it may be called from the
+/// frame callback.
+///
+/// # Parameters
+/// - `session`: Session from `photowall_edit_session_open`
+/// - `mode`: `PHOTOWALL_DISPLAY_*`
+/// - `split_position`: Split line position, 0.0 (left) to 1.0 (right); `SPLIT` only
+/// - `shadow_threshold`: Channel value (0-255) at or below which a pixel is
+///   marked as clipped shadow; `CLIPPING` only
+/// - `highlight_threshold`: Channel value (0-255) at or above which a pixel is
+///   marked as clipped highlight; `CLIPPING` only
+///
+/// # Returns
+/// - Generation (> 0) of the frames rendered in the new mode
+/// - `0` on error (e.g. the output buffer cannot hold side-by-side frames)
+#[no_mangle]
+pub unsafe extern "C" fn photowall_edit_session_set_display_mode(
+    session: *mut PhotowallEditSession,
+    mode: u32,
+    split_position: f32,
+    shadow_threshold: u32,
+    highlight_threshold: u32,
+) -> u64 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.edit_session_set_display_mode");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if session.is_null() {
+            set_last_error("session is null");
+            return 0;
+        }
+        let mode = match mode {
+            PHOTOWALL_DISPLAY_EDITED => DisplayMode::Edited,
+            PHOTOWALL_DISPLAY_SPLIT => DisplayMode::Split {
+                position: split_position,
+            },
+            PHOTOWALL_DISPLAY_SIDE_BY_SIDE => DisplayMode::SideBySide,
+            PHOTOWALL_DISPLAY_CLIPPING => DisplayMode::Clipping {
+                shadows: shadow_threshold.min(255) as u8,
+                highlights: highlight_threshold.min(255) as u8,
+            },
+            _ => {
+                set_last_error(format!("unknown display mode: {}", mode));
+                return 0;
+            }
+        };
+
+        match (*session).session.set_display_mode(mode) {
+            Ok(generation) => generation,
+            Err(e) => {
+                set_last_error(format!("failed to set display mode: {}", e));
+                0
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_edit_session_set_display_mode");
+        0
+    })
+}
+
+/// Set or clear the scopes callback.
+///
+/// While set, every frame also accumulates a luma waveform, an RGB parade
+/// and a vectorscope of the edited result (sampled on large previews), and
+/// the callback receives them on the render thread right before the frame
+/// callback. Takes effect from the next render.
+///
+/// # Parameters
+/// - `session`: Session from `photowall_edit_session_open`
+/// - `callback`: Scopes callback, or `NULL` to stop computing scopes
+/// - `user_data`: Passed to the callback; must stay valid until replaced or closed
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_edit_session_set_scopes_callback(
+    session: *mut PhotowallEditSession,
+    callback: Option<ScopesCallback>,
+    user_data: *mut c_void,
+) -> i32 {
+    clear_last_error();
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if session.is_null() {
+            set_last_error("session is null");
+            return -1;
+        }
+
+        let session = &*session;
+        let target = callback.map(|callback| ScopesTarget { callback, user_data });
+        let enabled = target.is_some();
+        *session.scopes_target.lock().unwrap_or_else(|e| e.into_inner()) = target;
+        session.session.set_scopes_enabled(enabled);
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_edit_session_set_scopes_callback");
+        -1
+    })
+}
+
+/// Close an edit session.
+///
+/// Waits for the render thread to stop; no callback is invoked afterwards.
+///
+/// # Safety
+/// - `session` must be a pointer returned by `photowall_edit_session_open`
+#[no_mangle]
+pub unsafe extern "C" fn photowall_edit_session_close(session: *mut PhotowallEditSession) {
+    if !session.is_null() {
+        let _ = Box::from_raw(session);
+    }
+}
@@ -2,6 +2,7 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
 use photowall_core::models::{PaginationParams, PhotoSortOptions};
 use serde::Serialize;
 use std::collections::{BTreeSet, HashMap};
@@ -164,6 +165,7 @@ pub unsafe extern "C" fn photowall_get_folder_tree_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.get_folder_tree_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -202,6 +204,7 @@ pub unsafe extern "C" fn photowall_get_folder_children_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.get_folder_children_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -256,6 +259,7 @@ pub unsafe extern "C" fn photowall_get_folder_photos_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.get_folder_photos_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || folder_path.is_null() || out_json.is_null() {
@@ -2,8 +2,8 @@
 
 use parking_lot::RwLock;
 use photowall_core::{
-    events::{EventSink, SharedEventSink},
-    paths::QtPathProvider,
+    events::{CoalescingEventSink, EventSink, SharedEventSink},
+    paths::{QtPathProvider, SharedPathProvider},
     services::ThumbnailQueue,
     PhotowallCore,
 };
@@ -18,6 +18,7 @@ use std::sync::Arc;
 pub type EventCallback = extern "C" fn(name: *const c_char, payload: *const c_char, user_data: *mut c_void);
 
 /// Stored callback with user data.
+#[derive(Clone, Copy)]
 pub struct StoredCallback {
     pub callback: EventCallback,
     pub user_data: *mut c_void,
@@ -60,8 +61,10 @@ impl Default for FfiEventSink {
 
 impl EventSink for FfiEventSink {
     fn emit(&self, event_name: &str, payload_json: &str) {
-        let guard = self.callback.read();
-        if let Some(ref stored) = *guard {
+        // Copy the callback out so it runs without the lock held; it may set or
+        // clear the callback, or emit again, from inside the call.
+        let stored = *self.callback.read();
+        if let Some(stored) = stored {
             // Create null-terminated strings
             if let (Ok(name_cstr), Ok(payload_cstr)) = (
                 std::ffi::CString::new(event_name),
@@ -79,25 +82,37 @@ pub struct PhotowallHandle {
     pub core: PhotowallCore,
     pub thumbnail_queue: ThumbnailQueue,
     pub event_sink: Arc<FfiEventSink>,
+    /// Rate-limiting front of `event_sink`; all events are emitted through it.
+    pub events: Arc<CoalescingEventSink>,
 }
 
 impl PhotowallHandle {
     pub fn new() -> Result<Self, photowall_core::utils::AppError> {
-        let path_provider = Arc::new(QtPathProvider::new());
+        Self::with_path_provider(Arc::new(QtPathProvider::new()))
+    }
+
+    /// Create a handle whose database, thumbnails and settings live under
+    /// the directories of `path_provider`.
+    pub fn with_path_provider(path_provider: SharedPathProvider) -> Result<Self, photowall_core::utils::AppError> {
         let event_sink = Arc::new(FfiEventSink::new());
-        let shared_sink: SharedEventSink = event_sink.clone();
+        let events = Arc::new(CoalescingEventSink::new(event_sink.clone()));
+        let shared_sink: SharedEventSink = events.clone();
 
         let core = PhotowallCore::new(path_provider.clone(), shared_sink)?;
 
         // Set global event sink for thumbnail workers
-        photowall_core::services::thumbnail_queue::set_event_sink(event_sink.clone());
+        photowall_core::services::thumbnail_queue::set_event_sink(events.clone());
 
         let thumbnail_queue = ThumbnailQueue::new(core.thumbnails().clone())?;
+        thumbnail_queue.set_database(core.database().clone());
+        thumbnail_queue.set_duplicate_index(core.duplicates().clone());
+        thumbnail_queue.set_color_index(core.colors().clone());
 
         Ok(Self {
             core,
             thumbnail_queue,
             event_sink,
+            events,
         })
     }
 }
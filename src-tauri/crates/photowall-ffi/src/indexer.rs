@@ -2,6 +2,7 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
 use photowall_core::events::EventSinkExt;
 use photowall_core::services::{IndexOptions, IndexProgress, PhotoIndexer, ScanOptions};
 use serde::Serialize;
@@ -48,6 +49,7 @@ pub unsafe extern "C" fn photowall_index_directory_async(
     path_utf8: *const c_char,
 ) -> u64 {
     clear_last_error();
+    let _timer = Timer::start("ffi.index_directory_async");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || path_utf8.is_null() {
@@ -78,7 +80,7 @@ pub unsafe extern "C" fn photowall_index_directory_async(
 
         // Clone what we need for the background thread
         let db = handle.core.database().clone();
-        let event_sink = handle.event_sink.clone();
+        let event_sink = handle.events.clone();
         let job_manager = handle.core.jobs().clone();
 
         // Spawn background thread
@@ -88,6 +90,7 @@ pub unsafe extern "C" fn photowall_index_directory_async(
                 skip_existing: true,
                 detect_duplicates: true,
                 batch_size: 50,
+                use_journal: true,
             };
 
             let indexer = PhotoIndexer::with_cancel_flag(db, options, cancel_token.flag());
@@ -0,0 +1,259 @@
+//! Streaming photo iterator API.
+//!
+//! An iterator runs one query on a dedicated read-only connection. A worker
+//! thread keeps the prepared statement alive and streams rows through a
+//! bounded channel; each `next_batch` call drains up to N rows into a
+//! caller-provided buffer using the `PhotowallPhotoBatch` layout.
+
+use crate::batch::{write_batch, BatchLayout, PhotoColumns, PhotowallPhotoBatch, PHOTOWALL_BATCH_NO_STRING};
+use crate::error::{clear_last_error, set_last_error};
+use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
+use photowall_core::models::{Photo, PhotoSortOptions, SearchFilters};
+use std::ffi::{c_char, CStr};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::sync::mpsc::{sync_channel, Receiver};
+use std::thread::{self, JoinHandle};
+
+/// Rows buffered between the query worker and the consumer.
+const ITER_CHANNEL_CAPACITY: usize = 1024;
+
+enum IterMessage {
+    Row(Photo),
+    Error(String),
+}
+
+/// Opaque iterator handle exposed to C.
+pub struct PhotowallPhotoIter {
+    rx: Option<Receiver<IterMessage>>,
+    worker: Option<JoinHandle<()>>,
+    /// Row received but not yet delivered (did not fit the last buffer).
+    pending: Option<Photo>,
+    finished: bool,
+}
+
+impl PhotowallPhotoIter {
+    /// Receive the next row, or `None` at the end of the result set.
+    fn next_row(&mut self) -> Result<Option<Photo>, String> {
+        if let Some(photo) = self.pending.take() {
+            return Ok(Some(photo));
+        }
+        if self.finished {
+            return Ok(None);
+        }
+
+        let message = self.rx.as_ref().and_then(|rx| rx.recv().ok());
+        match message {
+            Some(IterMessage::Row(photo)) => Ok(Some(photo)),
+            Some(IterMessage::Error(e)) => {
+                self.finished = true;
+                Err(e)
+            }
+            None => {
+                self.finished = true;
+                Ok(None)
+            }
+        }
+    }
+}
+
+impl Drop for PhotowallPhotoIter {
+    fn drop(&mut self) {
+        // Dropping the receiver makes the worker's next send fail, which
+        // ends the query loop.
+        self.rx = None;
+        if let Some(worker) = self.worker.take() {
+            let _ = worker.join();
+        }
+    }
+}
+
+/// Helper to convert C string to Rust string.
+unsafe fn cstr_to_string(ptr: *const c_char) -> Option<String> {
+    if ptr.is_null() {
+        return None;
+    }
+    CStr::from_ptr(ptr).to_str().ok().map(|s| s.to_string())
+}
+
+/// Open a streaming photo iterator.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `filters_json`: JSON search filters (null for all photos not in trash)
+/// - `sort_json`: JSON sort options (null for defaults)
+/// - `out_iter`: Output pointer for the iterator (must be closed with `photowall_photo_iter_close`)
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_photo_iter_open(
+    handle: *mut PhotowallHandle,
+    filters_json: *const c_char,
+    sort_json: *const c_char,
+    out_iter: *mut *mut PhotowallPhotoIter,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.photo_iter_open");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || out_iter.is_null() {
+            set_last_error("handle or out_iter is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        let db = handle.core.database().clone();
+
+        let filters: SearchFilters = cstr_to_string(filters_json)
+            .and_then(|s| serde_json::from_str(&s).ok())
+            .unwrap_or_default();
+
+        let sort: PhotoSortOptions = cstr_to_string(sort_json)
+            .and_then(|s| serde_json::from_str(&s).ok())
+            .unwrap_or_default();
+
+        let (tx, rx) = sync_channel(ITER_CHANNEL_CAPACITY);
+
+        let worker = thread::spawn(move || {
+            let result = db.for_each_photo(&filters, &sort, |photo| {
+                tx.send(IterMessage::Row(photo)).is_ok()
+            });
+            if let Err(e) = result {
+                let _ = tx.send(IterMessage::Error(e.to_string()));
+            }
+        });
+
+        *out_iter = Box::into_raw(Box::new(PhotowallPhotoIter {
+            rx: Some(rx),
+            worker: Some(worker),
+            pending: None,
+            finished: false,
+        }));
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_photo_iter_open");
+        -1
+    })
+}
+
+/// Fill a caller-provided buffer with the next rows of the iterator.
+///
+/// Rows are written in the `PhotowallPhotoBatch` layout; `out_batch` receives
+/// a header whose column pointers point into `buffer`. Fewer than `max_rows`
+/// rows are written if the buffer fills up first.
+///
+/// # Parameters
+/// - `iter`: Iterator from `photowall_photo_iter_open`
+/// - `max_rows`: Maximum number of rows to return
+/// - `buffer`: Caller-owned output buffer
+/// - `buffer_len`: Size of `buffer` in bytes
+/// - `out_batch`: Output header describing the rows in `buffer`
+///
+/// # Returns
+/// - Number of rows written (`0` when the iterator is exhausted)
+/// - `-1` on error (including a buffer too small for a single row)
+#[no_mangle]
+pub unsafe extern "C" fn photowall_photo_iter_next_batch(
+    iter: *mut PhotowallPhotoIter,
+    max_rows: u32,
+    buffer: *mut u8,
+    buffer_len: usize,
+    out_batch: *mut PhotowallPhotoBatch,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.photo_iter_next_batch");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if iter.is_null() || buffer.is_null() || out_batch.is_null() {
+            set_last_error("iter, buffer, or out_batch is null");
+            return -1;
+        }
+
+        let iter = &mut *iter;
+
+        // Columns must start on an 8-byte boundary.
+        let padding = buffer.align_offset(8);
+        if padding >= buffer_len {
+            set_last_error("buffer too small");
+            return -1;
+        }
+        let capacity = buffer_len - padding;
+
+        let mut columns = PhotoColumns::with_capacity(max_rows.min(4096) as usize);
+        while (columns.len() as u32) < max_rows {
+            let photo = match iter.next_row() {
+                Ok(Some(photo)) => photo,
+                Ok(None) => break,
+                Err(e) => {
+                    set_last_error(format!("photo iterator query failed: {}", e));
+                    return -1;
+                }
+            };
+
+            let needed = columns.encoded_len() + PhotoColumns::row_len(&photo);
+            if needed > capacity {
+                iter.pending = Some(photo);
+                if columns.is_empty() {
+                    set_last_error(format!("buffer too small: {} bytes needed", needed + padding));
+                    return -1;
+                }
+                break;
+            }
+            columns.push(&photo);
+        }
+
+        // Peek one row ahead so `has_more` is exact.
+        if iter.pending.is_none() {
+            match iter.next_row() {
+                Ok(next) => iter.pending = next,
+                Err(e) => {
+                    set_last_error(format!("photo iterator query failed: {}", e));
+                    return -1;
+                }
+            }
+        }
+
+        let layout = BatchLayout::new(columns.len(), columns.strings_len());
+        *out_batch = write_batch(
+            buffer.add(padding),
+            &layout,
+            &columns,
+            iter.pending.is_some(),
+            None,
+            PHOTOWALL_BATCH_NO_STRING,
+        );
+        columns.len() as i32
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_photo_iter_next_batch");
+        -1
+    })
+}
+
+/// Close an iterator and release its query.
+///
+/// # Safety
+/// - `iter` must be a pointer from `photowall_photo_iter_open` (may be null)
+/// - After calling this function, the iterator is invalid
+#[no_mangle]
+pub unsafe extern "C" fn photowall_photo_iter_close(iter: *mut PhotowallPhotoIter) {
+    clear_last_error();
+    let _timer = Timer::start("ffi.photo_iter_close");
+
+    if iter.is_null() {
+        return;
+    }
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        let _ = Box::from_raw(iter);
+    }));
+
+    if result.is_err() {
+        set_last_error("panic in photowall_photo_iter_close");
+    }
+}
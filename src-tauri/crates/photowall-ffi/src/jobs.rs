@@ -2,6 +2,7 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
 use std::panic::{catch_unwind, AssertUnwindSafe};
 
 /// Cancel a running job.
@@ -13,6 +14,7 @@ use std::panic::{catch_unwind, AssertUnwindSafe};
 #[no_mangle]
 pub unsafe extern "C" fn photowall_cancel_job(handle: *mut PhotowallHandle, job_id: u64) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.cancel_job");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -43,6 +45,7 @@ pub unsafe extern "C" fn photowall_cancel_job(handle: *mut PhotowallHandle, job_
 #[no_mangle]
 pub unsafe extern "C" fn photowall_get_active_job_count(handle: *mut PhotowallHandle) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.get_active_job_count");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -69,6 +72,7 @@ pub unsafe extern "C" fn photowall_get_active_job_count(handle: *mut PhotowallHa
 #[no_mangle]
 pub unsafe extern "C" fn photowall_is_job_active(handle: *mut PhotowallHandle, job_id: u64) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.is_job_active");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -18,39 +18,64 @@
 //! # Memory Management
 //!
 //! - Strings returned via `out_json` must be freed with `photowall_free_string()`
+//! - Batches returned by `_bin` functions must be freed with `photowall_free_photo_batch()`
 //! - The handle must be freed with `photowall_shutdown()`
 
 mod albums;
+mod batch;
+#[cfg(feature = "bench")]
+mod bench;
 mod callbacks;
+mod colors;
+mod duplicates;
+mod edit_session;
 mod error;
 mod folders;
 mod handle;
 mod indexer;
+mod iter;
 mod jobs;
+mod metrics;
+mod ocr;
 mod photo_ops;
 mod photos;
 mod settings;
 mod tags;
 mod thumbnail;
 mod trash;
+mod viewer;
 
 use error::{clear_last_error, get_last_error_ptr, set_global_error, set_last_error};
 use handle::PhotowallHandle;
-use std::ffi::{c_char, CString};
+use photowall_core::metrics::Timer;
+use photowall_core::paths::QtPathProvider;
+use std::ffi::{c_char, CStr, CString};
+use std::path::PathBuf;
+use std::sync::Arc;
 use std::panic::{catch_unwind, AssertUnwindSafe};
 
 // Re-export all public FFI functions
 pub use albums::*;
+pub use batch::*;
+#[cfg(feature = "bench")]
+pub use bench::*;
 pub use callbacks::*;
+pub use colors::*;
+pub use duplicates::*;
+pub use edit_session::*;
 pub use folders::*;
 pub use indexer::*;
+pub use iter::*;
 pub use jobs::*;
+pub use metrics::*;
+pub use ocr::*;
 pub use photo_ops::*;
 pub use photos::*;
 pub use settings::*;
 pub use tags::*;
 pub use thumbnail::*;
 pub use trash::*;
+pub use viewer::*;
 
 /// Initialize the PhotoWall library.
 ///
@@ -63,6 +88,7 @@ pub use trash::*;
 #[no_mangle]
 pub extern "C" fn photowall_init() -> *mut PhotowallHandle {
     clear_last_error();
+    let _timer = Timer::start("ffi.init");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         match PhotowallHandle::new() {
@@ -83,6 +109,55 @@ pub extern "C" fn photowall_init() -> *mut PhotowallHandle {
     })
 }
 
+/// Initialize the PhotoWall library with a custom data directory.
+///
+/// The database, thumbnails and settings are kept under `data_dir` instead
+/// of the per-user default. Useful for tests, benchmarks and portable installs.
+///
+/// # Returns
+/// - Valid handle pointer on success
+/// - `NULL` on error (call `photowall_last_error()` for details)
+///
+/// # Safety
+/// - `data_dir` must be a valid null-terminated UTF-8 string
+/// - The returned handle must be freed with `photowall_shutdown()`.
+#[no_mangle]
+pub unsafe extern "C" fn photowall_init_with_data_dir(data_dir: *const c_char) -> *mut PhotowallHandle {
+    clear_last_error();
+    let _timer = Timer::start("ffi.init_with_data_dir");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if data_dir.is_null() {
+            set_global_error("data_dir is null");
+            return std::ptr::null_mut();
+        }
+
+        let dir = match CStr::from_ptr(data_dir).to_str() {
+            Ok(s) => PathBuf::from(s),
+            Err(_) => {
+                set_global_error("invalid UTF-8 in data_dir");
+                return std::ptr::null_mut();
+            }
+        };
+
+        match PhotowallHandle::with_path_provider(Arc::new(QtPathProvider::with_base_dir(dir))) {
+            Ok(handle) => {
+                tracing::info!("PhotoWall FFI initialized");
+                Box::into_raw(Box::new(handle))
+            }
+            Err(e) => {
+                set_global_error(format!("initialization failed: {}", e));
+                std::ptr::null_mut()
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_global_error("panic during initialization");
+        std::ptr::null_mut()
+    })
+}
+
 /// Shutdown the PhotoWall library and free resources.
 ///
 /// # Safety
@@ -0,0 +1,105 @@
+//! Runtime metrics API.
+
+use crate::error::{clear_last_error, set_last_error};
+use crate::handle::PhotowallHandle;
+use photowall_core::metrics;
+use std::ffi::{c_char, CString};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+
+fn string_to_cstr(s: &str) -> *mut c_char {
+    CString::new(s)
+        .map(|cs| cs.into_raw())
+        .unwrap_or(std::ptr::null_mut())
+}
+
+/// Get a snapshot of the runtime metrics as JSON.
+///
+/// Cheap enough to poll every second: it reads atomic counters and walks
+/// the histogram buckets without blocking any recording thread.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `include_buckets`: `1` to include the non-empty histogram buckets
+/// - `out_json`: Output JSON (must be freed with `photowall_free_string`)
+///
+/// # Output format
+/// ```json
+/// {"uptimeSecs": 12.5,
+///  "counters": {"thumbnail.completed": 420, ...},
+///  "gauges": {"thumbnail.queue_depth": 3, ...},
+///  "hitRates": {"thumbnail.cache": 0.93, ...},
+///  "histograms": {"ffi.get_photos_cursor_bin": {"count": 10, "sumUs": 5120,
+///     "meanUs": 512.0, "p50Us": 479, "p90Us": 639, "p99Us": 700,
+///     "p999Us": 700, "maxUs": 700, "buckets": [[448, 3], ...]}, ...}}
+/// ```
+/// Counters are monotonic since the last `photowall_reset_metrics`; rates
+/// such as thumbnails or indexed files per second are the difference between
+/// two snapshots divided by the polling interval.
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_get_metrics_json(
+    handle: *mut PhotowallHandle,
+    include_buckets: i32,
+    out_json: *mut *mut c_char,
+) -> i32 {
+    clear_last_error();
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || out_json.is_null() {
+            set_last_error("handle or out_json is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        let m = metrics::global();
+
+        // Gauges sampled at snapshot time
+        m.set_gauge("thumbnail.queue_depth", handle.thumbnail_queue.len() as i64);
+        m.set_gauge("jobs.active", handle.core.jobs().active_job_count() as i64);
+
+        let snapshot = m.snapshot(include_buckets != 0);
+        match serde_json::to_string(&snapshot) {
+            Ok(json) => {
+                *out_json = string_to_cstr(&json);
+                0
+            }
+            Err(e) => {
+                set_last_error(format!("failed to serialize metrics: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_get_metrics_json");
+        -1
+    })
+}
+
+/// Reset all counters and histograms. Gauges keep their current value.
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_reset_metrics(handle: *mut PhotowallHandle) -> i32 {
+    clear_last_error();
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return -1;
+        }
+
+        metrics::global().reset();
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_reset_metrics");
+        -1
+    })
+}
@@ -0,0 +1,249 @@
+//! OCR API - async batch text recognition.
+//!
+//! The library decodes and preprocesses photos on its own thread pool; the host
+//! supplies the recognition engine as a callback, which is invoked from a
+//! bounded set of recognizer threads.
+
+use crate::error::{clear_last_error, set_last_error};
+use crate::handle::PhotowallHandle;
+use photowall_core::events::EventSinkExt;
+use photowall_core::metrics::Timer;
+use photowall_core::services::{
+    OcrBatch, OcrBatchOptions, OcrBatchProgress, OcrImage, OcrPreprocessOptions, OcrRecognizer, OcrTask,
+};
+use photowall_core::utils::error::{AppError, AppResult};
+use serde::Serialize;
+use std::ffi::{c_char, c_void, CStr};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::path::PathBuf;
+use std::sync::Arc;
+use std::thread;
+
+/// Text slot handed to the recognizer callback; filled with `photowall_ocr_text_set`.
+pub struct PhotowallOcrText {
+    text: Option<String>,
+}
+
+/// Recognizer callback type.
+/// - `pixels`: `width * height` bytes of 8-bit luma, 0 = ink, 255 = paper
+/// - `dpi`: resolution the image was scaled to
+/// - `out_text`: slot for the recognised text
+/// - `user_data`: user-provided context pointer
+///
+/// Returns `0` on success (leave `out_text` empty when there is no text),
+/// non-zero on failure.
+pub type OcrRecognizeCallback = extern "C" fn(
+    pixels: *const u8,
+    width: u32,
+    height: u32,
+    dpi: u32,
+    out_text: *mut PhotowallOcrText,
+    user_data: *mut c_void,
+) -> i32;
+
+/// Recognizer that forwards to a C callback.
+struct CallbackRecognizer {
+    callback: OcrRecognizeCallback,
+    user_data: *mut c_void,
+}
+
+// SAFETY: the caller guarantees the callback and user_data are thread-safe
+unsafe impl Send for CallbackRecognizer {}
+unsafe impl Sync for CallbackRecognizer {}
+
+impl OcrRecognizer for CallbackRecognizer {
+    fn recognize(&self, image: &OcrImage) -> AppResult<String> {
+        let mut out = PhotowallOcrText { text: None };
+        let code = (self.callback)(
+            image.pixels.as_ptr(),
+            image.width,
+            image.height,
+            image.dpi,
+            &mut out,
+            self.user_data,
+        );
+        if code != 0 {
+            return Err(AppError::General(format!("recognizer callback returned {}", code)));
+        }
+        Ok(out.text.unwrap_or_default())
+    }
+}
+
+/// OCR progress event payload.
+#[derive(Serialize)]
+#[serde(rename_all = "camelCase")]
+struct OcrProgressPayload<'a> {
+    job_id: u64,
+    #[serde(flatten)]
+    progress: &'a OcrBatchProgress,
+}
+
+/// OCR finished / cancelled event payload.
+#[derive(Serialize)]
+#[serde(rename_all = "camelCase")]
+struct OcrFinishedPayload {
+    job_id: u64,
+    total: usize,
+    recognized: usize,
+    no_text: usize,
+    failed: usize,
+}
+
+/// Set the text produced by a recognizer callback.
+///
+/// May only be called from inside the callback, with the `out_text` it
+/// received. Calling it again replaces the previous text.
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_ocr_text_set(out_text: *mut PhotowallOcrText, text_utf8: *const c_char) -> i32 {
+    clear_last_error();
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if out_text.is_null() || text_utf8.is_null() {
+            set_last_error("out_text or text is null");
+            return -1;
+        }
+
+        match CStr::from_ptr(text_utf8).to_str() {
+            Ok(text) => {
+                (*out_text).text = Some(text.to_string());
+                0
+            }
+            Err(_) => {
+                set_last_error("invalid UTF-8 in text");
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_ocr_text_set");
+        -1
+    })
+}
+
+/// Run OCR on every photo that has not been processed yet.
+///
+/// Photos are decoded, scaled to `target_dpi`, binarised and deskewed on a
+/// dedicated preprocessing pool; at most `2 * recognizer_threads`
+/// preprocessed pages wait for recognition at any time. A photo that fails
+/// preprocessing is recognised from its unprocessed grayscale image. Results
+/// are written to the database and the text becomes searchable through the
+/// full-text query.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `recognize`: Recognizer callback, called concurrently from
+///   `recognizer_threads` threads
+/// - `user_data`: Passed to every callback; must stay valid until the job ends
+/// - `recognizer_threads`: Concurrent recognitions (0 = half the CPU cores,
+///   between 1 and 4); preprocessing uses the remaining cores
+/// - `target_dpi`: Preprocessing resolution (0 = 300)
+///
+/// # Returns
+/// - Job ID (> 0) on success
+/// - `0` on error (call `photowall_last_error` for details)
+///
+/// # Events emitted
+/// - `ocr-progress`: After each photo
+/// - `ocr-finished`: When all pending photos are processed
+/// - `ocr-cancelled`: If the job is cancelled with `photowall_cancel_job`
+#[no_mangle]
+pub unsafe extern "C" fn photowall_ocr_pending_async(
+    handle: *mut PhotowallHandle,
+    recognize: Option<OcrRecognizeCallback>,
+    user_data: *mut c_void,
+    recognizer_threads: u32,
+    target_dpi: u32,
+) -> u64 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.ocr_pending_async");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return 0;
+        }
+        let callback = match recognize {
+            Some(callback) => callback,
+            None => {
+                set_last_error("recognize callback is null");
+                return 0;
+            }
+        };
+
+        let handle = &*handle;
+        let db = handle.core.database().clone();
+
+        let tasks: Vec<OcrTask> = match db.get_pending_ocr_paths() {
+            Ok(paths) => paths
+                .into_iter()
+                .map(|(photo_id, path)| OcrTask {
+                    photo_id,
+                    path: PathBuf::from(path),
+                })
+                .collect(),
+            Err(e) => {
+                set_last_error(format!("failed to load pending photos: {}", e));
+                return 0;
+            }
+        };
+
+        let cancel_token = handle.core.jobs().start_job();
+        let job_id = cancel_token.job_id();
+        let event_sink = handle.events.clone();
+        let job_manager = handle.core.jobs().clone();
+
+        let recognizer = Arc::new(CallbackRecognizer { callback, user_data });
+        let mut preprocess = OcrPreprocessOptions::default();
+        if target_dpi > 0 {
+            preprocess.target_dpi = target_dpi;
+        }
+        let options = OcrBatchOptions {
+            preprocess,
+            recognizer_threads: recognizer_threads as usize,
+            preprocess_threads: 0,
+            queue_depth: 0,
+        };
+
+        thread::spawn(move || {
+            let batch = OcrBatch::with_cancel_flag(recognizer, options, cancel_token.flag());
+
+            let sink_for_progress = event_sink.clone();
+            let result = batch.run(
+                &tasks,
+                |outcome| {
+                    let text = outcome.text.as_deref();
+                    if let Err(e) = db.update_photo_ocr(outcome.photo_id, text, outcome.status as i32) {
+                        tracing::error!("Failed to store OCR result for {}: {}", outcome.photo_id, e);
+                    }
+                },
+                |progress| {
+                    sink_for_progress.emit_typed("ocr-progress", &OcrProgressPayload { job_id, progress });
+                },
+            );
+
+            job_manager.complete_job(job_id);
+
+            let payload = OcrFinishedPayload {
+                job_id,
+                total: result.total,
+                recognized: result.recognized,
+                no_text: result.no_text,
+                failed: result.failed,
+            };
+            let event = if result.cancelled { "ocr-cancelled" } else { "ocr-finished" };
+            event_sink.emit_typed(event, &payload);
+        });
+
+        job_id
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_ocr_pending_async");
+        0
+    })
+}
@@ -2,6 +2,7 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
 use photowall_core::models::UpdatePhoto;
 use std::ffi::{c_char, CStr};
 use std::panic::{catch_unwind, AssertUnwindSafe};
@@ -18,6 +19,7 @@ pub unsafe extern "C" fn photowall_set_photos_favorite(
     is_favorite: i32,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.set_photos_favorite");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || photo_ids_json.is_null() {
@@ -72,6 +74,7 @@ pub unsafe extern "C" fn photowall_set_photo_rating(
     rating: i32,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.set_photo_rating");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -109,6 +112,7 @@ pub unsafe extern "C" fn photowall_soft_delete_photos(
     photo_ids_json: *const c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.soft_delete_photos");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || photo_ids_json.is_null() {
@@ -136,7 +140,10 @@ pub unsafe extern "C" fn photowall_soft_delete_photos(
         };
 
         match db.soft_delete_photos(&photo_ids) {
-            Ok(count) => count as i32,
+            Ok(count) => {
+                handle.core.forget_photos(&photo_ids);
+                count as i32
+            }
             Err(e) => {
                 set_last_error(format!("soft_delete_photos failed: {}", e));
                 -1
@@ -166,6 +173,7 @@ pub unsafe extern "C" fn photowall_update_photo_json(
     updates_json: *const c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.update_photo_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || updates_json.is_null() {
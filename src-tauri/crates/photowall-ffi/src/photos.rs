@@ -1,7 +1,9 @@
 //! Photo query API.
 
+use crate::batch::{into_owned_batch, PhotoColumns, PhotowallPhotoBatch};
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
 use photowall_core::models::{Photo, PhotoCursor, PhotoSortField, PhotoSortOptions, SearchFilters};
 use std::ffi::{c_char, CStr, CString};
 use std::panic::{catch_unwind, AssertUnwindSafe};
@@ -76,6 +78,7 @@ pub unsafe extern "C" fn photowall_get_photos_cursor_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.get_photos_cursor_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -132,6 +135,9 @@ pub unsafe extern "C" fn photowall_get_photos_cursor_json(
 
 /// Search photos with filters and cursor-based pagination.
 ///
+/// Quality filters (`minSharpness`, `maxHighlightClip`, `maxShadowClip`,
+/// `maxNoise`) only match photos whose scores have been computed.
+///
 /// # Parameters
 /// - `handle`: Valid handle from `photowall_init`
 /// - `filters_json`: JSON search filters
@@ -155,6 +161,7 @@ pub unsafe extern "C" fn photowall_search_photos_cursor_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.search_photos_cursor_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -206,6 +213,148 @@ pub unsafe extern "C" fn photowall_search_photos_cursor_json(
     })
 }
 
+/// Get photos with cursor-based pagination as a columnar binary batch.
+///
+/// Same query as `photowall_get_photos_cursor_json`, but the result is a
+/// struct-of-arrays that the host reads in place.
+///
+/// # Parameters
+/// - `out_batch`: Output pointer for the batch (must be freed with `photowall_free_photo_batch`)
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_get_photos_cursor_bin(
+    handle: *mut PhotowallHandle,
+    limit: u32,
+    cursor_json: *const c_char,
+    sort_json: *const c_char,
+    out_batch: *mut *mut PhotowallPhotoBatch,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.get_photos_cursor_bin");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || out_batch.is_null() {
+            set_last_error("handle or out_batch is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        let db = handle.core.database();
+
+        let cursor: Option<PhotoCursor> = cstr_to_string(cursor_json)
+            .and_then(|s| serde_json::from_str(&s).ok());
+
+        let sort: PhotoSortOptions = cstr_to_string(sort_json)
+            .and_then(|s| serde_json::from_str(&s).ok())
+            .unwrap_or_default();
+
+        let total = match db.count_photos() {
+            Ok(count) => count,
+            Err(e) => {
+                set_last_error(format!("count_photos failed: {}", e));
+                return -1;
+            }
+        };
+
+        match db.get_photos_cursor(limit, cursor.as_ref(), &sort) {
+            Ok(photos) => {
+                let has_more = photos.len() as u32 >= limit;
+                let next_cursor = build_next_cursor(&photos, &sort, has_more)
+                    .and_then(|c| serde_json::to_string(&c).ok());
+                *out_batch = into_owned_batch(
+                    PhotoColumns::from_photos(&photos),
+                    has_more,
+                    Some(total),
+                    next_cursor.as_deref(),
+                );
+                0
+            }
+            Err(e) => {
+                set_last_error(format!("get_photos_cursor failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_get_photos_cursor_bin");
+        -1
+    })
+}
+
+/// Search photos with filters and cursor-based pagination as a columnar binary batch.
+///
+/// Same query as `photowall_search_photos_cursor_json`; `total` in the batch
+/// is `-1` unless `include_total` is set.
+///
+/// # Parameters
+/// - `out_batch`: Output pointer for the batch (must be freed with `photowall_free_photo_batch`)
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_search_photos_cursor_bin(
+    handle: *mut PhotowallHandle,
+    filters_json: *const c_char,
+    limit: u32,
+    cursor_json: *const c_char,
+    sort_json: *const c_char,
+    include_total: i32,
+    out_batch: *mut *mut PhotowallPhotoBatch,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.search_photos_cursor_bin");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || out_batch.is_null() {
+            set_last_error("handle or out_batch is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        let db = handle.core.database();
+
+        let filters: SearchFilters = cstr_to_string(filters_json)
+            .and_then(|s| serde_json::from_str(&s).ok())
+            .unwrap_or_default();
+
+        let cursor: Option<PhotoCursor> = cstr_to_string(cursor_json)
+            .and_then(|s| serde_json::from_str(&s).ok());
+
+        let sort: PhotoSortOptions = cstr_to_string(sort_json)
+            .and_then(|s| serde_json::from_str(&s).ok())
+            .unwrap_or_default();
+
+        match db.search_photos_cursor(&filters, limit, cursor.as_ref(), &sort, include_total != 0) {
+            Ok((photos, total)) => {
+                let has_more = photos.len() as u32 >= limit;
+                let next_cursor = build_next_cursor(&photos, &sort, has_more)
+                    .and_then(|c| serde_json::to_string(&c).ok());
+                *out_batch = into_owned_batch(
+                    PhotoColumns::from_photos(&photos),
+                    has_more,
+                    total,
+                    next_cursor.as_deref(),
+                );
+                0
+            }
+            Err(e) => {
+                set_last_error(format!("search_photos_cursor failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_search_photos_cursor_bin");
+        -1
+    })
+}
+
 /// Get a single photo by ID.
 ///
 /// # Returns
@@ -219,6 +368,7 @@ pub unsafe extern "C" fn photowall_get_photo_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.get_photo_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -251,3 +401,55 @@ pub unsafe extern "C" fn photowall_get_photo_json(
         -1
     })
 }
+
+/// Get the perceptual hashes (dHash, pHash) of a photo.
+///
+/// Hashes are computed whenever a thumbnail is generated; photos whose
+/// thumbnails were all cached earlier get them on the next generation.
+///
+/// # Returns
+/// - `0` on success
+/// - `1` if the photo does not exist or has no hashes yet
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_get_perceptual_hash(
+    handle: *mut PhotowallHandle,
+    photo_id: i64,
+    out_dhash: *mut u64,
+    out_phash: *mut u64,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.get_perceptual_hash");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || out_dhash.is_null() || out_phash.is_null() {
+            set_last_error("handle or output pointer is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        let db = handle.core.database();
+
+        match db.get_photo(photo_id) {
+            Ok(Some(Photo {
+                dhash: Some(dhash),
+                phash: Some(phash),
+                ..
+            })) => {
+                *out_dhash = dhash;
+                *out_phash = phash;
+                0
+            }
+            Ok(_) => 1,
+            Err(e) => {
+                set_last_error(format!("get_photo failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_get_perceptual_hash");
+        -1
+    })
+}
@@ -2,6 +2,7 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
 use photowall_core::events::EventSinkExt;
 use photowall_core::models::AppSettings;
 use photowall_core::services::SettingsManager;
@@ -21,6 +22,7 @@ pub unsafe extern "C" fn photowall_get_settings_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.get_settings_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -62,6 +64,7 @@ pub unsafe extern "C" fn photowall_save_settings_json(
     settings_json: *const c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.save_settings_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || settings_json.is_null() {
@@ -91,7 +94,7 @@ pub unsafe extern "C" fn photowall_save_settings_json(
             Ok(manager) => match manager.save(&settings) {
                 Ok(()) => {
                     // Emit settings-changed event
-                    handle.event_sink.emit_typed("settings-changed", &settings);
+                    handle.events.emit_typed("settings-changed", &settings);
                     0
                 }
                 Err(e) => {
@@ -2,7 +2,8 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
-use photowall_core::models::{CreateTag, UpdateTag};
+use photowall_core::metrics::Timer;
+use photowall_core::models::{BatchItemStatus, CreateTag, UpdateTag};
 use std::ffi::{c_char, CStr, CString};
 use std::panic::{catch_unwind, AssertUnwindSafe};
 
@@ -21,6 +22,30 @@ fn string_to_cstr(s: &str) -> *mut c_char {
         .unwrap_or(std::ptr::null_mut())
 }
 
+/// Helper to view a C id array as a slice (null is allowed when `count` is 0).
+unsafe fn id_slice<'a>(ptr: *const i64, count: u32) -> Option<&'a [i64]> {
+    if count == 0 {
+        return Some(&[]);
+    }
+    if ptr.is_null() {
+        return None;
+    }
+    Some(std::slice::from_raw_parts(ptr, count as usize))
+}
+
+/// Helper to copy per-item statuses to a C array; returns the applied count.
+unsafe fn write_statuses(statuses: &[BatchItemStatus], out_status: *mut u8) -> i32 {
+    if !out_status.is_null() {
+        for (i, status) in statuses.iter().enumerate() {
+            *out_status.add(i) = *status as u8;
+        }
+    }
+    statuses
+        .iter()
+        .filter(|s| **s == BatchItemStatus::Applied)
+        .count() as i32
+}
+
 /// Get all tags as JSON.
 ///
 /// # Returns
@@ -32,6 +57,7 @@ pub unsafe extern "C" fn photowall_tags_get_all_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.tags_get_all_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -74,6 +100,7 @@ pub unsafe extern "C" fn photowall_tags_add_to_photo(
     tag_id: i64,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.tags_add_to_photo");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -113,6 +140,7 @@ pub unsafe extern "C" fn photowall_tags_remove_from_photo(
     tag_id: i64,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.tags_remove_from_photo");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -139,6 +167,118 @@ pub unsafe extern "C" fn photowall_tags_remove_from_photo(
     })
 }
 
+/// Add tags to photos in one transaction.
+///
+/// Every photo is paired with every tag. `out_status` (may be null) receives
+/// one `BatchItemStatus` byte per pair, photo-major:
+/// `out_status[photo_index * tag_count + tag_index]`.
+///
+/// # Returns
+/// - Number of pairs applied (>= 0)
+/// - `-1` on error (nothing is written)
+#[no_mangle]
+pub unsafe extern "C" fn photowall_tags_add_to_photos(
+    handle: *mut PhotowallHandle,
+    photo_ids: *const i64,
+    photo_count: u32,
+    tag_ids: *const i64,
+    tag_count: u32,
+    out_status: *mut u8,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.tags_add_to_photos");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return -1;
+        }
+
+        let (photo_ids, tag_ids) = match (
+            id_slice(photo_ids, photo_count),
+            id_slice(tag_ids, tag_count),
+        ) {
+            (Some(p), Some(t)) => (p, t),
+            _ => {
+                set_last_error("photo_ids or tag_ids is null");
+                return -1;
+            }
+        };
+
+        let handle = &*handle;
+        let db = handle.core.database();
+
+        match db.add_tags_to_photos(photo_ids, tag_ids) {
+            Ok(statuses) => write_statuses(&statuses, out_status),
+            Err(e) => {
+                set_last_error(format!("add_tags_to_photos failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_tags_add_to_photos");
+        -1
+    })
+}
+
+/// Remove tags from photos in one transaction.
+///
+/// Every photo is paired with every tag. `out_status` (may be null) receives
+/// one `BatchItemStatus` byte per pair, photo-major:
+/// `out_status[photo_index * tag_count + tag_index]`.
+///
+/// # Returns
+/// - Number of pairs applied (>= 0)
+/// - `-1` on error (nothing is written)
+#[no_mangle]
+pub unsafe extern "C" fn photowall_tags_remove_from_photos(
+    handle: *mut PhotowallHandle,
+    photo_ids: *const i64,
+    photo_count: u32,
+    tag_ids: *const i64,
+    tag_count: u32,
+    out_status: *mut u8,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.tags_remove_from_photos");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return -1;
+        }
+
+        let (photo_ids, tag_ids) = match (
+            id_slice(photo_ids, photo_count),
+            id_slice(tag_ids, tag_count),
+        ) {
+            (Some(p), Some(t)) => (p, t),
+            _ => {
+                set_last_error("photo_ids or tag_ids is null");
+                return -1;
+            }
+        };
+
+        let handle = &*handle;
+        let db = handle.core.database();
+
+        match db.remove_tags_from_photos(photo_ids, tag_ids) {
+            Ok(statuses) => write_statuses(&statuses, out_status),
+            Err(e) => {
+                set_last_error(format!("remove_tags_from_photos failed: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_tags_remove_from_photos");
+        -1
+    })
+}
+
 /// Create a new tag.
 ///
 /// # Parameters
@@ -157,6 +297,7 @@ pub unsafe extern "C" fn photowall_tags_create_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.tags_create_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || name.is_null() || out_json.is_null() {
@@ -219,6 +360,7 @@ pub unsafe extern "C" fn photowall_tags_create_json(
 #[no_mangle]
 pub unsafe extern "C" fn photowall_tags_delete(handle: *mut PhotowallHandle, tag_id: i64) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.tags_delete");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -260,6 +402,7 @@ pub unsafe extern "C" fn photowall_tags_update_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.tags_update_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -2,7 +2,9 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
-use photowall_core::services::{ThumbnailSize, ThumbnailTask};
+use photowall_core::metrics::Timer;
+use photowall_core::services::thumbnail_atlas::DEFAULT_ATLAS_PAGE_SIZE;
+use photowall_core::services::{build_atlas, AtlasFormat, AtlasOptions, OffscreenPolicy, ThumbnailSize, ThumbnailTask};
 use serde::Deserialize;
 use std::ffi::{c_char, CStr, CString};
 use std::panic::{catch_unwind, AssertUnwindSafe};
@@ -51,6 +53,7 @@ pub unsafe extern "C" fn photowall_enqueue_thumbnails_batch(
     requests_json: *const c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.enqueue_thumbnails_batch");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || requests_json.is_null() {
@@ -101,8 +104,82 @@ pub unsafe extern "C" fn photowall_enqueue_thumbnails_batch(
     })
 }
 
+/// Off-screen policy for `photowall_reprioritize_thumbnails`: move behind visible work.
+pub const PHOTOWALL_OFFSCREEN_DEMOTE: i32 = 0;
+/// Off-screen policy for `photowall_reprioritize_thumbnails`: drop queued work.
+pub const PHOTOWALL_OFFSCREEN_DROP: i32 = 1;
+
+/// Reorder queued thumbnail requests around the current viewport.
+///
+/// Call whenever the visible range changes (e.g. on scroll). Queued requests
+/// for `visible_hashes` run first, in array order; the rest are demoted or
+/// dropped according to `offscreen_policy`. Requests enqueued later are
+/// ordered the same way. Each worker applies the new viewport to its own
+/// queue the next time it touches it, so this call does not block on the
+/// queues. Passing `count == 0` restores enqueue priorities.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `visible_hashes`: Array of `count` file hash strings, top-left first
+///   (null entries are ignored)
+/// - `count`: Number of hashes
+/// - `offscreen_policy`: `PHOTOWALL_OFFSCREEN_DEMOTE` or `PHOTOWALL_OFFSCREEN_DROP`
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_reprioritize_thumbnails(
+    handle: *mut PhotowallHandle,
+    visible_hashes: *const *const c_char,
+    count: u32,
+    offscreen_policy: i32,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.reprioritize_thumbnails");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || (count > 0 && visible_hashes.is_null()) {
+            set_last_error("handle or visible_hashes is null");
+            return -1;
+        }
+
+        let policy = match offscreen_policy {
+            PHOTOWALL_OFFSCREEN_DEMOTE => OffscreenPolicy::Demote,
+            PHOTOWALL_OFFSCREEN_DROP => OffscreenPolicy::Drop,
+            other => {
+                set_last_error(format!("invalid offscreen policy: {}", other));
+                return -1;
+            }
+        };
+
+        let handle = &*handle;
+
+        let hashes: Vec<String> = if count == 0 {
+            Vec::new()
+        } else {
+            std::slice::from_raw_parts(visible_hashes, count as usize)
+                .iter()
+                .filter(|p| !p.is_null())
+                .filter_map(|&p| CStr::from_ptr(p).to_str().ok())
+                .map(str::to_string)
+                .collect()
+        };
+
+        handle.thumbnail_queue.reprioritize(&hashes, policy);
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_reprioritize_thumbnails");
+        -1
+    })
+}
+
 /// Get the path to a cached thumbnail.
 ///
+/// A thumbnail that only exists in the packed store is exported to a file.
+///
 /// # Parameters
 /// - `handle`: Valid handle from `photowall_init`
 /// - `file_hash`: File hash
@@ -118,6 +195,7 @@ pub unsafe extern "C" fn photowall_get_thumbnail_path_utf8(
     size: *const c_char,
 ) -> *mut c_char {
     clear_last_error();
+    let _timer = Timer::start("ffi.get_thumbnail_path_utf8");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || file_hash.is_null() || size.is_null() {
@@ -144,14 +222,11 @@ pub unsafe extern "C" fn photowall_get_thumbnail_path_utf8(
         };
 
         let thumb_size = parse_size(size_str);
-        let path = handle.core.thumbnails().get_cache_path(hash_str, thumb_size);
-
-        if path.exists() {
-            CString::new(path.to_string_lossy().as_ref())
+        match handle.core.thumbnails().thumbnail_path(hash_str, thumb_size) {
+            Some(path) => CString::new(path.to_string_lossy().as_ref())
                 .map(|cs| cs.into_raw())
-                .unwrap_or(std::ptr::null_mut())
-        } else {
-            std::ptr::null_mut()
+                .unwrap_or(std::ptr::null_mut()),
+            None => std::ptr::null_mut(),
         }
     }));
 
@@ -174,6 +249,7 @@ pub unsafe extern "C" fn photowall_is_thumbnail_cached(
     size: *const c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.is_thumbnail_cached");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || file_hash.is_null() || size.is_null() {
@@ -212,3 +288,440 @@ pub unsafe extern "C" fn photowall_is_thumbnail_cached(
         -1
     })
 }
+
+/// Check which of many thumbnails are cached, without touching the disk.
+///
+/// Backed by an in-memory index of the per-file cache and the packed store;
+/// the per-file cache directory is scanned once on the first call.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `file_hashes`: Array of `count` file hash strings
+/// - `count`: Number of hashes
+/// - `size`: Size name ("tiny", "small", "medium", "large")
+/// - `out_bits`: Output bitset of at least `(count + 7) / 8` bytes; bit `i`
+///   (`out_bits[i / 8] >> (i % 8) & 1`) is set if `file_hashes[i]` is cached
+///
+/// # Returns
+/// - Number of cached thumbnails (>= 0)
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_thumbnails_cached_bitset(
+    handle: *mut PhotowallHandle,
+    file_hashes: *const *const c_char,
+    count: u32,
+    size: *const c_char,
+    out_bits: *mut u8,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.thumbnails_cached_bitset");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || size.is_null() || (count > 0 && (file_hashes.is_null() || out_bits.is_null())) {
+            set_last_error("handle, file_hashes, size, or out_bits is null");
+            return -1;
+        }
+        if count == 0 {
+            return 0;
+        }
+
+        let handle = &*handle;
+
+        let size_str = match CStr::from_ptr(size).to_str() {
+            Ok(s) => s,
+            Err(_) => {
+                set_last_error("invalid UTF-8 in size");
+                return -1;
+            }
+        };
+
+        // Null or non-UTF-8 entries are reported as not cached.
+        let hashes: Vec<&str> = std::slice::from_raw_parts(file_hashes, count as usize)
+            .iter()
+            .map(|&p| {
+                if p.is_null() {
+                    ""
+                } else {
+                    CStr::from_ptr(p).to_str().unwrap_or("")
+                }
+            })
+            .collect();
+
+        let flags = handle.core.thumbnails().cached_flags(&hashes, parse_size(size_str));
+
+        let bits = std::slice::from_raw_parts_mut(out_bits, (count as usize).div_ceil(8));
+        bits.fill(0);
+        let mut cached = 0;
+        for (i, &is_cached) in flags.iter().enumerate() {
+            if is_cached && !hashes[i].is_empty() {
+                bits[i / 8] |= 1 << (i % 8);
+                cached += 1;
+            }
+        }
+        cached
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_thumbnails_cached_bitset");
+        -1
+    })
+}
+
+/// Get a thumbnail from the packed store as a pointer into mapped memory.
+///
+/// Thumbnails found only in the per-file cache are imported into the pack on
+/// first access. The returned bytes are WebP-encoded and stay valid until the
+/// next `photowall_compact_thumbnail_packs` call or `photowall_shutdown`.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `file_hash`: File hash
+/// - `size`: Size name ("tiny", "small", "medium", "large")
+/// - `out_data`: Output pointer to the thumbnail bytes (library-owned, do not free)
+/// - `out_len`: Output length in bytes
+///
+/// # Returns
+/// - `1` if found
+/// - `0` if not cached
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_get_thumbnail_packed(
+    handle: *mut PhotowallHandle,
+    file_hash: *const c_char,
+    size: *const c_char,
+    out_data: *mut *const u8,
+    out_len: *mut usize,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.get_thumbnail_packed");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || file_hash.is_null() || size.is_null() || out_data.is_null() || out_len.is_null() {
+            set_last_error("handle, file_hash, size, out_data, or out_len is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        *out_data = std::ptr::null();
+        *out_len = 0;
+
+        let hash_str = match CStr::from_ptr(file_hash).to_str() {
+            Ok(s) => s,
+            Err(_) => {
+                set_last_error("invalid UTF-8 in file_hash");
+                return -1;
+            }
+        };
+
+        let size_str = match CStr::from_ptr(size).to_str() {
+            Ok(s) => s,
+            Err(_) => {
+                set_last_error("invalid UTF-8 in size");
+                return -1;
+            }
+        };
+
+        let thumbnails = handle.core.thumbnails();
+        if thumbnails.pack_store().is_none() {
+            set_last_error("packed thumbnail store is unavailable");
+            return -1;
+        }
+
+        // The mapping stays owned by the pack store, so the pointer outlives
+        // the `PackedThumbnail` guard until the next compaction.
+        match thumbnails.get_packed(hash_str, parse_size(size_str)) {
+            Some(thumb) => {
+                let bytes = thumb.as_bytes();
+                *out_data = bytes.as_ptr();
+                *out_len = bytes.len();
+                1
+            }
+            None => 0,
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_get_thumbnail_packed");
+        -1
+    })
+}
+
+/// Compact the packed thumbnail store, reclaiming space of replaced and
+/// deleted thumbnails.
+///
+/// Invalidates all pointers previously returned by `photowall_get_thumbnail_packed`.
+///
+/// # Returns
+/// - Number of bytes reclaimed (>= 0)
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_compact_thumbnail_packs(handle: *mut PhotowallHandle) -> i64 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.compact_thumbnail_packs");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() {
+            set_last_error("handle is null");
+            return -1;
+        }
+
+        let handle = &*handle;
+        let store = match handle.core.thumbnails().pack_store() {
+            Some(store) => store,
+            None => {
+                set_last_error("packed thumbnail store is unavailable");
+                return -1;
+            }
+        };
+
+        match store.compact() {
+            Ok(stats) => stats.reclaimed_bytes as i64,
+            Err(e) => {
+                set_last_error(format!("failed to compact thumbnail packs: {}", e));
+                -1
+            }
+        }
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_compact_thumbnail_packs");
+        -1
+    })
+}
+
+/// Atlas pages are returned as raw RGBA8 pixels (`width * height * 4` bytes).
+pub const PHOTOWALL_ATLAS_FORMAT_RGBA: u32 = 0;
+/// Atlas pages are returned PNG-encoded.
+pub const PHOTOWALL_ATLAS_FORMAT_PNG: u32 = 1;
+/// Atlas pages are returned WebP-encoded (lossless).
+pub const PHOTOWALL_ATLAS_FORMAT_WEBP: u32 = 2;
+/// Cell page index for thumbnails that are not cached.
+pub const PHOTOWALL_ATLAS_NO_PAGE: u32 = u32::MAX;
+
+/// Placement of one thumbnail in an atlas.
+///
+/// `x`/`y`/`width`/`height` is the image rectangle in page pixels (without
+/// the letterbox padding of the cell); `u0`..`v1` is the same rectangle in
+/// normalized texture coordinates.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct PhotowallAtlasCell {
+    pub page: u32,
+    pub x: u32,
+    pub y: u32,
+    pub width: u32,
+    pub height: u32,
+    pub u0: f32,
+    pub v0: f32,
+    pub u1: f32,
+    pub v1: f32,
+}
+
+/// One atlas page.
+#[repr(C)]
+pub struct PhotowallAtlasPage {
+    pub width: u32,
+    pub height: u32,
+    pub data: *const u8,
+    pub len: usize,
+}
+
+/// Thumbnail atlas exposed to C.
+#[repr(C)]
+pub struct PhotowallAtlas {
+    /// `PHOTOWALL_ATLAS_FORMAT_*` of the page data.
+    pub format: u32,
+    pub page_count: u32,
+    pub pages: *const PhotowallAtlasPage,
+    /// Number of cells, equal to the number of requested hashes.
+    pub cell_count: u32,
+    pub cells: *const PhotowallAtlasCell,
+}
+
+/// Owned atlas allocation. The header must stay the first field so a pointer
+/// to the allocation can be handed out as `*mut PhotowallAtlas`.
+#[repr(C)]
+struct OwnedAtlas {
+    header: PhotowallAtlas,
+    pages: Vec<PhotowallAtlasPage>,
+    cells: Vec<PhotowallAtlasCell>,
+    buffers: Vec<Vec<u8>>,
+}
+
+/// Composite cached thumbnails into one or more texture atlas pages.
+///
+/// Each thumbnail is scaled to fit a `cell_size` square (never upscaled),
+/// centered in its cell, and cells are filled row by row in request order.
+/// Every cell is surrounded by a 2 px gutter filled with the thumbnail's
+/// edge pixels, so bilinear filtering at the UV edges never picks up a
+/// neighbour. A page holds `(max_page_size / (cell_size + 4))^2` cells; the
+/// last page is shrunk to the rows actually used. Thumbnails that are not cached do not
+/// take a cell and get `page == PHOTOWALL_ATLAS_NO_PAGE`.
+///
+/// # Parameters
+/// - `handle`: Valid handle from `photowall_init`
+/// - `file_hashes`: Array of `count` file hash strings
+/// - `count`: Number of hashes
+/// - `size`: Thumbnail size to read ("tiny", "small", "medium", "large")
+/// - `cell_size`: Cell edge in pixels (1..=1024)
+/// - `max_page_size`: Maximum page edge in pixels, `0` for 4096
+/// - `format`: `PHOTOWALL_ATLAS_FORMAT_*`
+///
+/// # Returns
+/// - Atlas (must be freed with `photowall_free_thumbnail_atlas`)
+/// - `NULL` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_build_thumbnail_atlas(
+    handle: *mut PhotowallHandle,
+    file_hashes: *const *const c_char,
+    count: u32,
+    size: *const c_char,
+    cell_size: u32,
+    max_page_size: u32,
+    format: u32,
+) -> *mut PhotowallAtlas {
+    clear_last_error();
+    let _timer = Timer::start("ffi.build_thumbnail_atlas");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if handle.is_null() || size.is_null() || (count > 0 && file_hashes.is_null()) {
+            set_last_error("handle, file_hashes, or size is null");
+            return std::ptr::null_mut();
+        }
+
+        let handle = &*handle;
+
+        let size_str = match CStr::from_ptr(size).to_str() {
+            Ok(s) => s,
+            Err(_) => {
+                set_last_error("invalid UTF-8 in size");
+                return std::ptr::null_mut();
+            }
+        };
+
+        let atlas_format = match format {
+            PHOTOWALL_ATLAS_FORMAT_RGBA => AtlasFormat::Rgba,
+            PHOTOWALL_ATLAS_FORMAT_PNG => AtlasFormat::Png,
+            PHOTOWALL_ATLAS_FORMAT_WEBP => AtlasFormat::WebP,
+            _ => {
+                set_last_error(format!("unknown atlas format: {}", format));
+                return std::ptr::null_mut();
+            }
+        };
+
+        // Null or non-UTF-8 entries are treated as not cached.
+        let hashes: Vec<&str> = if count == 0 {
+            Vec::new()
+        } else {
+            std::slice::from_raw_parts(file_hashes, count as usize)
+                .iter()
+                .map(|&p| {
+                    if p.is_null() {
+                        ""
+                    } else {
+                        CStr::from_ptr(p).to_str().unwrap_or("")
+                    }
+                })
+                .collect()
+        };
+
+        let options = AtlasOptions {
+            size: parse_size(size_str),
+            cell_size,
+            max_page_size: if max_page_size == 0 {
+                DEFAULT_ATLAS_PAGE_SIZE
+            } else {
+                max_page_size
+            },
+        };
+
+        let atlas = match build_atlas(handle.core.thumbnails(), &hashes, &options) {
+            Ok(atlas) => atlas,
+            Err(e) => {
+                set_last_error(format!("failed to build thumbnail atlas: {}", e));
+                return std::ptr::null_mut();
+            }
+        };
+
+        let cells: Vec<PhotowallAtlasCell> = atlas
+            .cells
+            .iter()
+            .map(|cell| match cell {
+                Some(c) => PhotowallAtlasCell {
+                    page: c.page,
+                    x: c.x,
+                    y: c.y,
+                    width: c.width,
+                    height: c.height,
+                    u0: c.u0,
+                    v0: c.v0,
+                    u1: c.u1,
+                    v1: c.v1,
+                },
+                None => PhotowallAtlasCell {
+                    page: PHOTOWALL_ATLAS_NO_PAGE,
+                    x: 0,
+                    y: 0,
+                    width: 0,
+                    height: 0,
+                    u0: 0.0,
+                    v0: 0.0,
+                    u1: 0.0,
+                    v1: 0.0,
+                },
+            })
+            .collect();
+
+        let mut pages = Vec::with_capacity(atlas.pages.len());
+        let mut buffers = Vec::with_capacity(atlas.pages.len());
+        for page in atlas.pages {
+            let (width, height) = (page.width(), page.height());
+            let data = match page.into_bytes(atlas_format) {
+                Ok(bytes) => bytes,
+                Err(e) => {
+                    set_last_error(format!("failed to encode atlas page: {}", e));
+                    return std::ptr::null_mut();
+                }
+            };
+            // Moving the Vec into `buffers` does not move its heap buffer.
+            pages.push(PhotowallAtlasPage {
+                width,
+                height,
+                data: data.as_ptr(),
+                len: data.len(),
+            });
+            buffers.push(data);
+        }
+
+        let header = PhotowallAtlas {
+            format,
+            page_count: pages.len() as u32,
+            pages: pages.as_ptr(),
+            cell_count: cells.len() as u32,
+            cells: cells.as_ptr(),
+        };
+        Box::into_raw(Box::new(OwnedAtlas {
+            header,
+            pages,
+            cells,
+            buffers,
+        })) as *mut PhotowallAtlas
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_build_thumbnail_atlas");
+        std::ptr::null_mut()
+    })
+}
+
+/// Free an atlas returned by `photowall_build_thumbnail_atlas`.
+///
+/// # Safety
+/// - `atlas` must be a pointer returned by `photowall_build_thumbnail_atlas`
+/// - After calling this function, the atlas and all page data are invalid
+#[no_mangle]
+pub unsafe extern "C" fn photowall_free_thumbnail_atlas(atlas: *mut PhotowallAtlas) {
+    if !atlas.is_null() {
+        let _ = Box::from_raw(atlas as *mut OwnedAtlas);
+    }
+}
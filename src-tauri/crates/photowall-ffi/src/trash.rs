@@ -2,6 +2,7 @@
 
 use crate::error::{clear_last_error, set_last_error};
 use crate::handle::PhotowallHandle;
+use photowall_core::metrics::Timer;
 use photowall_core::models::PaginationParams;
 use std::ffi::{c_char, CStr, CString};
 use std::panic::{catch_unwind, AssertUnwindSafe};
@@ -19,6 +20,7 @@ pub unsafe extern "C" fn photowall_trash_soft_delete(
     photo_ids_json: *const c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.trash_soft_delete");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || photo_ids_json.is_null() {
@@ -46,7 +48,10 @@ pub unsafe extern "C" fn photowall_trash_soft_delete(
         };
 
         match db.soft_delete_photos(&photo_ids) {
-            Ok(count) => count as i32,
+            Ok(count) => {
+                handle.core.forget_photos(&photo_ids);
+                count as i32
+            }
             Err(e) => {
                 set_last_error(format!("soft_delete_photos failed: {}", e));
                 -1
@@ -67,6 +72,7 @@ pub unsafe extern "C" fn photowall_trash_restore(
     photo_ids_json: *const c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.trash_restore");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || photo_ids_json.is_null() {
@@ -94,7 +100,12 @@ pub unsafe extern "C" fn photowall_trash_restore(
         };
 
         match db.restore_photos(&photo_ids) {
-            Ok(count) => count as i32,
+            Ok(count) => {
+                if let Err(e) = handle.core.reindex_photos(&photo_ids) {
+                    tracing::warn!("Failed to reindex restored photos: {}", e);
+                }
+                count as i32
+            }
             Err(e) => {
                 set_last_error(format!("restore_photos failed: {}", e));
                 -1
@@ -115,6 +126,7 @@ pub unsafe extern "C" fn photowall_trash_permanent_delete(
     photo_ids_json: *const c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.trash_permanent_delete");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || photo_ids_json.is_null() {
@@ -142,7 +154,10 @@ pub unsafe extern "C" fn photowall_trash_permanent_delete(
         };
 
         match db.permanent_delete_photos(&photo_ids) {
-            Ok(count) => count as i32,
+            Ok(count) => {
+                handle.core.forget_photos(&photo_ids);
+                count as i32
+            }
             Err(e) => {
                 set_last_error(format!("permanent_delete_photos failed: {}", e));
                 -1
@@ -165,6 +180,7 @@ pub unsafe extern "C" fn photowall_trash_get_photos_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.trash_get_photos_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -200,6 +216,7 @@ pub unsafe extern "C" fn photowall_trash_get_photos_json(
 #[no_mangle]
 pub unsafe extern "C" fn photowall_trash_empty(handle: *mut PhotowallHandle) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.trash_empty");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() {
@@ -232,6 +249,7 @@ pub unsafe extern "C" fn photowall_trash_get_stats_json(
     out_json: *mut *mut c_char,
 ) -> i32 {
     clear_last_error();
+    let _timer = Timer::start("ffi.trash_get_stats_json");
 
     let result = catch_unwind(AssertUnwindSafe(|| {
         if handle.is_null() || out_json.is_null() {
@@ -0,0 +1,250 @@
+//! Viewer API - predictive decoding for the full-screen viewer.
+//!
+//! A viewer owns a small pool of decode threads and a bounded cache of
+//! display-resolution renditions. The host passes the navigation order once
+//! and reports every move; the neighbours in the direction of travel are
+//! decoded ahead of time so stepping through photos does not wait on decode.
+
+use crate::error::{clear_last_error, set_last_error};
+use photowall_core::metrics::Timer;
+use photowall_core::services::{PrefetchOptions, Rendition, ViewerPrefetcher};
+use std::ffi::{c_char, CStr};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::path::PathBuf;
+use std::sync::Arc;
+
+/// Opaque viewer handle exposed to C.
+pub struct PhotowallViewer {
+    prefetcher: ViewerPrefetcher,
+}
+
+/// Decoded display rendition: RGBA8, `stride == width * 4`.
+#[repr(C)]
+pub struct PhotowallRendition {
+    pub width: u32,
+    pub height: u32,
+    pub stride: u32,
+    pub data: *const u8,
+    pub len: usize,
+}
+
+/// Owned rendition. The header must stay the first field so a pointer to the
+/// allocation can be handed out as `*mut PhotowallRendition`. Holding the
+/// `Arc` keeps the cached pixels alive without copying them.
+#[repr(C)]
+struct OwnedRendition {
+    header: PhotowallRendition,
+    rendition: Arc<Rendition>,
+}
+
+/// Create a viewer.
+///
+/// # Parameters
+/// - `radius`: Photos to decode ahead and behind the current one (0 = 3)
+/// - `max_dimension`: Longest edge of a rendition in pixels (0 = 2560)
+/// - `cache_mb`: Cache limit in MiB (0 = 256)
+/// - `threads`: Decode threads (0 = 2)
+///
+/// # Returns
+/// - Viewer (must be freed with `photowall_viewer_close`)
+/// - `NULL` on error
+#[no_mangle]
+pub extern "C" fn photowall_viewer_open(
+    radius: u32,
+    max_dimension: u32,
+    cache_mb: u32,
+    threads: u32,
+) -> *mut PhotowallViewer {
+    clear_last_error();
+    let _timer = Timer::start("ffi.viewer_open");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        let defaults = PrefetchOptions::default();
+        let options = PrefetchOptions {
+            radius: if radius == 0 { defaults.radius } else { radius as usize },
+            max_dimension: if max_dimension == 0 { defaults.max_dimension } else { max_dimension },
+            cache_bytes: if cache_mb == 0 {
+                defaults.cache_bytes
+            } else {
+                cache_mb as usize * 1024 * 1024
+            },
+            threads: if threads == 0 { defaults.threads } else { threads as usize },
+        };
+        Box::into_raw(Box::new(PhotowallViewer {
+            prefetcher: ViewerPrefetcher::new(options),
+        }))
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_viewer_open");
+        std::ptr::null_mut()
+    })
+}
+
+/// Set the navigation order and the current position.
+///
+/// Cached renditions of photos that are still in the order are kept.
+///
+/// # Parameters
+/// - `viewer`: Viewer from `photowall_viewer_open`
+/// - `paths`: Array of `count` file paths in navigation order
+/// - `count`: Number of paths
+/// - `current`: Index of the photo shown now
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_viewer_set_order(
+    viewer: *mut PhotowallViewer,
+    paths: *const *const c_char,
+    count: u32,
+    current: u32,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.viewer_set_order");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if viewer.is_null() || (count > 0 && paths.is_null()) {
+            set_last_error("viewer or paths is null");
+            return -1;
+        }
+
+        let viewer = &*viewer;
+
+        // Null or non-UTF-8 entries keep their slot but fail to decode.
+        let order: Vec<PathBuf> = if count == 0 {
+            Vec::new()
+        } else {
+            std::slice::from_raw_parts(paths, count as usize)
+                .iter()
+                .map(|&p| {
+                    if p.is_null() {
+                        PathBuf::new()
+                    } else {
+                        PathBuf::from(CStr::from_ptr(p).to_str().unwrap_or(""))
+                    }
+                })
+                .collect()
+        };
+
+        viewer.prefetcher.set_order(order, current as usize);
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_viewer_set_order");
+        -1
+    })
+}
+
+/// Report a move to `index`.
+///
+/// Prefetching is re-planned around the new position, favouring the
+/// direction of travel. When the direction reverses, queued decodes are
+/// dropped and in-flight decodes that left the window are cancelled.
+///
+/// # Returns
+/// - `0` on success
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_viewer_navigate(viewer: *mut PhotowallViewer, index: u32) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.viewer_navigate");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if viewer.is_null() {
+            set_last_error("viewer is null");
+            return -1;
+        }
+
+        (*viewer).prefetcher.navigate(index as usize);
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_viewer_navigate");
+        -1
+    })
+}
+
+/// Get the display rendition of the photo at `index`.
+///
+/// # Parameters
+/// - `viewer`: Viewer from `photowall_viewer_open`
+/// - `index`: Position in the navigation order
+/// - `wait`: `1` to wait for (or perform) the decode, `0` to return only a
+///   cached rendition
+/// - `out_rendition`: Output (must be freed with `photowall_free_rendition`)
+///
+/// # Returns
+/// - `0` on success
+/// - `1` if `wait == 0` and the rendition is not ready yet
+/// - `-1` on error
+#[no_mangle]
+pub unsafe extern "C" fn photowall_viewer_get(
+    viewer: *mut PhotowallViewer,
+    index: u32,
+    wait: i32,
+    out_rendition: *mut *mut PhotowallRendition,
+) -> i32 {
+    clear_last_error();
+    let _timer = Timer::start("ffi.viewer_get");
+
+    let result = catch_unwind(AssertUnwindSafe(|| {
+        if viewer.is_null() || out_rendition.is_null() {
+            set_last_error("viewer or out_rendition is null");
+            return -1;
+        }
+        *out_rendition = std::ptr::null_mut();
+
+        let viewer = &*viewer;
+        let rendition = match viewer.prefetcher.get(index as usize, wait != 0) {
+            Ok(Some(rendition)) => rendition,
+            Ok(None) => return 1,
+            Err(e) => {
+                set_last_error(format!("failed to decode photo: {}", e));
+                return -1;
+            }
+        };
+
+        let header = PhotowallRendition {
+            width: rendition.width,
+            height: rendition.height,
+            stride: rendition.width * 4,
+            data: rendition.pixels.as_ptr(),
+            len: rendition.pixels.len(),
+        };
+        *out_rendition = Box::into_raw(Box::new(OwnedRendition { header, rendition })) as *mut PhotowallRendition;
+        0
+    }));
+
+    result.unwrap_or_else(|_| {
+        set_last_error("panic in photowall_viewer_get");
+        -1
+    })
+}
+
+/// Free a rendition returned by `photowall_viewer_get`.
+///
+/// # Safety
+/// - `rendition` must be a pointer returned by `photowall_viewer_get`
+/// - After calling this function, the pixel data is invalid
+#[no_mangle]
+pub unsafe extern "C" fn photowall_free_rendition(rendition: *mut PhotowallRendition) {
+    if !rendition.is_null() {
+        let _ = Box::from_raw(rendition as *mut OwnedRendition);
+    }
+}
+
+/// Close a viewer, stopping its decode threads.
+///
+/// # Safety
+/// - `viewer` must be a pointer returned by `photowall_viewer_open`
+/// - Renditions obtained from the viewer stay valid until freed
+#[no_mangle]
+pub unsafe extern "C" fn photowall_viewer_close(viewer: *mut PhotowallViewer) {
+    if !viewer.is_null() {
+        let _ = Box::from_raw(viewer);
+    }
+}
@@ -374,6 +374,102 @@ cleanup:
     return result;
 }
 
+// ============ 缩略图 ============
+
+PW_API int pw_thumbnail(const char* input_path, const char* output_path, int size, int quality, PwPixels* pixels) {
+    VipsImage* out = nullptr;
+    VipsImage* memory = nullptr;
+    VipsImage* srgb = nullptr;
+    VipsImage* rgba = nullptr;
+    int result = -1;
+
+    if (pixels) {
+        pixels->data = nullptr;
+        pixels->width = 0;
+        pixels->height = 0;
+    }
+    if (size <= 0) {
+        set_error("Invalid thumbnail size");
+        return -1;
+    }
+
+    // vips_thumbnail 会根据格式选择最快的缩小方式（JPEG shrink-on-load、
+    // WebP/HEIF 按比例解码等），并在缩放前完成方向校正和色彩管理
+    if (vips_thumbnail(input_path, &out, size,
+                       "height", size,
+                       "size", VIPS_SIZE_DOWN,
+                       "import_profile", "srgb",
+                       "export_profile", "srgb",
+                       nullptr)) {
+        set_error(vips_error_buffer());
+        vips_error_clear();
+        goto cleanup;
+    }
+
+    // out 是惰性管线，WebP 编码和像素导出各求值一次会解码两遍；
+    // 先物化到内存，两次输出都读同一份像素
+    memory = vips_image_copy_memory(out);
+    if (!memory) {
+        set_error(vips_error_buffer());
+        vips_error_clear();
+        goto cleanup;
+    }
+
+    // 已转换到 sRGB，无需保留 ICC 和 EXIF
+    if (vips_webpsave(memory, output_path,
+                      "Q", clamp(quality, 1, 100),
+                      "keep", VIPS_FOREIGN_KEEP_NONE,
+                      nullptr)) {
+        set_error(vips_error_buffer());
+        vips_error_clear();
+        goto cleanup;
+    }
+
+    // 灰度 / 16 位图统一转为 8 位 sRGB，再补齐 alpha 通道
+    if (pixels) {
+        if (vips_colourspace(memory, &srgb, VIPS_INTERPRETATION_sRGB, nullptr)) {
+            set_error(vips_error_buffer());
+            vips_error_clear();
+            goto cleanup;
+        }
+        if (srgb->Bands == 4) {
+            rgba = srgb;
+            srgb = nullptr;
+        } else if (vips_addalpha(srgb, &rgba, nullptr)) {
+            set_error(vips_error_buffer());
+            vips_error_clear();
+            goto cleanup;
+        }
+
+        size_t len = 0;
+        void* data = vips_image_write_to_memory(rgba, &len);
+        if (!data) {
+            set_error(vips_error_buffer());
+            vips_error_clear();
+            goto cleanup;
+        }
+        pixels->data = static_cast<uint8_t*>(data);
+        pixels->width = vips_image_get_width(rgba);
+        pixels->height = vips_image_get_height(rgba);
+    }
+
+    result = 0;
+
+cleanup:
+    if (rgba) g_object_unref(rgba);
+    if (srgb) g_object_unref(srgb);
+    if (memory) g_object_unref(memory);
+    if (out) g_object_unref(out);
+    return result;
+}
+
+PW_API void pw_free_pixels(PwPixels* pixels) {
+    if (pixels && pixels->data) {
+        g_free(pixels->data);
+        pixels->data = nullptr;
+    }
+}
+
 // ============ 综合调整 ============
 
 PW_API int pw_apply_adjustments(
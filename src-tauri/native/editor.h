@@ -121,6 +121,39 @@ PW_API int pw_adjust_shadows(const char* input_path, const char* output_path, fl
  */
 PW_API int pw_adjust_temperature(const char* input_path, const char* output_path, float kelvin_shift);
 
+/**
+ * 像素缓冲区（RGBA8，按行紧密排列，由库分配，用 pw_free_pixels 释放）
+ */
+typedef struct {
+    uint8_t* data;
+    int width;
+    int height;
+} PwPixels;
+
+/**
+ * 生成 WebP 缩略图
+ *
+ * 基于 vips_thumbnail：JPEG/WebP/HEIF 等格式在解码阶段直接缩小（shrink-on-load），
+ * 按 EXIF 方向自动旋转，嵌入的 ICC 配置转换到 sRGB，结果直接编码为 WebP 并去除元数据。
+ * 只缩小不放大，输出保持宽高比。
+ *
+ * pixels 非空时同时返回编码前的 RGBA8 像素，调用方据此计算哈希和质量评分，
+ * 不受 WebP 有损压缩影响。
+ *
+ * @param input_path 输入图像路径
+ * @param output_path 输出 WebP 路径（不依赖扩展名）
+ * @param size 输出最长边（像素）
+ * @param quality WebP 质量 (1-100)
+ * @param pixels 可为 NULL；成功时写入像素缓冲区，失败时置空
+ * @return 0 成功，非0 失败
+ */
+PW_API int pw_thumbnail(const char* input_path, const char* output_path, int size, int quality, PwPixels* pixels);
+
+/**
+ * 释放 pw_thumbnail 返回的像素缓冲区（可重复调用）
+ */
+PW_API void pw_free_pixels(PwPixels* pixels);
+
 /**
  * 获取最后一次错误信息
  * @return 错误信息字符串
@@ -2,10 +2,13 @@
 //!
 //! 使用 Tesseract OCR 识别照片中的文字
 
-use std::path::Path;
+use std::path::{Path, PathBuf};
 use std::sync::atomic::{AtomicBool, AtomicI64, Ordering};
-use std::sync::Arc;
+use std::sync::{Arc, Mutex};
 
+use image::DynamicImage;
+use photowall_core::services::ocr_batch::{OcrBatch, OcrBatchOptions, OcrRecognizer, OcrStatus as BatchStatus, OcrTask};
+use photowall_core::services::ocr_preprocess::{self, OcrImage, OcrPreprocessOptions};
 use rusty_tesseract::{Args, Image};
 use tracing::{debug, error, info, warn};
 
@@ -170,31 +173,42 @@ impl OcrService {
             };
         }
 
-        // 加载图片
-        let image = match Image::from_path(image_path) {
-            Ok(img) => img,
+        // 预处理（缩小到目标 DPI、二值化、纠偏），失败时回退为直接加载原图
+        let preprocess_options = OcrPreprocessOptions::default();
+        let preprocessed = ocr_preprocess::preprocess_file(path, &preprocess_options)
+            .map_err(|e| e.to_string())
+            .and_then(|ocr_image| {
+                let dpi = ocr_image.dpi;
+                if ocr_image.skew_degrees != 0.0 {
+                    debug!("OCR 纠偏: {} -> {:.1}°", image_path, ocr_image.skew_degrees);
+                }
+                let gray = DynamicImage::ImageLuma8(ocr_image.into_gray_image());
+                Image::from_dynamic_image(&gray)
+                    .map(|image| (image, dpi))
+                    .map_err(|e| e.to_string())
+            });
+
+        let (image, dpi) = match preprocessed {
+            Ok(loaded) => loaded,
             Err(e) => {
-                return OcrResult {
-                    path: image_path.to_string(),
-                    text: String::new(),
-                    confidence: 0.0,
-                    error: Some(format!("加载图片失败: {}", e)),
-                    status: OcrStatus::Failed as i32,
-                };
+                warn!("OCR 预处理失败，使用原图: {} - {}", image_path, e);
+                match Image::from_path(image_path) {
+                    Ok(img) => (img, preprocess_options.target_dpi),
+                    Err(e) => {
+                        return OcrResult {
+                            path: image_path.to_string(),
+                            text: String::new(),
+                            confidence: 0.0,
+                            error: Some(format!("加载图片失败: {}", e)),
+                            status: OcrStatus::Failed as i32,
+                        };
+                    }
+                }
             }
         };
 
-        // 配置 Tesseract 参数
-        let args = Args {
-            lang: language.to_string(),
-            config_variables: Default::default(),
-            dpi: Some(300),
-            psm: Some(3), // 自动页面分割
-            oem: Some(3), // 默认 OCR 引擎模式
-        };
-
         // 执行 OCR
-        match rusty_tesseract::image_to_string(&image, &args) {
+        match rusty_tesseract::image_to_string(&image, &tesseract_args(language, dpi)) {
             Ok(text) => {
                 let trimmed = text.trim().to_string();
                 if trimmed.is_empty() {
@@ -230,8 +244,55 @@ impl OcrService {
     }
 
     /// 批量识别图片
+    ///
+    /// 解码和预处理在专用线程池上并行，识别由有限个线程（默认 CPU 核数的一半，至多 4 个）执行，
+    /// 两者之间的有界队列限制了同时驻留内存的预处理图片数。结果顺序与 `paths` 一致。
     pub fn recognize_batch(&self, paths: &[String]) -> Vec<OcrResult> {
-        paths.iter().map(|p| self.recognize(p)).collect()
+        let tasks: Vec<OcrTask> = paths
+            .iter()
+            .enumerate()
+            .map(|(i, p)| OcrTask {
+                photo_id: i as i64,
+                path: PathBuf::from(p),
+            })
+            .collect();
+
+        let results: Vec<Mutex<Option<OcrResult>>> = paths.iter().map(|_| Mutex::new(None)).collect();
+        let recognizer = Arc::new(TesseractRecognizer {
+            language: self.language.clone(),
+        });
+        let batch = OcrBatch::new(recognizer, OcrBatchOptions::default());
+        batch.run(
+            &tasks,
+            |outcome| {
+                let index = outcome.photo_id as usize;
+                let result = OcrResult {
+                    path: paths[index].clone(),
+                    text: outcome.text.clone().unwrap_or_default(),
+                    confidence: if outcome.status == BatchStatus::Processed { 80.0 } else { 0.0 },
+                    error: outcome.error.clone(),
+                    status: outcome.status as i32,
+                };
+                if let Ok(mut slot) = results[index].lock() {
+                    *slot = Some(result);
+                }
+            },
+            |_| {},
+        );
+
+        results
+            .into_iter()
+            .zip(paths)
+            .map(|(slot, path)| {
+                slot.into_inner().ok().flatten().unwrap_or_else(|| OcrResult {
+                    path: path.clone(),
+                    text: String::new(),
+                    confidence: 0.0,
+                    error: Some("OCR 未执行".to_string()),
+                    status: OcrStatus::Failed as i32,
+                })
+            })
+            .collect()
     }
 
     /// 获取当前进度
@@ -288,6 +349,32 @@ impl Default for OcrService {
     }
 }
 
+/// Tesseract 参数
+fn tesseract_args(language: &str, dpi: u32) -> Args {
+    Args {
+        lang: language.to_string(),
+        config_variables: Default::default(),
+        dpi: Some(dpi as i32),
+        psm: Some(3), // 自动页面分割
+        oem: Some(3), // 默认 OCR 引擎模式
+    }
+}
+
+/// 基于 Tesseract 的识别引擎，供批量 OCR 流水线使用
+struct TesseractRecognizer {
+    language: String,
+}
+
+impl OcrRecognizer for TesseractRecognizer {
+    fn recognize(&self, image: &OcrImage) -> photowall_core::AppResult<String> {
+        let gray = DynamicImage::ImageLuma8(image.clone().into_gray_image());
+        let image_arg = Image::from_dynamic_image(&gray)
+            .map_err(|e| photowall_core::AppError::General(format!("加载图片失败: {}", e)))?;
+        rusty_tesseract::image_to_string(&image_arg, &tesseract_args(&self.language, image.dpi))
+            .map_err(|e| photowall_core::AppError::General(format!("OCR 识别失败: {}", e)))
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;